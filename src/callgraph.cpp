@@ -0,0 +1,162 @@
+#include <qset.h>
+#include "callgraph.h"
+#include "cscopefrontend.h"
+#include "cscopecache.h"
+
+QHash<QString, QList<QStringList> > CallGraph::s_hashCalled;
+QHash<QString, QList<QStringList> > CallGraph::s_hashCalling;
+uint CallGraph::s_nGeneration = 0;
+
+/**
+ * @param	nType	The type of query
+ * @return	true if the results of the query describe function calls, false
+ *			otherwise
+ */
+bool CallGraph::supports(uint nType)
+{
+	return (nType == CscopeFrontend::Called) ||
+		(nType == CscopeFrontend::Calling);
+}
+
+/**
+ * Determines whether the calls of a function are stored.
+ * @param	nType	The type of query (called or calling functions)
+ * @param	sFunc	The name of the function
+ * @return	true if the calls are stored, false otherwise
+ */
+bool CallGraph::contains(uint nType, const QString& sFunc)
+{
+	QHash<QString, QList<QStringList> >* pEdges;
+
+	pEdges = getEdges(nType);
+	return (pEdges != NULL) && pEdges->contains(sFunc);
+}
+
+/**
+ * Looks up the calls of a function.
+ * @param	nType		The type of query (called or calling functions)
+ * @param	sFunc		The name of the function
+ * @param	lstRecords	Holds the calls, upon successful return, each
+ *						holding the function name, file path, line number and
+ *						line text (in this order)
+ * @return	true if the calls are stored, false otherwise
+ */
+bool CallGraph::find(uint nType, const QString& sFunc,
+	QList<QStringList>& lstRecords)
+{
+	QHash<QString, QList<QStringList> >* pEdges;
+	QHash<QString, QList<QStringList> >::ConstIterator itr;
+
+	pEdges = getEdges(nType);
+	if (pEdges == NULL)
+		return false;
+
+	itr = pEdges->find(sFunc);
+	if (itr == pEdges->end())
+		return false;
+
+	lstRecords = *itr;
+	return true;
+}
+
+/**
+ * Stores the calls of a function.
+ * The calls are ignored if the database has changed since the query was
+ * made.
+ * @param	nType		The type of query (called or calling functions)
+ * @param	sFunc		The name of the function
+ * @param	nGeneration	The generation of the database on which the query
+ *						was made
+ * @param	lstRecords	The calls, each holding the function name, file path,
+ *						line number and line text (in this order)
+ */
+void CallGraph::insert(uint nType, const QString& sFunc, uint nGeneration,
+	const QList<QStringList>& lstRecords)
+{
+	QHash<QString, QList<QStringList> >* pEdges;
+
+	pEdges = getEdges(nType);
+	if ((pEdges == NULL) || (nGeneration != s_nGeneration))
+		return;
+
+	pEdges->insert(sFunc, lstRecords);
+}
+
+/**
+ * Finds the functions, reachable from the given one by following the stored
+ * calls, whose calls are not stored.
+ * Each function is visited once (regardless of the number of paths that
+ * lead to it, including recursive calls.)
+ * @param	nType	The type of query (called or calling functions)
+ * @param	sFunc	The function from which to start
+ * @param	nDepth	The maximal number of calls to follow from the given
+ *					function
+ * @param	slMissing	Holds the functions whose calls are not stored, upon
+ *						return, in the order they were reached
+ */
+void CallGraph::getMissing(uint nType, const QString& sFunc, int nDepth,
+	QStringList& slMissing)
+{
+	QHash<QString, QList<QStringList> >* pEdges;
+	QHash<QString, QList<QStringList> >::ConstIterator itrEdges;
+	QList<QStringList>::ConstIterator itr;
+	QStringList slLevel, slNext;
+	QStringList::ConstIterator itrFunc;
+	QSet<QString> setVisited;
+
+	slMissing.clear();
+	pEdges = getEdges(nType);
+	if (pEdges == NULL)
+		return;
+
+	// Visit the functions level by level
+	slLevel.append(sFunc);
+	setVisited.insert(sFunc);
+	for (; nDepth > 0 && !slLevel.isEmpty(); nDepth--) {
+		slNext.clear();
+		for (itrFunc = slLevel.begin(); itrFunc != slLevel.end();
+			++itrFunc) {
+			itrEdges = pEdges->find(*itrFunc);
+			if (itrEdges == pEdges->end()) {
+				slMissing.append(*itrFunc);
+				continue;
+			}
+
+			for (itr = (*itrEdges).begin(); itr != (*itrEdges).end(); ++itr) {
+				if (!setVisited.contains((*itr)[0])) {
+					setVisited.insert((*itr)[0]);
+					slNext.append((*itr)[0]);
+				}
+			}
+		}
+
+		slLevel = slNext;
+	}
+}
+
+/**
+ * Returns the stored calls of the given type, discarding all stored calls if
+ * the database has changed.
+ * @param	nType	The type of query (called or calling functions)
+ * @return	The calls, by function name, NULL if the query does not describe
+ *			function calls
+ */
+QHash<QString, QList<QStringList> >* CallGraph::getEdges(uint nType)
+{
+	// Calls found on a previous database may no longer exist
+	if (s_nGeneration != CscopeCache::getGeneration()) {
+		s_hashCalled.clear();
+		s_hashCalling.clear();
+		s_nGeneration = CscopeCache::getGeneration();
+	}
+
+	switch (nType) {
+	case CscopeFrontend::Called:
+		return &s_hashCalled;
+
+	case CscopeFrontend::Calling:
+		return &s_hashCalling;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,49 @@
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qlist.h>
+#include <qhash.h>
+
+/**
+ * Holds the function calls found by Cscope queries on the current database.
+ * For each queried function, the store keeps the results of its "called"
+ * and "calling" queries (@see CscopeFrontend), parsed into records holding
+ * the name of the other function, the file path, the line number and the
+ * line's text. The records of a function are stored once, and are shared by
+ * all call trees in which the function appears, no matter how many times.
+ * Unlike the cache of query output (@see CscopeCache), records are never
+ * removed while the database remains the same. The store is emptied once
+ * the generation of the database changes, and records of queries that were
+ * made on a previous generation are ignored.
+ * The store can also compute the functions reachable from a given one, up
+ * to a given depth, by following the stored calls. Each function is visited
+ * once, so that recursive calls (cycles in the graph) are followed only
+ * once.
+ * @author Elad Lahav
+ */
+class CallGraph
+{
+public:
+	static bool supports(uint);
+	static bool contains(uint, const QString&);
+	static bool find(uint, const QString&, QList<QStringList>&);
+	static void insert(uint, const QString&, uint,
+		const QList<QStringList>&);
+	static void getMissing(uint, const QString&, int, QStringList&);
+
+private:
+	/** Calls made by each function, by name. */
+	static QHash<QString, QList<QStringList> > s_hashCalled;
+
+	/** Calls made to each function, by name. */
+	static QHash<QString, QList<QStringList> > s_hashCalling;
+
+	/** The generation of the database from which the calls were read. */
+	static uint s_nGeneration;
+
+	static QHash<QString, QList<QStringList> >* getEdges(uint);
+};
+
+#endif
@@ -86,9 +86,9 @@ bool ConfigFrontend::run(const QString& sCscopePath,
  * Handles tokens generated by the script.
  * Each token represents a line in the script's output, and is the result of
  * a different test.
- * @param	sToken	The generated token
+ * @param	token	The generated token
  */
-Frontend::ParseResult ConfigFrontend::parseStdout(QString& sToken, 
+Frontend::ParseResult ConfigFrontend::parseStdout(FrontendToken& token, 
 	ParserDelim)
 {
 	uint nResult;
@@ -99,14 +99,14 @@ Frontend::ParseResult ConfigFrontend::parseStdout(QString& sToken,
 	// Determine the next test
 	switch (m_nNextResult) {
 	case CscopePath:
-		if (sToken == "ERROR")
+		if (token.isEqual("ERROR"))
 			m_nNextResult = CtagsPath;
 		else
 			m_nNextResult = CscopeVersion;
 		break;
 		
 	case CscopeVersion:
-		if (sToken == "ERROR")
+		if (token.isEqual("ERROR"))
 			m_nNextResult = CtagsPath;
 		else
 			m_nNextResult = CscopeVerbose;
@@ -121,7 +121,7 @@ Frontend::ParseResult ConfigFrontend::parseStdout(QString& sToken,
 		break;
 		
 	case CtagsPath:
-		if (sToken == "ERROR")
+		if (token.isEqual("ERROR"))
 			m_nNextResult = END;
 		else
 			m_nNextResult = CtagsExub;
@@ -136,7 +136,7 @@ Frontend::ParseResult ConfigFrontend::parseStdout(QString& sToken,
 	}
 	
 	// Publish the result and the type of the next test
-	emit result(nResult, sToken);
+	emit result(nResult, token.getData());
 	emit test(m_nNextResult);
 	
 	return DiscardToken;
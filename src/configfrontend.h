@@ -42,7 +42,7 @@ signals:
 	void result(uint nType, const QString& sResult);
 	
 protected:
-	virtual ParseResult parseStdout(QString&, ParserDelim);
+	virtual ParseResult parseStdout(FrontendToken&, ParserDelim);
 	
 private:
 	/** The type of test whose result is expected next. */
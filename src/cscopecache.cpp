@@ -0,0 +1,109 @@
+#include "cscopecache.h"
+#include "cscopefrontend.h"
+
+QCache<QString, CscopeCache::Entry> CscopeCache::s_cache(CSCOPE_CACHE_SIZE);
+uint CscopeCache::s_nGeneration = 0;
+
+/**
+ * Determines whether the results of a query can be cached.
+ * Text and pattern queries search the source files rather than the database,
+ * and their results may change without a new database generation.
+ * @param	nType	The type of query
+ * @return	true if the results can be cached, false otherwise
+ */
+bool CscopeCache::isCached(uint nType)
+{
+	return (nType != CscopeFrontend::Text) &&
+		(nType != CscopeFrontend::Pattern);
+}
+
+/**
+ * Determines whether the results of a query on the current database are
+ * stored, without marking them as recently used.
+ * @param	nType		The type of query
+ * @param	sText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @return	true if the results are stored, false otherwise
+ */
+bool CscopeCache::contains(uint nType, const QString& sText, bool bCase)
+{
+	return s_cache.contains(getKey(nType, sText, bCase, s_nGeneration));
+}
+
+/**
+ * Looks up the results of a query on the current database.
+ * @param	nType		The type of query
+ * @param	sText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	baOutput	Holds the query's output, upon successful return
+ * @param	nRecords	Holds the number of records in the output, upon
+ *						successful return
+ * @return	true if the results were found, false otherwise
+ */
+bool CscopeCache::find(uint nType, const QString& sText, bool bCase,
+	QByteArray& baOutput, uint& nRecords)
+{
+	Entry* pEntry;
+
+	pEntry = s_cache.object(getKey(nType, sText, bCase, s_nGeneration));
+	if (pEntry == NULL)
+		return false;
+
+	baOutput = pEntry->baOutput;
+	nRecords = pEntry->nRecords;
+	return true;
+}
+
+/**
+ * Stores the results of a query.
+ * Results are ignored if the database has changed since the query was
+ * started, or if they are too large to be cached.
+ * @param	nType		The type of query
+ * @param	sText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	nGeneration	The generation of the database on which the query
+ *						was run
+ * @param	baOutput	The query's output
+ * @param	nRecords	The number of records in the output
+ */
+void CscopeCache::insert(uint nType, const QString& sText, bool bCase,
+	uint nGeneration, const QByteArray& baOutput, uint nRecords)
+{
+	Entry* pEntry;
+
+	if ((nGeneration != s_nGeneration) || !isCached(nType))
+		return;
+
+	// The cost of an entry is the size of its output (the cache deletes the
+	// entry if it exceeds the maximal cost)
+	pEntry = new Entry;
+	pEntry->baOutput = baOutput;
+	pEntry->nRecords = nRecords;
+	s_cache.insert(getKey(nType, sText, bCase, nGeneration), pEntry,
+		baOutput.size() + sText.length() + 1);
+}
+
+/**
+ * Starts a new database generation.
+ * Should be called whenever the database changes, or a different project
+ * is loaded.
+ */
+void CscopeCache::invalidate()
+{
+	s_nGeneration++;
+	s_cache.clear();
+}
+
+/**
+ * @param	nType		The type of query
+ * @param	sText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	nGeneration	The generation of the database
+ * @return	A key identifying the query's results in the cache
+ */
+QString CscopeCache::getKey(uint nType, const QString& sText, bool bCase,
+	uint nGeneration)
+{
+	return QString("%1 %2 %3 %4").arg(nGeneration).arg(nType)
+		.arg(bCase ? 1 : 0).arg(sText);
+}
@@ -0,0 +1,62 @@
+#ifndef CSCOPECACHE_H
+#define CSCOPECACHE_H
+
+#include <qcache.h>
+#include <qstring.h>
+#include <qbytearray.h>
+
+/** The maximal number of bytes of query output held by the cache. */
+#define CSCOPE_CACHE_SIZE	(8 * 1024 * 1024)
+
+/**
+ * Holds the results of recent Cscope queries.
+ * Repeating a query (e.g., by refreshing a query page, or expanding the same
+ * call tree node) serves the results stored in the cache, without running
+ * Cscope again. Results are stored in the output format of "cscope -L", and
+ * are keyed by the query's type, text and case sensitivity, as well as the
+ * generation of the database on which the query was run.
+ * The generation is advanced whenever the database changes (either rebuilt,
+ * or updated with files modified since the last build), which discards all
+ * stored results. Results of queries that started before the change are not
+ * stored.
+ * Once the total size of the stored output exceeds CSCOPE_CACHE_SIZE, the
+ * least-recently used results are removed.
+ * @author Elad Lahav
+ */
+class CscopeCache
+{
+public:
+	static bool isCached(uint);
+	static bool contains(uint, const QString&, bool);
+	static bool find(uint, const QString&, bool, QByteArray&, uint&);
+	static void insert(uint, const QString&, bool, uint, const QByteArray&,
+		uint);
+	static void invalidate();
+	static QString getKey(uint, const QString&, bool, uint);
+
+	/**
+	 * @return	The generation of the current project's database
+	 */
+	static uint getGeneration() { return s_nGeneration; }
+
+private:
+	/**
+	 * The results of a single query.
+	 */
+	struct Entry
+	{
+		/** The query's output, one record per line. */
+		QByteArray baOutput;
+
+		/** The number of records in the output. */
+		uint nRecords;
+	};
+
+	/** Stored results, by query. */
+	static QCache<QString, Entry> s_cache;
+
+	/** The generation of the current project's database. */
+	static uint s_nGeneration;
+};
+
+#endif
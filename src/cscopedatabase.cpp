@@ -0,0 +1,1385 @@
+#include "husky.h"
+#include <stdlib.h>
+#include <string.h>
+#include <qdir.h>
+#include <qfileinfo.h>
+#include <qalgorithms.h>
+#include "cscopedatabase.h"
+#include "cscopefrontend.h"
+
+/** Symbol types, as marked in the cross-reference file. */
+#define MARK_FCNCALL	'`'
+#define MARK_FCNDEF		'$'
+#define MARK_FCNEND		'}'
+#define MARK_DEFINE		'#'
+#define MARK_DEFINEEND	')'
+#define MARK_INCLUDE	'~'
+#define MARK_NEWFILE	'@'
+
+/** Symbol types which are considered as definitions. */
+#define DEF_MARKS		"#$cegmstulp"
+
+/** The name used for records outside any function or macro. */
+#define GLOBAL_NAME		"<global>"
+
+/**
+ * Digraph characters, used by Cscope to compress text.
+ * A byte with the most significant bit set stands for a pair of characters,
+ * the first taken from DICHAR1 and the second from DICHAR2.
+ */
+static const char DICHAR1[] = " teisaprnl(of)=c";
+static const char DICHAR2[] = " tnerpla";
+
+/**
+ * Keywords, used by Cscope to compress text.
+ * A byte with a value below that of a space character (other than a tab or a
+ * new line) stands for the keyword at the respective index.
+ */
+static const struct {
+	/** The keyword's text. */
+	const char* szText;
+
+	/** The character following the keyword ('\0' for none). If not null, a
+		space is added after the keyword, followed by a '(' character if
+		specified. */
+	char cDelim;
+} KEYWORDS[] = {
+	{ "", '\0' },
+	{ "#define", ' ' },
+	{ "#include", ' ' },
+	{ "break", '\0' },
+	{ "case", ' ' },
+	{ "char", ' ' },
+	{ "continue", '\0' },
+	{ "default", '\0' },
+	{ "double", ' ' },
+	{ "\t", '\0' },
+	{ "\n", '\0' },
+	{ "else", ' ' },
+	{ "enum", ' ' },
+	{ "extern", ' ' },
+	{ "float", ' ' },
+	{ "for", '(' },
+	{ "goto", ' ' },
+	{ "if", '(' },
+	{ "int", ' ' },
+	{ "long", ' ' },
+	{ "register", ' ' },
+	{ "return", '\0' },
+	{ "short", ' ' },
+	{ "sizeof", '\0' },
+	{ "static", ' ' },
+	{ "struct", ' ' },
+	{ "switch", '(' },
+	{ "typedef", ' ' },
+	{ "union", ' ' },
+	{ "unsigned", ' ' },
+	{ "void", ' ' },
+	{ "while", '(' }
+};
+
+#define KEYWORD_COUNT	((int)(sizeof(KEYWORDS) / sizeof(KEYWORDS[0])))
+
+QList<CscopeDatabase*> CscopeDatabase::s_lstDatabases;
+CscopeDatabase* CscopeDatabase::s_pDelta = NULL;
+QSet<QByteArray> CscopeDatabase::s_setDeltaFiles;
+
+/**
+ * Class constructor.
+ * Databases are only created through load() and setDelta().
+ * @param	bUseIndex	true to use an index of symbols, false to scan the
+ *						file on every query
+ */
+CscopeDatabase::CscopeDatabase(bool bUseIndex) :
+	m_pData(NULL),
+	m_nStart(0),
+	m_nSize(0),
+	m_bCompressed(true),
+	m_bUseIndex(bUseIndex),
+	m_pIndex(NULL),
+	m_pIndexHeader(NULL),
+	m_pSymbols(NULL),
+	m_pPostings(NULL),
+	m_pFiles(NULL),
+	m_pFuncs(NULL),
+	m_pMacros(NULL),
+	m_pPool(NULL)
+{
+}
+
+/**
+ * Class destructor.
+ */
+CscopeDatabase::~CscopeDatabase()
+{
+	if (m_pData != NULL)
+		m_file.unmap((uchar*)m_pData);
+
+	if ((m_pIndex != NULL) && m_baIndex.isEmpty())
+		m_fileIndex.unmap((uchar*)m_pIndex);
+}
+
+/**
+ * Loads the databases of the given project.
+ * Databases that were already loaded are kept, unless their cross-reference
+ * files were modified since. Thus, when only some of the shards of a project
+ * are rebuilt, the others are not read again.
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @param	slNames		The names of the cross-reference files (either
+ *						cscope.out or the databases of all shards)
+ * @param	bUseIndex	true if the project uses an inverted index, false
+ *						otherwise
+ * @return	true if all databases were loaded, false otherwise
+ */
+bool CscopeDatabase::load(const QString& sProjPath,
+	const QStringList& slNames, bool bUseIndex)
+{
+	QDir dir(sProjPath);
+	QList<CscopeDatabase*> lstDatabases;
+	CscopeDatabase* pDatabase;
+	int i;
+
+	for (i = 0; i < slNames.count(); i++) {
+		QFileInfo fi(dir, slNames[i]);
+
+		// Use the loaded database, unless the file has changed
+		if (i < s_lstDatabases.count()) {
+			pDatabase = s_lstDatabases[i];
+			if ((pDatabase->m_file.fileName() == fi.absoluteFilePath()) &&
+				(pDatabase->m_dtModified == fi.lastModified()) &&
+				(pDatabase->m_file.size() == fi.size()) &&
+				(pDatabase->m_bUseIndex == bUseIndex)) {
+				s_lstDatabases[i] = NULL;
+				lstDatabases.append(pDatabase);
+				continue;
+			}
+		}
+
+		if (!fi.exists())
+			break;
+
+		pDatabase = new CscopeDatabase(bUseIndex);
+		if (!pDatabase->open(fi.absoluteFilePath())) {
+			dp("Failed to load %s\n", fi.absoluteFilePath().toLatin1().data());
+			delete pDatabase;
+			break;
+		}
+
+		lstDatabases.append(pDatabase);
+	}
+
+	// Replace the previously-loaded databases
+	qDeleteAll(s_lstDatabases);
+	s_lstDatabases = lstDatabases;
+
+	// All databases are required for complete results
+	if (slNames.isEmpty() || (i < slNames.count())) {
+		qDeleteAll(s_lstDatabases);
+		s_lstDatabases.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Unloads the current databases, as well as the delta.
+ * Should be called whenever the database is rebuilt, or the project is
+ * closed.
+ */
+void CscopeDatabase::reset()
+{
+	qDeleteAll(s_lstDatabases);
+	s_lstDatabases.clear();
+
+	delete s_pDelta;
+	s_pDelta = NULL;
+	s_setDeltaFiles.clear();
+}
+
+/**
+ * Loads a database built for files modified since the project's database
+ * was built.
+ * Any delta previously loaded is replaced.
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @param	slFiles		The paths of the files covered by the delta, as
+ *						passed to Cscope
+ * @return	true if successful, false otherwise
+ */
+bool CscopeDatabase::setDelta(const QString& sProjPath,
+	const QStringList& slFiles)
+{
+	CscopeDatabase* pDelta;
+	QStringList::ConstIterator itr;
+
+	delete s_pDelta;
+	s_pDelta = NULL;
+	s_setDeltaFiles.clear();
+
+	// Delta databases are small, and are always scanned
+	pDelta = new CscopeDatabase(false);
+	if (!pDelta->open(QDir(sProjPath).absoluteFilePath(CSCOPE_DELTA_FILE))) {
+		delete pDelta;
+		return false;
+	}
+
+	s_pDelta = pDelta;
+	for (itr = slFiles.begin(); itr != slFiles.end(); ++itr)
+		s_setDeltaFiles.insert((*itr).toLocal8Bit());
+
+	return true;
+}
+
+/**
+ * Collects the names of all symbols in the loaded databases, including the
+ * delta.
+ * @param	hashSymbols	Maps each (UTF-8 encoded) name to true if the symbol
+ *						is defined in any of the databases, false if it is
+ *						only referenced, upon successful return
+ * @return	true if successful, false if no database is loaded
+ */
+bool CscopeDatabase::getSymbols(QHash<QByteArray, bool>& hashSymbols)
+{
+	int i;
+
+	hashSymbols.clear();
+	if (s_lstDatabases.isEmpty())
+		return false;
+
+	for (i = 0; i < s_lstDatabases.count(); i++)
+		s_lstDatabases[i]->addSymbols(hashSymbols);
+
+	if (s_pDelta != NULL)
+		s_pDelta->addSymbols(hashSymbols);
+
+	return true;
+}
+
+/**
+ * Determines whether a query can be answered without running Cscope.
+ * @param	nType	The type of query
+ * @param	sText	The query's text
+ * @return	true if the query is supported, false otherwise
+ */
+bool CscopeDatabase::supports(uint nType, const QString& sText)
+{
+	int i;
+
+	switch (nType) {
+	case CscopeFrontend::Reference:
+	case CscopeFrontend::Definition:
+	case CscopeFrontend::Called:
+	case CscopeFrontend::Calling:
+		break;
+
+	default:
+		return false;
+	}
+
+	if (sText.isEmpty())
+		return false;
+
+	// Only accept plain identifiers (Cscope treats any other text as a
+	// regular expression)
+	for (i = 0; i < sText.length(); i++) {
+		if ((sText[i].unicode() >= 0x80) ||
+			(!sText[i].isLetterOrNumber() && (sText[i] != '_'))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Runs a query on the loaded databases.
+ * The results are written in the same format as the output of a
+ * "cscope -L" process, one record per line.
+ * @param	nType		The type of query
+ * @param	sText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	baOutput	Holds the query's output, upon successful return
+ * @param	nRecords	Holds the number of records in the output, upon
+ *						successful return
+ * @return	true if successful, false if the query is not supported, or if
+ *			no database is loaded
+ */
+bool CscopeDatabase::query(uint nType, const QString& sText, bool bCase,
+	QByteArray& baOutput, uint& nRecords)
+{
+	QList<CscopeDatabase*>::ConstIterator itr;
+	QByteArray baText;
+
+	if (!supports(nType, sText) || s_lstDatabases.isEmpty())
+		return false;
+
+	baText = sText.toLocal8Bit();
+	baOutput.resize(0);
+	nRecords = 0;
+
+	for (itr = s_lstDatabases.begin(); itr != s_lstDatabases.end(); ++itr)
+		(*itr)->run(nType, baText, bCase, baOutput, nRecords);
+
+	// Add results from files modified since the database was built
+	if (s_pDelta != NULL)
+		s_pDelta->run(nType, baText, bCase, baOutput, nRecords);
+
+	// Merge the results of all shards
+	if (s_lstDatabases.count() > 1)
+		sortRecords(baOutput);
+
+	return true;
+}
+
+/**
+ * Runs a query on this database, using the index if available.
+ * @param	nType		The type of query
+ * @param	baText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	baOutput	Output buffer for query records
+ * @param	nRecords	The number of records in the output buffer
+ */
+void CscopeDatabase::run(uint nType, const QByteArray& baText, bool bCase,
+	QByteArray& baOutput, uint& nRecords)
+{
+	if (m_bUseIndex)
+		lookup(nType, baText, bCase, baOutput, nRecords);
+	else
+		scan(nType, baText, bCase, baOutput, nRecords);
+}
+
+/**
+ * Determines whether the entries of a file should be ignored, since the
+ * file is covered by the delta.
+ * @param	baFile	The path of the file, as stored in the database
+ * @return	true to ignore the file, false otherwise
+ */
+bool CscopeDatabase::isMasked(const QByteArray& baFile) const
+{
+	return (s_pDelta != NULL) && (s_pDelta != this) &&
+		s_setDeltaFiles.contains(baFile);
+}
+
+/**
+ * Maps the cross-reference file into memory, and reads its header.
+ * @param	sPath	The full path of the file
+ * @return	true if successful, false otherwise
+ */
+bool CscopeDatabase::open(const QString& sPath)
+{
+	const char* pEnd;
+	QList<QByteArray> lstFields;
+	qint64 nSize, nTrailer;
+	bool bResult;
+
+	m_file.setFileName(sPath);
+	m_dtModified = QFileInfo(sPath).lastModified();
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	// Positions are stored in 32 bits
+	nSize = m_file.size();
+	if ((nSize == 0) || (nSize >= 0xffffffffLL))
+		return false;
+
+	m_pData = (const char*)m_file.map(0, nSize);
+	if (m_pData == NULL)
+		return false;
+
+	m_nSize = (quint32)nSize;
+
+	// Read the header line, in the format of
+	// "cscope <version> <path> [-c] [-q <symbols>] [-T] <trailer offset>"
+	pEnd = (const char*)memchr(m_pData, '\n', m_nSize);
+	if (pEnd == NULL)
+		return false;
+
+	lstFields = QByteArray(m_pData, pEnd - m_pData).split(' ');
+	if ((lstFields.count() < 3) || (lstFields.first() != "cscope"))
+		return false;
+
+	m_bCompressed = !lstFields.contains("-c");
+	m_nStart = (pEnd - m_pData) + 1;
+
+	// Ignore the trailer (which holds the lists of directories and files)
+	nTrailer = lstFields.last().toLongLong(&bResult);
+	if (bResult && (nTrailer > m_nStart) && (nTrailer < m_nSize))
+		m_nSize = (quint32)nTrailer;
+
+	return true;
+}
+
+/**
+ * Reads the next entry in the cross-reference file.
+ * @param	nPos	The position from which to read, set to the position
+ *					following the entry upon return
+ * @param	line	Holds the source line, if the entry is a source line
+ * @param	baFile	Holds the name of the file, if the entry begins a new file
+ * @return	The type of the entry read
+ */
+CscopeDatabase::Entry CscopeDatabase::next(quint32& nPos, Line& line,
+	QByteArray& baFile) const
+{
+	const char* pLine;
+	const char* pEol;
+	quint32 nEol;
+
+	while (nPos < m_nSize) {
+		pLine = m_pData + nPos;
+
+		// Skip empty lines
+		if (*pLine == '\n') {
+			nPos++;
+			continue;
+		}
+
+		pEol = (const char*)memchr(pLine, '\n', m_nSize - nPos);
+		nEol = (pEol != NULL) ? (quint32)(pEol - m_pData) : m_nSize;
+
+		// A file mark begins a new file, an empty one ends the database
+		if ((pLine[0] == '\t') && (nPos + 1 < m_nSize) &&
+			(pLine[1] == MARK_NEWFILE)) {
+			if (nEol == nPos + 2)
+				return EndOfFile;
+
+			decode(pLine + 2, nEol - nPos - 2, baFile, false);
+			nPos = (nEol < m_nSize) ? nEol + 1 : m_nSize;
+			return NewFile;
+		}
+
+		// Read a source line
+		if (parseLine(nPos, line)) {
+			nPos = line.nEnd;
+			return SourceLine;
+		}
+
+		// Skip unknown entries
+		nPos = (nEol < m_nSize) ? nEol + 1 : m_nSize;
+	}
+
+	return EndOfFile;
+}
+
+/**
+ * Reads a source line out of the cross-reference file.
+ * A line begins with its number, after which text and symbols alternate,
+ * each on a line of its own. Symbols may be prefixed by a tab and a mark
+ * character denoting their type. An empty line in place of a symbol ends the
+ * source line.
+ * @param	nPos	The position of the line
+ * @param	line	Holds the parsed line, upon successful return
+ * @return	true if successful, false if the given position does not hold a
+ *			source line
+ */
+bool CscopeDatabase::parseLine(quint32 nPos, Line& line) const
+{
+	const char* p;
+	const char* pEnd;
+	const char* pEol;
+	Symbol sym;
+
+	p = m_pData + nPos;
+	pEnd = m_pData + m_nSize;
+	if ((*p < '0') || (*p > '9'))
+		return false;
+
+	// Get the line number
+	line.nStart = nPos;
+	for (line.nLine = 0; (p < pEnd) && (*p >= '0') && (*p <= '9'); p++)
+		line.nLine = (line.nLine * 10) + (*p - '0');
+
+	if ((p < pEnd) && (*p == ' '))
+		p++;
+
+	line.nText = p - m_pData;
+	line.vecSymbols.resize(0);
+
+	// Skip the first piece of text
+	pEol = (const char*)memchr(p, '\n', pEnd - p);
+	p = (pEol != NULL) ? pEol + 1 : pEnd;
+
+	// Read symbols up to the end of the line
+	while ((p < pEnd) && (*p != '\n')) {
+		if ((*p == '\t') && (p + 1 < pEnd)) {
+			sym.cMark = p[1];
+			p += 2;
+		}
+		else {
+			sym.cMark = 0;
+		}
+
+		pEol = (const char*)memchr(p, '\n', pEnd - p);
+		if (pEol == NULL)
+			pEol = pEnd;
+
+		sym.nOffset = p - m_pData;
+		sym.nLength = pEol - p;
+		line.vecSymbols.append(sym);
+
+		// Skip the symbol and the text that follows it
+		p = (pEol < pEnd) ? pEol + 1 : pEnd;
+		pEol = (const char*)memchr(p, '\n', pEnd - p);
+		p = (pEol != NULL) ? pEol + 1 : pEnd;
+	}
+
+	line.nTextEnd = p - m_pData;
+	line.nEnd = (p < pEnd) ? line.nTextEnd + 1 : m_nSize;
+	return true;
+}
+
+/**
+ * Expands compressed text.
+ * @param	pText	The text to decode
+ * @param	nLen	The length of the text
+ * @param	baText	Holds the decoded text, upon return
+ * @param	bKeywords	true to expand keywords (which only appear in source
+ *						text), false otherwise
+ */
+void CscopeDatabase::decode(const char* pText, int nLen, QByteArray& baText,
+	bool bKeywords) const
+{
+	uchar c;
+	int i;
+
+	baText.resize(0);
+	if (!m_bCompressed) {
+		baText.append(pText, nLen);
+		return;
+	}
+
+	for (i = 0; i < nLen; i++) {
+		c = (uchar)pText[i];
+		if (c & 0x80) {
+			// A digraph
+			c &= 0x7f;
+			baText.append(DICHAR1[c / 8]);
+			baText.append(DICHAR2[c & 7]);
+		}
+		else if (bKeywords && (c < ' ') && (c != '\t') && (c != '\n') &&
+			(c < KEYWORD_COUNT)) {
+			// A keyword
+			baText.append(KEYWORDS[c].szText);
+			if (KEYWORDS[c].cDelim != '\0')
+				baText.append(' ');
+			if (KEYWORDS[c].cDelim == '(')
+				baText.append('(');
+		}
+		else {
+			baText.append((char)c);
+		}
+	}
+}
+
+/**
+ * Decodes the name of a symbol.
+ * @param	sym		The symbol
+ * @param	baName	Holds the name of the symbol, upon return
+ */
+void CscopeDatabase::getSymbol(const Symbol& sym, QByteArray& baName) const
+{
+	decode(m_pData + sym.nOffset, sym.nLength, baName, false);
+}
+
+/**
+ * Reconstructs the text of a source line.
+ * @param	line	The source line
+ * @return	The line's text
+ */
+QByteArray CscopeDatabase::getText(const Line& line) const
+{
+	QByteArray baText, baPiece;
+	const char* p;
+	const char* pEnd;
+	const char* pEol;
+	bool bSymbol = false;
+	int i;
+
+	p = m_pData + line.nText;
+	pEnd = m_pData + line.nTextEnd;
+
+	// Concatenate text and symbols (without their marks)
+	while (p < pEnd) {
+		pEol = (const char*)memchr(p, '\n', pEnd - p);
+		if (pEol == NULL)
+			pEol = pEnd;
+
+		if (bSymbol && (*p == '\t') && (p + 1 < pEol))
+			p += 2;
+
+		decode(p, pEol - p, baPiece, !bSymbol);
+		baText += baPiece;
+
+		p = pEol + 1;
+		bSymbol = !bSymbol;
+	}
+
+	// Records are written on a single line, with no leading white space
+	for (i = 0; i < baText.size(); i++) {
+		if ((baText[i] == '\n') || (baText[i] == '\r'))
+			baText[i] = ' ';
+	}
+
+	for (i = 0; (i < baText.size()) && ((baText[i] == ' ') ||
+		(baText[i] == '\t')); i++)
+		;
+
+	return baText.mid(i);
+}
+
+/**
+ * Finds the scope that applies at the given position.
+ * @param	pScopes		A table of scope changes in the index, sorted by
+ *						position
+ * @param	nCount		The number of entries in the table
+ * @param	nPos		The position in the file
+ * @return	The name of the scope (empty if no scope applies)
+ */
+const char* CscopeDatabase::getScope(const Scope* pScopes, quint32 nCount,
+	quint32 nPos) const
+{
+	quint32 nLow, nHigh, nMid;
+
+	// Find the first change following the given position
+	nLow = 0;
+	nHigh = nCount;
+	while (nLow < nHigh) {
+		nMid = nLow + (nHigh - nLow) / 2;
+		if (pScopes[nMid].nOffset <= nPos)
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+
+	if (nLow == 0)
+		return "";
+
+	return m_pPool + pScopes[nLow - 1].nName;
+}
+
+/**
+ * Looks up a symbol in the index.
+ * @param	baName	The (decoded) name of the symbol
+ * @return	The symbol's entry in the symbol table, NULL if the symbol does
+ *			not appear in the file
+ */
+const CscopeDatabase::IndexSymbol* CscopeDatabase::findSymbol(
+	const QByteArray& baName) const
+{
+	quint32 nLow, nHigh, nMid;
+	int nResult;
+
+	nLow = 0;
+	nHigh = m_pIndexHeader->nSymbols;
+	while (nLow < nHigh) {
+		nMid = nLow + (nHigh - nLow) / 2;
+		nResult = strcmp(m_pPool + m_pSymbols[nMid].nName, baName.constData());
+		if (nResult == 0)
+			return &m_pSymbols[nMid];
+
+		if (nResult < 0)
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+
+	return NULL;
+}
+
+/**
+ * Compares the name of a symbol with the query's text.
+ * @param	sym		The symbol
+ * @param	baText	The query's text
+ * @param	bCase	true for case-sensitive comparison, false otherwise
+ * @return	true if the symbol matches the text, false otherwise
+ */
+bool CscopeDatabase::match(const Symbol& sym, const QByteArray& baText,
+	bool bCase)
+{
+	if (sym.nLength == 0)
+		return false;
+
+	getSymbol(sym, m_baSymbol);
+	if (m_baSymbol.size() != baText.size())
+		return false;
+
+	if (bCase)
+		return m_baSymbol == baText;
+
+	return qstrnicmp(m_baSymbol.constData(), baText.constData(),
+		baText.size()) == 0;
+}
+
+/**
+ * Reports a source line if it matches a query.
+ * Used for all query types except Called.
+ * @param	nType		The type of query
+ * @param	line		The source line
+ * @param	baFile		The file to which the line belongs
+ * @param	baFunc		The function or macro to which the line belongs
+ * @param	baText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	baOutput	Output buffer for query records
+ * @param	nRecords	The number of records in the output buffer
+ */
+void CscopeDatabase::evaluate(uint nType, const Line& line,
+	const QByteArray& baFile, const QByteArray& baFunc,
+	const QByteArray& baText, bool bCase, QByteArray& baOutput,
+	uint& nRecords)
+{
+	QByteArray baName;
+	int i;
+
+	for (i = 0; i < line.vecSymbols.size(); i++) {
+		const Symbol& sym = line.vecSymbols[i];
+
+		switch (nType) {
+		case CscopeFrontend::Reference:
+			// Any symbol, except for file names
+			if ((sym.cMark == MARK_INCLUDE) || (sym.cMark == MARK_NEWFILE) ||
+				!match(sym, baText, bCase)) {
+				continue;
+			}
+
+			addRecord(baFile, baFunc, line.nLine, getText(line), baOutput,
+				nRecords);
+			return;
+
+		case CscopeFrontend::Definition:
+			// Definitions are reported with the name of the symbol
+			if ((sym.cMark == 0) || (strchr(DEF_MARKS, sym.cMark) == NULL) ||
+				!match(sym, baText, bCase)) {
+				continue;
+			}
+
+			getSymbol(sym, baName);
+			addRecord(baFile, baName, line.nLine, getText(line), baOutput,
+				nRecords);
+			return;
+
+		case CscopeFrontend::Calling:
+			// Calls to the requested function
+			if ((sym.cMark != MARK_FCNCALL) || !match(sym, baText, bCase))
+				continue;
+
+			addRecord(baFile, baFunc, line.nLine, getText(line), baOutput,
+				nRecords);
+			return;
+		}
+	}
+}
+
+/**
+ * Reports all function calls made by a function.
+ * @param	nPos		The position of the line holding the function's
+ *						definition
+ * @param	baFile		The file to which the function belongs
+ * @param	baOutput	Output buffer for query records
+ * @param	nRecords	The number of records in the output buffer
+ */
+void CscopeDatabase::scanCalled(quint32 nPos, const QByteArray& baFile,
+	QByteArray& baOutput, uint& nRecords)
+{
+	Line line;
+	QByteArray baName, baText, baNone;
+	bool bFirst, bEnd;
+	int i;
+
+	for (bFirst = true; next(nPos, line, baNone) == SourceLine;
+		bFirst = false) {
+		// Stop at the beginning of another function
+		for (i = 0; !bFirst && (i < line.vecSymbols.size()); i++) {
+			if (line.vecSymbols[i].cMark == MARK_FCNDEF)
+				return;
+		}
+
+		// Report every function call on this line
+		bEnd = false;
+		baText.resize(0);
+		for (i = 0; i < line.vecSymbols.size(); i++) {
+			const Symbol& sym = line.vecSymbols[i];
+
+			if ((sym.cMark == MARK_FCNCALL) && (sym.nLength > 0)) {
+				if (baText.isEmpty())
+					baText = getText(line);
+
+				getSymbol(sym, baName);
+				addRecord(baFile, baName, line.nLine, baText, baOutput,
+					nRecords);
+			}
+			else if (sym.cMark == MARK_FCNEND) {
+				bEnd = true;
+			}
+		}
+
+		// Stop at the end of the function
+		if (bEnd)
+			return;
+	}
+}
+
+/**
+ * Runs a query by reading the entire cross-reference file.
+ * @param	nType		The type of query
+ * @param	baText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	baOutput	Output buffer for query records
+ * @param	nRecords	The number of records in the output buffer
+ */
+void CscopeDatabase::scan(uint nType, const QByteArray& baText, bool bCase,
+	QByteArray& baOutput, uint& nRecords)
+{
+	Line line;
+	QByteArray baFile, baFunc, baMacro;
+	quint32 nPos;
+	Entry entry;
+	bool bMasked = false;
+	int i;
+
+	nPos = m_nStart;
+	while ((entry = next(nPos, line, baFile)) != EndOfFile) {
+		if (entry == NewFile) {
+			baFunc.resize(0);
+			baMacro.resize(0);
+			bMasked = isMasked(baFile);
+			continue;
+		}
+
+		// Skip files covered by the delta
+		if (bMasked)
+			continue;
+
+		// Handle functions and macros which begin on this line
+		for (i = 0; i < line.vecSymbols.size(); i++) {
+			if (line.vecSymbols[i].cMark == MARK_FCNDEF)
+				getSymbol(line.vecSymbols[i], baFunc);
+			else if (line.vecSymbols[i].cMark == MARK_DEFINE)
+				getSymbol(line.vecSymbols[i], baMacro);
+		}
+
+		if (nType == CscopeFrontend::Called) {
+			// Look for the definition of the requested function
+			for (i = 0; i < line.vecSymbols.size(); i++) {
+				if ((line.vecSymbols[i].cMark == MARK_FCNDEF) &&
+					match(line.vecSymbols[i], baText, bCase)) {
+					scanCalled(line.nStart, baFile, baOutput, nRecords);
+					break;
+				}
+			}
+		}
+		else {
+			evaluate(nType, line, baFile, !baMacro.isEmpty() ? baMacro :
+				(!baFunc.isEmpty() ? baFunc : QByteArray(GLOBAL_NAME)),
+				baText, bCase, baOutput, nRecords);
+		}
+
+		// Handle functions and macros which end on this line
+		for (i = 0; i < line.vecSymbols.size(); i++) {
+			if (line.vecSymbols[i].cMark == MARK_FCNEND)
+				baFunc.resize(0);
+			else if (line.vecSymbols[i].cMark == MARK_DEFINEEND)
+				baMacro.resize(0);
+		}
+	}
+}
+
+/**
+ * Loads the index of symbols in the cross-reference file.
+ * The index is read from the index file, if it was built for the current
+ * contents of the cross-reference file. Otherwise, the index is built, and
+ * written to the index file. If the index file cannot be written, the index
+ * is kept in memory.
+ * @return	true if successful, false otherwise
+ */
+bool CscopeDatabase::loadIndex()
+{
+	QByteArray baIndex;
+	QString sPath;
+	QFile file;
+	qint64 nSize;
+	const char* pData;
+
+	if (m_pIndex != NULL)
+		return true;
+
+	// Map an existing index file
+	sPath = m_file.fileName() + CSCOPE_INDEX_SUFFIX;
+	m_fileIndex.setFileName(sPath);
+	if (m_fileIndex.open(QIODevice::ReadOnly)) {
+		nSize = m_fileIndex.size();
+		pData = (nSize > 0) ? (const char*)m_fileIndex.map(0, nSize) : NULL;
+		if ((pData != NULL) && mapIndex(pData, nSize))
+			return true;
+
+		if (pData != NULL)
+			m_fileIndex.unmap((uchar*)pData);
+		m_fileIndex.close();
+	}
+
+	// Build a new index, and write it through a temporary file, so that an
+	// incomplete index is never read
+	buildIndex(baIndex);
+	file.setFileName(sPath + ".tmp");
+	if (file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+		(file.write(baIndex) == baIndex.size())) {
+		file.close();
+		QFile::remove(sPath);
+		if (file.rename(sPath) && m_fileIndex.open(
+			QIODevice::ReadOnly)) {
+			pData = (const char*)m_fileIndex.map(0, baIndex.size());
+			if ((pData != NULL) && mapIndex(pData, baIndex.size()))
+				return true;
+
+			if (pData != NULL)
+				m_fileIndex.unmap((uchar*)pData);
+			m_fileIndex.close();
+		}
+	}
+	else {
+		file.close();
+		file.remove();
+	}
+
+	dp("Failed to write %s\n", sPath.toLatin1().data());
+
+	// Use the index from memory
+	m_baIndex = baIndex;
+	return mapIndex(m_baIndex.constData(), m_baIndex.size());
+}
+
+/**
+ * Validates the contents of an index, and sets the pointers to its tables.
+ * @param	pData	The contents of the index
+ * @param	nSize	The size of the index
+ * @return	true if successful, false if the index is corrupted, or was not
+ *			built for the current contents of the cross-reference file
+ */
+bool CscopeDatabase::mapIndex(const char* pData, qint64 nSize)
+{
+	const IndexHeader* pHeader;
+	qint64 nExpected;
+
+	if (nSize < (qint64)sizeof(IndexHeader))
+		return false;
+
+	// Validate the header, and make sure the tables fit in the file
+	pHeader = (const IndexHeader*)pData;
+	nExpected = sizeof(IndexHeader) +
+		(qint64)pHeader->nSymbols * sizeof(IndexSymbol) +
+		(qint64)pHeader->nPostings * sizeof(Posting) +
+		((qint64)pHeader->nFiles + pHeader->nFuncs + pHeader->nMacros) *
+		sizeof(Scope) + pHeader->nPool;
+	if ((pHeader->nMagic != CSCOPE_INDEX_MAGIC) ||
+		(pHeader->nVersion != CSCOPE_INDEX_VERSION) ||
+		(pHeader->nSize != (quint32)m_file.size()) ||
+		(pHeader->nTime != (quint32)m_dtModified.toTime_t()) ||
+		(nExpected != nSize) || (pHeader->nPool == 0) ||
+		(pData[nSize - 1] != 0)) {
+		return false;
+	}
+
+	m_pIndex = pData;
+	m_pIndexHeader = pHeader;
+	m_pSymbols = (const IndexSymbol*)(pData + sizeof(IndexHeader));
+	m_pPostings = (const Posting*)(m_pSymbols + pHeader->nSymbols);
+	m_pFiles = (const Scope*)(m_pPostings + pHeader->nPostings);
+	m_pFuncs = m_pFiles + pHeader->nFiles;
+	m_pMacros = m_pFuncs + pHeader->nFuncs;
+	m_pPool = (const char*)(m_pMacros + pHeader->nMacros);
+	return true;
+}
+
+/**
+ * Builds an index of all symbols in the cross-reference file.
+ * Also records the positions at which files, functions and macros begin and
+ * end, so that the scope of each line can be determined without reading the
+ * lines that precede it.
+ * @param	baIndex	Holds the contents of the index file, upon return
+ */
+void CscopeDatabase::buildIndex(QByteArray& baIndex)
+{
+	QHash<QByteArray, QVector<Posting> > hashPostings;
+	QHash<QByteArray, quint32> hashStrings;
+	QList<QByteArray> lstNames;
+	QVector<IndexSymbol> vecSymbols;
+	QVector<Posting> vecPostings;
+	QVector<Scope> vecFiles, vecFuncs, vecMacros;
+	QByteArray baPool;
+	IndexHeader header;
+	IndexSymbol symbol;
+	Line line;
+	QByteArray baFile, baName;
+	Scope scope;
+	quint32 nPos, nEmpty;
+	Posting posting;
+	Entry entry;
+	int i, j;
+
+	nEmpty = addString(QByteArray(""), baPool, hashStrings);
+
+	nPos = m_nStart;
+	while ((entry = next(nPos, line, baFile)) != EndOfFile) {
+		if (entry == NewFile) {
+			// A new file resets the function and macro scopes
+			scope.nOffset = nPos;
+			scope.nName = addString(baFile, baPool, hashStrings);
+			vecFiles.append(scope);
+
+			scope.nName = nEmpty;
+			vecFuncs.append(scope);
+			vecMacros.append(scope);
+			continue;
+		}
+
+		// Add all symbols on this line to the index, and record the scopes
+		// which begin on this line
+		posting.nLine = line.nStart;
+		for (i = 0; i < line.vecSymbols.size(); i++) {
+			const Symbol& sym = line.vecSymbols[i];
+
+			if ((sym.nLength == 0) || (sym.cMark == MARK_INCLUDE))
+				continue;
+
+			getSymbol(sym, baName);
+			posting.nMark = (uchar)sym.cMark;
+			hashPostings[baName].append(posting);
+
+			if ((sym.cMark == MARK_FCNDEF) || (sym.cMark == MARK_DEFINE)) {
+				scope.nOffset = line.nStart;
+				scope.nName = addString(baName, baPool, hashStrings);
+				if (sym.cMark == MARK_FCNDEF)
+					vecFuncs.append(scope);
+				else
+					vecMacros.append(scope);
+			}
+		}
+
+		// Record the scopes which end on this line (applying to the lines
+		// that follow)
+		for (i = 0; i < line.vecSymbols.size(); i++) {
+			scope.nOffset = line.nStart + 1;
+			scope.nName = nEmpty;
+			if (line.vecSymbols[i].cMark == MARK_FCNEND)
+				vecFuncs.append(scope);
+			else if (line.vecSymbols[i].cMark == MARK_DEFINEEND)
+				vecMacros.append(scope);
+		}
+	}
+
+	// Order the symbols by name, and list the occurrences of each symbol
+	// (already ordered by position) together
+	lstNames = hashPostings.keys();
+	qSort(lstNames);
+	vecSymbols.reserve(lstNames.count());
+	for (i = 0; i < lstNames.count(); i++) {
+		const QVector<Posting>& vecSymPostings = hashPostings[lstNames[i]];
+
+		symbol.nName = addString(lstNames[i], baPool, hashStrings);
+		symbol.nFirst = vecPostings.size();
+		symbol.nCount = vecSymPostings.size();
+		symbol.nDefined = 0;
+		for (j = 0; j < vecSymPostings.size(); j++) {
+			if ((vecSymPostings[j].nMark != 0) &&
+				(strchr(DEF_MARKS, (char)vecSymPostings[j].nMark) != NULL)) {
+				symbol.nDefined = 1;
+				break;
+			}
+		}
+
+		vecSymbols.append(symbol);
+		vecPostings += vecSymPostings;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.nMagic = CSCOPE_INDEX_MAGIC;
+	header.nVersion = CSCOPE_INDEX_VERSION;
+	header.nSize = (quint32)m_file.size();
+	header.nTime = (quint32)m_dtModified.toTime_t();
+	header.nSymbols = vecSymbols.size();
+	header.nPostings = vecPostings.size();
+	header.nFiles = vecFiles.size();
+	header.nFuncs = vecFuncs.size();
+	header.nMacros = vecMacros.size();
+	header.nPool = baPool.size();
+
+	baIndex.resize(0);
+	baIndex.append((const char*)&header, sizeof(header));
+	baIndex.append((const char*)vecSymbols.constData(),
+		vecSymbols.size() * sizeof(IndexSymbol));
+	baIndex.append((const char*)vecPostings.constData(),
+		vecPostings.size() * sizeof(Posting));
+	baIndex.append((const char*)vecFiles.constData(),
+		vecFiles.size() * sizeof(Scope));
+	baIndex.append((const char*)vecFuncs.constData(),
+		vecFuncs.size() * sizeof(Scope));
+	baIndex.append((const char*)vecMacros.constData(),
+		vecMacros.size() * sizeof(Scope));
+	baIndex.append(baPool);
+}
+
+/**
+ * Adds a string to the pool of an index, unless it is already there.
+ * @param	baText		The string to add
+ * @param	baPool		The string pool
+ * @param	hashStrings	Maps the strings in the pool to their positions
+ * @return	The position of the string in the pool
+ */
+quint32 CscopeDatabase::addString(const QByteArray& baText,
+	QByteArray& baPool, QHash<QByteArray, quint32>& hashStrings)
+{
+	QHash<QByteArray, quint32>::ConstIterator itr;
+	quint32 nPos;
+
+	itr = hashStrings.find(baText);
+	if (itr != hashStrings.end())
+		return *itr;
+
+	nPos = baPool.size();
+	baPool.append(baText);
+	baPool.append('\0');
+	hashStrings.insert(baText, nPos);
+	return nPos;
+}
+
+/**
+ * Adds the names of all symbols in the file to the given table.
+ * The names are taken from the index, if one is used. Otherwise, the entire
+ * file is scanned.
+ * @param	hashSymbols	Maps each name to true if the symbol is defined,
+ *						false if it is only referenced (a symbol already
+ *						known to be defined remains so)
+ */
+void CscopeDatabase::addSymbols(QHash<QByteArray, bool>& hashSymbols)
+{
+	Line line;
+	QByteArray baFile, baName;
+	quint32 nPos;
+	Entry entry;
+	int i;
+
+	// The index is required by further queries anyway
+	if (m_bUseIndex && loadIndex()) {
+		for (nPos = 0; nPos < m_pIndexHeader->nSymbols; nPos++) {
+			bool& bDefined =
+				hashSymbols[QByteArray(m_pPool + m_pSymbols[nPos].nName)];
+			if (!bDefined)
+				bDefined = (m_pSymbols[nPos].nDefined != 0);
+		}
+
+		return;
+	}
+
+	nPos = m_nStart;
+	while ((entry = next(nPos, line, baFile)) != EndOfFile) {
+		if (entry == NewFile)
+			continue;
+
+		for (i = 0; i < line.vecSymbols.size(); i++) {
+			const Symbol& sym = line.vecSymbols[i];
+
+			if ((sym.nLength == 0) || (sym.cMark == MARK_INCLUDE))
+				continue;
+
+			getSymbol(sym, baName);
+			bool& bDefined = hashSymbols[baName];
+			if (!bDefined) {
+				bDefined = (sym.cMark != 0) &&
+					(strchr(DEF_MARKS, sym.cMark) != NULL);
+			}
+		}
+	}
+}
+
+/**
+ * Orders postings by their position in the file.
+ * @param	post1	The first posting
+ * @param	post2	The second posting
+ * @return	true if the first posting precedes the second, false otherwise
+ */
+bool CscopeDatabase::postingLessThan(const Posting& post1,
+	const Posting& post2)
+{
+	return post1.nLine < post2.nLine;
+}
+
+/**
+ * Runs a query using the symbol index.
+ * The index is loaded (or built) on the first query.
+ * @param	nType		The type of query
+ * @param	baText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	baOutput	Output buffer for query records
+ * @param	nRecords	The number of records in the output buffer
+ */
+void CscopeDatabase::lookup(uint nType, const QByteArray& baText, bool bCase,
+	QByteArray& baOutput, uint& nRecords)
+{
+	const IndexSymbol* pSymbol;
+	QVector<Posting> vecPostings;
+	const char* szName;
+	const char* szFunc;
+	QByteArray baFile;
+	Line line;
+	quint32 nPrev, j;
+	int i;
+
+	if (!loadIndex()) {
+		scan(nType, baText, bCase, baOutput, nRecords);
+		return;
+	}
+
+	// Collect the occurrences of all matching symbols
+	if (bCase) {
+		pSymbol = findSymbol(baText);
+		for (j = 0; (pSymbol != NULL) && (j < pSymbol->nCount); j++)
+			vecPostings.append(m_pPostings[pSymbol->nFirst + j]);
+	}
+	else {
+		for (pSymbol = m_pSymbols; pSymbol <
+			m_pSymbols + m_pIndexHeader->nSymbols; pSymbol++) {
+			szName = m_pPool + pSymbol->nName;
+			if ((qstrlen(szName) != (uint)baText.size()) ||
+				(qstrnicmp(szName, baText.constData(), baText.size()) != 0)) {
+				continue;
+			}
+
+			for (j = 0; j < pSymbol->nCount; j++)
+				vecPostings.append(m_pPostings[pSymbol->nFirst + j]);
+		}
+
+		// Different symbols may appear on the same lines
+		qSort(vecPostings.begin(), vecPostings.end(), postingLessThan);
+	}
+
+	// Handle every line on which a symbol appears with the requested type
+	for (i = 0, nPrev = 0; i < vecPostings.size(); i++) {
+		const Posting& posting = vecPostings[i];
+
+		switch (nType) {
+		case CscopeFrontend::Definition:
+			if ((posting.nMark == 0) ||
+				(strchr(DEF_MARKS, (char)posting.nMark) == NULL)) {
+				continue;
+			}
+			break;
+
+		case CscopeFrontend::Called:
+			if (posting.nMark != (uchar)MARK_FCNDEF)
+				continue;
+			break;
+
+		case CscopeFrontend::Calling:
+			if (posting.nMark != (uchar)MARK_FCNCALL)
+				continue;
+			break;
+		}
+
+		// Report each line once (a line is never at position 0, which holds
+		// the header)
+		if (posting.nLine == nPrev)
+			continue;
+
+		nPrev = posting.nLine;
+		baFile = getScope(m_pFiles, m_pIndexHeader->nFiles, nPrev);
+
+		// Skip files covered by the delta
+		if (isMasked(baFile))
+			continue;
+
+		if (nType == CscopeFrontend::Called) {
+			scanCalled(nPrev, baFile, baOutput, nRecords);
+			continue;
+		}
+
+		if (!parseLine(nPrev, line))
+			continue;
+
+		// Get the function or macro to which the line belongs
+		szFunc = getScope(m_pMacros, m_pIndexHeader->nMacros, nPrev);
+		if (*szFunc == 0)
+			szFunc = getScope(m_pFuncs, m_pIndexHeader->nFuncs, nPrev);
+
+		evaluate(nType, line, baFile, QByteArray((*szFunc == 0) ?
+			GLOBAL_NAME : szFunc), baText, bCase, baOutput, nRecords);
+	}
+}
+
+/**
+ * Compares two query records by file name and line number.
+ * @param	baRec1	The first record
+ * @param	baRec2	The second record
+ * @return	true if the first record should be placed before the second
+ */
+bool CscopeDatabase::recordLessThan(const QByteArray& baRec1,
+	const QByteArray& baRec2)
+{
+	int nLen1, nLen2, nResult;
+
+	// Compare file names
+	nLen1 = baRec1.indexOf(' ');
+	nLen2 = baRec2.indexOf(' ');
+	nResult = memcmp(baRec1.constData(), baRec2.constData(),
+		qMin(nLen1, nLen2));
+	if (nResult != 0)
+		return nResult < 0;
+
+	if (nLen1 != nLen2)
+		return nLen1 < nLen2;
+
+	// Compare line numbers (following the function name)
+	nLen1 = baRec1.indexOf(' ', nLen1 + 1);
+	nLen2 = baRec2.indexOf(' ', nLen2 + 1);
+	return atoi(baRec1.constData() + nLen1 + 1) <
+		atoi(baRec2.constData() + nLen2 + 1);
+}
+
+/**
+ * Orders query records by file name and line number.
+ * Used to merge the results of several databases (either read in-process, or
+ * by Cscope processes querying the shards of a project.)
+ * Does not access any database, and so can be called from any thread.
+ * @param	baOutput	The records, one per line
+ */
+void CscopeDatabase::sortRecords(QByteArray& baOutput)
+{
+	QList<QByteArray> lstRecords;
+	QList<QByteArray>::ConstIterator itr;
+
+	// The last record ends with a newline
+	lstRecords = baOutput.split('\n');
+	lstRecords.removeLast();
+
+	qStableSort(lstRecords.begin(), lstRecords.end(), recordLessThan);
+
+	baOutput.resize(0);
+	for (itr = lstRecords.begin(); itr != lstRecords.end(); ++itr) {
+		baOutput += *itr;
+		baOutput += '\n';
+	}
+}
+
+/**
+ * Writes a query record, in the format used by "cscope -L".
+ * @param	baFile		The file name
+ * @param	baFunc		The function name
+ * @param	nLine		The line number
+ * @param	baText		The line's text
+ * @param	baOutput	Output buffer for query records
+ * @param	nRecords	The number of records in the output buffer
+ */
+void CscopeDatabase::addRecord(const QByteArray& baFile,
+	const QByteArray& baFunc, uint nLine, const QByteArray& baText,
+	QByteArray& baOutput, uint& nRecords)
+{
+	baOutput += baFile;
+	baOutput += ' ';
+	baOutput += baFunc;
+	baOutput += ' ';
+	baOutput += QByteArray::number(nLine);
+	baOutput += ' ';
+	baOutput += baText;
+	baOutput += '\n';
+
+	nRecords++;
+}
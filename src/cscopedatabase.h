@@ -0,0 +1,300 @@
+#ifndef CSCOPEDATABASE_H
+#define CSCOPEDATABASE_H
+
+#include <qfile.h>
+#include <qhash.h>
+#include <qvector.h>
+#include <qbytearray.h>
+#include <qdatetime.h>
+#include <qset.h>
+#include <qlist.h>
+#include <qstringlist.h>
+
+/** The name of the database built for files modified since the project's
+	database was last built. */
+#define CSCOPE_DELTA_FILE "cscope.delta.out"
+
+/** Appended to the name of a cross-reference file to get the name of its
+	symbol index. */
+#define CSCOPE_INDEX_SUFFIX ".idx"
+
+/** Identifies the format of a symbol index file. */
+#define CSCOPE_INDEX_MAGIC 0x4b535349
+
+/** The version of the symbol index file format. */
+#define CSCOPE_INDEX_VERSION 1
+
+/**
+ * Answers Cscope queries by reading the project's cross-reference file
+ * directly, without running a Cscope process.
+ * The cscope.out file is mapped into memory, and its records (including the
+ * digraph and keyword compression used by default) are decoded in-process.
+ * Only symbol queries (references, definitions and function calls) are
+ * handled. Other queries, as well as symbol queries using regular
+ * expressions, are still served by Cscope.
+ * If the project uses an inverted index, an index of all symbols in the
+ * file is used, so that queries only read the lines on which the requested
+ * symbol appears. Otherwise, each query scans the entire file, similar to the
+ * way Cscope does. The index is built on the first query, and is written
+ * next to the cross-reference file (with the CSCOPE_INDEX_SUFFIX suffix), so
+ * that it is only built again once the cross-reference file changes. The
+ * index file holds the following tables, following a header:
+ * - Symbols: the name of each symbol, the range of its occurrences in the
+ *   occurrence table and whether it is defined, ordered by name
+ * - Occurrences: the position of the line and the type of each occurrence
+ * - Scopes: the positions at which files, functions and macros begin and end
+ * - A pool of NULL-terminated strings, holding the names of the symbols and
+ *   the scopes
+ * The databases are not thread-safe. All queries are run by a single thread
+ * (@see CscopeWorker), so that reading the databases does not block the
+ * GUI.
+ * Files saved since the database was last built are covered by a small
+ * database, built for these files only (the "delta"). Entries of these files
+ * in the project's database are ignored, and are replaced by those found in
+ * the delta.
+ * A project built in shards (@see CscopeShards) has a database for each
+ * shard. Queries are run on all of them, and the results are merged by file
+ * name and line number.
+ * @author Elad Lahav
+ */
+class CscopeDatabase
+{
+public:
+	~CscopeDatabase();
+
+	static bool load(const QString&, const QStringList&, bool);
+	static void reset();
+	static bool setDelta(const QString&, const QStringList&);
+	static bool supports(uint, const QString&);
+	static bool query(uint, const QString&, bool, QByteArray&, uint&);
+	static bool getSymbols(QHash<QByteArray, bool>&);
+	static void sortRecords(QByteArray&);
+
+private:
+	CscopeDatabase(bool);
+
+	/**
+	 * The types of entries in the cross-reference file.
+	 */
+	enum Entry { SourceLine, NewFile, EndOfFile };
+
+	/**
+	 * A symbol on a source line.
+	 */
+	struct Symbol
+	{
+		/** The type of the symbol (0 for a plain reference). */
+		char cMark;
+
+		/** The position of the symbol's (encoded) name in the file. */
+		quint32 nOffset;
+
+		/** The length of the encoded name. */
+		int nLength;
+	};
+
+	/**
+	 * A source line, as stored in the cross-reference file.
+	 */
+	struct Line
+	{
+		/** The position of the line in the file. */
+		quint32 nStart;
+
+		/** The line number. */
+		uint nLine;
+
+		/** The position of the line's text in the file. */
+		quint32 nText;
+
+		/** The position of the line's terminator. */
+		quint32 nTextEnd;
+
+		/** The position following the line. */
+		quint32 nEnd;
+
+		/** The symbols on the line. */
+		QVector<Symbol> vecSymbols;
+	};
+
+	/**
+	 * The header of the index file.
+	 */
+	struct IndexHeader
+	{
+		/** Should be CSCOPE_INDEX_MAGIC. */
+		quint32 nMagic;
+
+		/** Should be CSCOPE_INDEX_VERSION. */
+		quint32 nVersion;
+
+		/** The size of the cross-reference file when it was indexed. */
+		quint32 nSize;
+
+		/** The modification time of the cross-reference file when it was
+			indexed. */
+		quint32 nTime;
+
+		/** The number of entries in the symbol table. */
+		quint32 nSymbols;
+
+		/** The number of entries in the occurrence table. */
+		quint32 nPostings;
+
+		/** The number of file scopes. */
+		quint32 nFiles;
+
+		/** The number of function scopes. */
+		quint32 nFuncs;
+
+		/** The number of macro scopes. */
+		quint32 nMacros;
+
+		/** The size of the string pool. */
+		quint32 nPool;
+	};
+
+	/**
+	 * An entry in the symbol table of the index.
+	 */
+	struct IndexSymbol
+	{
+		/** The position of the symbol's (decoded) name in the string
+			pool. */
+		quint32 nName;
+
+		/** The index of the symbol's first occurrence. */
+		quint32 nFirst;
+
+		/** The number of occurrences of the symbol. */
+		quint32 nCount;
+
+		/** 1 if any occurrence defines the symbol, 0 otherwise. */
+		quint32 nDefined;
+	};
+
+	/**
+	 * An occurrence of a symbol, stored in the index.
+	 */
+	struct Posting
+	{
+		/** The position of the source line in the file. */
+		quint32 nLine;
+
+		/** The type of the symbol. */
+		quint32 nMark;
+	};
+
+	/**
+	 * A change of scope (a new file, or the beginning or end of a function
+	 * or a macro.)
+	 */
+	struct Scope
+	{
+		/** The position in the file from which the scope applies. */
+		quint32 nOffset;
+
+		/** The position in the string pool of the name of the file,
+			function or macro (of an empty string at the end of a function
+			or macro.) */
+		quint32 nName;
+	};
+
+	/** The cross-reference file. */
+	QFile m_file;
+
+	/** The time at which the file was last modified when mapped. */
+	QDateTime m_dtModified;
+
+	/** The mapped contents of the file. */
+	const char* m_pData;
+
+	/** The position of the first source file in the mapped data. */
+	quint32 m_nStart;
+
+	/** The size of the cross-reference part of the file (that is, up to
+		the trailer). */
+	quint32 m_nSize;
+
+	/** true if text is compressed, false if the database was built with
+		the "-c" option. */
+	bool m_bCompressed;
+
+	/** true to use an index of symbols. */
+	bool m_bUseIndex;
+
+	/** The index file. */
+	QFile m_fileIndex;
+
+	/** The contents of an index that could not be written to (or mapped
+		from) the index file. */
+	QByteArray m_baIndex;
+
+	/** The contents of the index, NULL if it was not loaded yet. */
+	const char* m_pIndex;
+
+	/** The header of the index. */
+	const IndexHeader* m_pIndexHeader;
+
+	/** The symbol table of the index, ordered by name. */
+	const IndexSymbol* m_pSymbols;
+
+	/** The occurrence table of the index, ordered by symbol, and by position
+		for each symbol. */
+	const Posting* m_pPostings;
+
+	/** The source files, by position in the file. */
+	const Scope* m_pFiles;
+
+	/** Function scopes, by position in the file. */
+	const Scope* m_pFuncs;
+
+	/** Macro scopes, by position in the file. */
+	const Scope* m_pMacros;
+
+	/** The string pool of the index. */
+	const char* m_pPool;
+
+	/** A buffer used for decoding symbol names. */
+	QByteArray m_baSymbol;
+
+	/** The databases of the current project (one for each shard, if the
+		project is built in shards), empty if not loaded. */
+	static QList<CscopeDatabase*> s_lstDatabases;
+
+	/** The database of modified files, NULL if there is none. */
+	static CscopeDatabase* s_pDelta;
+
+	/** The (encoded) paths of the files covered by the delta. */
+	static QSet<QByteArray> s_setDeltaFiles;
+
+	bool open(const QString&);
+	void run(uint, const QByteArray&, bool, QByteArray&, uint&);
+	bool isMasked(const QByteArray&) const;
+	bool loadIndex();
+	bool mapIndex(const char*, qint64);
+	void buildIndex(QByteArray&);
+	void addSymbols(QHash<QByteArray, bool>&);
+	Entry next(quint32&, Line&, QByteArray&) const;
+	bool parseLine(quint32, Line&) const;
+	void decode(const char*, int, QByteArray&, bool) const;
+	void getSymbol(const Symbol&, QByteArray&) const;
+	QByteArray getText(const Line&) const;
+	const char* getScope(const Scope*, quint32, quint32) const;
+	const IndexSymbol* findSymbol(const QByteArray&) const;
+	bool match(const Symbol&, const QByteArray&, bool);
+	void evaluate(uint, const Line&, const QByteArray&, const QByteArray&,
+		const QByteArray&, bool, QByteArray&, uint&);
+	void scanCalled(quint32, const QByteArray&, QByteArray&, uint&);
+	void scan(uint, const QByteArray&, bool, QByteArray&, uint&);
+	void lookup(uint, const QByteArray&, bool, QByteArray&, uint&);
+
+	static bool postingLessThan(const Posting&, const Posting&);
+	static quint32 addString(const QByteArray&, QByteArray&,
+		QHash<QByteArray, quint32>&);
+	static bool recordLessThan(const QByteArray&, const QByteArray&);
+	static void addRecord(const QByteArray&, const QByteArray&, uint,
+		const QByteArray&, QByteArray&, uint&);
+};
+
+#endif
@@ -1,24 +1,31 @@
 #include <qfileinfo.h>
 #include <qtimer.h>
+#include <qthread.h>
 #include <kconfig.h>
 #include <kmessagebox.h>
 #include <klocale.h>
 #include <kglobalsettings.h>
 #include "cscopefrontend.h"
+#include "cscopesession.h"
+#include "cscopedatabase.h"
+#include "cscopeworker.h"
+#include "cscopeshards.h"
+#include "cscopecache.h"
 #include "kscopeconfig.h"
 #include "configfrontend.h"
 
 #include <Plasma/Theme>
 
-#define BUILD_STR		"Building symbol database %d of %d"
-#define SEARCH_STR		"Search %d of %d"
-#define INV_STR			"Possible references retrieved %d of %d"
-#define REGEXP_STR		"Symbols matched %d of %d"
-#define SEARCHEND_STR	"%d lines"
+#define BUILD_STR		"Building symbol database "
+#define SEARCH_STR		"Search "
+#define INV_STR			"Possible references retrieved "
+#define REGEXP_STR		"Symbols matched "
+#define PROGRESS_SEP	" of "
 
 QString CscopeFrontend::s_sProjPath;
 uint CscopeFrontend::s_nProjArgs;
 uint CscopeFrontend::s_nSupArgs;
+QHash<QString, CscopeFrontend*> CscopeFrontend::s_hashRunning;
 
 /**
  * Class constructor.
@@ -29,8 +36,23 @@ CscopeFrontend::CscopeFrontend(bool bAutoDelete) :
 	Frontend(CSCOPE_RECORD_SIZE, bAutoDelete),
 	m_state(Unknown),
 	m_sErrMsg(""),
-	m_bRebuildOnExit(false)
+	m_bRebuildOnExit(false),
+	m_bSessionQuery(false),
+	m_bNativeQuery(false),
+	m_bQueryKilled(false),
+	m_bQueryPending(false),
+	m_bBackground(false),
+	m_nWorkerJob(0),
+	m_nGeneration(0),
+	m_bCollect(false),
+	m_pLeader(NULL),
+	m_nQueryShardsLeft(0),
+	m_bQueryShardFailed(false),
+	m_nShardsLeft(0)
 {
+	// Collect query records for the cache and for waiting objects
+	connect(this, SIGNAL(dataReady(const FrontendBatch&)), this,
+		SLOT(slotCollectRecords(const FrontendBatch&)));
 }
 
 /**
@@ -38,17 +60,27 @@ CscopeFrontend::CscopeFrontend(bool bAutoDelete) :
  */
 CscopeFrontend::~CscopeFrontend()
 {
+	// Make sure the session does not deliver records to a deleted object,
+	// and that waiting objects run their own queries
+	cancelQuery();
+		
+	// Stop building shards
+	qDeleteAll(m_lstShards);
 }
 
 /**
- * Executes a Cscope process using the given command line arguments.
- * The full path to the Cscope executable should be set in the "Path" key
- * under the "Cscope" group.
- * @param	slArgs	Command line arguments for Cscope
- * @return	true if successful, false otherwise
+ * Creates a complete Cscope command line.
+ * Adds the path to the Cscope executable and the project-specific options to
+ * the given arguments.
+ * @param	slArgs		Command line arguments for Cscope
+ * @param	bVerbose	true to use verbose mode (if supported), false
+ *						otherwise
+ * @param	bInvIndex	(Optional) false to ignore the project's inverted
+ *						index option
+ * @return	The full command line
  */
-
-bool CscopeFrontend::run(const QStringList& slArgs)
+QStringList CscopeFrontend::getCmdLine(const QStringList& slArgs,
+	bool bVerbose, bool bInvIndex)
 {
 	QStringList slCmdLine;
 
@@ -57,19 +89,35 @@ bool CscopeFrontend::run(const QStringList& slArgs)
 	slCmdLine += slArgs;
 	
 	// Use verbose mode, if supported
-	if (s_nSupArgs & VerboseOut)
+	if (bVerbose && (s_nSupArgs & VerboseOut))
 		slCmdLine << "-v";
 		
 	// Project-specific options
 	if (s_nProjArgs & Kernel)
 		slCmdLine << "-k";
-	if (s_nProjArgs & InvIndex)
+	// Shards are queried in-process, which does not require Cscope's
+	// inverted index
+	if (bInvIndex && (s_nProjArgs & InvIndex) && !(s_nProjArgs & Sharded))
 		slCmdLine << "-q";
 	if (s_nProjArgs & NoCompression)
 		slCmdLine << "-c";
 	if (s_nProjArgs & s_nSupArgs & SlowPathDef)
 		slCmdLine << "-D";
-    return run("cscope", slCmdLine, s_sProjPath);
+
+	return slCmdLine;
+}
+
+/**
+ * Executes a Cscope process using the given command line arguments.
+ * The full path to the Cscope executable should be set in the "Path" key
+ * under the "Cscope" group.
+ * @param	slArgs	Command line arguments for Cscope
+ * @return	true if successful, false otherwise
+ */
+
+bool CscopeFrontend::run(const QStringList& slArgs)
+{
+    return run("cscope", getCmdLine(slArgs, true), s_sProjPath);
 }
 
 bool CscopeFrontend::run(const QString& sName, const QStringList& slArgs,
@@ -86,8 +134,11 @@ bool CscopeFrontend::run(const QString& sName, const QStringList& slArgs,
 
 /**
  * Executes a Cscope query.
- * A query is composed of a numeric type and a query text, which are written
- * to the stndard input of the currently running Cscope process.
+ * Queries whose results are found in the cache are answered immediately.
+ * Symbol queries are answered by reading the project's cross-reference file
+ * directly, if possible, using a separate thread (@see CscopeWorker). Other
+ * queries are served by the project's persistent Cscope session, if one is
+ * available. Otherwise, a new Cscope process is started for this query.
  * @param	nType		The type of query to run
  * @param	sText		The query's text
  * @param	bCase		true for case-sensitive queries, false otherwise
@@ -97,34 +148,313 @@ bool CscopeFrontend::run(const QString& sName, const QStringList& slArgs,
 void CscopeFrontend::query(uint nType, const QString& sText, bool bCase, 
 	uint nMaxRecords)
 {
-	QString sQuery;
-	QStringList slArgs;
+	CscopeFrontend* pLeader;
+	QByteArray baOutput;
+	uint nRecords;
+	
+	// A new query supersedes the one in progress
+	cancelQuery();
 	
 	m_nMaxRecords = nMaxRecords;
+	m_nQueryType = nType;
+	m_sQueryText = sText;
+	m_bQueryCase = bCase;
+	m_nGeneration = CscopeCache::getGeneration();
+	
+	// Use stored results, or read the database in-process, if possible
+	// The results are delivered once control returns to the event loop, so
+	// that callers receive them in the same order of events as with a
+	// process
+	if (CscopeCache::find(nType, sText, bCase, baOutput, nRecords) ||
+		CscopeDatabase::supports(nType, sText)) {
+		m_nRecords = 0;
+		m_bSessionQuery = false;
+		m_bNativeQuery = true;
+		emit progress(0, 1);
+		QTimer::singleShot(0, this, SLOT(slotNativeQuery()));
+		return;
+	}
+	
+	// Wait for an identical query run by another object, if there is one
+	pLeader = s_hashRunning.value(CscopeCache::getKey(nType, sText, bCase,
+		m_nGeneration));
+	if (pLeader != NULL) {
+		m_pLeader = pLeader;
+		pLeader->m_lstFollowers.append(this);
+		m_nRecords = 0;
+		emit progress(0, 1);
+		return;
+	}
+	
+	runExternal();
+}
+
+/**
+ * Stops the query in progress, without reporting its end.
+ * Used when a new query is made before the previous one has completed.
+ */
+void CscopeFrontend::cancelQuery()
+{
+	// Stop waiting for another object's query
+	if (m_pLeader != NULL) {
+		m_pLeader->m_lstFollowers.removeAll(this);
+		m_pLeader = NULL;
+	}
+	
+	// A query answered in-process is discarded when its timer expires, or
+	// removed from the worker thread's queue
+	if (m_bNativeQuery) {
+		m_bNativeQuery = false;
+		m_nWorkerJob = 0;
+		CscopeWorker::cancel(this);
+	}
+	
+	if (m_bSessionQuery) {
+		m_bSessionQuery = false;
+		CscopeSession::cancel(this);
+	}
+	
+	// Kill the query process, without waiting for it to exit (a new process
+	// is started once it has, @see slotFinished())
+	stopShardQuery();
+	m_bQueryPending = false;
+	if ((state() != QProcess::NotRunning) && (m_state >= SearchSymbol)) {
+		blockSignals(true);
+		Frontend::kill();
+		blockSignals(false);
+		m_bQueryKilled = true;
+		m_state = Unknown;
+	}
+	
+	// Objects waiting for this query need to run it themselves
+	endQuery(false, 0);
+}
+
+/**
+ * Ends the collection of records for the current query.
+ * The results of a query that has completed are stored in the cache, and
+ * handed to all objects waiting for the same query. Otherwise, these objects
+ * run the query themselves.
+ * @param	bComplete	true if the query has completed, false if it was
+ *						stopped or has failed
+ * @param	nRecords	The number of records produced by the query
+ */
+void CscopeFrontend::endQuery(bool bComplete, uint nRecords)
+{
+	QList<CscopeFrontend*> lstFollowers;
+	QList<CscopeFrontend*>::ConstIterator itr;
+	QByteArray baOutput;
+	QString sKey;
+	
+	if (!m_bCollect)
+		return;
+	
+	m_bCollect = false;
+	baOutput = m_baRecords;
+	m_baRecords = QByteArray();
+	
+	// No longer accept waiting objects
+	sKey = CscopeCache::getKey(m_nQueryType, m_sQueryText, m_bQueryCase,
+		m_nGeneration);
+	if (s_hashRunning.value(sKey) == this)
+		s_hashRunning.remove(sKey);
+	
+	if (bComplete) {
+		CscopeCache::insert(m_nQueryType, m_sQueryText, m_bQueryCase,
+			m_nGeneration, baOutput, nRecords);
+	}
+	
+	// Note that a waiting object may start a new query in response
+	lstFollowers = m_lstFollowers;
+	m_lstFollowers.clear();
+	for (itr = lstFollowers.begin(); itr != lstFollowers.end(); ++itr) {
+		(*itr)->m_pLeader = NULL;
+		if (bComplete) {
+			(*itr)->m_bNativeQuery = true;
+			(*itr)->deliver(baOutput, nRecords);
+		}
+		else {
+			(*itr)->query((*itr)->m_nQueryType, (*itr)->m_sQueryText,
+				(*itr)->m_bQueryCase, (*itr)->m_nMaxRecords);
+		}
+	}
+}
+
+/**
+ * Runs the current query in a Cscope process.
+ * The query is written to the persistent session, if possible, or otherwise
+ * executed by a new process.
+ */
+void CscopeFrontend::runExternal()
+{
+	// Collect the records, and let other objects making the same query wait
+	// for this one
+	m_bCollect = true;
+	m_baRecords.resize(0);
+	s_hashRunning.insert(CscopeCache::getKey(m_nQueryType, m_sQueryText,
+		m_bQueryCase, m_nGeneration), this);
+	
+	// Write the query to the persistent session, if possible (background
+	// queries should not delay those made by the user)
+	if (!m_bBackground && CscopeSession::query(this, m_nQueryType,
+		m_sQueryText, m_bQueryCase)) {
+		m_nRecords = 0;
+		m_bSessionQuery = true;
+		emit progress(0, 1);
+		return;
+	}
+	
+	m_bSessionQuery = false;
+	runQuery();
+}
+
+/**
+ * Runs the current query in a new Cscope process.
+ * For projects built in shards, the query is run on all shards at once, each
+ * in a separate process. The records found in all shards are ordered by file
+ * name and line number once all processes have exited (@see
+ * slotShardQueryFinished()).
+ */
+void CscopeFrontend::runQuery()
+{
+	QStringList slDatabases;
+	QStringList::ConstIterator itr;
+	CscopeFrontend* pShard;
+	
+	stopShardQuery();
+	if (s_nProjArgs & Sharded)
+		slDatabases = CscopeShards::getDatabases(s_sProjPath);
+	
+	// A single database is queried by this object's own process
+	if (slDatabases.count() < 2) {
+		startQuery(slDatabases.isEmpty() ? QString() : slDatabases.first());
+		emit progress(0, 1);
+		return;
+	}
+	
+	// Query the shards in parallel (the maximal number of records applies to
+	// the merged records)
+	m_baShardRecords.resize(0);
+	m_bQueryShardFailed = false;
+	for (itr = slDatabases.begin(); itr != slDatabases.end(); ++itr) {
+		pShard = new CscopeFrontend(true);
+		pShard->m_nQueryType = m_nQueryType;
+		pShard->m_sQueryText = m_sQueryText;
+		pShard->m_bQueryCase = m_bQueryCase;
+		pShard->m_nMaxRecords = 0;
+		connect(pShard, SIGNAL(dataReady(const FrontendBatch&)), this,
+			SLOT(slotShardRecords(const FrontendBatch&)));
+		connect(pShard, SIGNAL(error(const QString&)), this,
+			SIGNAL(error(const QString&)));
+		connect(pShard, SIGNAL(finished(uint)), this,
+			SLOT(slotShardQueryFinished()));
+		
+		pShard->startQuery(*itr);
+		if (pShard->state() == QProcess::NotRunning) {
+			delete pShard;
+			m_bQueryShardFailed = true;
+			continue;
+		}
+		
+		m_lstQueryShards.append(pShard);
+		m_nQueryShardsLeft++;
+	}
+	
+	if (m_nQueryShardsLeft == 0) {
+		endQuery(false, 0);
+		emit aborted();
+		return;
+	}
+	
+	emit progress(0, 1);
+}
+
+/**
+ * Starts a Cscope process for the current query.
+ * If the process of a cancelled query is still running, the new process is
+ * started once it exits.
+ * @param	sDatabase	The name of the cross-reference file to use, empty for
+ *						the project's default database
+ */
+void CscopeFrontend::startQuery(const QString& sDatabase)
+{
+	QStringList slArgs;
+	
+	if (m_bQueryKilled) {
+		m_bQueryPending = true;
+		m_sPendingDatabase = sDatabase;
+		return;
+	}
 	
 	// Create the Cscope command line
-	slArgs.append(QString("-L") + QString::number(nType));
-	slArgs.append(sText);
+	slArgs.append(QString("-L") + QString::number(m_nQueryType));
+	slArgs.append(m_sQueryText);
 	slArgs.append("-d");
-	if (!bCase)
+	if (!m_bQueryCase)
 		slArgs.append("-C");
+	if (!sDatabase.isEmpty())
+		slArgs << "-f" << sDatabase;
 		
 	run(slArgs);
 	
 	// Initialise stdout parsing
 	m_state = SearchSymbol;
 	m_delim = WSpace;
+}
 
-	emit progress(0, 1);
+/**
+ * Stops all processes running the current query on the shards of the
+ * project's database.
+ * The processes delete themselves once they exit.
+ */
+void CscopeFrontend::stopShardQuery()
+{
+	QList<CscopeFrontend*>::ConstIterator itr;
+	
+	for (itr = m_lstQueryShards.begin(); itr != m_lstQueryShards.end();
+		++itr) {
+		(*itr)->disconnect(this);
+		(*itr)->kill();
+	}
+	
+	m_lstQueryShards.clear();
+	m_nQueryShardsLeft = 0;
+	m_baShardRecords = QByteArray();
+}
+
+/**
+ * Determines the names of the cross-reference files of the current project,
+ * so that queries can be answered in-process.
+ * @return	The names of the files, relative to the project's directory
+ */
+QStringList CscopeFrontend::getDatabases()
+{
+	QStringList slNames;
+	
+	if (s_nProjArgs & Sharded)
+		slNames = CscopeShards::getDatabases(s_sProjPath);
+	else
+		slNames << "cscope.out";
+	
+	return slNames;
 }
 
 /**
  * Rebuilds the symbol database of the current project.
+ * For projects built in shards, only the shards holding the given files are
+ * rebuilt. Other projects are always rebuilt entirely.
+ * @param	slFiles	(Optional) the files that need to be indexed again, an
+ *					empty list to rebuild the entire database
  */
-void CscopeFrontend::rebuild()
+void CscopeFrontend::rebuild(const QStringList& slFiles)
 {
 	QStringList slArgs;
 	
+	if (s_nProjArgs & Sharded) {
+		rebuildShards(slFiles);
+		return;
+	}
+	
 	// If a process is already running, kill it start a new one
 	if (state() == QProcess::Running) {
 		m_bRebuildOnExit = true;
@@ -143,6 +473,140 @@ void CscopeFrontend::rebuild()
 	emit progress(0, 1);
 }
 
+/**
+ * Builds the shards of the project's database, each in a separate process.
+ * If all shards are rebuilt, the project's files are first divided into a
+ * shard for each available processor.
+ * @param	slFiles	The files whose shards need to be rebuilt, an empty list to
+ *					rebuild all shards
+ */
+void CscopeFrontend::rebuildShards(const QStringList& slFiles)
+{
+	QList<int> lstShards;
+	QStringList::ConstIterator itr;
+	CscopeFrontend* pShard;
+	int i, nShards;
+	
+	// If shards are being built, stop and start again once all processes
+	// have exited, including the interrupted shards
+	if (m_nShardsLeft > 0) {
+		if (!m_bRebuildOnExit)
+			m_slRebuildFiles = m_slBuildFiles;
+		
+		if (slFiles.isEmpty() || m_slRebuildFiles.isEmpty())
+			m_slRebuildFiles.clear();
+		else
+			m_slRebuildFiles += slFiles;
+		
+		m_bRebuildOnExit = true;
+		kill();
+		return;
+	}
+	
+	// Find the shards holding the given files
+	for (itr = slFiles.begin(); itr != slFiles.end(); ++itr) {
+		i = CscopeShards::find(s_sProjPath, *itr);
+		if (i < 0) {
+			lstShards.clear();
+			break;
+		}
+		
+		if (!lstShards.contains(i))
+			lstShards.append(i);
+	}
+	
+	// Divide all files into new shards, unless only some of the existing
+	// shards need to be rebuilt
+	if (lstShards.isEmpty()) {
+		nShards = CscopeShards::split(s_sProjPath,
+			QThread::idealThreadCount());
+		if (nShards == 0) {
+			emit aborted();
+			return;
+		}
+		
+		for (i = 0; i < nShards; i++)
+			lstShards.append(i);
+		
+		m_slBuildFiles.clear();
+	}
+	else {
+		m_slBuildFiles = slFiles;
+	}
+	
+	// Build the shards in parallel
+	// Until a process reports its progress, it counts as a single step
+	m_vecShardProgress.fill(0, lstShards.count());
+	m_vecShardTotal.fill(1, lstShards.count());
+	for (i = 0; i < lstShards.count(); i++) {
+		pShard = new CscopeFrontend();
+		connect(pShard, SIGNAL(progress(int, int)), this,
+			SLOT(slotShardProgress(int, int)));
+		connect(pShard, SIGNAL(error(const QString&)), this,
+			SIGNAL(error(const QString&)));
+		connect(pShard, SIGNAL(finished(uint)), this,
+			SLOT(slotShardFinished()));
+		
+		m_lstShards.append(pShard);
+		if (pShard->buildShard(lstShards[i]))
+			m_nShardsLeft++;
+	}
+	
+	if (m_nShardsLeft == 0) {
+		qDeleteAll(m_lstShards);
+		m_lstShards.clear();
+		emit aborted();
+		return;
+	}
+	
+	emit progress(0, 1);
+}
+
+/**
+ * Builds the database of a single shard.
+ * @param	nShard	The index of the shard
+ * @return	true if successful, false otherwise
+ */
+bool CscopeFrontend::buildShard(int nShard)
+{
+	QStringList slArgs;
+	
+	slArgs << "-b" << "-f" << CscopeShards::getDatabase(nShard) << "-i" <<
+		CscopeShards::getFileList(nShard);
+	if (!run(slArgs))
+		return false;
+	
+	// Initialise output parsing
+	m_state = BuildStart;
+	m_delim = Newline;
+	
+	return true;
+}
+
+/**
+ * Builds a database for the given files only.
+ * The database is written to a separate file, which is used to reflect the
+ * changes made to these files until the project's database is rebuilt
+ * (@see CscopeDatabase).
+ * @param	slFiles	The full paths of the files to include
+ */
+void CscopeFrontend::rebuildDelta(const QStringList& slFiles)
+{
+	QStringList slArgs;
+	
+	// An inverted index is not required for a few files
+	// Note that file names must follow all options on the command line
+	slArgs << "-b" << "-f" << CSCOPE_DELTA_FILE;
+	slArgs = getCmdLine(slArgs, false, false);
+	slArgs += slFiles;
+	if (!run("cscope", slArgs, s_sProjPath))
+		return;
+	
+	// There is no need to parse the output
+	m_state = Unknown;
+	m_delim = Newline;
+}
+
 /**
  * Sets default parameters for all CscopeFrontend projects based on the
  * current project.
@@ -153,6 +617,139 @@ void CscopeFrontend::init(const QString& sProjPath, uint nArgs)
 {
 	s_sProjPath = sProjPath;
 	s_nProjArgs = nArgs;
+	
+	// The persistent session and the loaded database belong to the previous
+	// settings
+	// Queries waiting for the session are aborted (any query made in
+	// response already uses the new settings)
+	CscopeSession::stop();
+	CscopeWorker::reset();
+	CscopeCache::invalidate();
+}
+
+/**
+ * Requests the names of all symbols in the database of the current project.
+ * The names are collected by a separate thread, and are posted to the given
+ * object as a CscopeWorkerEvent.
+ * @param	pReceiver	The object that receives the names
+ * @return	The serial number of the request, identifying the event
+ */
+uint CscopeFrontend::getSymbols(QObject* pReceiver)
+{
+	return CscopeWorker::getSymbols(pReceiver, s_sProjPath, getDatabases(),
+		(s_nProjArgs & InvIndex) != 0);
+}
+
+/**
+ * Converts a block of query records into lists of strings.
+ * Records for which Cscope does not report a function (i.e., global
+ * references) are given the function name "<global>".
+ * @param	batch		The block of records
+ * @param	lstRecords	Receives the records, each holding the function
+ *						name, file path, line number and line text (in this
+ *						order)
+ */
+void CscopeFrontend::getRecords(const FrontendBatch& batch,
+	QList<QStringList>& lstRecords)
+{
+	FrontendToken* pToken;
+	QString sFile, sFunc, sLine, sText;
+	int i;
+	
+	for (i = 0; i < batch.count(); i++) {
+		pToken = batch.at(i);
+		
+		// Get the file name
+		sFile = pToken->getData();
+		pToken = pToken->getNext();
+
+		// Get the function name
+		sFunc = pToken->getData();
+		pToken = pToken->getNext();
+
+		// Get the line number
+		if (!pToken->isNumber()) {
+			// Line number could not be 0!
+			// means that function name was empty
+			sLine = sFunc;
+			sFunc = "<global>";
+		}
+		else {
+			sLine = pToken->getData();
+			pToken = pToken->getNext();
+		}
+		
+		// Get the line's text
+		sText = pToken->getData();
+		
+		lstRecords.append(QStringList() << sFunc << sFile << sLine << sText);
+	}
+}
+
+/**
+ * Stops the current Cscope action.
+ * A query served by the persistent session is removed from the session's
+ * queue, and a query answered in-process (or by another object) is
+ * discarded. Any other action is stopped by killing the process (or all
+ * processes building shards.)
+ */
+void CscopeFrontend::kill()
+{
+	QList<CscopeFrontend*>::ConstIterator itr;
+	
+	if (m_nShardsLeft > 0) {
+		for (itr = m_lstShards.begin(); itr != m_lstShards.end(); ++itr)
+			(*itr)->kill();
+		
+		emit aborted();
+		return;
+	}
+	
+	// Let waiting objects run the query themselves
+	endQuery(false, 0);
+	
+	// The query did not start yet
+	if (m_bQueryPending) {
+		m_bQueryPending = false;
+		emit aborted();
+		emit finished(0);
+		return;
+	}
+	
+	if (m_nQueryShardsLeft > 0) {
+		stopShardQuery();
+		emit aborted();
+		emit finished(m_nRecords);
+		return;
+	}
+	
+	if (m_pLeader != NULL) {
+		m_pLeader->m_lstFollowers.removeAll(this);
+		m_pLeader = NULL;
+		emit aborted();
+		emit finished(m_nRecords);
+		return;
+	}
+	
+	if (m_bNativeQuery) {
+		m_bNativeQuery = false;
+		m_nWorkerJob = 0;
+		CscopeWorker::cancel(this);
+		Frontend::kill();
+		emit finished(m_nRecords);
+		return;
+	}
+	
+	if (!m_bSessionQuery) {
+		Frontend::kill();
+		return;
+	}
+	
+	m_bSessionQuery = false;
+	CscopeSession::cancel(this);
+	
+	emit aborted();
+	emit finished(m_nRecords);
 }
 
 /**
@@ -163,19 +760,395 @@ void CscopeFrontend::slotCancel()
 	kill();
 }
 
+/**
+ * Answers the current query from the cache, or submits it to the thread
+ * reading the project's cross-reference file.
+ * This slot is activated by a timer set when the query is made.
+ */
+void CscopeFrontend::slotNativeQuery()
+{
+	QByteArray baOutput;
+	uint nRecords;
+	
+	// Check whether the query was cancelled
+	if (!m_bNativeQuery || (m_nWorkerJob != 0))
+		return;
+	
+	// Use stored results, or run the query
+	if (CscopeCache::find(m_nQueryType, m_sQueryText, m_bQueryCase,
+		baOutput, nRecords)) {
+		deliver(baOutput, nRecords);
+		return;
+	}
+	
+	m_nWorkerJob = CscopeWorker::query(this, s_sProjPath, getDatabases(),
+		(s_nProjArgs & InvIndex) != 0, m_nQueryType, m_sQueryText,
+		m_bQueryCase, m_bBackground);
+}
+
+/**
+ * Handles the results of a query run by the thread reading the project's
+ * cross-reference file.
+ * If the database could not be read, the query is run by Cscope instead.
+ * @param	pEvent	The event
+ */
+void CscopeFrontend::customEvent(QEvent* pEvent)
+{
+	CscopeWorkerEvent* pWorkerEvent;
+	
+	if (pEvent->type() != CscopeWorkerEvent::eventTypeId) {
+		Frontend::customEvent(pEvent);
+		return;
+	}
+	
+	// Ignore the results of a cancelled query
+	pWorkerEvent = (CscopeWorkerEvent*)pEvent;
+	if (!m_bNativeQuery || (pWorkerEvent->m_nSerial != m_nWorkerJob))
+		return;
+	
+	m_nWorkerJob = 0;
+	if (!pWorkerEvent->m_bSuccess) {
+		m_bNativeQuery = false;
+		runExternal();
+		return;
+	}
+	
+	CscopeCache::insert(m_nQueryType, m_sQueryText, m_bQueryCase,
+		m_nGeneration, pWorkerEvent->m_baOutput,
+		pWorkerEvent->m_nRecords);
+	deliver(pWorkerEvent->m_baOutput, pWorkerEvent->m_nRecords);
+}
+
+/**
+ * Reports the results of a query that was not run by a process owned by this
+ * object (either answered in-process, or by another object.)
+ * @param	baOutput	The query's output, in the format of "cscope -L"
+ * @param	nRecords	The number of records in the output
+ */
+void CscopeFrontend::deliver(const QByteArray& baOutput, uint nRecords)
+{
+	// Abort if the number of records exceeds the requested maximum
+	if ((m_nMaxRecords > 0) && (nRecords > (uint)m_nMaxRecords)) {
+		m_bNativeQuery = false;
+		emit aborted();
+		emit finished(0);
+		return;
+	}
+	
+	// The output is in the same format as that of a Cscope process
+	// Note that the query may be cancelled while records are handled
+	m_state = File;
+	m_delim = WSpace;
+	parseOutput(baOutput);
+	m_state = Unknown;
+	
+	if (m_bNativeQuery) {
+		m_bNativeQuery = false;
+		emit finished(m_nRecords);
+	}
+}
+
+/**
+ * Copies the records of the current query, so that they can be stored in the
+ * cache once the query completes.
+ * This slot is connected to the dataReady() signal of this object.
+ * @param	batch	The block of records
+ */
+void CscopeFrontend::slotCollectRecords(const FrontendBatch& batch)
+{
+	if (m_bCollect)
+		appendRecords(batch, m_baRecords);
+}
+
+/**
+ * Stores the records found by a process querying a single shard, until the
+ * records of all shards can be merged.
+ * This slot is connected to the dataReady() signal of each such process.
+ * @param	batch	The block of records
+ */
+void CscopeFrontend::slotShardRecords(const FrontendBatch& batch)
+{
+	appendRecords(batch, m_baShardRecords);
+}
+
+/**
+ * Called when a process querying a single shard exits.
+ * Once all processes have exited, the records of all shards are ordered by
+ * file name and line number, and are reported as those of a single query.
+ */
+void CscopeFrontend::slotShardQueryFinished()
+{
+	CscopeFrontend* pShard;
+	QByteArray baOutput;
+	bool bComplete;
+	
+	pShard = (CscopeFrontend*)sender();
+	if (!m_lstQueryShards.contains(pShard))
+		return;
+	
+	// The process deletes itself once this slot returns
+	m_lstQueryShards.removeAll(pShard);
+	if ((pShard->exitStatus() != QProcess::NormalExit) ||
+		(pShard->exitCode() != 0)) {
+		m_bQueryShardFailed = true;
+	}
+	
+	if (--m_nQueryShardsLeft > 0)
+		return;
+	
+	baOutput = m_baShardRecords;
+	m_baShardRecords = QByteArray();
+	bComplete = !m_bQueryShardFailed;
+	CscopeDatabase::sortRecords(baOutput);
+	
+	// Abort if the number of records exceeds the requested maximum
+	if ((m_nMaxRecords > 0) && (baOutput.count('\n') > m_nMaxRecords)) {
+		endQuery(false, 0);
+		emit aborted();
+		emit finished(0);
+		return;
+	}
+	
+	// The merged output is parsed as if it was written by a single process
+	// Note that the query may be cancelled while records are handled
+	m_state = File;
+	m_delim = WSpace;
+	parseOutput(baOutput);
+	m_state = Unknown;
+	if (!m_bCollect)
+		return;
+	
+	endQuery(bComplete, m_nRecords);
+	emit finished(m_nRecords);
+}
+
+/**
+ * Writes records in the same format as the output of Cscope.
+ * @param	batch	The block of records
+ * @param	baOutput	Receives the records, one per line
+ */
+void CscopeFrontend::appendRecords(const FrontendBatch& batch,
+	QByteArray& baOutput)
+{
+	FrontendToken* pToken;
+	int i;
+	
+	for (i = 0; i < batch.count(); i++) {
+		for (pToken = batch.at(i); pToken != NULL;
+			pToken = pToken->getNext()) {
+			baOutput.append(pToken->getText(), pToken->getLength());
+			baOutput += (pToken->getNext() != NULL) ? ' ' : '\n';
+		}
+	}
+}
+
+/**
+ * Combines the progress of all shard-building processes.
+ * This slot is connected to the progress() signal of each such process.
+ * @param	nFiles	The number of files indexed by the process
+ * @param	nTotal	The number of files in the process's shard
+ */
+void CscopeFrontend::slotShardProgress(int nFiles, int nTotal)
+{
+	int i, nSumFiles, nSumTotal;
+	
+	i = m_lstShards.indexOf((CscopeFrontend*)sender());
+	if (i < 0)
+		return;
+	
+	m_vecShardProgress[i] = nFiles;
+	m_vecShardTotal[i] = nTotal;
+	
+	nSumFiles = 0;
+	nSumTotal = 0;
+	for (i = 0; i < m_lstShards.count(); i++) {
+		nSumFiles += m_vecShardProgress[i];
+		nSumTotal += m_vecShardTotal[i];
+	}
+	
+	emit progress(nSumFiles, nSumTotal);
+}
+
+/**
+ * Called when a shard-building process exits.
+ * Once all shards are built, the build is restarted if required, or
+ * otherwise reported as finished.
+ * This slot is connected to the finished() signal of each such process.
+ */
+void CscopeFrontend::slotShardFinished()
+{
+	QList<CscopeFrontend*>::ConstIterator itr;
+	QStringList slFiles;
+	
+	if (--m_nShardsLeft > 0)
+		return;
+	
+	// The processes are deleted once control returns to the event loop, as
+	// this slot is called by one of them
+	for (itr = m_lstShards.begin(); itr != m_lstShards.end(); ++itr)
+		(*itr)->deleteLater();
+	
+	m_lstShards.clear();
+	
+	// Restart the building process, if required
+	if (m_bRebuildOnExit) {
+		m_bRebuildOnExit = false;
+		slFiles = m_slRebuildFiles;
+		m_slRebuildFiles.clear();
+		rebuildShards(slFiles);
+		return;
+	}
+	
+	emit finished(0);
+}
+
+/**
+ * Called by the persistent session when the output of this object's query
+ * begins.
+ * @param	nRecords	The number of records in the query's output
+ * @return	true to receive the records, false if the query should be aborted
+ */
+bool CscopeFrontend::sessionAccept(uint nRecords)
+{
+	// Abort if the number of records exceeds the requested maximum
+	if ((m_nMaxRecords > 0) && (nRecords > (uint)m_nMaxRecords)) {
+		m_bSessionQuery = false;
+		endQuery(false, 0);
+		emit aborted();
+		emit finished(0);
+		return false;
+	}
+	
+	return true;
+}
+
+/**
+ * Called by the persistent session for every block of records produced by
+ * this object's query.
+ * @param	batch	The block of records
+ */
+void CscopeFrontend::sessionRecords(const FrontendBatch& batch)
+{
+	// Signal the query is complete on the first record (similar to the
+	// behaviour of a query run in a separate process)
+	if (m_nRecords == 0)
+		emit progress(1, 1);
+		
+	m_nRecords += batch.count();
+	emit dataReady(batch);
+}
+
+/**
+ * Called by the persistent session when this object's query has completed.
+ * @param	nRecords	The number of records delivered
+ */
+void CscopeFrontend::sessionFinished(uint nRecords)
+{
+	m_bSessionQuery = false;
+	endQuery(true, nRecords);
+	emit finished(nRecords);
+}
+
+/**
+ * Called when the persistent session terminates before this object's query
+ * has completed.
+ * If no records were delivered yet, the query is executed in a separate
+ * process. Otherwise, the query ends with the records received so far.
+ * @param	nRecords	The number of records delivered
+ */
+void CscopeFrontend::sessionFailed(uint nRecords)
+{
+	m_bSessionQuery = false;
+	
+	if (nRecords > 0) {
+		endQuery(false, 0);
+		emit finished(nRecords);
+		return;
+	}
+	
+	runQuery();
+}
+
+/**
+ * Called when the persistent session is stopped before this object's query
+ * has completed, since the project was closed (or its settings have
+ * changed.)
+ * The query is aborted, rather than run on the database of the new project,
+ * and so are the queries of objects waiting for it.
+ * @param	nRecords	The number of records delivered
+ */
+void CscopeFrontend::sessionAborted(uint nRecords)
+{
+	QList<CscopeFrontend*> lstFollowers;
+	QList<CscopeFrontend*>::ConstIterator itr;
+	
+	m_bSessionQuery = false;
+	
+	// Do not let waiting objects run the query themselves
+	lstFollowers = m_lstFollowers;
+	m_lstFollowers.clear();
+	endQuery(false, 0);
+	
+	for (itr = lstFollowers.begin(); itr != lstFollowers.end(); ++itr) {
+		(*itr)->m_pLeader = NULL;
+		(*itr)->sessionAborted(0);
+	}
+	
+	emit aborted();
+	emit finished(nRecords);
+}
+
+/**
+ * Reads a progress message in the format of "<Prefix>X of Y".
+ * @param	token		The token holding the message
+ * @param	szPrefix	The expected prefix of the message
+ * @param	nProgress	Holds the current progress value (X), upon successful
+ *						return
+ * @param	nTotal		Holds the final progress value (Y), upon successful
+ *						return
+ * @return	true if the token holds a progress message of the given type,
+ *			false otherwise
+ */
+static bool getProgress(const FrontendToken& token, const char* szPrefix,
+	int& nProgress, int& nTotal)
+{
+	int nPos, nEnd, nSepLen;
+	
+	if (!token.startsWith(szPrefix))
+		return false;
+		
+	// Get the current value
+	nPos = qstrlen(szPrefix);
+	nProgress = token.toInt(nPos, &nEnd);
+	if (nEnd == nPos)
+		return false;
+	
+	// Skip the separator
+	nSepLen = qstrlen(PROGRESS_SEP);
+	if ((token.getLength() - nEnd < nSepLen) ||
+		(memcmp(token.getText() + nEnd, PROGRESS_SEP, nSepLen) != 0)) {
+		return false;
+	}
+	
+	// Get the final value
+	nPos = nEnd + nSepLen;
+	nTotal = token.toInt(nPos, &nEnd);
+	return (nEnd > nPos);
+}
+
 /**
  * Parses the output of a Cscope process.
  * Implements a state machine, where states correspond to the output of the
  * controlled Cscope process.
- * @param	sToken	The current token read (the token delimiter is determined
+ * @param	token	The current token read (the token delimiter is determined
  *					by the current state)
  * @return	A value indicating the way this token should be treated: dropped,
  *			added to the token queue, or finishes a new record
  */
-Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
+Frontend::ParseResult CscopeFrontend::parseStdout(FrontendToken& token,
 	ParserDelim /* ignored */)
 {
-	int nFiles, nTotal, nRecords;
+	int nFiles, nTotal, nRecords, nEnd;
 	ParseResult result = DiscardToken;
 	ParserState stPrev;
 	
@@ -185,11 +1158,11 @@ Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
 	// Handle the token according to the current state
 	switch (m_state) {
 	case BuildStart:
-		if (sToken == "Building cross-reference...") {
+		if (token.isEqual("Building cross-reference...")) {
 			m_state = BuildSymbol;
 			m_delim = WSpace;
 		}
-		else if (sToken == "Building inverted index...") {
+		else if (token.isEqual("Building inverted index...")) {
 			emit buildInvIndex();
 		}
 		
@@ -199,7 +1172,7 @@ Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
 	case BuildSymbol:
 		// A single angle bracket is the prefix of a progress indication,
 		// while double brackets is Cscope's prompt for a new query
-		if (sToken == ">") {
+		if (token.isEqual(">")) {
 			m_state = Building;
 			m_delim = Newline;
 		}
@@ -209,7 +1182,7 @@ Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
 
 	case Building:
 		// Try to get building progress
-		if (sscanf(sToken.toLatin1(), BUILD_STR, &nFiles, &nTotal) == 2) {
+		if (getProgress(token, BUILD_STR, nFiles, nTotal)) {
 			emit progress(nFiles, nTotal);
 			
 			// Check for last progress message
@@ -232,13 +1205,13 @@ Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
 	case SearchSymbol:
 		// Check for more search progress, or the end of the search,
 		// designated by a line in the format of "cscope: X lines"
-		if (sToken == ">") {
+		if (token.isEqual(">")) {
 			m_state = Searching;
 			m_delim = Newline;
 			result = DiscardToken;
 			break;
 		}
-		else if (sToken == "cscope:") {
+		else if (token.isEqual("cscope:")) {
 			m_state = SearchEnd;
 			m_delim = Newline;
 			result = DiscardToken;
@@ -257,9 +1230,9 @@ Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
 
 	case Searching:
 		// Try to get the search progress value (ignore other messages)
-		if ((sscanf(sToken.toLatin1(), SEARCH_STR, &nFiles, &nTotal) == 2) ||
-			(sscanf(sToken.toLatin1(), INV_STR, &nFiles, &nTotal) == 2) ||
-			(sscanf(sToken.toLatin1(), REGEXP_STR, &nFiles, &nTotal) == 2)) {
+		if (getProgress(token, SEARCH_STR, nFiles, nTotal) ||
+			getProgress(token, INV_STR, nFiles, nTotal) ||
+			getProgress(token, REGEXP_STR, nFiles, nTotal)) {
 			emit progress(nFiles, nTotal);
 		}
 
@@ -270,8 +1243,8 @@ Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
 
 	case SearchEnd:
 		// Get the number of results found in this search
-		if ((sscanf(sToken.toLatin1(), SEARCHEND_STR, &nRecords) == 1) &&
-			(m_nMaxRecords > 0) &&
+		nRecords = token.toInt(0, &nEnd);
+		if ((nEnd > 0) && (m_nMaxRecords > 0) &&
 			(nRecords > m_nMaxRecords)) {
 			result = Abort;
 		}
@@ -285,7 +1258,7 @@ Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
 		
 	case Func:
 		// Treat the token as the name of the function in this record
-		if (sToken.toInt()) {
+		if (token.isNumber()) {
 			// In case of a global definition, there is no function name, and
 			// instead the line number is given immediately
 			m_state = LineText;
@@ -328,6 +1301,10 @@ Frontend::ParseResult CscopeFrontend::parseStdout(QString& sToken,
  */
 void CscopeFrontend::parseStderr(const QString& sText)
 {
+	// Ignore the messages of a cancelled query
+	if (m_bQueryKilled)
+		return;
+	
 	// Wait for a complete line to arrive
 	m_sErrMsg += sText;
 	if (!sText.endsWith("\n"))
@@ -343,10 +1320,23 @@ void CscopeFrontend::parseStderr(const QString& sText)
 /**
  * Called when the underlying process exits.
  * Checks if the rebuild flag was raised, and if so restarts the building
- * process.
+ * process. Once a build has ended, the persistent session is restarted.
  */
 void CscopeFrontend::finalize()
 {
+	// Hand the results of a complete query to the cache and to waiting
+	// objects
+	if (m_state >= SearchSymbol) {
+		endQuery((exitStatus() == QProcess::NormalExit) && (exitCode() == 0),
+			m_nRecords);
+	}
+	
+	// The persistent session needs to load a rebuilt database
+	if ((m_state >= BuildStart) && (m_state <= Building)) {
+		CscopeSession::restart();
+		CscopeWorker::reset();
+	}
+		
 	// Reset the parser state machine
 	m_state = Unknown;
 	
@@ -357,6 +1347,27 @@ void CscopeFrontend::finalize()
 	}
 }
 
+/**
+ * Called when the underlying process exits.
+ * The exit of a process killed when its query was cancelled is not reported.
+ * Instead, the process of the next query is started, if one is waiting.
+ * @param	nExitCode	The exit code of the process
+ * @param	status		Whether the process has exited normally
+ */
+void CscopeFrontend::slotFinished(int nExitCode, QProcess::ExitStatus status)
+{
+	if (!m_bQueryKilled) {
+		Frontend::slotFinished(nExitCode, status);
+		return;
+	}
+	
+	m_bQueryKilled = false;
+	if (m_bQueryPending) {
+		m_bQueryPending = false;
+		startQuery(m_sPendingDatabase);
+	}
+}
+
 /**
  * Class constructor.
  * @param	pMainWidget	The parent widget to use for the progress bar and
@@ -4,6 +4,9 @@
 #include <qstringlist.h>
 #include <qprogressbar.h>
 #include <qlabel.h>
+#include <qlist.h>
+#include <qvector.h>
+#include <qhash.h>
 
 #include "frontend.h"
 
@@ -43,12 +46,16 @@ public:
 	 * Some of these options are global, while some are project specific.
 	 */
 	enum Options { VerboseOut = 0x01, SlowPathDef = 0x02,
-		Kernel = 0x04, InvIndex = 0x08, NoCompression = 0x10 };
+		Kernel = 0x04, InvIndex = 0x08, NoCompression = 0x10, Sharded = 0x20 };
 
 	void query(uint, const QString&, bool bCase = true, uint nMaxRecords = 0);
-	void rebuild();
+	void rebuild(const QStringList& slFiles = QStringList());
+	void rebuildDelta(const QStringList&);
+	virtual void kill();
 	
 	static void init(const QString&, uint);
+	static void getRecords(const FrontendBatch&, QList<QStringList>&);
+	static uint getSymbols(QObject*);
 	
 	/**
 	 * @param	nArgs	The command-line arguments supported by the version of
@@ -56,9 +63,25 @@ public:
 	 */
 	static void setSupArgs(uint nArgs) { s_nSupArgs = nArgs; }
 	
+	/**
+	 * Marks the queries made by this object as background ones. Such
+	 * queries yield to all other queries answered in-process (@see
+	 * CscopeWorker), and do not occupy the persistent Cscope session.
+	 * @param	bBackground	true for background queries, false otherwise
+	 */
+	void setBackground(bool bBackground) { m_bBackground = bBackground; }
+	
 public slots:
 	void slotCancel();
 
+private slots:
+	void slotNativeQuery();
+	void slotCollectRecords(const FrontendBatch&);
+	void slotShardProgress(int, int);
+	void slotShardFinished();
+	void slotShardRecords(const FrontendBatch&);
+	void slotShardQueryFinished();
+
 signals:
 	/**
 	 * Emitted when Cscope starts building the inverted index.
@@ -66,9 +89,13 @@ signals:
 	void buildInvIndex();
 
 protected:
-	virtual ParseResult parseStdout(QString&, ParserDelim);
+	virtual ParseResult parseStdout(FrontendToken&, ParserDelim);
 	virtual void parseStderr(const QString&);
 	virtual void finalize();
+	virtual void customEvent(QEvent*);
+
+protected slots:
+	virtual void slotFinished(int, QProcess::ExitStatus);
 
 private:
 	/**
@@ -91,6 +118,99 @@ private:
 		The process aborts if this number if reached. */
 	int m_nMaxRecords;
 	
+	/** The type of the current query. */
+	uint m_nQueryType;
+	
+	/** The text of the current query. */
+	QString m_sQueryText;
+	
+	/** Whether the current query is case-sensitive. */
+	bool m_bQueryCase;
+	
+	/** true if the current query is served by the project's persistent
+		Cscope session, rather than by a process owned by this object. */
+	bool m_bSessionQuery;
+	
+	/** true if the current query is answered by reading the project's
+		cross-reference file, rather than by a Cscope process. */
+	bool m_bNativeQuery;
+	
+	/** true while the process of a cancelled query is still exiting (its
+		exit is not reported.) */
+	bool m_bQueryKilled;
+	
+	/** true if a query process should be started once the process of a
+		cancelled query has exited. */
+	bool m_bQueryPending;
+	
+	/** The database to use for the query process waiting to be started. */
+	QString m_sPendingDatabase;
+	
+	/** true if queries are run in the background (@see setBackground()). */
+	bool m_bBackground;
+	
+	/** The serial number of the job running the current query in the
+		thread reading the cross-reference file (@see CscopeWorker), 0 if
+		the query was not submitted. */
+	uint m_nWorkerJob;
+	
+	/** The generation of the database when the current query was made
+		(@see CscopeCache). */
+	uint m_nGeneration;
+	
+	/** true if the records of the current query are collected, to be
+		stored in the cache and handed to objects waiting for the same
+		query once it completes. */
+	bool m_bCollect;
+	
+	/** Accumulates the records of the current query. */
+	QByteArray m_baRecords;
+	
+	/** The object running the query this object is waiting for, NULL if
+		this object runs its own query. */
+	CscopeFrontend* m_pLeader;
+	
+	/** Objects waiting for the query run by this object. */
+	QList<CscopeFrontend*> m_lstFollowers;
+	
+	/** The processes running the current query on the shards of the
+		project's database (for projects built in shards.) */
+	QList<CscopeFrontend*> m_lstQueryShards;
+	
+	/** The number of shard-querying processes still running. */
+	int m_nQueryShardsLeft;
+	
+	/** true if any of the shard-querying processes has failed. */
+	bool m_bQueryShardFailed;
+	
+	/** Accumulates the records found in all shards, until they can be
+		merged. */
+	QByteArray m_baShardRecords;
+	
+	/** The processes building the shards of the project's database. */
+	QList<CscopeFrontend*> m_lstShards;
+	
+	/** The number of shard-building processes still running. */
+	int m_nShardsLeft;
+	
+	/** The progress of each shard-building process. */
+	QVector<int> m_vecShardProgress;
+	
+	/** The final progress value of each shard-building process. */
+	QVector<int> m_vecShardTotal;
+	
+	/** The files for which the shards are currently built (empty if all
+		shards are built.) */
+	QStringList m_slBuildFiles;
+	
+	/** The files for which the shards should be rebuilt once the current
+		build exits (empty if all shards should be rebuilt.) */
+	QStringList m_slRebuildFiles;
+	
+	/** Objects running queries in Cscope processes, by query (@see
+		CscopeCache::getKey()). */
+	static QHash<QString, CscopeFrontend*> s_hashRunning;
+	
 	/** The full path of the directory holding the project files. */
 	static QString s_sProjPath;
 	
@@ -103,6 +223,29 @@ private:
 	bool run(const QString&, const QStringList&,
 		const QString& sWorkDir = "", bool bBlock = false);
 	bool run(const QStringList& slArgs);
+	void cancelQuery();
+	void endQuery(bool, uint);
+	void deliver(const QByteArray&, uint);
+	void runExternal();
+	void runQuery();
+	void startQuery(const QString&);
+	void stopShardQuery();
+	void rebuildShards(const QStringList&);
+	bool buildShard(int);
+	
+	static QStringList getDatabases();
+	static void appendRecords(const FrontendBatch&, QByteArray&);
+	
+	bool sessionAccept(uint);
+	void sessionRecords(const FrontendBatch&);
+	void sessionFinished(uint);
+	void sessionFailed(uint);
+	void sessionAborted(uint);
+	
+	static QStringList getCmdLine(const QStringList&, bool,
+		bool bInvIndex = true);
+	
+	friend class CscopeSession;
 };
 
 /**
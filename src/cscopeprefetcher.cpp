@@ -0,0 +1,170 @@
+#include "cscopeprefetcher.h"
+#include "cscopefrontend.h"
+#include "cscopecache.h"
+#include "callgraph.h"
+
+/**
+ * Class constructor.
+ * @param	pParent	The parent object
+ */
+CscopePrefetcher::CscopePrefetcher(QObject* pParent) : QObject(pParent),
+	m_nType(CscopeFrontend::None)
+{
+}
+
+/**
+ * Class destructor.
+ * Stops all running queries.
+ */
+CscopePrefetcher::~CscopePrefetcher()
+{
+	cancel();
+}
+
+/**
+ * Schedules queries to run in the background.
+ * Queries scheduled by a previous call, which have not started yet, are
+ * discarded.
+ * @param	nType	The type of the queries (@see CscopeFrontend)
+ * @param	slText	The text of each query
+ */
+void CscopePrefetcher::prefetch(uint nType, const QStringList& slText)
+{
+	// Results of queries that cannot be stored are of no use
+	if (!CscopeCache::isCached(nType))
+		return;
+
+	m_nType = nType;
+	m_slPending = slText;
+	dispatch();
+}
+
+/**
+ * Discards all scheduled queries, and stops the running ones.
+ * Objects waiting for a stopped query run the query themselves.
+ */
+void CscopePrefetcher::cancel()
+{
+	m_slPending.clear();
+
+	// Deleting the objects stops their queries
+	m_lstIdle.clear();
+	m_hashJobs.clear();
+	qDeleteAll(m_lstWorkers);
+	m_lstWorkers.clear();
+}
+
+/**
+ * Starts scheduled queries, as long as the number of running queries is
+ * below the limit.
+ */
+void CscopePrefetcher::dispatch()
+{
+	CscopeFrontend* pWorker;
+	QString sText;
+	Job job;
+
+	while (!m_slPending.isEmpty()) {
+		// Skip queries whose results are already stored
+		sText = m_slPending.first();
+		if (isStored(sText)) {
+			m_slPending.removeFirst();
+			continue;
+		}
+
+		// Get an idle object, creating one if the pool is not full
+		if (!m_lstIdle.isEmpty()) {
+			pWorker = m_lstIdle.takeFirst();
+		} else if (m_lstWorkers.count() < CSCOPE_PREFETCH_WORKERS) {
+			pWorker = new CscopeFrontend();
+			pWorker->setBackground(true);
+			connect(pWorker, SIGNAL(dataReady(const FrontendBatch&)), this,
+				SLOT(slotDataReady(const FrontendBatch&)));
+			connect(pWorker, SIGNAL(aborted()), this, SLOT(slotAborted()));
+			connect(pWorker, SIGNAL(finished(uint)), this,
+				SLOT(slotFinished(uint)));
+			m_lstWorkers.append(pWorker);
+		} else {
+			return;
+		}
+
+		m_slPending.removeFirst();
+		job.nType = m_nType;
+		job.sText = sText;
+		job.nGeneration = CscopeCache::getGeneration();
+		job.bAborted = false;
+		m_hashJobs.insert(pWorker, job);
+		pWorker->query(m_nType, sText, true);
+	}
+}
+
+/**
+ * Determines whether the results of a query are available without running
+ * it.
+ * @param	sText	The text of the query
+ * @return	true if the results are stored, false otherwise
+ */
+bool CscopePrefetcher::isStored(const QString& sText)
+{
+	if (CallGraph::supports(m_nType))
+		return CallGraph::contains(m_nType, sText);
+
+	return CscopeCache::contains(m_nType, sText, true);
+}
+
+/**
+ * Collects the records of a query for function calls.
+ * This slot is connected to the dataReady() signal of each of the objects
+ * running the queries.
+ * @param	batch	The block of records
+ */
+void CscopePrefetcher::slotDataReady(const FrontendBatch& batch)
+{
+	QHash<CscopeFrontend*, Job>::Iterator itr;
+
+	itr = m_hashJobs.find((CscopeFrontend*)sender());
+	if (itr != m_hashJobs.end() && CallGraph::supports((*itr).nType))
+		CscopeFrontend::getRecords(batch, (*itr).lstRecords);
+}
+
+/**
+ * Marks a query as incomplete.
+ * This slot is connected to the aborted() signal of each of the objects
+ * running the queries.
+ */
+void CscopePrefetcher::slotAborted()
+{
+	QHash<CscopeFrontend*, Job>::Iterator itr;
+
+	itr = m_hashJobs.find((CscopeFrontend*)sender());
+	if (itr != m_hashJobs.end())
+		(*itr).bAborted = true;
+}
+
+/**
+ * Stores the calls found by a query once it has completed, and starts the
+ * next scheduled query.
+ * This slot is connected to the finished() signal of each of the objects
+ * running the queries.
+ */
+void CscopePrefetcher::slotFinished(uint)
+{
+	CscopeFrontend* pWorker;
+	Job job;
+
+	pWorker = (CscopeFrontend*)sender();
+	if (!m_hashJobs.contains(pWorker))
+		return;
+
+	job = m_hashJobs.take(pWorker);
+	if (!job.bAborted && CallGraph::supports(job.nType)) {
+		CallGraph::insert(job.nType, job.sText, job.nGeneration,
+			job.lstRecords);
+	}
+
+	m_lstIdle.append(pWorker);
+	dispatch();
+	
+	if (isIdle())
+		emit idle();
+}
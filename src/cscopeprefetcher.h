@@ -0,0 +1,106 @@
+#ifndef CSCOPEPREFETCHER_H
+#define CSCOPEPREFETCHER_H
+
+#include <qobject.h>
+#include <qstringlist.h>
+#include <qlist.h>
+#include <qhash.h>
+
+/** The maximal number of queries run at the same time by a prefetcher. */
+#define CSCOPE_PREFETCH_WORKERS	2
+
+class CscopeFrontend;
+class FrontendBatch;
+
+/**
+ * Runs Cscope queries in the background, so that their results are stored
+ * in the cache (@see CscopeCache) before they are requested.
+ * Queries are made through a small pool of CscopeFrontend objects, which is
+ * never larger than CSCOPE_PREFETCH_WORKERS. These objects only schedule the
+ * queries: queries answered in-process run on the thread reading the
+ * cross-reference file, after any query made by the user (@see
+ * CscopeWorker), while other queries run in separate Cscope processes,
+ * rather than in the persistent session. Queries whose results are already
+ * stored are skipped. The results of queries for function calls are also
+ * added to the call graph (@see CallGraph), and so are skipped only if the
+ * graph already holds them.
+ * A query made by another object while the same query is being prefetched
+ * waits for the prefetching object, rather than running Cscope again, and
+ * runs the query itself if the prefetch is cancelled.
+ * Each call to prefetch() replaces the queries that have not started yet, so
+ * that the most recently requested ones are served first.
+ * @author Elad Lahav
+ */
+class CscopePrefetcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	CscopePrefetcher(QObject* pParent = 0);
+	~CscopePrefetcher();
+
+	void prefetch(uint, const QStringList&);
+	void cancel();
+
+	/**
+	 * @return	true if no query is scheduled or running, false otherwise
+	 */
+	bool isIdle() const {
+		return m_slPending.isEmpty() &&
+			(m_lstIdle.count() == m_lstWorkers.count());
+	}
+
+signals:
+	/**
+	 * Emitted when the last running query completes, and no other query is
+	 * scheduled.
+	 */
+	void idle();
+
+private:
+	/**
+	 * A query run by one of the objects in the pool.
+	 */
+	struct Job
+	{
+		/** The type of the query. */
+		uint nType;
+
+		/** The text of the query. */
+		QString sText;
+
+		/** The generation of the database when the query was made. */
+		uint nGeneration;
+
+		/** The records produced by the query so far. */
+		QList<QStringList> lstRecords;
+
+		/** true if the query was stopped before it completed. */
+		bool bAborted;
+	};
+
+	/** The type of the pending queries. */
+	uint m_nType;
+
+	/** The text of the queries that have not started yet. */
+	QStringList m_slPending;
+
+	/** The objects running the queries. */
+	QList<CscopeFrontend*> m_lstWorkers;
+
+	/** Objects that are not running any query. */
+	QList<CscopeFrontend*> m_lstIdle;
+
+	/** The query run by each object. */
+	QHash<CscopeFrontend*, Job> m_hashJobs;
+
+	void dispatch();
+	bool isStored(const QString&);
+
+private slots:
+	void slotDataReady(const FrontendBatch&);
+	void slotAborted();
+	void slotFinished(uint);
+};
+
+#endif
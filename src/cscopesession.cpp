@@ -0,0 +1,448 @@
+#include "husky.h"
+#include <qdir.h>
+#include "cscopesession.h"
+#include "cscopefrontend.h"
+
+CscopeSession* CscopeSession::s_pSession = NULL;
+
+/**
+ * Class constructor.
+ * Sessions are only created through get().
+ */
+CscopeSession::CscopeSession() : Frontend(CSCOPE_RECORD_SIZE),
+	m_state(Starting),
+	m_pActive(NULL),
+	m_nLeft(0),
+	m_nDelivered(0),
+	m_bCaseless(false),
+	m_nSkipPrompts(0),
+	m_bRestart(false)
+{
+	// Hand complete records to the object that issued the current query
+	connect(this, SIGNAL(dataReady(const FrontendBatch&)), this,
+		SLOT(slotDataReady(const FrontendBatch&)));
+}
+
+/**
+ * Class destructor.
+ */
+CscopeSession::~CscopeSession()
+{
+}
+
+/**
+ * Submits a query to the project's session.
+ * The query is served as soon as all previously-submitted queries have
+ * completed. Any query previously submitted by the same object is cancelled.
+ * @param	pOwner	The object issuing the query
+ * @param	nType	The type of query to run
+ * @param	sText	The query's text
+ * @param	bCase	true for case-sensitive queries, false otherwise
+ * @return	true if the query was accepted, false if no session is available
+ *			(in which case the caller should run its own Cscope process)
+ */
+bool CscopeSession::query(CscopeFrontend* pOwner, uint nType,
+	const QString& sText, bool bCase)
+{
+	CscopeSession* pSession;
+	Request req;
+
+	// Queries are written as single lines
+	if (sText.contains('\n'))
+		return false;
+
+	// Get the current session, starting one if required
+	pSession = get();
+	if (pSession == NULL)
+		return false;
+
+	// A new query supersedes any previous one made by the same object
+	cancel(pOwner);
+
+	// Queue the query
+	req.pOwner = pOwner;
+	req.nType = nType;
+	req.sText = sText;
+	req.bCase = bCase;
+	pSession->m_lstPending.append(req);
+
+	// Send the query to Cscope, if it is waiting for input
+	pSession->dispatch();
+	return true;
+}
+
+/**
+ * Removes all queries submitted by the given object.
+ * If one of these queries is currently served by the session, its output is
+ * discarded.
+ * @param	pOwner	The object whose queries should be removed
+ */
+void CscopeSession::cancel(CscopeFrontend* pOwner)
+{
+	QList<Request>::Iterator itr;
+
+	if (s_pSession == NULL)
+		return;
+
+	// Stop delivering records for a query currently in progress
+	if (s_pSession->m_pActive == pOwner)
+		s_pSession->m_pActive = NULL;
+
+	// Remove queued queries
+	itr = s_pSession->m_lstPending.begin();
+	while (itr != s_pSession->m_lstPending.end()) {
+		if ((*itr).pOwner == pOwner)
+			itr = s_pSession->m_lstPending.erase(itr);
+		else
+			++itr;
+	}
+}
+
+/**
+ * Restarts the session, so that further queries are served by a process
+ * that has loaded the current database.
+ * Should be called whenever the database has been rebuilt. If a query is
+ * currently in progress, the session is stopped once it completes.
+ */
+void CscopeSession::restart()
+{
+	CscopeSession* pSession;
+
+	if (s_pSession == NULL)
+		return;
+
+	// Do not interrupt a query in progress
+	if (s_pSession->m_state >= Header && s_pSession->m_state <= LineText) {
+		s_pSession->m_bRestart = true;
+		return;
+	}
+
+	// The next query will start a new session, and serve the queries that
+	// were not served yet
+	pSession = s_pSession;
+	s_pSession = NULL;
+	pSession->shutdown(false);
+}
+
+/**
+ * Terminates the current session.
+ * Should be called when the project is closed, or its settings change.
+ * Queries that were not served yet are aborted, since they were made for the
+ * previous project (or settings), and should not run on the database of the
+ * new one.
+ */
+void CscopeSession::stop()
+{
+	CscopeSession* pSession;
+
+	pSession = s_pSession;
+	if (pSession == NULL)
+		return;
+
+	s_pSession = NULL;
+	pSession->shutdown(true);
+}
+
+/**
+ * Returns the session for the current project, starting one if required.
+ * @return	The current session, or NULL if one could not be started
+ */
+CscopeSession* CscopeSession::get()
+{
+	if (s_pSession != NULL)
+		return s_pSession;
+
+	// A line-oriented session requires an existing database
+	// Projects built in shards have a database for each shard, which are
+	// queried in turn by separate processes
+	if ((CscopeFrontend::s_nProjArgs & CscopeFrontend::Sharded) ||
+		!QDir(CscopeFrontend::s_sProjPath).exists("cscope.out")) {
+		return NULL;
+	}
+
+	s_pSession = new CscopeSession();
+	if (!s_pSession->start()) {
+		dp("Failed to start a Cscope session in %s\n",
+			CscopeFrontend::s_sProjPath.toLatin1().data());
+		delete s_pSession;
+		s_pSession = NULL;
+	}
+
+	return s_pSession;
+}
+
+/**
+ * Starts a line-oriented Cscope process on the current project's database.
+ * @return	true if the process was started, false otherwise
+ */
+bool CscopeSession::start()
+{
+	QStringList slArgs;
+
+	// Line-oriented mode, do not update the database
+	// Progress messages are not required, so verbose output is not used
+	slArgs << "-l" << "-d";
+	if (!run("cscope", CscopeFrontend::getCmdLine(slArgs, false),
+		CscopeFrontend::s_sProjPath))
+		return false;
+
+	// Wait for Cscope's first prompt
+	m_state = Starting;
+	m_delim = WSpace;
+
+	return waitForStarted();
+}
+
+/**
+ * Writes the next pending query to Cscope's standard input.
+ * Does nothing unless the process is waiting for a new command.
+ */
+void CscopeSession::dispatch()
+{
+	Request req;
+	QByteArray baCmd;
+
+	if ((m_state != Ready) || m_lstPending.isEmpty())
+		return;
+
+	req = m_lstPending.takeFirst();
+	m_pActive = req.pOwner;
+	m_nDelivered = 0;
+	m_nSkipPrompts = 0;
+
+	// Toggle case sensitivity, if required
+	// Cscope responds to this command with a new prompt
+	if (req.bCase == m_bCaseless) {
+		baCmd = "c\n";
+		m_bCaseless = !m_bCaseless;
+		m_nSkipPrompts++;
+	}
+
+	// The query command is composed of the query type followed by its text
+	baCmd += QByteArray::number(req.nType);
+	baCmd += req.sText.toLocal8Bit();
+	baCmd += "\n";
+	write(baCmd);
+
+	// Wait for the query's results
+	m_state = Header;
+	m_delim = WSpace;
+}
+
+/**
+ * Ends the current query.
+ * Reports the number of records to the owner object, and prepares for the
+ * next query.
+ */
+void CscopeSession::complete()
+{
+	CscopeFrontend* pOwner;
+
+	// The next query is sent once Cscope prompts for it
+	m_state = Prompt;
+	m_delim = WSpace;
+
+	// Notify the owner (note that it may submit a new query in response)
+	pOwner = m_pActive;
+	m_pActive = NULL;
+	if (pOwner != NULL)
+		pOwner->sessionFinished(m_nDelivered);
+
+	// Stop a session whose database was rebuilt
+	if (m_bRestart && (s_pSession == this)) {
+		s_pSession = NULL;
+		shutdown(false);
+	}
+}
+
+/**
+ * Returns all queries (including one in progress) to their owners.
+ * Used when the session terminates.
+ * @param	bAbort	true to abort the queries, false to let their owners run
+ *					them as separate processes
+ */
+void CscopeSession::detach(bool bAbort)
+{
+	CscopeFrontend* pActive;
+	QList<Request> lstPending;
+	QList<Request>::Iterator itr;
+
+	pActive = m_pActive;
+	m_pActive = NULL;
+	lstPending = m_lstPending;
+	m_lstPending.clear();
+
+	if (pActive != NULL) {
+		if (bAbort)
+			pActive->sessionAborted(m_nDelivered);
+		else
+			pActive->sessionFailed(m_nDelivered);
+	}
+
+	for (itr = lstPending.begin(); itr != lstPending.end(); ++itr) {
+		if (bAbort)
+			(*itr).pOwner->sessionAborted(0);
+		else
+			(*itr).pOwner->sessionFailed(0);
+	}
+}
+
+/**
+ * Terminates the Cscope process and schedules the object for deletion.
+ * @param	bAbort	true to abort the queries that were not served yet, false
+ *					to return them to their owners (@see detach())
+ */
+void CscopeSession::shutdown(bool bAbort)
+{
+	// Ignore any further output
+	blockSignals(true);
+
+	closeWriteChannel();
+	KProcess::kill();
+
+	detach(bAbort);
+	deleteLater();
+}
+
+/**
+ * Parses the output of the line-oriented Cscope process.
+ * The output of each query begins with a line in the format of
+ * "cscope: X lines", followed by X records, and ends with a ">> " prompt.
+ * The output of a query that fails holds an error message and the prompt,
+ * without the header.
+ * @param	token	The current token read (the token delimiter is determined
+ *					by the current state)
+ * @return	A value indicating the way this token should be treated: dropped,
+ *			added to the token queue, or finishes a new record
+ */
+Frontend::ParseResult CscopeSession::parseStdout(FrontendToken& token,
+	ParserDelim /* ignored */)
+{
+	ParseResult result = DiscardToken;
+
+	switch (m_state) {
+	case Starting:
+	case Prompt:
+		// Cscope is waiting for a new command
+		if (token.isEqual(">>")) {
+			m_state = Ready;
+			dispatch();
+		}
+		break;
+
+	case Header:
+		if (token.isEqual(">>")) {
+			// Skip prompts printed in response to mode-change commands
+			if (m_nSkipPrompts > 0) {
+				m_nSkipPrompts--;
+				break;
+			}
+
+			// A prompt without a "cscope: X lines" header means the query
+			// has failed (e.g., "Unable to search database" is printed for
+			// an invalid regular expression)
+			// Since Cscope is already waiting for a new command, the next
+			// query can be sent immediately
+			complete();
+			m_state = Ready;
+			dispatch();
+		}
+		else if (token.isEqual("cscope:")) {
+			m_state = Count;
+			m_delim = Newline;
+		}
+		break;
+
+	case Count:
+		// Get the number of records in the query's output
+		m_nLeft = token.toInt();
+		m_state = File;
+		m_delim = WSpace;
+
+		// Let the owner decide whether the results are still required
+		if ((m_pActive != NULL) && !m_pActive->sessionAccept(m_nLeft))
+			m_pActive = NULL;
+
+		if (m_nLeft == 0)
+			complete();
+		break;
+
+	case File:
+		// Treat the token as the name of the file in this record
+		m_state = Func;
+		result = AcceptToken;
+		break;
+
+	case Func:
+		// Treat the token as the name of the function in this record
+		// In case of a global definition, there is no function name, and
+		// instead the line number is given immediately
+		if (token.isNumber()) {
+			m_state = LineText;
+			m_delim = Newline;
+		}
+		else {
+			m_state = Line;
+		}
+
+		result = AcceptToken;
+		break;
+
+	case Line:
+		// Treat the token as the line number in this record
+		m_state = LineText;
+		m_delim = Newline;
+		result = AcceptToken;
+		break;
+
+	case LineText:
+		// Treat the token as the text of this record, and report a new
+		// record
+		m_state = File;
+		m_delim = WSpace;
+		result = RecordReady;
+		
+		// Deliver the records of the current query before the output of the
+		// next one begins
+		if ((m_nLeft > 0) && (--m_nLeft == 0))
+			result = BatchReady;
+		break;
+
+	default:
+		// Ignore unexpected output
+		break;
+	}
+
+	return result;
+}
+
+/**
+ * Called when the Cscope process exits unexpectedly.
+ * Returns all pending queries to their owners.
+ */
+void CscopeSession::finalize()
+{
+	if (s_pSession == this)
+		s_pSession = NULL;
+
+	m_state = Starting;
+	detach(false);
+	deleteLater();
+}
+
+/**
+ * Delivers complete records to the owner of the current query.
+ * This slot is connected to the dataReady() signal of this object.
+ * @param	batch	The block of records
+ */
+void CscopeSession::slotDataReady(const FrontendBatch& batch)
+{
+	if (m_pActive != NULL) {
+		m_pActive->sessionRecords(batch);
+		m_nDelivered += batch.count();
+	}
+
+	// Check if the block ends the current query
+	if (m_nLeft == 0)
+		complete();
+}
@@ -0,0 +1,112 @@
+#ifndef CSCOPESESSION_H
+#define CSCOPESESSION_H
+
+#include <qlist.h>
+#include <qstring.h>
+
+#include "frontend.h"
+
+class CscopeFrontend;
+
+/**
+ * A long-lived Cscope process, running in line-oriented mode ("cscope -l").
+ * Instead of starting a new Cscope process for every query (which requires
+ * reloading the cross-reference file and its inverted index each time), the
+ * project keeps a single process alive and writes queries to its standard
+ * input. Queries are served in the order they were submitted, and the
+ * resulting records are handed back to the CscopeFrontend object that issued
+ * each one.
+ * The session is started on demand, when the first query is made for a
+ * project with an existing database, and is restarted whenever the database
+ * is rebuilt. Queries still waiting when the project is closed are aborted.
+ * @author Elad Lahav
+ */
+class CscopeSession : public Frontend
+{
+	Q_OBJECT
+
+public:
+	static bool query(CscopeFrontend*, uint, const QString&, bool);
+	static void cancel(CscopeFrontend*);
+	static void restart();
+	static void stop();
+
+protected:
+	virtual ParseResult parseStdout(FrontendToken&, ParserDelim);
+	virtual void finalize();
+
+private:
+	CscopeSession();
+	~CscopeSession();
+
+#ifdef TESTCASE
+	friend class CscopeSessionTest;
+#endif
+
+	/**
+	 * A query waiting to be served by the session.
+	 */
+	struct Request
+	{
+		/** The object that issued the query. */
+		CscopeFrontend* pOwner;
+
+		/** The type of query to run. */
+		uint nType;
+
+		/** The query's text. */
+		QString sText;
+
+		/** true for case-sensitive queries, false otherwise. */
+		bool bCase;
+	};
+
+	/**
+	 * The possible states of the parser state machine.
+	 */
+	enum ParserState { Starting = 0, Ready, Header, Count, File, Func, Line,
+		LineText, Prompt };
+
+	/** The current state of the parser state machine. */
+	ParserState m_state;
+
+	/** Queries waiting for the session to become ready. */
+	QList<Request> m_lstPending;
+
+	/** The object whose query is currently being served (NULL if there is
+		no such query, or if its owner is no longer interested in the
+		results). */
+	CscopeFrontend* m_pActive;
+
+	/** The number of records still expected for the current query. */
+	uint m_nLeft;
+
+	/** The number of records delivered for the current query. */
+	uint m_nDelivered;
+
+	/** Whether the Cscope process is currently in case-insensitive mode. */
+	bool m_bCaseless;
+
+	/** The number of prompts to ignore before the current query's output
+		begins (one for every mode-change command.) */
+	uint m_nSkipPrompts;
+
+	/** If true, the session is stopped as soon as the current query ends
+		(set when the database is rebuilt while a query is served.) */
+	bool m_bRestart;
+
+	/** The session for the current project, NULL if none is running. */
+	static CscopeSession* s_pSession;
+
+	static CscopeSession* get();
+	bool start();
+	void dispatch();
+	void complete();
+	void detach(bool);
+	void shutdown(bool);
+
+private slots:
+	void slotDataReady(const FrontendBatch&);
+};
+
+#endif
@@ -0,0 +1,214 @@
+#include <qdir.h>
+#include <qfile.h>
+#include <qtextstream.h>
+#include <qmap.h>
+#include <qvector.h>
+#include "cscopeshards.h"
+
+QString CscopeShards::s_sProjPath;
+QHash<QString, int> CscopeShards::s_hashDirs;
+
+/**
+ * Divides the files of a project into shards.
+ * Reads the project's cscope.files file, and writes a file list for each
+ * shard. Directories are assigned to shards from the largest to the
+ * smallest, each one to the shard holding the least files so far, so that
+ * the shards are of similar sizes.
+ * Option lines (beginning with a dash) are copied to all file lists. Lists
+ * and databases of shards beyond the new number of shards are removed.
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @param	nShards		The requested number of shards
+ * @return	The number of shards created (which may be smaller than requested
+ *			for projects with few directories), 0 on failure
+ */
+int CscopeShards::split(const QString& sProjPath, int nShards)
+{
+	QDir dir(sProjPath);
+	QFile file(dir.absoluteFilePath("cscope.files"));
+	QString sPath;
+	QStringList slOptions;
+	QHash<QString, QStringList> hashFiles;
+	QHash<QString, QStringList>::ConstIterator itrFiles;
+	QMultiMap<int, QString> mapDirs;
+	QMap<int, QString>::ConstIterator itrDirs;
+	QVector<QStringList> vecShards;
+	QVector<int> vecSizes;
+	int i, nMin;
+
+	s_sProjPath = sProjPath;
+	s_hashDirs.clear();
+
+	// Group the project's files by directory
+	if (!file.open(QIODevice::ReadOnly))
+		return 0;
+
+	QTextStream strIn(&file);
+	while (!(sPath = strIn.readLine()).isNull()) {
+		if (sPath.isEmpty())
+			continue;
+
+		if (sPath.at(0) == '-')
+			slOptions.append(sPath);
+		else
+			hashFiles[getDir(sPath)].append(sPath);
+	}
+
+	file.close();
+
+	if (hashFiles.isEmpty())
+		return 0;
+
+	// Order directories by the number of files
+	for (itrFiles = hashFiles.constBegin(); itrFiles != hashFiles.constEnd();
+		++itrFiles) {
+		mapDirs.insert((*itrFiles).count(), itrFiles.key());
+	}
+
+	// Assign the largest directories first, each to the smallest shard
+	nShards = qBound(1, nShards, hashFiles.count());
+	vecShards.resize(nShards);
+	vecSizes.fill(0, nShards);
+	itrDirs = mapDirs.constEnd();
+	while (itrDirs != mapDirs.constBegin()) {
+		--itrDirs;
+
+		nMin = 0;
+		for (i = 1; i < nShards; i++) {
+			if (vecSizes[i] < vecSizes[nMin])
+				nMin = i;
+		}
+
+		vecShards[nMin] += hashFiles[*itrDirs];
+		vecSizes[nMin] += itrDirs.key();
+		s_hashDirs.insert(*itrDirs, nMin);
+	}
+
+	// Write the file list of each shard
+	for (i = 0; i < nShards; i++) {
+		file.setFileName(dir.absoluteFilePath(getFileList(i)));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			s_hashDirs.clear();
+			return 0;
+		}
+
+		QTextStream strOut(&file);
+		if (!slOptions.isEmpty())
+			strOut << slOptions.join("\n") << "\n";
+		strOut << vecShards[i].join("\n") << "\n";
+
+		file.close();
+	}
+
+	// Remove shards left from previous builds
+	for (i = nShards; dir.exists(getFileList(i)); i++) {
+		dir.remove(getFileList(i));
+		dir.remove(getDatabase(i));
+	}
+
+	return nShards;
+}
+
+/**
+ * Determines the number of shards into which a project's files are divided.
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @return	The number of shards, 0 if the files were not divided
+ */
+int CscopeShards::count(const QString& sProjPath)
+{
+	QDir dir(sProjPath);
+	int i;
+
+	for (i = 0; dir.exists(getFileList(i)); i++)
+		;
+
+	return i;
+}
+
+/**
+ * Finds the shard holding the given file.
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @param	sFile		The path of the file, as listed in cscope.files
+ * @return	The index of the shard, -1 if the file's directory does not belong
+ *			to any shard
+ */
+int CscopeShards::find(const QString& sProjPath, const QString& sFile)
+{
+	// Read the file lists of the shards, if the project has changed
+	if ((s_sProjPath != sProjPath) || s_hashDirs.isEmpty()) {
+		if (!load(sProjPath))
+			return -1;
+	}
+
+	return s_hashDirs.value(getDir(sFile), -1);
+}
+
+/**
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @return	The names of the databases of all shards, in order
+ */
+QStringList CscopeShards::getDatabases(const QString& sProjPath)
+{
+	QStringList slDatabases;
+	int i, nShards;
+
+	nShards = count(sProjPath);
+	for (i = 0; i < nShards; i++)
+		slDatabases.append(getDatabase(i));
+
+	return slDatabases;
+}
+
+/**
+ * Maps directories to shards by reading the file list of each shard.
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @return	true if successful, false otherwise
+ */
+bool CscopeShards::load(const QString& sProjPath)
+{
+	QDir dir(sProjPath);
+	QFile file;
+	QString sPath;
+	int i, nShards;
+
+	s_sProjPath = sProjPath;
+	s_hashDirs.clear();
+
+	nShards = count(sProjPath);
+	for (i = 0; i < nShards; i++) {
+		file.setFileName(dir.absoluteFilePath(getFileList(i)));
+		if (!file.open(QIODevice::ReadOnly)) {
+			s_hashDirs.clear();
+			return false;
+		}
+
+		QTextStream str(&file);
+		while (!(sPath = str.readLine()).isNull()) {
+			if (!sPath.isEmpty() && (sPath.at(0) != '-'))
+				s_hashDirs.insert(getDir(sPath), i);
+		}
+
+		file.close();
+	}
+
+	return !s_hashDirs.isEmpty();
+}
+
+/**
+ * @param	sPath	The path of a file
+ * @return	The directory part of the path
+ */
+QString CscopeShards::getDir(const QString& sPath)
+{
+	int nPos;
+
+	nPos = sPath.lastIndexOf('/');
+	if (nPos < 0)
+		return "";
+
+	return sPath.left(nPos);
+}
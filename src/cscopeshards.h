@@ -0,0 +1,60 @@
+#ifndef CSCOPESHARDS_H
+#define CSCOPESHARDS_H
+
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qhash.h>
+
+/** The name of the file list of a shard. */
+#define CSCOPE_SHARD_FILES	"cscope.%1.files"
+
+/** The name of the database of a shard. */
+#define CSCOPE_SHARD_OUT	"cscope.%1.out"
+
+/**
+ * Manages the division of a project's files into shards.
+ * A project may be configured to build its database in several parts
+ * ("shards"), which are built concurrently by separate Cscope processes.
+ * The files listed in the project's cscope.files file are divided by
+ * directory, so that all files in the same directory belong to the same shard.
+ * Each shard has its own file list and database in the project's directory.
+ * When a file is modified, only the shard holding this file needs to be
+ * rebuilt.
+ * @author Elad Lahav
+ */
+class CscopeShards
+{
+public:
+	static int split(const QString&, int);
+	static int count(const QString&);
+	static int find(const QString&, const QString&);
+	static QStringList getDatabases(const QString&);
+
+	/**
+	 * @param	nShard	The index of a shard
+	 * @return	The name of the shard's file list
+	 */
+	static QString getFileList(int nShard) {
+		return QString(CSCOPE_SHARD_FILES).arg(nShard);
+	}
+
+	/**
+	 * @param	nShard	The index of a shard
+	 * @return	The name of the shard's database
+	 */
+	static QString getDatabase(int nShard) {
+		return QString(CSCOPE_SHARD_OUT).arg(nShard);
+	}
+
+private:
+	/** The project for which directories were mapped to shards. */
+	static QString s_sProjPath;
+
+	/** Maps each directory in the project to the shard holding its files. */
+	static QHash<QString, int> s_hashDirs;
+
+	static bool load(const QString&);
+	static QString getDir(const QString&);
+};
+
+#endif
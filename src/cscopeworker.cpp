@@ -0,0 +1,318 @@
+#include <qapplication.h>
+#include <qalgorithms.h>
+#include <qhash.h>
+#include "cscopeworker.h"
+#include "cscopedatabase.h"
+
+int CscopeWorkerEvent::eventTypeId = QEvent::None;
+
+CscopeWorker* CscopeWorker::s_pWorker = NULL;
+
+/**
+ * Class constructor.
+ * @param	nSerial		The serial number of the job that produced the
+ *						results
+ * @param	bSuccess	true if the job has completed, false otherwise
+ */
+CscopeWorkerEvent::CscopeWorkerEvent(uint nSerial, bool bSuccess) :
+	QEvent(QEvent::Type(CscopeWorkerEvent::eventTypeId)),
+	m_nSerial(nSerial),
+	m_bSuccess(bSuccess),
+	m_nRecords(0)
+{
+}
+
+int CscopeWorkerEvent::registerWorkerEventType()
+{
+	CscopeWorkerEvent::eventTypeId =
+		QEvent::registerEventType(CscopeWorkerEvent::EventId);
+	return CscopeWorkerEvent::eventTypeId;
+}
+
+/**
+ * Class constructor.
+ * The worker is only created through submit().
+ */
+CscopeWorker::CscopeWorker() : QThread(),
+	m_pCurrent(NULL),
+	m_nSerial(0),
+	m_bStop(false)
+{
+	if (CscopeWorkerEvent::eventTypeId == QEvent::None)
+		CscopeWorkerEvent::registerWorkerEventType();
+}
+
+/**
+ * Class destructor.
+ */
+CscopeWorker::~CscopeWorker()
+{
+}
+
+/**
+ * Submits a query.
+ * @param	pReceiver	The object that receives the results
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @param	slNames		The names of the cross-reference files (either
+ *						cscope.out or the databases of all shards)
+ * @param	bUseIndex	true if the project uses an inverted index, false
+ *						otherwise
+ * @param	nType		The type of query
+ * @param	sText		The query's text
+ * @param	bCase		true for case-sensitive queries, false otherwise
+ * @param	bBackground	true to run the query only after all other jobs
+ *						waiting in the queue, false otherwise
+ * @return	The serial number of the job
+ */
+uint CscopeWorker::query(QObject* pReceiver, const QString& sProjPath,
+	const QStringList& slNames, bool bUseIndex, uint nType,
+	const QString& sText, bool bCase, bool bBackground)
+{
+	Job job;
+
+	job.type = Query;
+	job.pReceiver = pReceiver;
+	job.sProjPath = sProjPath;
+	job.slNames = slNames;
+	job.bUseIndex = bUseIndex;
+	job.nType = nType;
+	job.sText = sText;
+	job.bCase = bCase;
+	job.bBackground = bBackground;
+	return submit(job);
+}
+
+/**
+ * Submits a request for the names of all symbols in the databases.
+ * @param	pReceiver	The object that receives the results
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @param	slNames		The names of the cross-reference files
+ * @param	bUseIndex	true if the project uses an inverted index, false
+ *						otherwise
+ * @return	The serial number of the job
+ */
+uint CscopeWorker::getSymbols(QObject* pReceiver, const QString& sProjPath,
+	const QStringList& slNames, bool bUseIndex)
+{
+	Job job;
+
+	job.type = Symbols;
+	job.pReceiver = pReceiver;
+	job.bBackground = false;
+	job.sProjPath = sProjPath;
+	job.slNames = slNames;
+	job.bUseIndex = bUseIndex;
+	return submit(job);
+}
+
+/**
+ * Removes all jobs submitted by the given object.
+ * If one of these jobs is currently running, its results are discarded.
+ * Must be called before the object is deleted.
+ * @param	pReceiver	The object whose jobs should be removed
+ */
+void CscopeWorker::cancel(QObject* pReceiver)
+{
+	QList<Job>::Iterator itr;
+
+	if (s_pWorker == NULL)
+		return;
+
+	QMutexLocker locker(&s_pWorker->m_mutex);
+
+	if (s_pWorker->m_pCurrent == pReceiver)
+		s_pWorker->m_pCurrent = NULL;
+
+	itr = s_pWorker->m_lstJobs.begin();
+	while (itr != s_pWorker->m_lstJobs.end()) {
+		if ((*itr).pReceiver == pReceiver)
+			itr = s_pWorker->m_lstJobs.erase(itr);
+		else
+			++itr;
+	}
+}
+
+/**
+ * Unloads the databases, as well as the delta (@see CscopeDatabase::reset()).
+ * Should be called whenever the database is rebuilt, or the project is
+ * closed.
+ */
+void CscopeWorker::reset()
+{
+	Job job;
+
+	job.type = Reset;
+	job.pReceiver = NULL;
+	job.bBackground = false;
+	submit(job);
+}
+
+/**
+ * Loads a database built for files modified since the project's database
+ * was built (@see CscopeDatabase::setDelta()).
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @param	slFiles		The paths of the files covered by the delta, as
+ *						passed to Cscope
+ */
+void CscopeWorker::setDelta(const QString& sProjPath,
+	const QStringList& slFiles)
+{
+	Job job;
+
+	job.type = Delta;
+	job.pReceiver = NULL;
+	job.bBackground = false;
+	job.sProjPath = sProjPath;
+	job.slNames = slFiles;
+	submit(job);
+}
+
+/**
+ * Terminates the thread, once the job currently running has completed.
+ * Jobs that did not start yet are discarded.
+ * Should be called when the application exits.
+ */
+void CscopeWorker::stop()
+{
+	if (s_pWorker == NULL)
+		return;
+
+	s_pWorker->m_mutex.lock();
+	s_pWorker->m_lstJobs.clear();
+	s_pWorker->m_pCurrent = NULL;
+	s_pWorker->m_bStop = true;
+	s_pWorker->m_condJobs.wakeAll();
+	s_pWorker->m_mutex.unlock();
+
+	s_pWorker->wait();
+	delete s_pWorker;
+	s_pWorker = NULL;
+}
+
+/**
+ * Adds a job to the queue, starting the thread if required.
+ * Other queries, as well as requests for symbols, are placed ahead of the
+ * background queries at the end of the queue. Jobs that change the loaded
+ * databases are always placed at the end, so that jobs submitted before
+ * them still run on the same databases.
+ * @param	job	The job to add
+ * @return	The serial number of the job
+ */
+uint CscopeWorker::submit(Job& job)
+{
+	int i;
+
+	if (s_pWorker == NULL) {
+		s_pWorker = new CscopeWorker();
+		s_pWorker->start();
+	}
+
+	QMutexLocker locker(&s_pWorker->m_mutex);
+
+	i = s_pWorker->m_lstJobs.count();
+	if (!job.bBackground && (job.type == Query || job.type == Symbols)) {
+		while ((i > 0) && s_pWorker->m_lstJobs[i - 1].bBackground)
+			i--;
+	}
+
+	job.nSerial = ++s_pWorker->m_nSerial;
+	s_pWorker->m_lstJobs.insert(i, job);
+	s_pWorker->m_condJobs.wakeOne();
+	return job.nSerial;
+}
+
+/**
+ * Runs the submitted jobs, and posts their results.
+ * This is the main loop of the thread.
+ */
+void CscopeWorker::run()
+{
+	CscopeWorkerEvent* pEvent;
+	Job job;
+
+	for (;;) {
+		// Wait for the next job
+		m_mutex.lock();
+		while (m_lstJobs.isEmpty() && !m_bStop)
+			m_condJobs.wait(&m_mutex);
+
+		if (m_bStop) {
+			m_mutex.unlock();
+			break;
+		}
+
+		job = m_lstJobs.takeFirst();
+		m_pCurrent = job.pReceiver;
+		m_mutex.unlock();
+
+		pEvent = execute(job);
+
+		// Post the results, unless the job was cancelled while running
+		m_mutex.lock();
+		if ((pEvent != NULL) && (m_pCurrent != NULL))
+			QApplication::postEvent(m_pCurrent, pEvent);
+		else
+			delete pEvent;
+
+		m_pCurrent = NULL;
+		m_mutex.unlock();
+	}
+
+	// The databases belong to this thread
+	CscopeDatabase::reset();
+}
+
+/**
+ * Runs a single job.
+ * @param	job	The job to run
+ * @return	An event holding the results, NULL for jobs that do not produce
+ *			any
+ */
+CscopeWorkerEvent* CscopeWorker::execute(const Job& job)
+{
+	CscopeWorkerEvent* pEvent;
+	QHash<QByteArray, bool> hashSymbols;
+	bool bResult;
+	int i;
+
+	switch (job.type) {
+	case Query:
+		pEvent = new CscopeWorkerEvent(job.nSerial, false);
+		pEvent->m_bSuccess = CscopeDatabase::load(job.sProjPath, job.slNames,
+			job.bUseIndex) && CscopeDatabase::query(job.nType, job.sText,
+			job.bCase, pEvent->m_baOutput, pEvent->m_nRecords);
+		return pEvent;
+
+	case Symbols:
+		pEvent = new CscopeWorkerEvent(job.nSerial, false);
+		bResult = CscopeDatabase::load(job.sProjPath, job.slNames,
+			job.bUseIndex) && CscopeDatabase::getSymbols(hashSymbols);
+		if (!bResult)
+			return pEvent;
+
+		// Order the names, so that the receiver only needs to copy them
+		pEvent->m_lstSymbols = hashSymbols.keys();
+		qSort(pEvent->m_lstSymbols);
+		pEvent->m_baDefined.resize(pEvent->m_lstSymbols.count());
+		for (i = 0; i < pEvent->m_lstSymbols.count(); i++) {
+			if (hashSymbols.value(pEvent->m_lstSymbols[i]))
+				pEvent->m_baDefined.setBit(i);
+		}
+
+		pEvent->m_bSuccess = true;
+		return pEvent;
+
+	case Reset:
+		CscopeDatabase::reset();
+		break;
+
+	case Delta:
+		CscopeDatabase::setDelta(job.sProjPath, job.slNames);
+		break;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,154 @@
+#ifndef CSCOPEWORKER_H
+#define CSCOPEWORKER_H
+
+#include <qthread.h>
+#include <qevent.h>
+#include <qmutex.h>
+#include <qwaitcondition.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qbytearray.h>
+#include <qbitarray.h>
+#include <qlist.h>
+
+/**
+ * Carries the results of a CscopeWorker job to the main application thread.
+ * @author Elad Lahav
+ */
+class CscopeWorkerEvent : public QEvent
+{
+public:
+	/** The event's unique ID. */
+	enum { EventId = 6929 };
+
+	CscopeWorkerEvent(uint, bool);
+	static int registerWorkerEventType();
+	static int eventTypeId;
+
+	/** The serial number of the job that produced the results. */
+	uint m_nSerial;
+
+	/** true if the job has completed, false if the databases could not be
+		loaded, or the query is not supported. */
+	bool m_bSuccess;
+
+	/** The output of a query, in the format of "cscope -L". */
+	QByteArray m_baOutput;
+
+	/** The number of records in the output of a query. */
+	uint m_nRecords;
+
+	/** The (UTF-8 encoded) names of all symbols in the databases, in
+		alphabetical order (@see CscopeWorker::getSymbols()). */
+	QList<QByteArray> m_lstSymbols;
+
+	/** Marks the names of symbols defined in the databases, by their
+		position in the above list. */
+	QBitArray m_baDefined;
+};
+
+/**
+ * Reads the project's cross-reference files in a separate thread.
+ * The databases read in-process (@see CscopeDatabase) are only accessed by
+ * this thread, so that queries, and the building of the symbol index on the
+ * first query, do not block the GUI. Jobs are run one at a time, in the order
+ * they were submitted, and the results of each job are posted to its
+ * receiver as a CscopeWorkerEvent, tagged with the serial number returned
+ * when the job was submitted. Queries submitted in the background (such as
+ * those of CscopePrefetcher) are run only once no other job is waiting.
+ * Each job carries the location of the databases at the time it was made,
+ * so that a job made for a project that was closed since does not run on the
+ * databases of the new project. Changes to the loaded databases (such as
+ * unloading them after a rebuild) are submitted as jobs as well, so that
+ * they apply to all jobs submitted after them.
+ * @author Elad Lahav
+ */
+class CscopeWorker : public QThread
+{
+public:
+	static uint query(QObject*, const QString&, const QStringList&, bool,
+		uint, const QString&, bool, bool bBackground = false);
+	static uint getSymbols(QObject*, const QString&, const QStringList&,
+		bool);
+	static void cancel(QObject*);
+	static void reset();
+	static void setDelta(const QString&, const QStringList&);
+	static void stop();
+
+protected:
+	virtual void run();
+
+private:
+	CscopeWorker();
+	~CscopeWorker();
+
+	/**
+	 * The types of jobs.
+	 */
+	enum JobType { Query, Symbols, Reset, Delta };
+
+	/**
+	 * A job waiting to be run.
+	 */
+	struct Job
+	{
+		/** The type of the job. */
+		JobType type;
+
+		/** The object that receives the results, NULL for jobs that do not
+			produce any. */
+		QObject* pReceiver;
+
+		/** The serial number of the job. */
+		uint nSerial;
+
+		/** The full path of the directory holding the project files. */
+		QString sProjPath;
+
+		/** The names of the cross-reference files (or, for Delta jobs, the
+			files covered by the delta.) */
+		QStringList slNames;
+
+		/** true if the project uses an inverted index, false otherwise. */
+		bool bUseIndex;
+
+		/** The type of the query. */
+		uint nType;
+
+		/** The text of the query. */
+		QString sText;
+
+		/** true for case-sensitive queries, false otherwise. */
+		bool bCase;
+
+		/** true for queries that should yield to all other jobs. */
+		bool bBackground;
+	};
+
+	/** Jobs waiting to be run. */
+	QList<Job> m_lstJobs;
+
+	/** The receiver of the job currently running, NULL if there is no such
+		job, or if the receiver is no longer interested in the results. */
+	QObject* m_pCurrent;
+
+	/** The serial number of the last submitted job. */
+	uint m_nSerial;
+
+	/** Set to true to terminate the thread. */
+	bool m_bStop;
+
+	/** Protects the job queue and the current receiver. */
+	QMutex m_mutex;
+
+	/** Wakes the thread when jobs are submitted. */
+	QWaitCondition m_condJobs;
+
+	/** The single worker thread, NULL if not started yet. */
+	static CscopeWorker* s_pWorker;
+
+	static uint submit(Job&);
+	CscopeWorkerEvent* execute(const Job&);
+};
+
+#endif
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <utime.h>
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qdir.h>
+#include <qdatetime.h>
+#include <qcryptographichash.h>
+#include "ctagscache.h"
+
+/** Identifies the format of cache files. */
+#define CTAGS_CACHE_MAGIC	"KScope Ctags Cache 2"
+
+QString CtagsCache::s_sDir;
+qint64 CtagsCache::s_nSize = 0;
+
+/**
+ * Sets the directory of the current project.
+ * Removes old cache files left by previous sessions.
+ * @param	sProjPath	The project directory, or an empty string to disable
+ *						the cache (when no project is open, or for temporary
+ *						projects)
+ */
+void CtagsCache::setDir(const QString& sProjPath)
+{
+	if (sProjPath.isEmpty())
+		s_sDir = QString::null;
+	else
+		s_sDir = sProjPath + "/" CTAGS_CACHE_DIR;
+
+	s_nSize = 0;
+	if (!s_sDir.isEmpty())
+		prune();
+}
+
+/**
+ * Creates the header that identifies a source file's cached tags.
+ * The header should be created before Ctags is run, so that tags produced
+ * for a file that was modified during the run are not used later.
+ * @param	sFile	The full path of the source file
+ * @param	slArgs	The Ctags command line
+ * @return	The header, or an empty array if the file's tags cannot be cached
+ */
+QByteArray CtagsCache::getHeader(const QString& sFile,
+	const QStringList& slArgs)
+{
+	struct stat st;
+	QByteArray baHeader;
+
+	if (s_sDir.isEmpty() || stat(QFile::encodeName(sFile).data(), &st) != 0 ||
+		!S_ISREG(st.st_mode)) {
+		return QByteArray();
+	}
+
+	// A modification time in whole seconds does not tell apart changes made
+	// within the same second (e.g., by a script, or a fast build)
+	baHeader = CTAGS_CACHE_MAGIC "\n";
+	baHeader += QFile::encodeName(sFile) + '\n';
+	baHeader += QByteArray::number((qlonglong)st.st_size) + ' ' +
+		QByteArray::number((qlonglong)st.st_mtim.tv_sec) + '.' +
+		QByteArray::number((qlonglong)st.st_mtim.tv_nsec)
+		.rightJustified(9, '0') + '\n';
+	baHeader += QCryptographicHash::hash(slArgs.join("\n").toUtf8(),
+		QCryptographicHash::Md5).toHex() + '\n';
+
+	return baHeader;
+}
+
+/**
+ * Looks up the stored tags of a source file.
+ * @param	sFile		The full path of the source file
+ * @param	baHeader	The header identifying the file's current contents
+ *						(as returned by getHeader())
+ * @param	baOutput	Holds the stored Ctags output, upon successful return
+ * @return	true if matching tags were found, false otherwise
+ */
+bool CtagsCache::find(const QString& sFile, const QByteArray& baHeader,
+	QByteArray& baOutput)
+{
+	QFile file;
+	QByteArray baData;
+
+	if (baHeader.isEmpty())
+		return false;
+
+	file.setFileName(getCacheFile(sFile));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	// Stale tags (or those of a different file with the same hash) are
+	// rejected by comparing headers
+	baData = file.readAll();
+	if (!baData.startsWith(baHeader))
+		return false;
+
+	baOutput = baData.mid(baHeader.size());
+
+	// Mark the file as recently used (@see prune())
+	file.close();
+	utime(QFile::encodeName(file.fileName()).data(), NULL);
+	return true;
+}
+
+/**
+ * Stores the tags of a source file.
+ * The cache file is written under a temporary name, and then renamed, so
+ * that a partially-written file is never read.
+ * @param	sFile		The full path of the source file
+ * @param	baHeader	The header identifying the file's contents at the
+ *						time Ctags was run (as returned by getHeader())
+ * @param	baOutput	The output of Ctags
+ */
+void CtagsCache::insert(const QString& sFile, const QByteArray& baHeader,
+	const QByteArray& baOutput)
+{
+	QString sPath, sTemp;
+	QFile file;
+	qint64 nOldSize;
+	bool bResult;
+
+	if (s_sDir.isEmpty() || baHeader.isEmpty())
+		return;
+
+	if (!QDir().mkpath(s_sDir))
+		return;
+
+	sPath = getCacheFile(sFile);
+	sTemp = sPath + ".tmp";
+
+	file.setFileName(sTemp);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return;
+
+	bResult = (file.write(baHeader) == baHeader.size()) &&
+		(file.write(baOutput) == baOutput.size());
+	file.close();
+
+	nOldSize = QFileInfo(sPath).size();
+	if (!bResult || rename(QFile::encodeName(sTemp).data(),
+		QFile::encodeName(sPath).data()) != 0) {
+		QFile::remove(sTemp);
+		return;
+	}
+
+	s_nSize += baHeader.size() + baOutput.size() - nOldSize;
+	if (s_nSize > CTAGS_CACHE_MAX_SIZE)
+		prune();
+}
+
+/**
+ * @param	sFile	The full path of a source file
+ * @return	The path of the cache file holding the tags of the given file
+ */
+QString CtagsCache::getCacheFile(const QString& sFile)
+{
+	return s_sDir + "/" + QCryptographicHash::hash(QFile::encodeName(sFile),
+		QCryptographicHash::Md5).toHex();
+}
+
+/**
+ * Removes cache files that were not used for CTAGS_CACHE_MAX_AGE days.
+ * If the total size of the remaining files exceeds CTAGS_CACHE_MAX_SIZE, the
+ * least recently used ones are removed as well, until a quarter of the
+ * allowed size is free (so that the cache is not pruned on every insert.)
+ * The modification time of a cache file is the last time it was used.
+ */
+void CtagsCache::prune()
+{
+	QFileInfoList lstFiles;
+	QFileInfoList::ConstIterator itr;
+	QDateTime dtOldest;
+	qint64 nLimit;
+
+	// Sort the files from the least recently used
+	lstFiles = QDir(s_sDir).entryInfoList(QDir::Files,
+		QDir::Time | QDir::Reversed);
+
+	s_nSize = 0;
+	for (itr = lstFiles.begin(); itr != lstFiles.end(); ++itr)
+		s_nSize += (*itr).size();
+
+	nLimit = CTAGS_CACHE_MAX_SIZE;
+	if (s_nSize > nLimit)
+		nLimit -= nLimit / 4;
+
+	dtOldest = QDateTime::currentDateTime().addDays(-CTAGS_CACHE_MAX_AGE);
+	for (itr = lstFiles.begin(); itr != lstFiles.end(); ++itr) {
+		if (s_nSize <= nLimit && (*itr).lastModified() >= dtOldest)
+			break;
+
+		if (QFile::remove((*itr).filePath()))
+			s_nSize -= (*itr).size();
+	}
+}
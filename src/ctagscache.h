@@ -0,0 +1,54 @@
+#ifndef CTAGSCACHE_H
+#define CTAGSCACHE_H
+
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qbytearray.h>
+
+/** The name of the directory, inside the project directory, that holds the
+	cached tags. */
+#define CTAGS_CACHE_DIR	"ctags.cache"
+
+/** The maximal total size, in bytes, of the cache files of a project. */
+#define CTAGS_CACHE_MAX_SIZE	(32 * 1024 * 1024)
+
+/** The number of days after which unused cache files are removed. */
+#define CTAGS_CACHE_MAX_AGE	30
+
+/**
+ * Stores the tags of source files in the project directory.
+ * Opening a file whose tags are stored in the cache fills its tag list
+ * immediately, without running Ctags. Each file's tags are held in a separate
+ * cache file, in the output format of Ctags. The cache file begins with a
+ * header that identifies the source file by its path, size and modification
+ * time (in nanoseconds), as well as the Ctags command line that produced the
+ * tags. Stored tags are only used if all of these match, so a file that was
+ * modified, or a change to the per-project Ctags arguments, results in Ctags
+ * being run again (replacing the stored tags.)
+ * The least recently used cache files are removed once their total size
+ * exceeds CTAGS_CACHE_MAX_SIZE, as are files not used for CTAGS_CACHE_MAX_AGE
+ * days.
+ * The cache is only used by persistent projects.
+ * @author Elad Lahav
+ */
+class CtagsCache
+{
+public:
+	static void setDir(const QString&);
+	static QByteArray getHeader(const QString&, const QStringList&);
+	static bool find(const QString&, const QByteArray&, QByteArray&);
+	static void insert(const QString&, const QByteArray&, const QByteArray&);
+
+private:
+	/** The directory holding the cache files, or an empty string if the
+		cache is disabled. */
+	static QString s_sDir;
+
+	/** The total size of the cache files. */
+	static qint64 s_nSize;
+
+	static QString getCacheFile(const QString&);
+	static void prune();
+};
+
+#endif
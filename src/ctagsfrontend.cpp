@@ -1,18 +1,28 @@
 #include "husky.h"
 #include <qfileinfo.h>
+#include <qprocess.h>
 #include <kmessagebox.h>
 #include <klocale.h>
 #include <kshell.h>
 #include "ctagsfrontend.h"
 #include "kscopeconfig.h"
+#include "ctagscache.h"
+#include "ctagsindex.h"
+#include "tagextractor.h"
 
 QStringList CtagsFrontend::s_slExtraArgs;
+QString CtagsFrontend::s_sCheckedPath;
+bool CtagsFrontend::s_bEndField = false;
+QProcess* CtagsFrontend::s_pVersionProc = NULL;
 
 /**
  * Class constructor.
  */
 CtagsFrontend::CtagsFrontend() : Frontend(CTAGS_RECORD_SIZE)
 {
+	// Collect records for the cache
+	connect(this, SIGNAL(dataReady(const FrontendBatch&)), this,
+		SLOT(slotCollectRecords(const FrontendBatch&)));
 }
 
 /**
@@ -33,11 +43,77 @@ bool CtagsFrontend::run(const QString& sFileName, const QStringList& slArgs,
 
 /**
  * Executes a Ctags process on a source file.
+ * If the tags of the file are found in the project's tag index, are stored
+ * in the cache, or can be extracted in-process, they are delivered
+ * (followed by the finished() signal) before this method returns, and no
+ * process is run.
  * @param	sFileName	The full path to the source file
  * @return	true if successful, false otherwise
  */
 // TODO: will override Frontend::run ?
 bool CtagsFrontend::run(const QString& sFileName)
+{
+	QStringList slArgs;
+	QByteArray baOutput;
+	bool bBuiltin, bEndField;
+
+	// Cannot start if another controlled process is currently running
+	if (state() == QProcess::Running)
+		return false;
+
+	// Set the command line arguments (an empty list if Ctags is not
+	// available)
+	slArgs = getArgs();
+	if (!slArgs.isEmpty()) {
+		slArgs.append("-f");
+		slArgs.append("-");
+		slArgs.append(sFileName);
+	}
+
+	// Initialize stdout parsing
+	m_state = Name;
+	m_delim = Tab;
+	m_sFileName = sFileName;
+	m_baRecords.resize(0);
+	
+	// Use the project's tag index, or the stored tags, if the file has not
+	// changed since they were produced. Otherwise, extract the tags
+	// in-process for C and C++ files, unless the project passes its own
+	// arguments to Ctags.
+	// If Ctags does not report the lines on which scopes end, the tags
+	// extracted in-process are preferred, as they provide these lines
+	bBuiltin = Config().getBuiltinTags() && s_slExtraArgs.isEmpty() &&
+		TagExtractor::supports(sFileName);
+	bEndField = slArgs.contains("--fields=+e");
+	m_baCacheHeader = CtagsCache::getHeader(sFileName, slArgs);
+	if ((bBuiltin && !bEndField &&
+		TagExtractor::extract(sFileName, baOutput)) ||
+		CtagsIndex::getFileTags(sFileName, baOutput) ||
+		CtagsCache::find(sFileName, m_baCacheHeader, baOutput) ||
+		(bBuiltin && bEndField &&
+		TagExtractor::extract(sFileName, baOutput))) {
+		m_baCacheHeader = QByteArray();
+		parseOutput(baOutput);
+		emit finished(m_nRecords);
+		return true;
+	}
+	
+	if (!slArgs.isEmpty() && run("ctags", slArgs)) {
+		m_state = Name;
+		m_delim = Tab;
+		return true;
+	}
+	
+	m_baCacheHeader = QByteArray();
+	return false;
+}
+
+/**
+ * Creates the Ctags command line, not including the input and output files.
+ * @return	The executable followed by its arguments, or an empty list if the
+ *			path to Ctags is not set
+ */
+QStringList CtagsFrontend::getArgs()
 {
 	QString sPath;
 	QStringList slArgs;
@@ -47,28 +123,75 @@ bool CtagsFrontend::run(const QString& sFileName)
 
     if (sPath == "") {
         dp("ctags path is empty");
-        return false;
+        return slArgs;
     }
 
-	// Set the command line arguments
 	slArgs.append(sPath);
 	slArgs.append("--excmd=n");
 	slArgs.append("-u"); // don't sort
-	slArgs.append("-f");
-	slArgs.append("-");
+	
+	// Report the lines on which scopes end (rejected by Exuberant Ctags)
+	if (supportsEndField(sPath))
+		slArgs.append("--fields=+e");
 	
 	// Per-project command-line arguments
 	slArgs += s_slExtraArgs;
 	
-	slArgs.append(sFileName);
+	return slArgs;
+}
 
-	// Initialize stdout parsing
-    if (run("ctags", slArgs)) {
-        m_state = Name;
-        m_delim = Tab;
-        return true;
-    }
-    return false;
+/**
+ * Starts querying the version of the given Ctags executable.
+ * Should be called whenever the path of Ctags is set, so that the version is
+ * known by the time the command line is created (@see supportsEndField()).
+ * The executable is only queried once, until a different path is given.
+ * @param	sPath	The path of the Ctags executable
+ */
+void CtagsFrontend::checkVersion(const QString& sPath)
+{
+	if (sPath == s_sCheckedPath)
+		return;
+
+	delete s_pVersionProc;
+	s_sCheckedPath = sPath;
+	s_bEndField = false;
+
+	// The output is read once the process has finished
+	s_pVersionProc = new QProcess();
+	s_pVersionProc->start(sPath, QStringList("--version"));
+}
+
+/**
+ * Determines whether the given Ctags executable can report the lines on
+ * which scopes end (the "end:" field.)
+ * Only Universal Ctags is recognised (by the name it reports with its
+ * version), other implementations are assumed not to support the field.
+ * If the version of the executable was not queried yet, or the query has not
+ * finished, waits for at most CTAGS_VERSION_TIMEOUT milliseconds.
+ * @param	sPath	The path of the Ctags executable
+ * @return	true if the "end:" field is supported, false otherwise
+ */
+bool CtagsFrontend::supportsEndField(const QString& sPath)
+{
+	checkVersion(sPath);
+	if (s_pVersionProc == NULL)
+		return s_bEndField;
+
+	if (s_pVersionProc->state() != QProcess::NotRunning)
+		s_pVersionProc->waitForFinished(CTAGS_VERSION_TIMEOUT);
+
+	if (s_pVersionProc->state() == QProcess::NotRunning &&
+		s_pVersionProc->exitStatus() == QProcess::NormalExit) {
+		s_bEndField = s_pVersionProc->readAllStandardOutput()
+			.contains("Universal Ctags");
+	} else {
+		s_pVersionProc->kill();
+		s_pVersionProc->waitForFinished(CTAGS_VERSION_TIMEOUT);
+	}
+
+	delete s_pVersionProc;
+	s_pVersionProc = NULL;
+	return s_bEndField;
 }
 
 /**
@@ -88,6 +211,7 @@ bool CtagsFrontend::verify(const QString& sPath)
 		return false;
 	}
 
+	checkVersion(sPath);
 	return true;
 }
 
@@ -103,13 +227,13 @@ void CtagsFrontend::setExtraArgs(const QString& sArgs)
 
 /**
  * Parses the output of a Ctags process.
- * @param	sToken	The current token read (the token delimiter is determined
+ * @param	token	The current token read (the token delimiter is determined
  *					by the current state)
  * @param	delim	The delimiter that ends this token
  * @return	A value indicating the way this token should be treated: dropped,
  *			added to the token queue, or finishes a new record
  */
-Frontend::ParseResult CtagsFrontend::parseStdout(QString& sToken,
+Frontend::ParseResult CtagsFrontend::parseStdout(FrontendToken& token,
 	ParserDelim delim)
 {
 	ParseResult result = DiscardToken;
@@ -117,7 +241,7 @@ Frontend::ParseResult CtagsFrontend::parseStdout(QString& sToken,
 	// Handle the token according to the current state
 	switch (m_state) {
 	case Name:
-		if (sToken.left(6) == "ctags:") {
+		if (token.startsWith("ctags:")) {
 			m_state = Other;
 			m_delim = Newline;
 			break;
@@ -133,7 +257,8 @@ Frontend::ParseResult CtagsFrontend::parseStdout(QString& sToken,
 		break;
 
 	case Line:
-		sToken = sToken.left(sToken.length() - 2);
+		// Remove the trailing ';"'
+		token.chop(2);
 		m_state = Type;
 		m_delim = All;
 		result = AcceptToken;
@@ -143,13 +268,25 @@ Frontend::ParseResult CtagsFrontend::parseStdout(QString& sToken,
 		if (delim == Newline) {
 			m_state = Name;
 			m_delim = Tab;
+			result = RecordReady;
 		}
 		else {
-			m_state = Other;
-			m_delim = Newline;
+			m_state = Fields;
+			m_delim = (ParserDelim)(Tab | Newline);
+			result = AcceptToken;
+		}
+		break;
+
+	case Fields:
+		// Keep only the "end:" field
+		if (delim == Newline) {
+			m_state = Name;
+			m_delim = Tab;
+			result = token.startsWith("end:") ? RecordReady : RecordEnded;
+		}
+		else if (token.startsWith("end:")) {
+			result = AcceptToken;
 		}
-		
-		result = RecordReady;
 		break;
 
 	case Other:
@@ -162,3 +299,53 @@ Frontend::ParseResult CtagsFrontend::parseStdout(QString& sToken,
 
 	return result;
 }
+
+/**
+ * Stores the tags of the file once Ctags has exited successfully.
+ */
+void CtagsFrontend::finalize()
+{
+	if (!m_baCacheHeader.isEmpty() && exitStatus() == QProcess::NormalExit &&
+		exitCode() == 0) {
+		CtagsCache::insert(m_sFileName, m_baCacheHeader, m_baRecords);
+	}
+	
+	m_baCacheHeader = QByteArray();
+	m_baRecords = QByteArray();
+}
+
+/**
+ * Copies the records of the current run, so that they can be stored in the
+ * cache once Ctags exits.
+ * The records are written in the same format as the output of Ctags (with
+ * the file name replaced by a '-'), so that they can be parsed again by
+ * parseStdout().
+ * This slot is connected to the dataReady() signal of this object.
+ * @param	batch	The block of records
+ */
+void CtagsFrontend::slotCollectRecords(const FrontendBatch& batch)
+{
+	FrontendToken* pName, * pLine, * pType, * pEnd;
+	int i;
+	
+	if (m_baCacheHeader.isEmpty())
+		return;
+	
+	for (i = 0; i < batch.count(); i++) {
+		pName = batch.at(i);
+		pLine = pName->getNext();
+		pType = pLine->getNext();
+		pEnd = pType->getNext();
+		
+		m_baRecords.append(pName->getText(), pName->getLength());
+		m_baRecords += "\t-\t";
+		m_baRecords.append(pLine->getText(), pLine->getLength());
+		m_baRecords += ";\"\t";
+		m_baRecords.append(pType->getText(), pType->getLength());
+		if (pEnd != NULL) {
+			m_baRecords += '\t';
+			m_baRecords.append(pEnd->getText(), pEnd->getLength());
+		}
+		m_baRecords += '\n';
+	}
+}
@@ -3,7 +3,10 @@
 
 #include "frontend.h"
 
-#define CTAGS_RECORD_SIZE 3
+#define CTAGS_RECORD_SIZE 4
+
+/** The maximal time, in milliseconds, to wait for the version of Ctags. */
+#define CTAGS_VERSION_TIMEOUT 2000
 
 /**
  * Controls a Ctags process for an file in an EditorPage window.
@@ -15,8 +18,14 @@
  * - Tag type
  * - Tag name
  * - Line number
+ * - The line on which the tag's scope ends (the "end:" extension field, only
+ *   if reported for this tag)
  * The records are then displayed in the CtagsList widget that is attached to
  * each EditorPage window.
+ * The output of each run is stored by CtagsCache, and a file whose tags are
+ * found in the cache, or in the project's tag index (@see CtagsIndex), is
+ * not passed to Ctags at all. The tags of C and C++ files may also be
+ * extracted in-process (@see TagExtractor).
  * @author Elad Lahav
  */
 
@@ -33,20 +42,48 @@ public:
 	bool run(const QString&);
 	
 	static bool verify(const QString&);
+	static void checkVersion(const QString&);
 	static void setExtraArgs(const QString&);
+	static QStringList getArgs();
 	
 protected:
-	virtual ParseResult parseStdout(QString&, ParserDelim);
+	virtual ParseResult parseStdout(FrontendToken&, ParserDelim);
+	virtual void finalize();
 
 private:
 	/** State values for the parser state machine. */
-	enum ParserState { Name = 0, File, Line, Type, Other };
+	enum ParserState { Name = 0, File, Line, Type, Fields, Other };
 
 	/** The current state of the parser state machine. */
 	ParserState m_state;
 	
+	/** The file on which Ctags is run. */
+	QString m_sFileName;
+	
+	/** Identifies the contents of the file for the cache (empty if the
+		output should not be cached.) */
+	QByteArray m_baCacheHeader;
+	
+	/** The records of the current run, in the output format of Ctags. */
+	QByteArray m_baRecords;
+	
 	/** Additional ommand-line arguments (per-project). */
 	static QStringList s_slExtraArgs;
+
+	/** The Ctags executable last checked by supportsEndField(). */
+	static QString s_sCheckedPath;
+
+	/** Whether the last checked executable reports the "end:" field. */
+	static bool s_bEndField;
+
+	/** Queries the version of the checked executable (NULL once the result
+		was read.) */
+	static QProcess* s_pVersionProc;
+
+	static bool supportsEndField(const QString&);
+
+private slots:
+	void slotCollectRecords(const FrontendBatch&);
 };
 
 #endif
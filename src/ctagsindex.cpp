@@ -0,0 +1,254 @@
+#include <string.h>
+#include <qdir.h>
+#include <qfileinfo.h>
+#include <qdatetime.h>
+#include <qcryptographichash.h>
+#include "ctagsindex.h"
+#include "ctagsfrontend.h"
+
+QFile CtagsIndex::s_file;
+const uchar* CtagsIndex::s_pData = NULL;
+const CtagsIndex::Header* CtagsIndex::s_pHeader = NULL;
+const CtagsIndex::File* CtagsIndex::s_pFiles = NULL;
+const CtagsIndex::Record* CtagsIndex::s_pTags = NULL;
+const quint32* CtagsIndex::s_pNames = NULL;
+const quint32* CtagsIndex::s_pPaths = NULL;
+const char* CtagsIndex::s_pPool = NULL;
+
+/**
+ * Loads the tag index of the given project.
+ * Any previously-loaded index is released first.
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ * @return	true if successful, false if the index does not exist, is
+ *			corrupted, or was built with a different Ctags command line
+ */
+bool CtagsIndex::load(const QString& sProjPath)
+{
+	const Header* pHeader;
+	qint64 nSize, nExpected;
+	QByteArray baArgs;
+
+	reset();
+
+	s_file.setFileName(QDir(sProjPath).absoluteFilePath(CTAGS_INDEX_FILE));
+	if (!s_file.open(QIODevice::ReadOnly))
+		return false;
+
+	nSize = s_file.size();
+	if (nSize < (qint64)sizeof(Header)) {
+		s_file.close();
+		return false;
+	}
+
+	s_pData = s_file.map(0, nSize);
+	if (s_pData == NULL) {
+		s_file.close();
+		return false;
+	}
+
+	// Validate the header, and make sure the tables fit in the file
+	pHeader = (const Header*)s_pData;
+	baArgs = getArgsHash();
+	nExpected = sizeof(Header) + (qint64)pHeader->nFiles * sizeof(File) +
+		(qint64)pHeader->nTags * sizeof(Record) +
+		(qint64)pHeader->nTags * sizeof(quint32) +
+		(qint64)pHeader->nFiles * sizeof(quint32) + pHeader->nPool;
+	if ((pHeader->nMagic != CTAGS_INDEX_MAGIC) ||
+		(pHeader->nVersion != CTAGS_INDEX_VERSION) ||
+		(memcmp(pHeader->arrArgs, baArgs.data(), sizeof(pHeader->arrArgs))
+			!= 0) ||
+		(nExpected != nSize) || (pHeader->nPool == 0) ||
+		(s_pData[nSize - 1] != 0)) {
+		reset();
+		return false;
+	}
+
+	s_pHeader = pHeader;
+	s_pFiles = (const File*)(s_pData + sizeof(Header));
+	s_pTags = (const Record*)(s_pFiles + pHeader->nFiles);
+	s_pNames = (const quint32*)(s_pTags + pHeader->nTags);
+	s_pPaths = s_pNames + pHeader->nTags;
+	s_pPool = (const char*)(s_pPaths + pHeader->nFiles);
+
+	return true;
+}
+
+/**
+ * Releases the loaded index.
+ */
+void CtagsIndex::reset()
+{
+	if (s_pData != NULL)
+		s_file.unmap((uchar*)s_pData);
+
+	s_file.close();
+	s_pData = NULL;
+	s_pHeader = NULL;
+	s_pFiles = NULL;
+	s_pTags = NULL;
+	s_pNames = NULL;
+	s_pPaths = NULL;
+	s_pPool = NULL;
+}
+
+/**
+ * Computes the hash identifying the Ctags command line with which the index
+ * is built.
+ * @return	The MD5 hash of the command line
+ */
+QByteArray CtagsIndex::getArgsHash()
+{
+	return QCryptographicHash::hash(CtagsFrontend::getArgs().join("\n")
+		.toUtf8(), QCryptographicHash::Md5);
+}
+
+/**
+ * Returns the tags of a file, in the output format of Ctags.
+ * The tags are only returned if the file was not modified since the index
+ * was built.
+ * @param	sFile		The full path of the file
+ * @param	baOutput	Holds the tags, one per line, upon successful return
+ * @return	true if successful, false if no index is loaded, the file is not
+ *			a part of the index, or it was modified since it was indexed
+ */
+bool CtagsIndex::getFileTags(const QString& sFile, QByteArray& baOutput)
+{
+	const File* pFile;
+	const Record* pTag;
+	quint32 i;
+
+	pFile = findFile(QFile::encodeName(sFile));
+	if ((pFile == NULL) || !isCurrent(pFile, sFile))
+		return false;
+
+	baOutput.resize(0);
+	for (i = 0; i < pFile->nCount; i++) {
+		pTag = &s_pTags[pFile->nFirst + i];
+		baOutput += s_pPool + pTag->nName;
+		baOutput += "\t-\t";
+		baOutput += QByteArray::number(pTag->nLine);
+		baOutput += ";\"\t";
+		baOutput += (char)pTag->nKind;
+		if (pTag->nEnd > 0) {
+			baOutput += "\tend:";
+			baOutput += QByteArray::number(pTag->nEnd);
+		}
+
+		baOutput += '\n';
+	}
+
+	return true;
+}
+
+/**
+ * Finds all tags with the given name.
+ * As with getFileTags(), tags are only returned if the files holding them
+ * were not modified since the index was built. Since the lines of the tags
+ * may have changed, and so may have the set of files holding the name, no
+ * tags are returned if any of these files was modified.
+ * @param	sName	The name to look for
+ * @param	szKinds	The kinds of tags to return (a string of single-letter
+ *					kinds, as reported by Ctags), or NULL for all tags
+ * @param	lstTags	Holds the matching tags, ordered by file and line, upon
+ *					successful return
+ * @return	true if any tags were found, false if there are no such tags, or
+ *			any of the files holding them was modified
+ */
+bool CtagsIndex::find(const QString& sName, const char* szKinds,
+	QList<Tag>& lstTags)
+{
+	QByteArray baName;
+	const Record* pTag;
+	Tag tag;
+	quint32 nLow, nHigh, nMid, nFile;
+
+	lstTags.clear();
+	if (s_pData == NULL)
+		return false;
+
+	// Find the first tag with the given name
+	baName = sName.toUtf8();
+	nLow = 0;
+	nHigh = s_pHeader->nTags;
+	while (nLow < nHigh) {
+		nMid = nLow + (nHigh - nLow) / 2;
+		if (strcmp(s_pPool + s_pTags[s_pNames[nMid]].nName, baName.data()) < 0)
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+
+	// Collect all tags with the name, skipping those of other kinds
+	for (; nLow < s_pHeader->nTags; nLow++) {
+		pTag = &s_pTags[s_pNames[nLow]];
+		if (strcmp(s_pPool + pTag->nName, baName.data()) != 0)
+			break;
+
+		if ((szKinds != NULL) && (strchr(szKinds, (char)pTag->nKind) == NULL))
+			continue;
+
+		// Tags are ordered by file, check each file once
+		if (lstTags.isEmpty() || (pTag->nFile != nFile)) {
+			nFile = pTag->nFile;
+			tag.sFile = QFile::decodeName(s_pPool + s_pFiles[nFile].nPath);
+			if (!isCurrent(&s_pFiles[nFile], tag.sFile)) {
+				lstTags.clear();
+				return false;
+			}
+		}
+
+		tag.sName = sName;
+		tag.nLine = pTag->nLine;
+		tag.cKind = (char)pTag->nKind;
+		lstTags.append(tag);
+	}
+
+	return !lstTags.isEmpty();
+}
+
+/**
+ * Determines whether a file has not changed since it was indexed, by
+ * comparing its size and modification time with those stored in the index.
+ * @param	pFile	The file's entry
+ * @param	sFile	The full path of the file
+ * @return	true if the file has not changed, false otherwise
+ */
+bool CtagsIndex::isCurrent(const File* pFile, const QString& sFile)
+{
+	QFileInfo fi(sFile);
+
+	return fi.isFile() && (pFile->nSize == (quint32)fi.size()) &&
+		(pFile->nTime == (quint32)fi.lastModified().toTime_t());
+}
+
+/**
+ * Looks up a file in the index.
+ * @param	baPath	The encoded full path of the file
+ * @return	The file's entry, or NULL if the file is not in the index
+ */
+const CtagsIndex::File* CtagsIndex::findFile(const QByteArray& baPath)
+{
+	quint32 nLow, nHigh, nMid;
+	int nResult;
+
+	if (s_pData == NULL)
+		return NULL;
+
+	nLow = 0;
+	nHigh = s_pHeader->nFiles;
+	while (nLow < nHigh) {
+		nMid = nLow + (nHigh - nLow) / 2;
+		nResult = strcmp(s_pPool + s_pFiles[s_pPaths[nMid]].nPath,
+			baPath.data());
+		if (nResult == 0)
+			return &s_pFiles[s_pPaths[nMid]];
+
+		if (nResult < 0)
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+
+	return NULL;
+}
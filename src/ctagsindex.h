@@ -0,0 +1,171 @@
+#ifndef CTAGSINDEX_H
+#define CTAGSINDEX_H
+
+#include <qfile.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qbytearray.h>
+#include <qlist.h>
+
+/** The name of the project-wide tag index, in the project directory. */
+#define CTAGS_INDEX_FILE	"ctags.idx"
+
+/** Identifies the format of the index file. */
+#define CTAGS_INDEX_MAGIC	0x4b535449
+
+/** The version of the index file format. */
+#define CTAGS_INDEX_VERSION	2
+
+/** The kinds of tags that define a symbol (rather than declare it), for C
+	and C++ files. */
+#define CTAGS_DEF_KINDS	"cdefgmnstuv"
+
+/**
+ * Holds the tags of all files in a project.
+ * The index is built by CtagsIndexBuilder, and is read by mapping the index
+ * file into memory, so that loading it does not depend on the size of the
+ * project. The file holds the following tables, following a header:
+ * - Files: the path, size and modification time of each project file, as
+ *   well as the range of its tags in the tag table
+ * - Tags: the name, file, line, kind and scope end line of each tag, ordered
+ *   by file and line
+ * - Names: the tags, ordered by name
+ * - Paths: the files, ordered by path
+ * - A pool of NULL-terminated strings, holding the names of the tags and the
+ *   paths of the files
+ * All numbers are stored in the native byte order, and the header records
+ * the Ctags command line used to build the index. An index built with
+ * different arguments (or on a different machine) is not loaded.
+ * Files modified since the index was built are not served from the index,
+ * and their tags need to be produced by Ctags.
+ * @author Elad Lahav
+ */
+class CtagsIndex
+{
+public:
+	/**
+	 * A single tag, as returned by find().
+	 */
+	struct Tag
+	{
+		/** The name of the tag. */
+		QString sName;
+
+		/** The full path of the file holding the tag. */
+		QString sFile;
+
+		/** The line on which the tag is defined. */
+		uint nLine;
+
+		/** The kind of the tag (the single-letter kind reported by Ctags.) */
+		char cKind;
+	};
+
+	static bool load(const QString&);
+	static void reset();
+	static QByteArray getArgsHash();
+	static bool getFileTags(const QString&, QByteArray&);
+	static bool find(const QString&, const char*, QList<Tag>&);
+
+	/**
+	 * @return	true if an index is loaded, false otherwise
+	 */
+	static bool isLoaded() { return s_pData != NULL; }
+
+	/**
+	 * The header of the index file.
+	 */
+	struct Header
+	{
+		/** Should be CTAGS_INDEX_MAGIC. */
+		quint32 nMagic;
+
+		/** Should be CTAGS_INDEX_VERSION. */
+		quint32 nVersion;
+
+		/** The MD5 hash of the Ctags command line. */
+		char arrArgs[16];
+
+		/** The number of entries in the file table. */
+		quint32 nFiles;
+
+		/** The number of entries in the tag table. */
+		quint32 nTags;
+
+		/** The size of the string pool. */
+		quint32 nPool;
+	};
+
+	/**
+	 * An entry in the file table.
+	 */
+	struct File
+	{
+		/** The position of the file's path in the string pool. */
+		quint32 nPath;
+
+		/** The index of the file's first tag. */
+		quint32 nFirst;
+
+		/** The number of tags in the file. */
+		quint32 nCount;
+
+		/** The size of the file when it was indexed (modulo 2^32.) */
+		quint32 nSize;
+
+		/** The modification time of the file when it was indexed. */
+		quint32 nTime;
+	};
+
+	/**
+	 * An entry in the tag table.
+	 */
+	struct Record
+	{
+		/** The position of the tag's name in the string pool. */
+		quint32 nName;
+
+		/** The index of the file holding the tag. */
+		quint32 nFile;
+
+		/** The line on which the tag is defined. */
+		quint32 nLine;
+
+		/** The kind of the tag. */
+		quint32 nKind;
+
+		/** The line on which the tag's scope ends (the "end:" field), 0 if
+			not reported. */
+		quint32 nEnd;
+	};
+
+private:
+	/** The index file. */
+	static QFile s_file;
+
+	/** The mapped contents of the index file, NULL if no index is loaded. */
+	static const uchar* s_pData;
+
+	/** The header of the loaded index. */
+	static const Header* s_pHeader;
+
+	/** The file table. */
+	static const File* s_pFiles;
+
+	/** The tag table. */
+	static const Record* s_pTags;
+
+	/** Indices of the tags, ordered by name. */
+	static const quint32* s_pNames;
+
+	/** Indices of the files, ordered by path. */
+	static const quint32* s_pPaths;
+
+	/** The string pool. */
+	static const char* s_pPool;
+
+	static const File* findFile(const QByteArray&);
+	static bool isCurrent(const File*, const QString&);
+};
+
+#endif
@@ -0,0 +1,533 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <qapplication.h>
+#include <qdir.h>
+#include <qfile.h>
+#include <qprocess.h>
+#include "ctagsindexbuilder.h"
+#include "ctagsfrontend.h"
+
+int CtagsIndexEvent::eventTypeId = QEvent::None;
+
+/**
+ * Class constructor.
+ * @param	sProjPath	The project directory for which the index was built
+ * @param	bSuccess	true if the index was written successfully, false
+ *						otherwise
+ */
+CtagsIndexEvent::CtagsIndexEvent(const QString& sProjPath, bool bSuccess) :
+	QEvent(QEvent::Type(CtagsIndexEvent::eventTypeId)),
+	m_sProjPath(sProjPath),
+	m_bSuccess(bSuccess)
+{
+}
+
+int CtagsIndexEvent::registerIndexEventType()
+{
+	CtagsIndexEvent::eventTypeId =
+		QEvent::registerEventType(CtagsIndexEvent::EventId);
+	return CtagsIndexEvent::eventTypeId;
+}
+
+/**
+ * Orders the indices of entries in a table by the strings they refer to.
+ * Entries referring to the same string retain their relative order.
+ * @author Elad Lahav
+ */
+class CtagsIndexLessThan
+{
+public:
+	/**
+	 * Class constructor.
+	 * @param	pPool	The string pool
+	 * @param	pOffsets	The position in the pool of each entry's string
+	 * @param	nStride		The distance, in 32-bit words, between the
+	 *						string positions of consecutive entries
+	 */
+	CtagsIndexLessThan(const char* pPool, const quint32* pOffsets,
+		int nStride) : m_pPool(pPool), m_pOffsets(pOffsets),
+		m_nStride(nStride) {}
+
+	/**
+	 * @param	nIndex1	The index of the first entry
+	 * @param	nIndex2	The index of the second entry
+	 * @return	true if the first entry should precede the second, false
+	 *			otherwise
+	 */
+	bool operator()(quint32 nIndex1, quint32 nIndex2) const {
+		int nResult;
+
+		nResult = strcmp(m_pPool + m_pOffsets[nIndex1 * m_nStride],
+			m_pPool + m_pOffsets[nIndex2 * m_nStride]);
+		if (nResult != 0)
+			return nResult < 0;
+
+		return nIndex1 < nIndex2;
+	}
+
+private:
+	/** The string pool. */
+	const char* m_pPool;
+
+	/** The string position of the first entry. */
+	const quint32* m_pOffsets;
+
+	/** The distance between the string positions of consecutive entries. */
+	int m_nStride;
+};
+
+/**
+ * Orders tags by file and line.
+ * @param	tag1	The first tag
+ * @param	tag2	The second tag
+ * @return	true if the first tag should precede the second, false otherwise
+ */
+static bool tagLessThan(const CtagsIndex::Record& tag1,
+	const CtagsIndex::Record& tag2)
+{
+	if (tag1.nFile != tag2.nFile)
+		return tag1.nFile < tag2.nFile;
+
+	return tag1.nLine < tag2.nLine;
+}
+
+/**
+ * Class constructor.
+ * @param	pEventReceiver	Pointer to an object to receive the
+ *							CtagsIndexEvent once the index is built
+ */
+CtagsIndexBuilder::CtagsIndexBuilder(QObject* pEventReceiver) : QThread(),
+	m_pEventReceiver(pEventReceiver),
+	m_bCancel(false)
+{
+	if (CtagsIndexEvent::eventTypeId == QEvent::None)
+		CtagsIndexEvent::registerIndexEventType();
+}
+
+/**
+ * Class destructor.
+ */
+CtagsIndexBuilder::~CtagsIndexBuilder()
+{
+	stop();
+}
+
+/**
+ * Starts building the tag index of a project.
+ * A build in progress is stopped first.
+ * @param	sProjPath	The full path of the directory holding the project
+ *						files
+ */
+void CtagsIndexBuilder::start(const QString& sProjPath)
+{
+	stop();
+
+	// The command line is determined by the project's settings, and so
+	// needs to be read by the main thread
+	m_sProjPath = sProjPath;
+	m_slArgs = CtagsFrontend::getArgs();
+	m_baArgsHash = CtagsIndex::getArgsHash();
+	if (m_slArgs.isEmpty())
+		return;
+
+	m_bCancel = false;
+	QThread::start(QThread::LowPriority);
+}
+
+/**
+ * Stops the current build, and waits for the thread to terminate.
+ * The existing index is not modified.
+ */
+void CtagsIndexBuilder::stop()
+{
+	if (!isRunning())
+		return;
+
+	m_bCancel = true;
+	wait();
+}
+
+/**
+ * Builds the index.
+ * This is the thread's main function.
+ */
+void CtagsIndexBuilder::run()
+{
+	QDir dir(m_sProjPath);
+	bool bResult;
+	int i, nShards;
+
+	// Write the file lists, and run Ctags on all shards
+	nShards = split();
+	bResult = (nShards > 0) && runCtags(nShards);
+
+	// Merge the output into the index
+	for (i = 0; i < nShards; i++) {
+		if (bResult && !m_bCancel)
+			readTags(dir.absoluteFilePath(QString(CTAGS_SHARD_TAGS).arg(i)));
+
+		dir.remove(QString(CTAGS_SHARD_FILES).arg(i));
+		dir.remove(QString(CTAGS_SHARD_TAGS).arg(i));
+	}
+
+	bResult = bResult && !m_bCancel && write();
+	clear();
+
+	// A cancelled build is not reported
+	if (!m_bCancel) {
+		QApplication::postEvent(m_pEventReceiver,
+			new CtagsIndexEvent(m_sProjPath, bResult));
+	}
+}
+
+/**
+ * Reads the project's file list, and divides the files into shards of
+ * consecutive files (thus, files in the same directory usually belong to
+ * the same shard.)
+ * A file list is written for each shard, and an entry is added to the file
+ * table for every file.
+ * @return	The number of shards, 0 on failure
+ */
+int CtagsIndexBuilder::split()
+{
+	QDir dir(m_sProjPath);
+	QFile file(dir.absoluteFilePath("cscope.files"));
+	QList<QByteArray> lstFiles;
+	QByteArray baLine;
+	int i, j, nShards, nFirst, nLast;
+
+	if (!file.open(QIODevice::ReadOnly))
+		return 0;
+
+	// Option lines, beginning with a dash, are meant for Cscope only
+	while (!file.atEnd()) {
+		baLine = file.readLine().trimmed();
+		if (baLine.isEmpty() || baLine.at(0) == '-')
+			continue;
+
+		if (baLine.size() > 1 && baLine.startsWith('"') &&
+			baLine.endsWith('"')) {
+			baLine = baLine.mid(1, baLine.size() - 2);
+		}
+
+		addFile(baLine);
+		lstFiles.append(baLine);
+	}
+
+	file.close();
+
+	if (lstFiles.isEmpty())
+		return 0;
+
+	// Write the file list of each shard
+	nShards = qBound(1, QThread::idealThreadCount(), lstFiles.count());
+	for (i = 0; i < nShards; i++) {
+		file.setFileName(dir.absoluteFilePath(QString(CTAGS_SHARD_FILES)
+			.arg(i)));
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+			return 0;
+
+		nFirst = (int)((qint64)lstFiles.count() * i / nShards);
+		nLast = (int)((qint64)lstFiles.count() * (i + 1) / nShards);
+		for (j = nFirst; j < nLast; j++)
+			file.write(lstFiles[j] + '\n');
+
+		file.close();
+	}
+
+	return nShards;
+}
+
+/**
+ * Runs a Ctags process on each shard, and waits for all processes to exit.
+ * If the build is stopped, all processes are killed.
+ * @param	nShards	The number of shards
+ * @return	true if all processes completed successfully, false otherwise
+ */
+bool CtagsIndexBuilder::runCtags(int nShards)
+{
+	QList<QProcess*> lstProcs;
+	QProcess* pProc;
+	QStringList slArgs;
+	bool bResult;
+	int i;
+
+	// Start the processes
+	bResult = true;
+	for (i = 0; i < nShards; i++) {
+		pProc = new QProcess();
+		pProc->setWorkingDirectory(m_sProjPath);
+		pProc->setStandardOutputFile("/dev/null");
+		pProc->setStandardErrorFile("/dev/null");
+		lstProcs.append(pProc);
+
+		slArgs = m_slArgs.mid(1);
+		slArgs << "-f" << QString(CTAGS_SHARD_TAGS).arg(i) << "-L" <<
+			QString(CTAGS_SHARD_FILES).arg(i);
+		pProc->start(m_slArgs.first(), slArgs);
+		if (!pProc->waitForStarted()) {
+			bResult = false;
+			break;
+		}
+	}
+
+	// Wait for all processes to exit
+	for (i = 0; i < lstProcs.count(); i++) {
+		pProc = lstProcs[i];
+		while (pProc->state() != QProcess::NotRunning) {
+			if (m_bCancel || !bResult)
+				pProc->kill();
+
+			pProc->waitForFinished(CTAGS_INDEX_POLL);
+		}
+
+		if ((pProc->exitStatus() != QProcess::NormalExit) ||
+			(pProc->exitCode() != 0)) {
+			bResult = false;
+		}
+	}
+
+	qDeleteAll(lstProcs);
+	return bResult && !m_bCancel;
+}
+
+/**
+ * Adds an entry to the file table.
+ * The size and modification time of the file are recorded, so that its
+ * tags are only used while it remains unchanged.
+ * @param	baPath	The encoded full path of the file
+ */
+void CtagsIndexBuilder::addFile(const QByteArray& baPath)
+{
+	CtagsIndex::File entry;
+	struct stat st;
+
+	if (m_hashFiles.contains(baPath))
+		return;
+
+	entry.nPath = addString(baPath);
+	entry.nFirst = 0;
+	entry.nCount = 0;
+	entry.nSize = 0;
+	entry.nTime = 0;
+	if (stat(baPath.data(), &st) == 0) {
+		entry.nSize = (quint32)st.st_size;
+		entry.nTime = (quint32)st.st_mtime;
+	}
+
+	m_hashFiles.insert(baPath, m_vecFiles.size());
+	m_vecFiles.append(entry);
+}
+
+/**
+ * Adds the tags written by a Ctags process to the tag table.
+ * Each line in the output has the following format (with the "-n" option):
+ * name<TAB>file<TAB>line;"<TAB>kind[<TAB>extra fields]
+ * Of the extra fields, only "end:" is kept.
+ * @param	sPath	The path of the Ctags output file
+ */
+void CtagsIndexBuilder::readTags(const QString& sPath)
+{
+	QFile file(sPath);
+	QHash<QByteArray, quint32>::ConstIterator itr;
+	CtagsIndex::Record tag;
+	const char* pData, * pEnd, * pLine, * pEol, * pFile, * pAddr, * pField;
+	char* pKind;
+	QByteArray baName, baFile;
+
+	if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+		return;
+
+	pData = (const char*)file.map(0, file.size());
+	if (pData == NULL)
+		return;
+
+	pEnd = pData + file.size();
+	for (pLine = pData; pLine < pEnd && !m_bCancel; pLine = pEol + 1) {
+		pEol = (const char*)memchr(pLine, '\n', pEnd - pLine);
+		if (pEol == NULL)
+			break;
+
+		// Skip pseudo-tags
+		if (*pLine == '!')
+			continue;
+
+		// Split the line into fields
+		pFile = (const char*)memchr(pLine, '\t', pEol - pLine);
+		if (pFile == NULL)
+			continue;
+
+		pAddr = (const char*)memchr(pFile + 1, '\t', pEol - pFile - 1);
+		if (pAddr == NULL)
+			continue;
+
+		tag.nLine = (quint32)strtoul(pAddr + 1, &pKind, 10);
+		if ((tag.nLine == 0) || (pKind + 2 >= pEol) ||
+			(strncmp(pKind, ";\"\t", 3) != 0)) {
+			continue;
+		}
+
+		baName = QByteArray(pLine, pFile - pLine);
+		baFile = QByteArray(pFile + 1, pAddr - pFile - 1);
+
+		// Files reported under a different path are added with no time
+		// stamp, so that they are never served from the index
+		itr = m_hashFiles.find(baFile);
+		if (itr == m_hashFiles.end()) {
+			CtagsIndex::File entry = { addString(baFile), 0, 0, 0, 0 };
+			itr = m_hashFiles.insert(baFile, m_vecFiles.size());
+			m_vecFiles.append(entry);
+		}
+
+		tag.nName = addString(baName);
+		tag.nFile = *itr;
+		tag.nKind = (pKind + 3 < pEol) ? (uchar)pKind[3] : ' ';
+
+		// Look for the line on which the tag's scope ends
+		tag.nEnd = 0;
+		for (pField = pKind + 3; pField < pEol; pField++) {
+			pField = (const char*)memchr(pField, '\t', pEol - pField);
+			if (pField == NULL)
+				break;
+
+			if ((pEol - pField > 5) && (strncmp(pField + 1, "end:", 4) == 0)) {
+				tag.nEnd = (quint32)strtoul(pField + 5, NULL, 10);
+				break;
+			}
+		}
+
+		m_vecTags.append(tag);
+	}
+
+	file.unmap((uchar*)pData);
+}
+
+/**
+ * Writes the index file.
+ * The file is written under a temporary name, and then renamed, so that the
+ * existing index (which may be mapped by CtagsIndex) is replaced atomically.
+ * @return	true if successful, false otherwise
+ */
+bool CtagsIndexBuilder::write()
+{
+	QDir dir(m_sProjPath);
+	QString sPath, sTemp;
+	QFile file;
+	CtagsIndex::Header header;
+	QVector<quint32> vecNames, vecPaths;
+	quint32 i, nFile;
+	bool bResult;
+
+	// Order tags by file and line, and find the range of each file's tags
+	qStableSort(m_vecTags.begin(), m_vecTags.end(), tagLessThan);
+	for (i = 0; i < (quint32)m_vecTags.size(); i++) {
+		nFile = m_vecTags[i].nFile;
+		if (m_vecFiles[nFile].nCount == 0)
+			m_vecFiles[nFile].nFirst = i;
+
+		m_vecFiles[nFile].nCount++;
+	}
+
+	// Order the tags by name, and the files by path
+	vecNames.resize(m_vecTags.size());
+	for (i = 0; i < (quint32)vecNames.size(); i++)
+		vecNames[i] = i;
+
+	vecPaths.resize(m_vecFiles.size());
+	for (i = 0; i < (quint32)vecPaths.size(); i++)
+		vecPaths[i] = i;
+
+	if (!m_vecTags.isEmpty()) {
+		qSort(vecNames.begin(), vecNames.end(),
+			CtagsIndexLessThan(m_baPool.constData(), &m_vecTags[0].nName,
+				sizeof(CtagsIndex::Record) / sizeof(quint32)));
+	}
+
+	if (!m_vecFiles.isEmpty()) {
+		qSort(vecPaths.begin(), vecPaths.end(),
+			CtagsIndexLessThan(m_baPool.constData(), &m_vecFiles[0].nPath,
+				sizeof(CtagsIndex::File) / sizeof(quint32)));
+	}
+
+	// The pool always ends with a NULL character
+	if (m_baPool.isEmpty())
+		m_baPool.append('\0');
+
+	memset(&header, 0, sizeof(header));
+	header.nMagic = CTAGS_INDEX_MAGIC;
+	header.nVersion = CTAGS_INDEX_VERSION;
+	memcpy(header.arrArgs, m_baArgsHash.constData(),
+		qMin((int)sizeof(header.arrArgs), m_baArgsHash.size()));
+	header.nFiles = m_vecFiles.size();
+	header.nTags = m_vecTags.size();
+	header.nPool = m_baPool.size();
+
+	sPath = dir.absoluteFilePath(CTAGS_INDEX_FILE);
+	sTemp = sPath + ".tmp";
+	file.setFileName(sTemp);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	bResult = (file.write((const char*)&header, sizeof(header)) ==
+			sizeof(header)) &&
+		(file.write((const char*)m_vecFiles.constData(),
+			m_vecFiles.size() * sizeof(CtagsIndex::File)) ==
+			(qint64)(m_vecFiles.size() * sizeof(CtagsIndex::File))) &&
+		(file.write((const char*)m_vecTags.constData(),
+			m_vecTags.size() * sizeof(CtagsIndex::Record)) ==
+			(qint64)(m_vecTags.size() * sizeof(CtagsIndex::Record))) &&
+		(file.write((const char*)vecNames.constData(),
+			vecNames.size() * sizeof(quint32)) ==
+			(qint64)(vecNames.size() * sizeof(quint32))) &&
+		(file.write((const char*)vecPaths.constData(),
+			vecPaths.size() * sizeof(quint32)) ==
+			(qint64)(vecPaths.size() * sizeof(quint32))) &&
+		(file.write(m_baPool) == m_baPool.size());
+	file.close();
+
+	if (!bResult || rename(QFile::encodeName(sTemp).data(),
+		QFile::encodeName(sPath).data()) != 0) {
+		QFile::remove(sTemp);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Releases the tables built for the index.
+ */
+void CtagsIndexBuilder::clear()
+{
+	m_vecFiles.clear();
+	m_vecTags.clear();
+	m_hashFiles.clear();
+	m_hashNames.clear();
+	m_baPool.clear();
+}
+
+/**
+ * Adds a string to the string pool, unless it was already added.
+ * Thus, the name of a tag is stored once, regardless of the number of tags
+ * with that name.
+ * @param	baText	The string to add
+ * @return	The position of the string in the pool
+ */
+quint32 CtagsIndexBuilder::addString(const QByteArray& baText)
+{
+	QHash<QByteArray, quint32>::ConstIterator itr;
+	quint32 nPos;
+
+	itr = m_hashNames.find(baText);
+	if (itr != m_hashNames.end())
+		return *itr;
+
+	nPos = m_baPool.size();
+	m_baPool.append(baText);
+	m_baPool.append('\0');
+	m_hashNames.insert(baText, nPos);
+	return nPos;
+}
@@ -0,0 +1,108 @@
+#ifndef CTAGSINDEXBUILDER_H
+#define CTAGSINDEXBUILDER_H
+
+#include <qthread.h>
+#include <qevent.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <QHash>
+#include <QVector>
+#include "ctagsindex.h"
+
+/** The name of the file list of an index shard. */
+#define CTAGS_SHARD_FILES	"ctags.%1.files"
+
+/** The name of the Ctags output of an index shard. */
+#define CTAGS_SHARD_TAGS	"ctags.%1.tags"
+
+/** The time, in milliseconds, between checks for cancellation while the
+	Ctags processes are running. */
+#define CTAGS_INDEX_POLL	100
+
+/**
+ * Notifies the main application thread that a tag index was built.
+ * @author Elad Lahav
+ */
+class CtagsIndexEvent : public QEvent
+{
+public:
+	/** The event's unique ID. */
+	enum { EventId = 6928 };
+
+	CtagsIndexEvent(const QString&, bool);
+	static int registerIndexEventType();
+	static int eventTypeId;
+
+	/** The project directory for which the index was built. */
+	QString m_sProjPath;
+
+	/** true if the index was written successfully, false otherwise. */
+	bool m_bSuccess;
+};
+
+/**
+ * Builds the tag index of a project (@see CtagsIndex).
+ * The index is built by a separate thread. The files listed in the project's
+ * cscope.files file are divided into a shard for each available processor,
+ * and a Ctags process is run on the file list of each shard (using the "-L"
+ * option.) Once all processes have exited, their output is merged into the
+ * index file, which replaces the existing one, and a CtagsIndexEvent is
+ * posted to the receiver object.
+ * The size and modification time of each file are recorded before Ctags is
+ * run, so that a file modified during the build is not served from the
+ * index.
+ * @author Elad Lahav
+ */
+class CtagsIndexBuilder : public QThread
+{
+public:
+	CtagsIndexBuilder(QObject*);
+	~CtagsIndexBuilder();
+
+	void start(const QString&);
+	void stop();
+
+protected:
+	virtual void run();
+
+private:
+	/** Pointer to an object that receives the completion event. */
+	QObject* m_pEventReceiver;
+
+	/** The project directory. */
+	QString m_sProjPath;
+
+	/** The Ctags command line, not including the input and output files. */
+	QStringList m_slArgs;
+
+	/** The hash of the Ctags command line, stored in the index header. */
+	QByteArray m_baArgsHash;
+
+	/** Set to true to stop the build. */
+	volatile bool m_bCancel;
+
+	/** The entries of the file table. */
+	QVector<CtagsIndex::File> m_vecFiles;
+
+	/** The entries of the tag table. */
+	QVector<CtagsIndex::Record> m_vecTags;
+
+	/** Maps file paths to their indices in the file table. */
+	QHash<QByteArray, quint32> m_hashFiles;
+
+	/** Maps tag names to their positions in the string pool. */
+	QHash<QByteArray, quint32> m_hashNames;
+
+	/** The string pool. */
+	QByteArray m_baPool;
+
+	int split();
+	bool runCtags(int);
+	void addFile(const QByteArray&);
+	void readTags(const QString&);
+	bool write();
+	void clear();
+	quint32 addString(const QByteArray&);
+};
+
+#endif
@@ -18,12 +18,24 @@
 CtagsListWidget::CtagsListWidget(QWidget* pParent) :
 	SearchListView(HEADER_NAME, pParent),
 	m_nItems(0),
-	m_nCurItem(0),
+	m_nCurItem(-1),
+	m_nCurScope(-1),
 	m_bReady(false),
-	m_nCurLine(0),
-	m_nPendLine(0)
+	m_nPendLine(0),
+	m_bPendSelect(false)
 {
+	int nPix;
+	
     m_pModel = new StringListModel(HEADER_COUNT, this);
+	
+	// Create the icon of each symbol type once, for all tags of this type
+	m_pModel->setIconColumn(HEADER_NAME);
+	for (nPix = KScopePixmaps::SymFunc; nPix <= KScopePixmaps::SymUnknown;
+		nPix++) {
+		m_pModel->setIcon(nPix, QIcon(Pixmaps().getPixmap(
+			(KScopePixmaps::PixName)nPix)));
+	}
+	
     QStringList header;
     header << i18n("Name") << i18n("Line") << i18n("Type");
     m_pModel->setHeader(header);
@@ -69,15 +81,57 @@ CtagsListWidget::~CtagsListWidget()
 }
 
 /**
- * Adds a Ctags output entry to the list.
+ * Adds a block of Ctags output entries to the list.
  * This slot is connected to the dataReady() signal of a CtagsFrontend object.
- * @param	pToken	The first token in the entry
+ * Entries are appended in a single operation (Ctags reports tags in the order
+ * they appear in the file, so the list remains sorted in ascending line
+ * order.)
+ * Each entry is also added to the scope index, under the same row as in the
+ * model.
+ * @param	batch	The block of entries
  */
-void CtagsListWidget::slotDataReady(FrontendToken* pToken)
+void CtagsListWidget::slotDataReady(const FrontendBatch& batch)
 {
+	QList<QStringList> lstRows;
+	QList<int> lstPix;
 	QString sName, sType, sLine;
 	KScopePixmaps::PixName pix;
+	FrontendToken* pToken, * pLine, * pType, * pEnd;
+	int i;
+
+	for (i = 0; i < batch.count(); i++) {
+		pToken = batch.at(i);
+		getEntry(pToken, sName, sLine, sType, pix);
+		
+		lstRows.append(QStringList() << sName << sLine << sType);
+		lstPix.append(pix);
+		
+		// Index the tag by its line, and by the end of its scope (if
+		// reported)
+		pLine = pToken->getNext();
+		pType = pLine->getNext();
+		pEnd = pType->getNext();
+		m_scopes.add(pLine->toInt(), (pEnd != NULL) ? pEnd->toInt(4) : 0,
+			*pType->getText(), sName);
+	}
 
+	// Add the new items to the list
+	m_pModel->addItems(lstRows, lstPix);
+	
+	m_nItems += lstRows.count();
+}
+
+/**
+ * Extracts the fields of a single Ctags output entry.
+ * @param	pToken	The first token in the entry
+ * @param	sName	Holds the name of the symbol, upon return
+ * @param	sLine	Holds the line number, upon return
+ * @param	sType	Holds the (translated) type of the symbol, upon return
+ * @param	pix		Holds the pixmap matching the symbol type, upon return
+ */
+void CtagsListWidget::getEntry(FrontendToken* pToken, QString& sName,
+	QString& sLine, QString& sType, KScopePixmaps::PixName& pix)
+{
 	// Get the name of the symbol
 	sName = pToken->getData();
 	pToken = pToken->getNext();
@@ -88,7 +142,6 @@ void CtagsListWidget::slotDataReady(FrontendToken* pToken)
 
 	// Get the type of the symbol
 	sType = pToken->getData();
-	pToken = pToken->getNext();
 
 	// Set the appropriate pixmap
 	//switch (sType[0].latin1()) {
@@ -152,16 +205,6 @@ void CtagsListWidget::slotDataReady(FrontendToken* pToken)
 		sType = "Unknown";
 		pix = KScopePixmaps::SymUnknown;
 	}
-
-	// Add a new item to the list
-    int row = 0;
-    QStringList itemList;
-    itemList << sName << sLine << sType;
-    m_pModel->addItem(itemList, row);
-
-    QIcon icon(Pixmaps().getPixmap(pix));
-	m_pModel->setIcon(row, HEADER_NAME, icon);
-	m_nItems++;
 }
 
 /**
@@ -228,75 +271,83 @@ void CtagsListWidget::applyPrefs()
 }
 
 /**
- * Selects the symbol that dominates the given line in the source file.
+ * Selects the symbol that dominates the given line in the source file, and
+ * updates the scope of the line.
+ * Both are found through the scope index, so the selection does not depend
+ * on the order of the list.
  * @param	nLine	The requested line
+ * @param	bSelect	true to select the dominating symbol, false to only
+ *					update the scope
  */
-void CtagsListWidget::gotoLine(uint nLine)
+void CtagsListWidget::gotoLine(uint nLine, bool bSelect)
 {
-	int nFrom, nTo, nItem, nDiff;
-    uint mLine;
+	int nItem;
 
 	// Wait until Ctags finishes
 	if (!m_bReady) {
 		m_nPendLine = nLine;
+		m_bPendSelect = bSelect;
 		return;
 	}		
 	
+	m_nPendLine = 0;
+	
 	// Do nothing if no tags are available
 	if (m_nItems == 0)
 		return;
 	
-	// Calculate the difference from the current line
-	nDiff = (int)(nLine - m_nCurLine);
-	m_nCurLine = nLine;
-		
-	// In most cases, all the user does is move to the next or prevuious lines
-	// Handle these simple cases first
-	if (nDiff == -1) {
-		if ((m_nCurItem < m_nItems - 1) && 
-			(getLine(m_nCurItem) > nLine)) {
-			m_nCurItem++;
-		} else {
-			return; // New line corresponds to the same tag
-		}
-	} else if (nDiff == 1) {
-		if ((m_nCurItem > 0) && 
-			(getLine(m_nCurItem - 1) == nLine)) {
-			m_nCurItem--;
-		} else {
-			return; // New line corresponds to the same tag
-		}
-	} else {
-		// Initialise binary search
-		nFrom = m_nItems - 1;
-		nTo = 0;
-		m_nCurItem = 0; // use the first item if nothing else works
-		
-		// Perform a binary search
-		// This algorithm finds the greatest line that is smaller or equal to
-		// the requested line
-		do {
-			nItem = (nFrom + nTo) / 2;
-            mLine = getLine(nItem);
-
-			if (mLine == nLine) {
-				m_nCurItem = nItem;
-				break;
-			} else if (nLine > mLine) {
-				m_nCurItem = nItem;
-				nFrom = nItem - 1;
-			} else {
-				nTo = nItem + 1;
-			}
-		} while (nFrom >= nTo);
+	// Notify of a change to the innermost scope
+	nItem = m_scopes.findScope(nLine);
+	if (nItem != m_nCurScope) {
+		m_nCurScope = nItem;
+		emit scopeChanged(getScope());
 	}
-
-	// Mark the selected item
-	nItem = m_nCurItem;
-
+	
+	// Mark the selected item, unless it is already selected
+	nItem = m_scopes.findTag(nLine);
+	if (!bSelect || nItem == m_nCurItem)
+		return;
+		
+	m_nCurItem = nItem;
     QModelIndex index = m_proxyModel->mapFromSource(m_pModel->index(nItem, HEADER_NAME));
     setCurrentRow(index);
-	m_nPendLine = 0;
+}
+
+/**
+ * Describes the innermost scope of the current line.
+ * @return	The name of the function (followed by parentheses), or the kind
+ *			and name of the structure, class or namespace, an empty string if
+ *			the line is not inside any scope
+ */
+QString CtagsListWidget::getScope() const
+{
+	QString sName;
+	
+	if (m_nCurScope < 0)
+		return QString();
+		
+	sName = m_scopes.getName(m_nCurScope);
+	switch (m_scopes.getKind(m_nCurScope)) {
+	case 'f':
+		return sName + "()";
+		
+	case 'n':
+		return "namespace " + sName;
+		
+	case 's':
+		return "struct " + sName;
+		
+	case 'u':
+		return "union " + sName;
+		
+	case 'c':
+		return "class " + sName;
+		
+	case 'g':
+		return "enum " + sName;
+	}
+	
+	return sName;
 }
 
 /**
@@ -304,25 +355,33 @@ void CtagsListWidget::gotoLine(uint nLine)
  */
 void CtagsListWidget::clear()
 {
-    m_pModel->removeRows(0, m_pModel->rowCount());
+    m_pModel->clear();
+	m_scopes.clear();
 	m_nItems = 0;
-	m_nCurItem = 0;
-	m_nCurLine = 0;
+	m_nCurItem = -1;
 	m_nPendLine = 0;
 	m_bReady = false;
+	
+	if (m_nCurScope >= 0) {
+		m_nCurScope = -1;
+		emit scopeChanged(QString());
+	}
 }
 
 /**
  * Indicates Ctags has finished processing the current file.
- * If a goto operation has been scheduled, it is processed.
+ * The scope index is built, and if a goto operation has been scheduled, it
+ * is processed.
  * @param	nRecords	The number of records generated by Ctags
  */
 void CtagsListWidget::slotCtagsFinished(uint nRecords)
 {
+	m_scopes.build();
+	
 	if (nRecords) {
 		m_bReady = true;
 		if (m_nPendLine)
-			gotoLine(m_nPendLine);
+			gotoLine(m_nPendLine, m_bPendSelect);
 	}
 }
 
@@ -363,9 +422,3 @@ void CtagsListWidget::focusOnEdit()
 {
     m_pEdit->setFocus();
 }
-
-    
-uint CtagsListWidget::getLine(int row)
-{
-    return m_pModel->getString(row, HEADER_LINE).toInt();
-}
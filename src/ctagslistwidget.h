@@ -8,6 +8,8 @@
 #include "searchlistview.h"
 #include "stringlistmodel.h"
 #include "frontend.h"
+#include "kscopepixmaps.h"
+#include "tagscopeindex.h"
 
 /**
  * Displays a list of tags for a source file with QTreeWidget.
@@ -15,6 +17,9 @@
  * opened in that editor, or the current document is changed and saved, the
  * source file is re-scanned for tags, and the results are displayed in this
  * list.
+ * The tags are also kept in a TagScopeIndex, which maps lines in the file to
+ * the tags that dominate them, and to the functions, structures or classes
+ * that hold them, independent of the order in which the list is sorted.
  */
 class CtagsListWidget : public SearchListView
 {
@@ -25,15 +30,15 @@ public:
 	~CtagsListWidget();
 
 	void applyPrefs();
-	void gotoLine(uint);
+	void gotoLine(uint, bool bSelect = true);
 	void clear();
     void focusOnEdit();
-    uint getLine(int row);
+	QString getScope() const;
 	
     virtual bool getTip(QModelIndex &index, QString& sTip);
 	
 public slots:
-	void slotDataReady(FrontendToken*);
+	void slotDataReady(const FrontendBatch&);
 	void slotCtagsFinished(uint);
 	
 signals:
@@ -49,6 +54,14 @@ signals:
 	 */
 	void lineRequested(uint nLine);
 	
+	/**
+	 * Emitted when the innermost function, structure or class holding the
+	 * current line changes.
+	 * @param	sScope	Describes the new scope (an empty string if the line
+	 *					is not inside any scope)
+	 */
+	void scopeChanged(const QString& sScope);
+	
 protected:
 	virtual void resizeEvent(QResizeEvent*);
     virtual void processItemSelected(const QModelIndex &);
@@ -57,19 +70,30 @@ private:
 	/** The number of items in the tag list. */
 	int m_nItems;
 	
-	/** The last item selected by gotoLine(). */
+	/** The last item selected by gotoLine(), -1 if none. */
 	int m_nCurItem;
 	
+	/** The tag defining the innermost scope of the current line, -1 if
+		none. */
+	int m_nCurScope;
+	
 	/** This value is set to 'false' while the Ctags process is running. */
 	bool m_bReady;
 	
-	/** The current line number. */
-	uint m_nCurLine;
-	
 	/** Stores the requested line number during Ctags operation. */
 	uint m_nPendLine;
+	
+	/** Whether the tag of the requested line should be selected, once Ctags
+		finishes. */
+	bool m_bPendSelect;
 
     StringListModel *m_pModel;
+	
+	/** Maps lines to the tags in the list (by their rows in the model.) */
+	TagScopeIndex m_scopes;
+
+	void getEntry(FrontendToken*, QString&, QString&, QString&,
+		KScopePixmaps::PixName&);
 
 private slots:
 	void slotSortChanged(int);
@@ -1,5 +1,12 @@
 #include "husky.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <unistd.h>
 #include <qapplication.h>
+#include <qfile.h>
 #include "dirscanner.h"
 
 int DirScanEvent::eventTypeId = QEvent::None;
@@ -16,17 +23,101 @@ DirScanEvent::DirScanEvent(int nFiles, bool bFinished) :
 {
 }
 
+/**
+ * Runs the scanning loop of a single DirScanner worker.
+ * @author Elad Lahav
+ */
+class DirScanWorker : public QThread
+{
+public:
+	/**
+	 * Class constructor.
+	 * @param	pScanner	The scanner coordinating the workers
+	 * @param	nIndex		The index of this worker's queue
+	 */
+	DirScanWorker(DirScanner* pScanner, int nIndex) : QThread(),
+		m_pScanner(pScanner), m_nIndex(nIndex) {}
+
+protected:
+	/**
+	 * Scans directories until all queues are empty.
+	 */
+	virtual void run() { m_pScanner->work(m_nIndex); }
+
+private:
+	/** The scanner coordinating the workers. */
+	DirScanner* m_pScanner;
+
+	/** The index of this worker's queue. */
+	int m_nIndex;
+};
+
+/**
+ * Parses a space-separated list of wildcard patterns.
+ * @param	sPatterns	The list of patterns
+ */
+void GlobMatcher::compile(const QString& sPatterns)
+{
+	QStringList slPatterns;
+	QStringList::Iterator itr;
+	QByteArray ba;
+
+	m_setSuffixes.clear();
+	m_lstPatterns.clear();
+
+	// Names are matched regardless of case, as QDir does
+	slPatterns = sPatterns.toLower().split(" ", QString::SkipEmptyParts);
+	for (itr = slPatterns.begin(); itr != slPatterns.end(); ++itr) {
+		ba = QFile::encodeName(*itr);
+		if (ba.startsWith("*.") && strpbrk(ba.data() + 1, "*?[\\") == NULL)
+			m_setSuffixes.insert(ba.mid(1));
+		else
+			m_lstPatterns.append(ba);
+	}
+}
+
+/**
+ * @param	szName	A file name
+ * @param	nLen	The length of the name
+ * @return	true if the name matches any of the patterns, false otherwise
+ */
+bool GlobMatcher::matches(const char* szName, int nLen) const
+{
+	QList<QByteArray>::ConstIterator itr;
+	const char* szDot;
+
+	// Look up the name's extension
+	if (!m_setSuffixes.isEmpty()) {
+		szDot = strrchr(szName, '.');
+		if (szDot != NULL &&
+			m_setSuffixes.contains(QByteArray(szDot, szName + nLen - szDot)
+				.toLower())) {
+			return true;
+		}
+	}
+
+	for (itr = m_lstPatterns.begin(); itr != m_lstPatterns.end(); ++itr) {
+		if (fnmatch((*itr).data(), szName, FNM_CASEFOLD) == 0)
+			return true;
+	}
+
+	return false;
+}
+
 /**
  * Class constructor.
  * @param	pEventReceiver	Pointer to an object to receive DirScanEvent
  *							updates
- * @param	pDicFiles		Pointer to a map of current project files (to
- 							avoid duplication)
+ * @param	pFiles			Pointer to the current project files (to avoid
+ *							duplication)
  */
-DirScanner::DirScanner(QObject* pEventReceiver,
-	QHash<QString, QTreeWidgetItem *> *pDicFiles) : QThread(),
+DirScanner::DirScanner(QObject* pEventReceiver, const PathTrie* pFiles) :
+	QThread(),
 	m_pEventReceiver(pEventReceiver),
-	m_pDicFiles(pDicFiles)
+	m_pFiles(pFiles),
+	m_bCancel(false),
+	m_bRecursive(false),
+	m_nBusy(0)
 {
 }
 
@@ -56,93 +147,244 @@ void DirScanner::start(const QString& sDir, const QString& sNameFilter,
 	bool bRecursive)
 {
 	// Initialise the search parameters
-	m_dir = QDir(sDir);
-	m_sNameFilter = sNameFilter;
+	m_sDir = QDir(sDir).absolutePath();
+	m_glob.compile(sNameFilter);
 	m_bCancel = false;
 	m_bRecursive = bRecursive;
 	m_slFiles.clear();
 
+	// The project's file list belongs to the GUI thread, so the workers check
+	// for duplicates against a copy (which shares the trie's data until
+	// either is modified)
+	m_trieExisting = *m_pFiles;
+
 	// Invoke the thread
 	QThread::start();
 }
 
 /**
  * Begins a scan of files on the directory associated with this object.
+ * Starts the worker threads, and reports their progress until all of them
+ * are done.
  * Note that this function is synchronous: it returns when the scan ends.
  */
 void DirScanner::run()
 {
-	int nFiles;
-	
-	nFiles = scanDir(m_dir);
+	int i, nWorkers, nFiles;
+	bool bDone;
 
-	QApplication::postEvent(m_pEventReceiver,
-		new DirScanEvent(nFiles, true));
-	
+	// A flat scan involves a single directory
+	nWorkers = m_bRecursive ? QThread::idealThreadCount() : 1;
+	if (nWorkers < 1)
+		nWorkers = 1;
+
+	m_vecQueues.fill(QList<QByteArray>(), nWorkers);
+	m_vecFiles.fill(QStringList(), nWorkers);
+	m_vecQueues[0].append(QFile::encodeName(m_sDir));
+	m_nBusy = 0;
+	m_nNewFiles = 0;
+
+	// Start the workers
+	for (i = 0; i < nWorkers; i++) {
+		m_vecWorkers.append(new DirScanWorker(this, i));
+		m_vecWorkers[i]->start();
+	}
+
+	// Report the files found by all workers in a single event, once in a
+	// while
+	do {
+		bDone = m_vecWorkers[0]->wait(DIR_SCAN_PROGRESS_INTERVAL);
+		for (i = 1; bDone && i < nWorkers; i++)
+			bDone = m_vecWorkers[i]->isFinished();
+
+		// Do not spin if the first worker is done before the others
+		if (!bDone && m_vecWorkers[0]->isFinished())
+			msleep(DIR_SCAN_PROGRESS_INTERVAL);
+
+		nFiles = m_nNewFiles.fetchAndStoreOrdered(0);
+		if (nFiles > 0 && !bDone && !m_bCancel) {
+			QApplication::postEvent(m_pEventReceiver,
+				new DirScanEvent(nFiles, false));
+		}
+	} while (!bDone);
+
+	// Merge the results of all workers
+	nFiles = 0;
+	for (i = 0; i < nWorkers; i++) {
+		m_slFiles += m_vecFiles[i];
+		nFiles += m_vecFiles[i].count();
+		delete m_vecWorkers[i];
+	}
+	m_slFiles.sort();
+
+	m_vecWorkers.clear();
+	m_vecQueues.clear();
+	m_vecFiles.clear();
 	m_setScanned.clear();
+	m_trieExisting.clear();
+
+	QApplication::postEvent(m_pEventReceiver,
+		new DirScanEvent(m_bCancel ? -1 : nFiles, true));
+}
+
+/**
+ * Scans directories taken from the queues, until there is no more work.
+ * This is the main loop of each worker thread.
+ * @param	nIndex	The index of the worker's own queue
+ */
+void DirScanner::work(int nIndex)
+{
+	QByteArray baDir;
+
+	while (getDir(nIndex, baDir)) {
+		scanDir(nIndex, baDir);
+
+		m_mutex.lock();
+		m_nBusy--;
+
+		// Wake any workers waiting for directories, if this one has added
+		// some, or if the scan is complete
+		if (!m_vecQueues[nIndex].isEmpty() || m_nBusy == 0)
+			m_condWork.wakeAll();
+		m_mutex.unlock();
+	}
 }
 
 /**
- * Recursively scans a directory for a files matching the current filter.
- * @param	dir	A directory object set to the folder from which files are
- *			added
- * @return	The total number of files added
+ * Gets the next directory to scan.
+ * The directory is taken from the end of the worker's own queue (which
+ * results in a depth-first scan of its part of the tree), or, if this queue
+ * is empty, from the head of another worker's queue (where the directories
+ * nearest the root, and thus the largest sub-trees, are found.) Blocks while
+ * all queues are empty, but other workers may still add directories.
+ * @param	nIndex	The index of the worker's own queue
+ * @param	baDir	Holds the directory path, on return
+ * @return	true if a directory was found, false if the scan is over
  */
-int DirScanner::scanDir(QDir& dir)
+bool DirScanner::getDir(int nIndex, QByteArray& baDir)
 {
-	QString sCanon;
-	QStringList slDirFiles, slDirs;
-	QString sFile, sDir;
-	int nFiles = 0;
-
-	if (m_bCancel)
-		return -1;
-		
-	// Make sure this directory has not been previously visited (e.g., through a
-	// symbolic link)
-	sCanon = dir.canonicalPath();
-	if (m_setScanned.exists(sCanon))
-		return 0;
-	m_setScanned.insert(sCanon);
-	
-	// Add all files in this directory
-    QStringList nameFilter;
-    nameFilter << m_sNameFilter.split(" ");
-	slDirFiles = dir.entryList(nameFilter, QDir::Files);
-    for (int i = 0; i < slDirFiles.size(); i++) {
-        sFile = dir.absolutePath() + "/" + slDirFiles[i];
-		// Make sure an entry for this file does not exist
-		if (m_pDicFiles->find(sFile) == m_pDicFiles->end()) {
-			m_slFiles.append(sFile);
-			nFiles++;
+	int i, nVictim;
+
+	QMutexLocker locker(&m_mutex);
+
+	while (!m_bCancel) {
+		if (!m_vecQueues[nIndex].isEmpty()) {
+			baDir = m_vecQueues[nIndex].takeLast();
+			m_nBusy++;
+			return true;
 		}
+
+		for (i = 1; i < m_vecQueues.size(); i++) {
+			nVictim = (nIndex + i) % m_vecQueues.size();
+			if (!m_vecQueues[nVictim].isEmpty()) {
+				baDir = m_vecQueues[nVictim].takeFirst();
+				m_nBusy++;
+				return true;
+			}
+		}
+
+		// All queues are empty, and no worker can add to them
+		if (m_nBusy == 0)
+			return false;
+
+		m_condWork.wait(&m_mutex, DIR_SCAN_PROGRESS_INTERVAL);
 	}
 
-	QApplication::postEvent(m_pEventReceiver,
-		new DirScanEvent(nFiles, false));
-	
-	// Recurse into sub-directories, if requested
-	if (!m_bRecursive) {
-		return nFiles;
-    }
-
-	slDirs = dir.entryList(QDir::Dirs);
-
-	// Iterate the list of sub-directories
-    for (int i = 0; i < slDirs.size(); i++) {
-		if (m_bCancel)
-			return -1;
-			
-        sDir = slDirs[i];
-		// Skip the "." and ".." directories
-		if (sDir == "." || sDir == "..")
+	// Release workers waiting for directories after cancellation
+	m_condWork.wakeAll();
+	return false;
+}
+
+/**
+ * Adds the files in a directory that match the current filter, and queues
+ * its sub-directories if the scan is recursive.
+ * Entries are read directly from the directory's descriptor, and are only
+ * stat()'ed if their type is not reported by readdir() (or if they are
+ * symbolic links).
+ * @param	nIndex	The index of the scanning worker
+ * @param	baDir	The encoded path of the directory
+ */
+void DirScanner::scanDir(int nIndex, const QByteArray& baDir)
+{
+	QList<QByteArray> lstDirs;
+	QString sFile;
+	struct stat st;
+	struct dirent* pEntry;
+	DIR* pDir;
+	int nFd, nLen, nFiles;
+	bool bDir, bFile;
+
+	nFd = open(baDir.data(), O_RDONLY | O_DIRECTORY);
+	if (nFd < 0)
+		return;
+
+	// Make sure this directory has not been previously visited (e.g., through
+	// a symbolic link)
+	if (fstat(nFd, &st) != 0) {
+		close(nFd);
+		return;
+	}
+
+	m_mutex.lock();
+	if (m_setScanned.contains(qMakePair((quint64)st.st_dev,
+		(quint64)st.st_ino))) {
+		m_mutex.unlock();
+		close(nFd);
+		return;
+	}
+	m_setScanned.insert(qMakePair((quint64)st.st_dev, (quint64)st.st_ino));
+	m_mutex.unlock();
+
+	pDir = fdopendir(nFd);
+	if (pDir == NULL) {
+		close(nFd);
+		return;
+	}
+
+	nFiles = 0;
+	while (!m_bCancel && (pEntry = readdir(pDir)) != NULL) {
+		// Skip hidden entries, including the "." and ".." directories
+		if (pEntry->d_name[0] == '.')
 			continue;
 
-		// Add the files in each sub-directory
-		QDir dirSub(dir);
-		if (dirSub.cd(sDir))
-			nFiles += scanDir(dirSub);
+		nLen = strlen(pEntry->d_name);
+
+		// Determine the type of the entry, following symbolic links
+		bDir = (pEntry->d_type == DT_DIR);
+		bFile = (pEntry->d_type == DT_REG);
+		if (pEntry->d_type == DT_UNKNOWN || pEntry->d_type == DT_LNK) {
+			// Avoid stat()'ing entries which cannot be used
+			if (!m_bRecursive && !m_glob.matches(pEntry->d_name, nLen))
+				continue;
+
+			if (fstatat(nFd, pEntry->d_name, &st, 0) != 0)
+				continue;
+
+			bDir = S_ISDIR(st.st_mode);
+			bFile = S_ISREG(st.st_mode);
+		}
+
+		if (bDir) {
+			if (m_bRecursive)
+				lstDirs.append(baDir + '/' + QByteArray(pEntry->d_name, nLen));
+		} else if (bFile && m_glob.matches(pEntry->d_name, nLen)) {
+			// Make sure an entry for this file does not exist
+			sFile = QFile::decodeName(baDir + '/' +
+				QByteArray(pEntry->d_name, nLen));
+			if (!m_trieExisting.contains(sFile)) {
+				m_vecFiles[nIndex].append(sFile);
+				nFiles++;
+			}
+		}
 	}
 
-	return nFiles;
+	closedir(pDir);
+	m_nNewFiles.fetchAndAddOrdered(nFiles);
+
+	// Queue the sub-directories
+	if (!lstDirs.isEmpty()) {
+		m_mutex.lock();
+		m_vecQueues[nIndex] += lstDirs;
+		m_mutex.unlock();
+	}
 }
@@ -6,9 +6,16 @@
 #include <qthread.h>
 #include <qdir.h>
 #include <qstringlist.h>
-#include <QHash>
-#include <QTreeWidgetItem>
+#include <QSet>
+#include <QPair>
 #include <QEvent>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include "pathtrie.h"
+
+/** The minimal time, in milliseconds, between progress events. */
+#define DIR_SCAN_PROGRESS_INTERVAL	100
 
 class DirScanner;
 
@@ -36,34 +43,45 @@ public:
 };
 
 /**
- * A set of unique strings.
- * Qt3 does not have a set class, so this is a simple implementation based on
- * a QHash of dummy int pointers.
- * @author	Elad Lahav
+ * Matches file names against a list of shell wildcard patterns.
+ * The list is parsed once, before scanning starts. Patterns of the form
+ * "*.ext" (the common case for source file types) are matched by a lookup of
+ * the name's suffix, other patterns using fnmatch(). Matching does not modify
+ * the object, so it may be shared by several threads.
+ * @author Elad Lahav
  */
-class StringSet : public QHash<QString, int>
+class GlobMatcher
 {
 public:
-	StringSet() : QHash<QString, int>() {}
-	
-	void insert(const QString& sItem) {
-		static int nDummy = 0;
-		QHash<QString, int>::insert(sItem, nDummy);
-	}
-	
-	bool exists(const QString& sItem) {
-		return find(sItem) != end();
-	}
+	void compile(const QString&);
+	bool matches(const char*, int) const;
+
+private:
+	/** The extensions of "*.ext" patterns (including the dot). */
+	QSet<QByteArray> m_setSuffixes;
+
+	/** Patterns matched by fnmatch(). */
+	QList<QByteArray> m_lstPatterns;
 };
 
+class DirScanWorker;
+
 /**
- * Scans a directory for files matching a given pattern, using a separate thread.
+ * Scans a directory for files matching a given pattern, using separate
+ * threads.
+ * The scan is performed by a pool of worker threads. Each worker keeps a
+ * queue of directories to scan, adding the sub-directories it finds to its
+ * own queue, and takes directories from the queues of other workers once its
+ * own queue is empty. The thread started by start() only coordinates the
+ * workers, and reports their progress to the receiver object, combining the
+ * progress of all workers into a single event at most every
+ * DIR_SCAN_PROGRESS_INTERVAL milliseconds.
  * @author Elad Lahav
  */
 class DirScanner : public QThread
 {
 public: 
-	DirScanner(QObject*, QHash<QString, QTreeWidgetItem *>*);
+	DirScanner(QObject*, const PathTrie*);
 	~DirScanner();
 
 	void start(const QString&, const QString&, bool);
@@ -90,32 +108,62 @@ private:
 	/** Pointer to an object that receives the scanner update events. */
 	QObject* m_pEventReceiver;
 	
-	/** Currently scanned directory. */
-	QDir m_dir;
+	/** The directory from which the scan starts. */
+	QString m_sDir;
 	
 	/**
-	 * A set of already-scanned directories (prevents infinite loops in case
-	 * of cyclic symbolic links in the scanned file system).
+	 * The (device, inode) pairs of already-scanned directories (prevents
+	 * infinite loops in case of cyclic symbolic links in the scanned file
+	 * system).
 	 */
-	StringSet m_setScanned;
+	QSet< QPair<quint64, quint64> > m_setScanned;
+	
+	/** Pointer to the current project files (used to identify files that
+		should not appear in the scan results.) */
+	const PathTrie* m_pFiles;
 	
-	/** Pointer to a list of files indexed by the file path (used to identify
-		files that should not appear in the scan results.) */
-	QHash<QString, QTreeWidgetItem *> *m_pDicFiles;
+	/** A copy of the project files, taken when the scan starts, which the
+		worker threads can safely read. */
+	PathTrie m_trieExisting;
 	
-	/** Regular expression for scanning source files. */
-	QString m_sNameFilter;
+	/** Matches the names of source files. */
+	GlobMatcher m_glob;
 	
 	/** The list of scanned file paths. */
 	QStringList m_slFiles;
 	
 	/** A cancellation flag. Stops the scanning process when raised. */
-	bool m_bCancel;
+	volatile bool m_bCancel;
 	
 	/** true to descend to child directories, false otherwise. */
 	bool m_bRecursive;
 	
-	int scanDir(QDir&);
+	/** The worker threads. */
+	QVector<DirScanWorker*> m_vecWorkers;
+	
+	/** The directories waiting to be scanned by each worker. */
+	QVector< QList<QByteArray> > m_vecQueues;
+	
+	/** The files found by each worker. */
+	QVector<QStringList> m_vecFiles;
+	
+	/** The number of workers currently scanning a directory. */
+	int m_nBusy;
+	
+	/** The number of files found since the last progress event. */
+	QAtomicInt m_nNewFiles;
+	
+	/** Protects the queues, the scanned set and the busy count. */
+	QMutex m_mutex;
+	
+	/** Wakes workers waiting for directories to scan. */
+	QWaitCondition m_condWork;
+	
+	void work(int);
+	bool getDir(int, QByteArray&);
+	void scanDir(int, const QByteArray&);
+	
+	friend class DirScanWorker;
 };
 
 #endif
@@ -7,11 +7,13 @@
 #include <KTextEditor/CommandInterface>
 #include <KTextEditor/ModificationInterface>
 #include <KTextEditor/Editor>
+#include <KTextEditor/CodeCompletionInterface>
 #include <QStringList>
 #include <QString>
 
 #include "kscopeconfig.h"
 #include "editorpage.h"
+#include "symbolcompletionmodel.h"
 
 /**
  * Class constructor.
@@ -29,6 +31,8 @@ EditorPage::EditorPage(KTextEditor::Document* pDoc, QMenu* pMenu, QTabWidget* pP
 	m_bWritable(true), /* new documents are writable by default */
 	m_bModified(false),
 	m_nLine(0),
+	m_bACEnabled(false),
+	m_nACMinChars(DEF_AC_MIN_CHARS),
 	m_bSaveNewSizes(false)
 {
     QHBoxLayout *layout = new QHBoxLayout(this);
@@ -64,9 +68,13 @@ EditorPage::EditorPage(KTextEditor::Document* pDoc, QMenu* pMenu, QTabWidget* pP
 	connect(m_pCtagsListWidget, SIGNAL(lineRequested(uint)), this,
 		SLOT(slotGotoLine(uint)));
 
+	// Report the scope of the cursor
+	connect(m_pCtagsListWidget, SIGNAL(scopeChanged(const QString&)), this,
+		SIGNAL(scopeChanged(const QString&)));
+
 	// Add Ctag records to the tag list
-	connect(&m_ctags, SIGNAL(dataReady(FrontendToken*)), m_pCtagsListWidget,
-		SLOT(slotDataReady(FrontendToken*)));
+	connect(&m_ctags, SIGNAL(dataReady(const FrontendBatch&)),
+		m_pCtagsListWidget, SLOT(slotDataReady(const FrontendBatch&)));
 		
 	// Monitor Ctags' operation
 	connect(&m_ctags, SIGNAL(finished(uint)), m_pCtagsListWidget, 
@@ -81,6 +89,16 @@ EditorPage::EditorPage(KTextEditor::Document* pDoc, QMenu* pMenu, QTabWidget* pP
                 this, SLOT(slotCursorPosChange(KTextEditor::View *, 
                         const KTextEditor::Cursor &)));
 
+	// Complete symbols once the user stops typing
+	m_pCompletion = new SymbolCompletionModel(this);
+	m_timerComplete.setSingleShot(true);
+	connect(m_pDoc, SIGNAL(textInserted(KTextEditor::Document*,
+		const KTextEditor::Range&)), this,
+		SLOT(slotTextInserted(KTextEditor::Document*,
+		const KTextEditor::Range&)));
+	connect(&m_timerComplete, SIGNAL(timeout()), this,
+		SLOT(slotAutoComplete()));
+
     setShowLinenum(Config().getShowLinenum());
 }
 
@@ -118,6 +136,16 @@ KTextEditor::View* EditorPage::getView()
 	return m_pView;
 }
 
+/**
+ * Describes the function, structure or class that holds the cursor.
+ * @return	The name of the scope, an empty string if the cursor is not
+ *			inside any scope
+ */
+QString EditorPage::getScope()
+{
+	return m_pCtagsListWidget->getScope();
+}
+
 /** 
  * Returns the full path of the file being edited.
  * @return	The path of the file associated with the Document object, empty 
@@ -433,10 +461,12 @@ void EditorPage::slotMenuSelect()
 /**
  * Displays a list of possible completions for the symbol currently under the
  * cursor.
+ * Any pending auto-completion is cancelled.
  */
 void EditorPage::slotCompleteSymbol()
 {
-	//m_pCompletion->slotComplete();
+	m_timerComplete.stop();
+	startCompletion(1);
 }
 
 /**
@@ -590,6 +620,48 @@ void EditorPage::setTabWidth(uint nTabWidth)
     }
 }
 
+/**
+ * Applies the per-project auto-completion settings.
+ * @param	opt	The project's options
+ */
+void EditorPage::setAutoCompletion(const ProjectBase::Options& opt)
+{
+	m_bACEnabled = opt.bACEnabled;
+	m_nACMinChars = opt.nACMinChars;
+	m_timerComplete.setInterval(opt.nACDelay);
+	m_pCompletion->setMaxEntries(opt.nACMaxEntries);
+	
+	if (!m_bACEnabled)
+		m_timerComplete.stop();
+}
+
+/**
+ * Shows the completions of the part of the symbol that precedes the cursor.
+ * @param	nMinChars	The minimal length of the completed part
+ */
+void EditorPage::startCompletion(uint nMinChars)
+{
+	KTextEditor::CodeCompletionInterface* pIface;
+	QString sWord;
+	uint nPos;
+	
+	pIface = qobject_cast<KTextEditor::CodeCompletionInterface*>(m_pView);
+	if (pIface == NULL || !m_bOpen)
+		return;
+	
+	// Symbols cannot begin with a digit
+	sWord = getWordUnderCursor(&nPos);
+	if (sWord.isEmpty() || nPos < nMinChars || nPos == 0 ||
+		sWord.at(0).isDigit()) {
+		return;
+	}
+	
+	const KTextEditor::Cursor c = m_pView->cursorPosition();
+	KTextEditor::Range range(c.line(), c.column() - nPos, c.line(),
+		c.column());
+	pIface->startCompletion(range, m_pCompletion);
+}
+
 /*
  * show all the commands supported by KTextEditor
  * It's a debug function
@@ -691,6 +763,53 @@ void EditorPage::slotSetModified(KTextEditor::Document *pDoc)
 	}
 }
 
+/**
+ * Schedules auto-completion when a character of a symbol is typed.
+ * Every character restarts the delay, so that the completion is looked up
+ * only once the user stops typing. Other changes cancel a pending
+ * completion.
+ * This slot is connected to the textInserted() signal of the Document
+ * object.
+ * @param	range	The inserted text
+ */
+void EditorPage::slotTextInserted(KTextEditor::Document*,
+	const KTextEditor::Range& range)
+{
+	KTextEditor::CodeCompletionInterface* pIface;
+	QString sText;
+	
+	if (!m_bACEnabled)
+		return;
+	
+	// The editor filters the completions shown while typing
+	pIface = qobject_cast<KTextEditor::CodeCompletionInterface*>(m_pView);
+	if (pIface == NULL || pIface->isCompletionActive())
+		return;
+	
+	sText = m_pDoc->text(range);
+	if (sText.length() != 1 || (!sText[0].isLetterOrNumber() &&
+		sText[0] != '_')) {
+		m_timerComplete.stop();
+		return;
+	}
+	
+	m_cursorComplete = range.end();
+	m_timerComplete.start();
+}
+
+/**
+ * Shows the completions of the symbol being typed, unless the cursor has
+ * moved since the last character was typed.
+ * This slot is connected to the timeout() signal of the completion timer.
+ */
+void EditorPage::slotAutoComplete()
+{
+	if (m_pView->cursorPosition() != m_cursorComplete)
+		return;
+	
+	startCompletion(m_nACMinChars);
+}
+
 /**
  * Marks a file as not modified if all undo levels have been applied.
  * This slot is conncted to the undoChanged() signal of the Document object.
@@ -725,9 +844,10 @@ void EditorPage::slotCursorPosChange(KTextEditor::View *view,
 
 	emit cursorPosChanged(nLine, nCol);
 	
-	// Select the relevant symbol in the tag list
-	if (Config().getAutoTagHl() && (m_nLine != nLine)) {
-		m_pCtagsListWidget->gotoLine(nLine);
+	// Update the scope of the cursor, and select the relevant symbol in the
+	// tag list
+	if (m_nLine != nLine) {
+		m_pCtagsListWidget->gotoLine(nLine, Config().getAutoTagHl());
 		m_nLine = nLine;
 	}
     m_pView->setFocus();
@@ -5,6 +5,7 @@
 #include <qtabwidget.h>
 #include <QSplitter>
 #include <QMenu>
+#include <qtimer.h>
 
 #include <KTextEditor/Document>
 #include <KTextEditor/View>
@@ -15,6 +16,8 @@
 #include "kscopeconfig.h"
 #include "projectbase.h"
 
+class SymbolCompletionModel;
+
 // TODO: cursor position type change  from uint to int or to Cursor
 
 /**
@@ -25,6 +28,9 @@
  * The widget creates an instance of the editor application, and uses its 
  * document and view objects that allow KScope to control it. A page also
  * Each page is inserted in a separate tab in the EditorTabs widget.
+ * Symbol names are completed from the project's symbol dictionary (@see
+ * SymbolIndex). If auto-completion is enabled for the project, a completion
+ * is offered once the user stops typing a symbol for the configured delay.
  * @author Elad Lahav
  */
 
@@ -56,10 +62,12 @@ public:
 	QString getSelection();
 	QString getSuggestedText();
 	QString getLineContents(uint);
+	QString getScope();
 	void setLayout(bool bShowTagList, const SPLIT_SIZES&);	
 	bool getCursorPos(uint&, uint&);
 	bool setCursorPos(uint, uint nCol = 1);
 	void setTabWidth(uint);
+	void setAutoCompletion(const ProjectBase::Options&);
 
     void aboutCommand();
 
@@ -119,6 +127,14 @@ signals:
 	 */
 	void cursorPosChanged(uint nLine, uint nCol);
 	
+	/**
+	 * Emitted when the cursor moves into a different function, structure or
+	 * class.
+	 * @param	sScope	Describes the new scope (an empty string if the
+	 *					cursor is not inside any scope)
+	 */
+	void scopeChanged(const QString& sScope);
+	
 	/**
 	 * Emitted when a file is saved after it was modified.
 	 * Indicates the project's cross-reference database needs to be updated.
@@ -174,6 +190,22 @@ private:
 	/** The current line position of the cursor. */
 	int m_nLine;
 	
+	/** Provides the editor with symbol completions. */
+	SymbolCompletionModel* m_pCompletion;
+	
+	/** Delays auto-completion until the user stops typing. */
+	QTimer m_timerComplete;
+	
+	/** The position of the cursor when the above timer was started. */
+	KTextEditor::Cursor m_cursorComplete;
+	
+	/** true if symbols are completed while typing, false otherwise. */
+	bool m_bACEnabled;
+	
+	/** The minimal length of a symbol, before the cursor, for
+		auto-completion. */
+	uint m_nACMinChars;
+	
 	/** Determines whether size changes in the child widgets should be
 		stored in the global configuration file. 
 		Needs to be explicitly set to false before _each_ operation that
@@ -186,6 +218,11 @@ private slots:
     void slotSetModified(KTextEditor::Document *pDoc);
 	void slotUndoChanged();
 	void slotCursorPosChange(KTextEditor::View *view, const KTextEditor::Cursor &newPosition);
+	void slotTextInserted(KTextEditor::Document*, const KTextEditor::Range&);
+	void slotAutoComplete();
+	
+private:
+	void startCompletion(uint);
 };
 
 #endif
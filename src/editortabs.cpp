@@ -292,6 +292,18 @@ void EditorTabs::applyPrefs()
 	}
 }
 
+/**
+ * Applies the per-project auto-completion settings to all editor pages.
+ * @param	opt	The project's options
+ */
+void EditorTabs::setAutoCompletion(const ProjectBase::Options& opt)
+{
+	int i;
+
+	for (i = 0; i < count(); i++)
+		((EditorPage*)widget(i))->setAutoCompletion(opt);
+}
+
 /**
  * Fills a list with the paths and cursor positions of all files currently
  * open.
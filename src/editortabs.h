@@ -32,6 +32,7 @@ public:
 	void removeCurrentPage();
 	bool removeAllPages();
 	void applyPrefs();
+	void setAutoCompletion(const ProjectBase::Options&);
 	void getOpenFiles(FileLocationList&);
 	void getBookmarks(FileLocationList&);
 	void setBookmarks(FileLocationList&);
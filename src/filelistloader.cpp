@@ -0,0 +1,219 @@
+#include <string.h>
+#include <qapplication.h>
+#include <qfile.h>
+#include "filelistloader.h"
+#include "projectbase.h"
+
+int FileListEvent::eventTypeId = QEvent::None;
+
+/**
+ * Class constructor.
+ * @param	nSerial	The serial number of the load that read the paths
+ * @param	slFiles	The file paths
+ */
+FileListEvent::FileListEvent(uint nSerial, const QStringList& slFiles) :
+	QEvent(QEvent::Type(FileListEvent::eventTypeId)),
+	m_nSerial(nSerial),
+	m_slFiles(slFiles)
+{
+}
+
+int FileListEvent::registerFileListEventType()
+{
+	FileListEvent::eventTypeId =
+		QEvent::registerEventType(FileListEvent::EventId);
+	return FileListEvent::eventTypeId;
+}
+
+/**
+ * Class constructor.
+ */
+FileListLoader::FileListLoader() : QThread(),
+	m_pTarget(NULL),
+	m_nSerial(0),
+	m_bCancel(false)
+{
+	if (FileListEvent::eventTypeId == QEvent::None)
+		FileListEvent::registerFileListEventType();
+}
+
+/**
+ * Class destructor.
+ */
+FileListLoader::~FileListLoader()
+{
+	cancel();
+}
+
+/**
+ * Begins reading a file list in a separate thread.
+ * A load that is still in progress is stopped first.
+ * @param	sPath	The path of the 'cscope.files' file
+ * @param	pTarget	The object to receive the entries
+ * @return	true if the file exists, false otherwise
+ */
+bool FileListLoader::start(const QString& sPath, FileListTarget* pTarget)
+{
+	cancel();
+
+	if (!QFile::exists(sPath))
+		return false;
+
+	// Initialise the load parameters
+	m_sPath = sPath;
+	m_pTarget = pTarget;
+	m_bCancel = false;
+	m_nSerial++;
+
+	// Invoke the thread
+	QThread::start();
+	return true;
+}
+
+/**
+ * Reads a file list in the calling thread.
+ * A load that is still in progress is stopped first.
+ * @param	sPath	The path of the 'cscope.files' file
+ * @param	pTarget	The object to receive the entries
+ * @return	true if the file exists, false otherwise
+ */
+bool FileListLoader::load(const QString& sPath, FileListTarget* pTarget)
+{
+	cancel();
+
+	if (!QFile::exists(sPath))
+		return false;
+
+	m_sPath = sPath;
+	m_bCancel = false;
+	read(pTarget);
+	return true;
+}
+
+/**
+ * Stops the current load, and waits for the thread to terminate.
+ * Entries of the stopped load which were not yet handed to the target are
+ * discarded.
+ */
+void FileListLoader::cancel()
+{
+	m_bCancel = true;
+	wait();
+
+	// Batches posted by the stopped load are ignored
+	m_nSerial++;
+	m_pTarget = NULL;
+}
+
+/**
+ * Counts the entries in a file list, without creating a string for each.
+ * @param	sPath	The path of the 'cscope.files' file
+ * @return	The number of entries, -1 if the file could not be read
+ */
+int FileListLoader::count(const QString& sPath)
+{
+	QFile file(sPath);
+	const char* pPos, * pEnd, * pEol;
+	int nFiles;
+
+	if (!file.open(QIODevice::ReadOnly))
+		return -1;
+
+	if (file.size() == 0)
+		return 0;
+
+	pPos = (const char*)file.map(0, file.size());
+	if (pPos == NULL)
+		return -1;
+
+	// Count the lines which are neither empty nor options
+	nFiles = 0;
+	for (pEnd = pPos + file.size(); pPos < pEnd; pPos = pEol + 1) {
+		pEol = (const char*)memchr(pPos, '\n', pEnd - pPos);
+		if (pEol == NULL)
+			pEol = pEnd;
+
+		if (pEol > pPos && *pPos != '-' && *pPos != '\r')
+			nFiles++;
+	}
+
+	return nFiles;
+}
+
+/**
+ * Reads the file list, posting the entries in batches.
+ */
+void FileListLoader::run()
+{
+	read(NULL);
+}
+
+/**
+ * Hands a batch of entries to the target object.
+ * Batches of loads which were cancelled or replaced are ignored.
+ * @param	pEvent	A FileListEvent object
+ */
+void FileListLoader::customEvent(QEvent* pEvent)
+{
+	FileListEvent* pFLE;
+	QStringList::ConstIterator itr;
+
+	if (pEvent->type() != FileListEvent::eventTypeId)
+		return;
+
+	pFLE = (FileListEvent*)pEvent;
+	if (pFLE->m_nSerial != m_nSerial || m_pTarget == NULL)
+		return;
+
+	for (itr = pFLE->m_slFiles.begin(); itr != pFLE->m_slFiles.end(); ++itr)
+		m_pTarget->addItem(*itr);
+}
+
+/**
+ * Scans the mapped file for entries.
+ * @param	pTarget	The object to receive the entries directly, or NULL to post
+ *					them to the main thread
+ */
+void FileListLoader::read(FileListTarget* pTarget)
+{
+	QFile file(m_sPath);
+	QStringList slFiles;
+	const char* pPos, * pEnd, * pEol;
+	int nLen;
+
+	if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+		return;
+
+	pPos = (const char*)file.map(0, file.size());
+	if (pPos == NULL)
+		return;
+
+	for (pEnd = pPos + file.size(); pPos < pEnd && !m_bCancel;
+		pPos = pEol + 1) {
+		pEol = (const char*)memchr(pPos, '\n', pEnd - pPos);
+		if (pEol == NULL)
+			pEol = pEnd;
+
+		// Skip empty lines and option lines
+		nLen = pEol - pPos;
+		if (nLen > 0 && pPos[nLen - 1] == '\r')
+			nLen--;
+		if (nLen == 0 || *pPos == '-')
+			continue;
+
+		if (pTarget != NULL) {
+			pTarget->addItem(QString::fromLocal8Bit(pPos, nLen));
+			continue;
+		}
+
+		slFiles.append(QString::fromLocal8Bit(pPos, nLen));
+		if (slFiles.count() == FILE_LIST_BATCH) {
+			QApplication::postEvent(this,
+				new FileListEvent(m_nSerial, slFiles));
+			slFiles.clear();
+		}
+	}
+
+	if (!slFiles.isEmpty() && !m_bCancel)
+		QApplication::postEvent(this, new FileListEvent(m_nSerial, slFiles));
+}
@@ -0,0 +1,79 @@
+#ifndef FILELISTLOADER_H
+#define FILELISTLOADER_H
+
+#include <qthread.h>
+#include <qevent.h>
+#include <qstringlist.h>
+
+class FileListTarget;
+
+/** The number of file paths passed to the target object at once. */
+#define FILE_LIST_BATCH		4096
+
+/**
+ * Carries a batch of file paths read by a FileListLoader thread to the main
+ * application thread.
+ * @author Elad Lahav
+ */
+class FileListEvent : public QEvent
+{
+public:
+	/** The event's unique ID. */
+	enum { EventId = 6927 };
+
+	FileListEvent(uint, const QStringList&);
+	static int registerFileListEventType();
+	static int eventTypeId;
+
+	/** The serial number of the load that read the paths. */
+	uint m_nSerial;
+
+	/** The file paths, in the order of the file. */
+	QStringList m_slFiles;
+};
+
+/**
+ * Reads the entries of a 'cscope.files' file.
+ * The file is mapped to memory, and scanned for lines in large chunks.
+ * Option lines (beginning with a dash) are skipped.
+ * The entries can be read either in the calling thread, or in a separate
+ * thread, in which case they are posted to the main thread in batches of
+ * FILE_LIST_BATCH paths, and handed to the target object from there (so the
+ * target is only accessed by the main thread.) A new load, or a call to
+ * cancel(), discards all batches of a previous load that were not yet handed
+ * to the target.
+ * @author Elad Lahav
+ */
+class FileListLoader : public QThread
+{
+public:
+	FileListLoader();
+	~FileListLoader();
+
+	bool start(const QString&, FileListTarget*);
+	bool load(const QString&, FileListTarget*);
+	void cancel();
+
+	static int count(const QString&);
+
+protected:
+	virtual void run();
+	virtual void customEvent(QEvent*);
+
+private:
+	/** The path of the file being read. */
+	QString m_sPath;
+
+	/** The object receiving the entries. */
+	FileListTarget* m_pTarget;
+
+	/** The serial number of the current load. */
+	uint m_nSerial;
+
+	/** A cancellation flag. Stops the current load when raised. */
+	volatile bool m_bCancel;
+
+	void read(FileListTarget*);
+};
+
+#endif
@@ -1,7 +1,9 @@
+#include <qtimer.h>
 #include <klocale.h>
 #include "filelistwidget.h"
 #include "kscope.h"
 #include "kscopeconfig.h"
+#include "pathtable.h"
 
 #define FILE_LIST_COL_NUM 3
 #define FILE_LIST_TYPE_COL 0
@@ -14,10 +16,10 @@
  * @param	szName	The widget's name
  */
 FileListWidget::FileListWidget(QWidget* pParent) :
-	SearchListView(FILE_LIST_NAME_COL, pParent),
-	m_sRoot(qgetenv("HOME"))
+	SearchListView(FILE_LIST_NAME_COL, pParent)
 {
     m_pModel = new StringListModel(FILE_LIST_COL_NUM, this);
+    m_pModel->setPathColumn(FILE_LIST_PATH_COL);
     QStringList header;
     header << i18n("Type") << i18n("File") << i18n("Path");
     m_pModel->setHeader(header);
@@ -47,7 +49,8 @@ FileListWidget::~FileListWidget()
  * class. When a FileList object is given as a parameter to
  * ProjectManager::fillList(), this method is called for each file included
  * in the project. A new list item is created, containing the file's name and
- * path, and is added to the list.
+ * path. Items are added to the list in a single block, once control returns
+ * to the event loop.
  * @param	sFilePath	The full path of a source file
  */
 void FileListWidget::addItem(const QString& sFilePath)
@@ -65,17 +68,15 @@ void FileListWidget::addItem(const QString& sFilePath)
 	if (nTypePos > -1)
 		sFileType = sFileName.mid(nTypePos + 1);
 	
-	// If a root path has been set, use a $ sign instead of that part of the
-	// path
-	sPath = sFilePath;
-	if (m_sRoot != "/")
-		sPath.replace(m_sRoot, "$");
-    sPath.truncate(sPath.lastIndexOf('/') + 1);
+	// The directory is stored in the path table, and is shown relative to
+	// the source root
+	sPath = sFilePath.left(sFilePath.lastIndexOf('/') + 1);
 	
-	// Create the list item
-    QStringList strList;
-    strList << sFileType << sFileName << sPath;
-    m_pModel->addItem(strList);
+	// Schedule the addition of pending items with the first one
+	if (m_lstPending.isEmpty())
+		QTimer::singleShot(0, this, SLOT(slotAddPending()));
+	
+	m_lstPending.append(QStringList() << sFileType << sFileName << sPath);
 }
 
 /**
@@ -85,15 +86,26 @@ void FileListWidget::addItem(const QString& sFilePath)
  */
 bool FileListWidget::findFile(const QString& sPath)
 {
-	QString sFindPath(sPath);
-    QList<QStandardItem *> list;
+	QString sName;
+	int nId, i;
 	
-	if (m_sRoot != "/")
-		sFindPath.replace(m_sRoot, "$");
-
-	list = m_pModel->findItems(sFindPath, Qt::MatchExactly, FILE_LIST_PATH_COL);
+	slotAddPending();
+	
+	// Files in a directory that is not in the path table cannot be listed
+	nId = PathTable::find(sPath.left(sPath.lastIndexOf('/') + 1));
+	if (nId == -1)
+		return false;
+
+	// Compare the name of each file in the same directory
+	sName = sPath.mid(sPath.lastIndexOf('/') + 1);
+	for (i = 0; i < m_pModel->rowCount(); i++) {
+		if (m_pModel->getPathId(i) == nId &&
+			m_pModel->getString(i, FILE_LIST_NAME_COL) == sName) {
+			return true;
+		}
+	}
 
-	return !list.isEmpty();
+	return false;
 }
 
 /**
@@ -101,10 +113,23 @@ bool FileListWidget::findFile(const QString& sPath)
  */
 void FileListWidget::clear()
 {
-    m_pModel->removeRows(0, m_pModel->rowCount());
+	m_lstPending.clear();
+    m_pModel->clear();
 	m_pEdit->setText("");
 }
 
+/**
+ * Adds all items created by addItem() to the list, in a single operation.
+ */
+void FileListWidget::slotAddPending()
+{
+	if (m_lstPending.isEmpty())
+		return;
+	
+	m_pModel->addItems(m_lstPending);
+	m_lstPending.clear();
+}
+
 /**
  * Opens a file for editing when its entry is clicked in the file list.
  * @param	pItem	The clicked list item
@@ -117,12 +142,10 @@ void FileListWidget::processItemSelected(const QModelIndex &index)
     QModelIndex newIndex = m_proxyModel->index(index.row(), FILE_LIST_NAME_COL);
     sFile = m_proxyModel->data(newIndex).toString();
 
-	// Get the file path (replace the root symbol, if required)
+	// Get the full path of the file's directory
     newIndex = m_proxyModel->index(index.row(), FILE_LIST_PATH_COL);
-	sPath = m_proxyModel->data(newIndex).toString();
-
-	if (sPath.startsWith("$"))
-		sPath.replace("$", m_sRoot);
+	sPath = PathTable::getPath(m_proxyModel->data(newIndex,
+		StringListModel::PathIdRole).toInt());
     sPath += sFile;
 	m_pEdit->setText("");
 
@@ -149,33 +172,14 @@ void FileListWidget::applyPrefs()
 /**
  * Associates a root directory with this list.
  * For each file in the list, the part of the path corresponding to the root
- * is replaced with a $ sign.
+ * is displayed as a $ sign. Paths are only rendered when displayed, so the
+ * list merely needs to be repainted.
  * @param	sRoot	The new root path
  */
 void FileListWidget::setRoot(const QString& sRoot)
 {
-	QString sPath;
-
-    QStandardItem *pItem;
-
-	// Update all items in the list
-    for (int i = 0; i < m_pModel->rowCount(); i++) {
-        pItem = m_pModel->item(i, FILE_LIST_PATH_COL);
-        sPath = pItem->data().toString();
-	
-		// Restore the full path
-		sPath.replace("$", m_sRoot);
-		
-		// Replace the root with a $ sign
-		if (sRoot != "/")
-			sPath.replace(sRoot, "$");
-		
-        sPath.truncate(sPath.lastIndexOf('/') + 1);
-        pItem->setData(sPath);
-	}
-	
-	// Store the new root
-	m_sRoot = sRoot;
+	PathTable::setRoot(sRoot);
+	m_pView->viewport()->update();
 }
 
 /**
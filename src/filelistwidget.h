@@ -33,9 +33,13 @@ protected:
     virtual void processItemSelected(const QModelIndex &);
 	
 private:
-	/** A common root path for all items in the list. */
-	QString m_sRoot;
     StringListModel *m_pModel;
+	
+	/** Items created by addItem() that were not yet added to the list. */
+	QList<QStringList> m_lstPending;
+
+private slots:
+	void slotAddPending();
 };
 
 #endif
@@ -1,10 +1,114 @@
 #include "husky.h"
 #include <iostream>
+#include <string.h>
 #include <qfileinfo.h>
 #include <qdir.h>
 #include <klocale.h>
 #include "frontend.h"
 
+/** The initial capacity of the buffer holding process output. */
+#define FRONTEND_BUF_SIZE	0x10000
+
+/** The initial number of records in a block. */
+#define FRONTEND_BATCH_SIZE	0x400
+
+/**
+ * Converts the token to a string.
+ * This is the only place where the text of a token is copied out of the
+ * output buffer.
+ * @return	The text associated with this token
+ */
+QString FrontendToken::getData() const
+{
+	if (m_bSet)
+		return m_sData;
+		
+	return QString::fromLatin1(getText(), m_nLength);
+}
+
+/**
+ * Compares the original text of the token with the given string.
+ * @param	szText	The string to compare with
+ * @return	true if the token consists of exactly the given text, false
+ *			otherwise
+ */
+bool FrontendToken::isEqual(const char* szText) const
+{
+	int nLen;
+	
+	nLen = qstrlen(szText);
+	return ((nLen == m_nLength) && (memcmp(getText(), szText, nLen) == 0));
+}
+
+/**
+ * Checks whether the original text of the token begins with the given
+ * string.
+ * @param	szText	The prefix to look for
+ * @return	true if the token starts with the given text, false otherwise
+ */
+bool FrontendToken::startsWith(const char* szText) const
+{
+	int nLen;
+	
+	nLen = qstrlen(szText);
+	return ((nLen <= m_nLength) && (memcmp(getText(), szText, nLen) == 0));
+}
+
+/**
+ * Reads a decimal number out of the original text of the token.
+ * @param	nPos	(Optional) the position of the first digit
+ * @param	pEnd	(Optional) set to the position following the last digit
+ *					upon return
+ * @return	The numeric value, 0 if there are no digits at the given position
+ */
+int FrontendToken::toInt(int nPos, int* pEnd) const
+{
+	const char* pText;
+	int nResult = 0;
+	
+	pText = getText();
+	for (; (nPos < m_nLength) && (pText[nPos] >= '0') &&
+		(pText[nPos] <= '9'); nPos++) {
+		nResult = (nResult * 10) + (pText[nPos] - '0');
+	}
+	
+	if (pEnd != NULL)
+		*pEnd = nPos;
+	
+	return nResult;
+}
+
+/**
+ * @return	true if the token is a positive decimal number, false otherwise
+ */
+bool FrontendToken::isNumber() const
+{
+	int nEnd;
+	
+	return (toInt(0, &nEnd) > 0) && (nEnd == m_nLength);
+}
+
+/**
+ * Removes characters from the end of the token.
+ * @param	nChars	The number of characters to remove
+ */
+void FrontendToken::chop(int nChars)
+{
+	m_nLength = (nChars < m_nLength) ? m_nLength - nChars : 0;
+}
+
+/**
+ * Replaces the contents of the token.
+ * Allows parsers to pass modified text on to the consumers of a record.
+ * Note that the comparison methods still refer to the original text.
+ * @param	sData	The new text of the token
+ */
+void FrontendToken::setData(const QString& sData)
+{
+	m_sData = sData;
+	m_bSet = true;
+}
+
 /**
  * Class constructor.
  * @param	nRecordSize	The number of fields in each record
@@ -13,13 +117,20 @@
  */
 Frontend::Frontend(uint nRecordSize, bool bAutoDelete) : KProcess(),
 	m_nRecords(0),
-	m_pHeadToken(NULL),
-	m_pTailToken(NULL),
-	m_pCurToken(NULL),
 	m_bAutoDelete(bAutoDelete),
-	m_bInToken(false),
-	m_nRecordSize(nRecordSize)
+	m_nRecordSize(nRecordSize),
+	m_nPos(0),
+	m_nTokenStart(-1),
+	m_nRecordStart(0),
+	m_bKilled(false)
 {
+	// The output buffer and the record block are allocated once, and reused
+	// for all reads
+	m_baBuf.reserve(FRONTEND_BUF_SIZE);
+	m_vecTokens.reserve(FRONTEND_BATCH_SIZE * nRecordSize);
+	m_vecBounds.reserve(FRONTEND_BATCH_SIZE);
+	m_batch.m_vecRecords.reserve(FRONTEND_BATCH_SIZE);
+	
     setOutputChannelMode(SeparateChannels);
 	// Parse data on the standard output
     connect(this, SIGNAL(readyReadStandardOutput()), this,
@@ -39,9 +150,6 @@ Frontend::Frontend(uint nRecordSize, bool bAutoDelete) : KProcess(),
  */
 Frontend::~Frontend()
 {
-	// Delete all pending tokens
-	while (m_pHeadToken)
-		removeToken();
 }
 
 /**
@@ -65,6 +173,7 @@ bool Frontend::run(const QString& sName, const QStringList& slArgs,
 	// Reset variables
 	m_nRecords = 0;
 	m_bKilled = false;
+	resetBuffer();
 	
     clearEnvironment(); // TODO: to check if this call is needed
 	// Setup the command-line arguments
@@ -106,77 +215,104 @@ void Frontend::kill()
 }
 
 /**
- * Appends a token to the end of the token list.
- * @param	pToken	The token to add
+ * Appends a token to the current record.
+ * @param	token	The token to add
  */
-void Frontend::addToken(FrontendToken* pToken)
+void Frontend::addToken(const FrontendToken& token)
 {
-	// Check if this is the firt token
-	if (m_pHeadToken == NULL) {
-		m_pHeadToken = pToken;
-		m_pTailToken = pToken;
-	}
-	else {
-		// Not the first token, append and reset the tail token
-		m_pTailToken->m_pNext = pToken;
-		m_pTailToken = pToken;
-	}
+	// Ignore extra tokens
+	if (m_vecTokens.size() - m_nRecordStart >= (int)m_nRecordSize)
+		return;
+		
+	m_vecTokens.append(token);
 }
 
 /**
- * Removes and deletes the token at the head of the token list.
+ * Marks the current record as complete, and adds it to the current block.
  */
-void Frontend::removeToken()
+void Frontend::endRecord()
 {
-	FrontendToken* pToken;
+	m_vecBounds.append(m_nRecordStart);
+	m_nRecordStart = m_vecTokens.size();
+}
+
+/**
+ * Delivers all complete records in the current block.
+ * Tokens of the incomplete record (if any) are kept for the next block.
+ */
+void Frontend::emitBatch()
+{
+	int nRecord, nEnd, nPartial, i;
 	
-	if (m_pHeadToken == NULL)
+	if (m_vecBounds.isEmpty())
 		return;
-
-	pToken = m_pHeadToken;
-	m_pHeadToken = m_pHeadToken->m_pNext;
-	delete pToken;
-
-	if (m_pHeadToken == NULL)
-		m_pTailToken = NULL;	
+		
+	// Link the tokens of each record
+	m_batch.m_vecRecords.resize(0);
+	for (nRecord = 0; nRecord < m_vecBounds.size(); nRecord++) {
+		nEnd = (nRecord + 1 < m_vecBounds.size()) ?
+			m_vecBounds[nRecord + 1] : m_nRecordStart;
+		
+		for (i = m_vecBounds[nRecord]; i < nEnd; i++) {
+			m_vecTokens[i].m_pNext = (i + 1 < nEnd) ?
+				&m_vecTokens[i + 1] : NULL;
+		}
+		
+		m_batch.m_vecRecords.append(&m_vecTokens[m_vecBounds[nRecord]]);
+	}
+	
+	// Notify the target object that records can be read
+	emit dataReady(m_batch);
+	
+	// Move the tokens of the incomplete record to the beginning of the list
+	nPartial = m_vecTokens.size() - m_nRecordStart;
+	for (i = 0; i < nPartial; i++)
+		m_vecTokens[i] = m_vecTokens[m_nRecordStart + i];
+		
+	m_vecTokens.resize(nPartial);
+	m_vecBounds.resize(0);
+	m_batch.m_vecRecords.resize(0);
+	m_nRecordStart = 0;
 }
 
 /**
- * Removes tokens from the head of the list, according to the size of a
- * record.
+ * Discards all buffered output, as well as any parsed tokens.
  */
-void Frontend::removeRecord()
+void Frontend::resetBuffer()
 {
-	uint i;
-
-	for (i = 0; (i < m_nRecordSize) && (m_pHeadToken != NULL); i++)
-		removeToken();
+	m_baBuf.resize(0);
+	m_nPos = 0;
+	m_nTokenStart = -1;
+	m_vecTokens.resize(0);
+	m_vecBounds.resize(0);
+	m_nRecordStart = 0;
 }
 
 /**
- * Extracts tokens of text out of a given buffer.
- * @param	ppBuf		Points to the buffer to parse, and is set to the
- *						beginning of the next token, upon return
- * @param	pBufSize	Points to the size of the buffer, and is set to the
- *						remaining size, upon return
- * @param	sResult		Holds the token's text, upon successful return
+ * Extracts the next token out of the output buffer.
+ * Parsing begins at the position where the previous call has stopped. If the
+ * buffer ends before a delimiter is found, the beginning of the partial token
+ * is remembered, so that the next call continues from the same token once
+ * more output has arrived.
+ * @param	token		Refers to the token's text, upon successful return
  * @param	delim		Holds the delimiter by which the token's end was
  * 						determined
  * @return	true if a token was extracted up to the given delimter(s), false
  *			if the buffer ended before a delimiter could be identified
  */
-bool Frontend::tokenize(char** ppBuf, int* pBufSize, QString& sResult,
-	ParserDelim& delim)
+bool Frontend::tokenize(FrontendToken& token, ParserDelim& delim)
 {
-	int nSize;
-	char* pBuf;
-	bool bDelim, bWhiteSpace, bFoundToken = false;
+	const char* pBuf;
+	int nPos, nSize;
+	bool bDelim, bWhiteSpace;
+	
+	pBuf = m_baBuf.constData();
+	nSize = m_baBuf.size();
 	
 	// Iterate buffer
-	for (nSize = *pBufSize, pBuf = *ppBuf; (nSize > 0) && !bFoundToken;
-		nSize--, pBuf++) {
+	for (nPos = m_nPos; nPos < nSize; nPos++) {
 		// Test if this is a delimiter character
-		switch (*pBuf) {
+		switch (pBuf[nPos]) {
 		case '\n':
 			bDelim = ((m_delim & Newline) != 0);
 			bWhiteSpace = true;
@@ -200,32 +336,52 @@ bool Frontend::tokenize(char** ppBuf, int* pBufSize, QString& sResult,
 			bWhiteSpace = false;
 		}
 
-		if (m_bInToken && bDelim) {
-			m_bInToken = false;
-			*pBuf = 0;
-			bFoundToken = true;
-		}
-		else if (!m_bInToken && !bWhiteSpace) {
-			m_bInToken = true;
-			*ppBuf = pBuf;
+		if ((m_nTokenStart >= 0) && bDelim) {
+			// Found the end of the token
+			token.m_pBuf = &m_baBuf;
+			token.m_nOffset = m_nTokenStart;
+			token.m_nLength = nPos - m_nTokenStart;
+			
+			m_nTokenStart = -1;
+			m_nPos = nPos + 1;
+			return true;
 		}
+		
+		if ((m_nTokenStart < 0) && !bWhiteSpace)
+			m_nTokenStart = nPos;
 	}
 
-	// Either a token was found, or the search through the buffer was
-	// finished without a delimiter character
-	if (bFoundToken) {
-		sResult = *ppBuf;
-		*ppBuf = pBuf;
-		*pBufSize = nSize;
-	}
-	else if (m_bInToken) {
-		sResult = QString::fromLatin1(*ppBuf, *pBufSize);
-	}
-	else {
-		sResult = QString::null;
-	}
+	// The buffer has ended before the requested delimiter
+	m_nPos = nSize;
+	return false;
+}
 
-	return bFoundToken;
+/**
+ * Discards parsed output from the beginning of the buffer.
+ * Text referred to by the tokens of an incomplete record, or by a partial
+ * token, is moved to the beginning of the buffer.
+ * Must only be called after the current block of records was delivered.
+ */
+void Frontend::compact()
+{
+	int nKeep, i;
+	
+	// Find the first position that is still required
+	nKeep = (m_nTokenStart >= 0) ? m_nTokenStart : m_nPos;
+	if (!m_vecTokens.isEmpty() && (m_vecTokens[0].m_nOffset < nKeep))
+		nKeep = m_vecTokens[0].m_nOffset;
+		
+	if (nKeep == 0)
+		return;
+		
+	// Move the remaining text, and adjust all positions accordingly
+	m_baBuf.remove(0, nKeep);
+	m_nPos -= nKeep;
+	if (m_nTokenStart >= 0)
+		m_nTokenStart -= nKeep;
+		
+	for (i = 0; i < m_vecTokens.size(); i++)
+		m_vecTokens[i].m_nOffset -= nKeep;
 }
 
 /**
@@ -246,6 +402,11 @@ void Frontend::slotFinished(int, ExitStatus)
 	// Allow specialised clean-up by inheriting classes
 	finalize();
 	
+	// An inheriting class may have started another process to continue the
+	// same operation, in which case the signal is emitted when it terminates
+	if (state() != QProcess::NotRunning)
+		return;
+	
 	// Signal the process has terminated
 	emit finished(m_nRecords);
 	
@@ -255,80 +416,109 @@ void Frontend::slotFinished(int, ExitStatus)
 }
 
 /**
- * Reads data written on the standard output by the controlled process.
- * This is a private slot called attached to the readyReadStdout() signal of
- * the controlled process, which means that it is called whenever data is
- * ready to be read from the process' stream.
- * The method reads whatever data is queued, and sends it to be interpreted
- * by parseStdout().
+ * Parses output that was produced without running a process.
+ * The given text is handled exactly as if it was written by a process to its
+ * standard output, and the resulting records are delivered through the
+ * dataReady() signal before this method returns.
+ * @param	baOutput	The output to parse
  */
-void Frontend::slotReadStdout(KProcess*, char* pBuffer, int nSize)
+void Frontend::parseOutput(const QByteArray& baOutput)
 {
-	char* pLocalBuf;
-	QString sToken;
-	bool bTokenEnded;
-	ParserDelim delim;
-
-	// Do nothing if waiting for process to die
-	if (m_bKilled)
-		return;
-	
-	pLocalBuf = pBuffer;
+	m_nRecords = 0;
+	m_bKilled = false;
+	resetBuffer();
 	
-	// Iterate over the given buffer
-	while (nSize > 0) {
-		// Create a new token, if the last iteration has completed one
-		if (m_pCurToken == NULL)
-			m_pCurToken = new FrontendToken();
-
-		// Extract text until the requested delimiter
-		bTokenEnded = tokenize(&pLocalBuf, &nSize, sToken, delim);
-
-		// Add the extracted text to the current token
-		m_pCurToken->m_sData += sToken;
-
-		// If the buffer has ended before the requested delimiter, we need
-		// to wait for more output from the process
-		if (!bTokenEnded)
-			return;
+	m_baBuf.append(baOutput);
+	parseBuffer();
+}
 
+/**
+ * Sends the complete tokens in the output buffer to be interpreted by
+ * parseStdout(), and delivers the resulting records.
+ */
+void Frontend::parseBuffer()
+{
+	FrontendToken token;
+	ParserDelim delim;
+	ParseResult result;
+	
+	// Iterate over the complete tokens in the buffer
+	while (!m_bKilled && tokenize(token, delim)) {
 		// Call the process-specific parser function
-		switch (parseStdout(m_pCurToken->m_sData, delim)) {
+		switch (result = parseStdout(token, delim)) {
 		case DiscardToken:
 			// Token should not be saved
-			delete m_pCurToken;
 			break;
 
 		case AcceptToken:
-			// Store token in linked list
-			addToken(m_pCurToken);
+			// Store token in the current record
+			addToken(token);
 			break;
 
 		case RecordReady:
-			// Store token, and notify the target object that an entry can
-			// be read
+		case BatchReady:
+			// Store token, and add the record to the current block
 			m_nRecords++;
-			addToken(m_pCurToken);
-			emit dataReady(m_pHeadToken);
+			addToken(token);
+			endRecord();
+			
+			// Deliver the block now, if requested by the parser
+			if (result == BatchReady)
+				emitBatch();
+			break;
 
-			// Delete all tokens in the entry
-			removeRecord();
+		case RecordEnded:
+			// Add the record to the current block, without this token
+			m_nRecords++;
+			endRecord();
 			break;
 			
 		case Abort:
 			kill();
-			nSize = 0;
 			break;
 		}
 
-		m_pCurToken = NULL;
+		token = FrontendToken();
 	}
+	
+	// Deliver all records parsed in this pass
+	if (!m_bKilled)
+		emitBatch();
+	
+	// Keep only the text required for the next read
+	if (m_bKilled)
+		resetBuffer();
+	else
+		compact();
 }
 
+/**
+ * Reads data written on the standard output by the controlled process.
+ * This is a private slot called attached to the readyReadStandardOutput()
+ * signal of the controlled process, which means that it is called whenever
+ * data is ready to be read from the process' stream.
+ * The method appends whatever data is queued to the output buffer, and sends
+ * the complete tokens to be interpreted by parseStdout().
+ */
 void Frontend::slotReadStdout2()
 {
-    QByteArray output = this->readAllStandardOutput();
-    slotReadStdout(this, output.data(), output.size());
+	qint64 nAvail;
+	int nSize;
+
+	// Append the new output to the buffer
+	nSize = m_baBuf.size();
+	nAvail = bytesAvailable();
+	m_baBuf.resize(nSize + (int)nAvail);
+	nAvail = read(m_baBuf.data() + nSize, nAvail);
+	m_baBuf.resize(nSize + ((nAvail > 0) ? (int)nAvail : 0));
+	
+	// Do nothing if waiting for process to die
+	if (m_bKilled) {
+		resetBuffer();
+		return;
+	}
+	
+	parseBuffer();
 }
 
 /**
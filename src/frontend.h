@@ -2,10 +2,15 @@
 #define FRONTEND_H
 
 #include <QObject>
+#include <QVector>
 #include <KProcess>
 
 /**
  * Represents a single token in the parsed output stream.
+ * A token does not hold a copy of its text. Instead, it refers to a range of
+ * bytes inside the buffer into which the process output is read. The text is
+ * only converted to a QString when getData() is called. Consequently, a token
+ * is only valid while the record it belongs to is being handled.
  * @author Elad Lahav
  */
 
@@ -15,12 +20,27 @@ public:
 	/**
 	 * Class constructor.
 	 */
-	FrontendToken() : m_pNext(NULL) {}
+	FrontendToken() : m_pNext(NULL), m_pBuf(NULL), m_nOffset(0),
+		m_nLength(0), m_bSet(false) {}
 
+	QString getData() const;
+	bool isEqual(const char*) const;
+	bool startsWith(const char*) const;
+	int toInt(int nPos = 0, int* pEnd = NULL) const;
+	bool isNumber() const;
+	void chop(int);
+	void setData(const QString&);
+	
+	/**
+	 * @return	A pointer to the first character of the token (not
+	 *			NULL-terminated)
+	 */
+	const char* getText() const { return m_pBuf->constData() + m_nOffset; }
+	
 	/**
-	 * @return	The text associated with this token
+	 * @return	The number of characters in the token
 	 */
-	const QString& getData() const { return m_sData; }
+	int getLength() const { return m_nLength; }
 	
 	/**
 	 * @return	A pointer to the next token in the strem.
@@ -28,14 +48,56 @@ public:
 	FrontendToken* getNext() const { return m_pNext; }
 
 protected:
-	/** Free text associated with the token. */
-	QString m_sData;
-	
 	/** A pointer to the next token in the stream. */
 	FrontendToken* m_pNext;
+	
+	/** The buffer holding the token's text. */
+	const QByteArray* m_pBuf;
+	
+	/** The position of the token's text in the buffer. */
+	int m_nOffset;
+	
+	/** The length of the token's text. */
+	int m_nLength;
+	
+	/** Text set by a parser to replace the original contents of the token. */
+	QString m_sData;
+	
+	/** true if the text of the token was replaced by setData(). */
+	bool m_bSet;
 
 	friend class Frontend;
 };
+
+/**
+ * A block of complete records, parsed out of the output of the controlled
+ * process.
+ * Records are delivered in blocks (one per read from the process), rather
+ * than one at a time, so that consumers can handle all available records in
+ * a single operation. Each record is represented by the list of its tokens.
+ * The block is only valid while the dataReady() signal is being handled.
+ * @author Elad Lahav
+ */
+class FrontendBatch
+{
+public:
+	/**
+	 * @return	The number of records in the block
+	 */
+	int count() const { return m_vecRecords.count(); }
+	
+	/**
+	 * @param	nIndex	The index of a record in the block
+	 * @return	The first token of the requested record
+	 */
+	FrontendToken* at(int nIndex) const { return m_vecRecords[nIndex]; }
+	
+private:
+	/** The first token of each record in the block. */
+	QVector<FrontendToken*> m_vecRecords;
+	
+	friend class Frontend;
+};
  
 /**
  * Abstract base class that provides a front-end to console-based programmes.
@@ -55,7 +117,7 @@ public:
 
 	virtual bool run(const QString&, const QStringList&,
 		const QString& sWorkDir = "", bool bBlock = false);
-	void kill();
+	virtual void kill();
 		
 	/**
 	 * @return	An string describing the error which made run() fail
@@ -64,13 +126,13 @@ public:
 	
 signals:
 	/**
-	 * Indicates tokens can be read.
+	 * Indicates records can be read.
 	 * The Frontend object parses the back-end output and creates a list of
-	 * tokens. This signal is emitted when a batch of characters has been
-	 * converted into a token list.
-	 * @param	pToken	The head of the token list
+	 * tokens for each record. This signal is emitted when a batch of
+	 * characters has been converted into a block of complete records.
+	 * @param	batch	The block of records
 	 */
-	void dataReady(FrontendToken* pToken);
+	void dataReady(const FrontendBatch& batch);
 	
 	/**
 	 * Emitted when the back-end process terminates.
@@ -107,21 +169,16 @@ protected:
 		DiscardToken	/** Delete this token */,
 		AcceptToken		/** Add this token to the list */,
 		RecordReady		/** This token completes a record */,
+		BatchReady		/** This token completes a record, and the block of
+							records should be delivered immediately */,
+		RecordEnded		/** Delete this token, and complete the current
+							record */,
 		Abort			/** Kill the process */
 	};
 
 	/** Number of complete records read so far. */
 	uint m_nRecords;	
 	
-	/** The head of the list of parsed output tokens. */
-	FrontendToken* m_pHeadToken;
-
-	/** The tail of the list of parsed output tokens. */
-	FrontendToken* m_pTailToken;
-
-	/** An iterator on the list of parsed output tokens. */
-	FrontendToken* m_pCurToken;
-
 	/** The current delimiters used for parsing the output. */
 	ParserDelim m_delim;
 	
@@ -131,18 +188,20 @@ protected:
 	/**
 	 * Handles a text token received on the Standard Output stream of the
 	 * controlled process.
-	 * This is called by slotReadStdout whenever a new token is recognised.
+	 * This is called by slotReadStdout2() whenever a new token is recognised.
 	 * Inheriting classes should implement this method to parse the resutling
 	 * stream of tokens.
-	 * @param	sToken	A part of the text received on the Standard Output,
+	 * @param	token	A part of the text received on the Standard Output,
 	 *					disected according to current delimiter settings
 	 * @param	delim	The delimiter that ended this token
 	 * @result	A ParseResult value, indicating what should be done with the
 	 *			new token
 	 */
-	virtual ParseResult parseStdout(QString& sToken, ParserDelim delim) = 0;
+	virtual ParseResult parseStdout(FrontendToken& token,
+		ParserDelim delim) = 0;
 
 	virtual void parseStderr(const QString&);
+	void parseOutput(const QByteArray&);
 	
 	/**
 	 * Called when the process exits.
@@ -154,30 +213,58 @@ protected slots:
 	virtual void slotFinished(int exitCode, QProcess::ExitStatus exitStatus);
 	
 private:
+#ifdef TESTCASE
+	friend class FrontendTest;
+#endif
+
 	/** Determines whether the object should be deleted once the process has
 		exited */
 	bool m_bAutoDelete;
 
-	/** Determines whether the parser is in the middle of a token, or between
-		two tokens */
-	bool m_bInToken;
-
 	/** The number of fields in each parsed record. Should be defined for 
 		every sub-class. */
 	uint m_nRecordSize;
 	
+	/** Holds output read from the process that was not yet parsed, or that
+		belongs to a record which is not complete. The buffer is reused for
+		all output read from the process. */
+	QByteArray m_baBuf;
+	
+	/** The position in the buffer from which parsing should continue. */
+	int m_nPos;
+	
+	/** The position in the buffer at which the current token begins, or -1
+		if the parser is between two tokens. */
+	int m_nTokenStart;
+	
+	/** Tokens accepted for the records of the current block, as well as for
+		the following incomplete record. */
+	QVector<FrontendToken> m_vecTokens;
+	
+	/** The index of the first token of each complete record in the current
+		block. */
+	QVector<int> m_vecBounds;
+	
+	/** The index of the first token of the incomplete record. */
+	int m_nRecordStart;
+	
+	/** The block of records delivered by dataReady(). */
+	FrontendBatch m_batch;
+	
 	/** This flag is raised when kill() is called. It signifies that even
 		though the process may not be dead yet, it should be considered as
 		such. */
 	bool m_bKilled;
 	
-	void addToken(FrontendToken*);
-	void removeToken();
-	void removeRecord();
-	bool tokenize(char**, int*, QString&, ParserDelim&);
+	void addToken(const FrontendToken&);
+	void endRecord();
+	void emitBatch();
+	void resetBuffer();
+	bool tokenize(FrontendToken&, ParserDelim&);
+	void compact();
+	void parseBuffer();
 		
 private slots:
-	void slotReadStdout(KProcess*, char*, int);
 	void slotReadStderr(KProcess*, char*, int);
     void slotReadStdout2();
     void slotReadStderr2();
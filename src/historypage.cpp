@@ -1,6 +1,9 @@
+#include <QTreeWidgetItemIterator>
 #include <klocale.h>
 #include "historypage.h"
 #include "historyview.h"
+#include "pathtable.h"
+#include "pagefile.h"
 
 int HistoryPage::s_nMaxPageID = 0;
 
@@ -13,7 +16,8 @@ HistoryPage::HistoryPage(QWidget* pParent) :
 	QueryPageBase(pParent),
 	m_nPageID(++s_nMaxPageID)
 {
-	m_pView = new HistoryView(this);
+	m_pHistory = new HistoryView(this);
+	m_pView = m_pHistory;
     m_pLayout = new QHBoxLayout(this);
     m_pLayout->addWidget(m_pView);
     setLayout(m_pLayout);
@@ -45,7 +49,7 @@ void HistoryPage::addRecord(const QString& sFile, uint nLine,
 {
 	HistoryItem* pItem, * pNextItem;
 	
-	pItem = (HistoryItem*)m_pView->currentItem();
+	pItem = (HistoryItem*)m_pHistory->currentItem();
 	if (pItem != NULL) {
 		// Do not add duplicate items
 		if ((pItem->text(1) == sFile) && (pItem->text(2).toUInt() == nLine))
@@ -62,7 +66,7 @@ void HistoryPage::addRecord(const QString& sFile, uint nLine,
 	}
 	
 	// Create the new item at the top of the list
-	m_pView->addRecord("", sFile, QString::number(nLine), sText, NULL);
+	m_pHistory->addRecord("", sFile, QString::number(nLine), sText, NULL);
 }
 
 /**
@@ -75,7 +79,24 @@ void HistoryPage::addRecord(const QString& sFile, uint nLine,
 void HistoryPage::addRecord(const QString& sFunc, const QString& sFile,
 	const QString& sLine, const QString& sText)
 {
-	m_pView->addRecord(sFunc, sFile, sLine, sText, NULL);
+	m_pHistory->addRecord(sFunc, PathTable::toDisplay(sFile), sLine, sText,
+		NULL);
+}
+
+/**
+ * Moves to the next position in the history.
+ */
+void HistoryPage::selectNext()
+{
+	m_pHistory->selectNext();
+}
+
+/**
+ * Moves to the previous position in the history.
+ */
+void HistoryPage::selectPrev()
+{
+	m_pHistory->selectPrev();
 }
 
 /**
@@ -96,3 +117,17 @@ QString HistoryPage::getFileName(const QString&) const
 {
 	return QString("History_") + QString::number(m_nPageID);
 }
+
+/**
+ * Adds the history records to a page file.
+ * @param	file	The page file to write
+ */
+void HistoryPage::writeRecords(PageFile& file)
+{
+	QTreeWidgetItemIterator itr(m_pHistory);
+
+	for (; *itr; ++itr) {
+		file.addRecord((*itr)->text(0), PathTable::toPath((*itr)->text(1)),
+			(*itr)->text(2).toUInt(), (*itr)->text(3));
+	}
+}
@@ -3,6 +3,8 @@
 
 #include "querypagebase.h"
 
+class HistoryView;
+
 /**
  * A QueryWidget page for holding position history.
  * @author Elad Lahav
@@ -17,6 +19,9 @@ public:
 	
 	void addRecord(const QString&, uint, const QString&);
 	
+	virtual void selectNext();
+	virtual void selectPrev();
+	
 	virtual QString getCaption(bool bBrief = false) const;
 
 protected:
@@ -29,12 +34,22 @@ protected:
 	 */
 	virtual bool readHeader(QTextStream&) { return true; }
 	
+	/**
+	 * @return	Always true, since History files do not contain a header
+	 */
+	virtual bool readHeader(const PageFile&) { return true; }
+	
 	/**
 	 * This method does nothing, since History files do not contain a header.
 	 */	
-	virtual void writeHeader(QTextStream&) {}
+	virtual void writeHeader(PageFile&) {}
+	
+	virtual void writeRecords(PageFile&);
 
 private:
+	/** The embedded view (also referenced as m_pView). */
+	HistoryView* m_pHistory;
+	
 	/** A unique ID used to create a tab caption for this page. */
 	int m_nPageID;
 
@@ -36,6 +36,14 @@
 #include "querywidget.h"
 #include "editormanager.h"
 #include "cscopefrontend.h"
+#include "cscopesession.h"
+#include "cscopeworker.h"
+#include "cscopecache.h"
+#include "symbolindex.h"
+#include "ctagscache.h"
+#include "ctagsindex.h"
+#include "ctagsindexbuilder.h"
+#include "pathtable.h"
 #include "newprojectdlg.h"
 #include "openprojectdlg.h"
 #include "preferencesdlg.h"
@@ -50,6 +58,15 @@
 #include "bookmarksdlg.h"
 #include "kscopeactions.h"
 #include "symboldlg.h"
+#include "projectwatcher.h"
+
+/** The maximal number of modified files covered by the delta database. Once
+	this number is exceeded, the database is rebuilt as usual. */
+#define DELTA_MAX_FILES		32
+
+/** The minimal time (in seconds) before rebuilding the database, for files
+	covered by the delta database. */
+#define DELTA_IDLE_TIME		300
 
 /**
  * Class constructor.
@@ -59,13 +76,16 @@
 KScope::KScope(QWidget* pParent) :
     KXmlGuiWindow(pParent),
 	m_pCscopeBuild(NULL),	
+	m_pCscopeDelta(NULL),
+	m_bDeltaPending(false),
 	m_sCurFilePath(""),
 	m_nCurLine(0),
 	m_pProgressDlg(NULL),
 	m_bUpdateGUI(true),
 	m_bCscopeVerified(false),
 	m_bRebuildDB(false),
-	m_pMakeDlg(NULL)
+	m_pMakeDlg(NULL),
+	m_bRebuildAll(false)
 {
 	QString sPath;
 
@@ -104,6 +124,11 @@ KScope::KScope(QWidget* pParent) :
 	// Create control objects
 	m_pProjMgr = new ProjectManager();
 	m_pEditMgr = new EditorManager(this);
+	m_pWatcher = new ProjectWatcher(this);
+	m_pTagBuilder = new CtagsIndexBuilder(this);
+
+	// Query the version of Ctags in the background, before it is run
+	CtagsFrontend::checkVersion(Config().getCtagsPath());
 
 	// Initialise the KscopePixmaps icon manager	
 	Pixmaps().init();
@@ -134,7 +159,8 @@ KScope::KScope(QWidget* pParent) :
 
 	// Rebuild the project database after a certain time period has elapsed
 	// since the last save
-	connect(&m_timerRebuild, SIGNAL(timeout()), this, SLOT(slotRebuildDB()));
+	connect(&m_timerRebuild, SIGNAL(timeout()), this,
+		SLOT(slotRebuildSaved()));
 
 	// Store main window settings when closed
 	setAutoSaveSettings();
@@ -170,10 +196,16 @@ KScope::~KScope()
 	Config().store();
 	Config().storeWorkspace(this);
 	
+	delete m_pWatcher;
+	delete m_pTagBuilder;
 	delete m_pEditMgr;
 	delete m_pCscopeBuild;
+	delete m_pCscopeDelta;
 	delete m_pProjMgr;
 	
+	// Wait for the thread reading the database
+	CscopeWorker::stop();
+	
 	if (m_pMakeDlg != NULL)
 		delete m_pMakeDlg;
 }
@@ -191,6 +223,7 @@ void KScope::initMainWindow()
 	// Create the status bar
 	pStatus = statusBar();
 	pStatus->insertItem(i18n(" Line: N/A Col: N/A "), 0, true);
+	pStatus->insertItem(i18n(" Scope: N/A "), 1, true);
 
 	// Create the main dock for the editor tabs widget
 	pMainDock = new QDockWidget("Editors Window", this);
@@ -415,9 +448,20 @@ void KScope::slotProjectProps()
 	// Set per-project command-line arguments for Ctags
 	CtagsFrontend::setExtraArgs(opt.sCtagsCmd);
 	
+	// Apply the auto-completion settings to open editors
+	m_pEditTabs->setAutoCompletion(opt);
+	
 	// Set the source root
 	m_pFileView->setRoot(pProj->getSourceRoot());
     m_pQueryWidget->setRoot(pProj->getSourceRoot());
+	
+	// The source root and the file types may have changed
+	m_pWatcher->start(pProj->getSourceRoot(), pProj->getFileTypes());
+	
+	// The tag index needs to be built again if the Ctags arguments have
+	// changed
+	if (!CtagsIndex::load(pProj->getPath()))
+		m_pTagBuilder->start(pProj->getPath());
 }
 
 /**
@@ -524,18 +568,30 @@ void KScope::slotQueryIncluding()
  * Initiates a query to find the global definition of the symbol currently
  * selected or under the cursor. The user is prompted only if no symbol can
  * be found.
+ * A symbol with a single definition in the project's tag index is displayed
+ * immediately, without running a query (unless the file holding the
+ * definition was modified since the index was built.)
  */
 void KScope::slotQueryQuickDef()
 {
 	QString sSymbol;
 	QueryViewDlg* pDlg;
+	QList<CtagsIndex::Tag> lstTags;
 	uint nType;
 	bool bCase;
 	
 	// Get the requested symbol and query type
 	nType = SymbolDlg::Definition;
+	bCase = true;
 	if (!getSymbol(nType, sSymbol, bCase, false))
 		return;
+	
+	// Look for the definition in the tag index
+	if (bCase && CtagsIndex::find(sSymbol, CTAGS_DEF_KINDS, lstTags) &&
+		lstTags.count() == 1) {
+		slotShowEditor(lstTags.first().sFile, lstTags.first().nLine);
+		return;
+	}
 		
 	// Create a modeless query view dialogue
 	pDlg = new QueryViewDlg(QueryViewDlg::DestroyOnSelect, this);
@@ -567,7 +623,16 @@ void KScope::slotRebuildDB()
 		m_pProgressDlg->setValue(0);
 	}
 
+	// The new database covers all files modified so far
+	m_slDeltaFiles.clear();
+	m_bRebuildAll = false;
+	m_timerRebuild.stop();
+	
 	m_pCscopeBuild->rebuild();
+	
+	// Build the tag index along with the database
+	if (!pProj->isTemporary())
+		m_pTagBuilder->start(pProj->getPath());
 }
 
 /**
@@ -611,10 +676,8 @@ void KScope::slotProjectFilesChanged()
 	QStringList slArgs;
 	
 	// Refresh the file list
-	m_pFileListWidget->setUpdatesEnabled(false);
 	m_pFileListWidget->clear();
-	m_pProjMgr->curProject()->loadFileList(m_pFileListWidget);
-	m_pFileListWidget->setUpdatesEnabled(true);
+	m_pProjMgr->curProject()->loadFileList(m_pFileListWidget, true);
 	
 	// Rebuild the symbol database
 	if (isAutoRebuildEnabled())
@@ -707,12 +770,24 @@ void KScope::openProject(const QString& sDir)
 	// Set per-project command-line arguments for Ctags
 	CtagsFrontend::setExtraArgs(opt.sCtagsCmd);
 	
+	// Store the tags of files in the project directory
+	CtagsCache::setDir(pProj->isTemporary() ? QString::null :
+		pProj->getPath());
+	
 	// Create an initial query page
 	m_pQueryWidget->addQueryPage();
 	
 	// Enable project-related actions
 	m_pActions->slotEnableProjectActions(true);
 	
+	// Track files created in or removed from the source tree, and load the
+	// tag index (building it if required)
+	if (!pProj->isTemporary()) {
+		m_pWatcher->start(pProj->getSourceRoot(), pProj->getFileTypes());
+		if (!CtagsIndex::load(pProj->getPath()))
+			m_pTagBuilder->start(pProj->getPath());
+	}
+	
 	// If this is a new project (i.e., no source files are yet included), 
 	// display the project files dialogue
 	if (pProj->isEmpty()) {
@@ -721,9 +796,7 @@ void KScope::openProject(const QString& sDir)
 	}
 	
 	// Fill the file list with all files in the project. 
-	m_pFileListWidget->setUpdatesEnabled(false);
-	pProj->loadFileList(m_pFileListWidget);
-	m_pFileListWidget->setUpdatesEnabled(true);
+	pProj->loadFileList(m_pFileListWidget, true);
 	
 	// Restore the last session
 	restoreSession();
@@ -775,9 +848,7 @@ bool KScope::openCscopeOut(const QString& sFilePath)
 	m_pActions->slotEnableProjectActions(true);
 	
 	// Fill the file list with all files in the project. 
-	m_pFileListWidget->setUpdatesEnabled(false);
-	pProj->loadFileList(m_pFileListWidget);
-	m_pFileListWidget->setUpdatesEnabled(true);
+	pProj->loadFileList(m_pFileListWidget, true);
 	
 	return true;
 }
@@ -952,9 +1023,12 @@ void KScope::initCscope()
 {
 	ProjectBase* pProj;
 	
-	// Delete the current object, if one exists
+	// Delete the current objects, if they exist
 	if (m_pCscopeBuild)
 		delete m_pCscopeBuild;
+	delete m_pCscopeDelta;
+	m_slDeltaFiles.clear();
+	m_bDeltaPending = false;
 
 	// Initialise CscopeFrontend
 	pProj = m_pProjMgr->curProject();
@@ -976,6 +1050,30 @@ void KScope::initCscope()
 	// Show errors in a modeless dialogue
 	connect(m_pCscopeBuild, SIGNAL(error(const QString&)), this,
 		SLOT(slotCscopeError(const QString&)));
+		
+	// Create a Cscope process for building databases of modified files
+	m_pCscopeDelta = new CscopeFrontend();
+	connect(m_pCscopeDelta, SIGNAL(finished(uint)), this,
+		SLOT(slotDeltaFinished(uint)));
+}
+
+/**
+ * Builds a database for the files modified since the project's database was
+ * last built.
+ * Once built, queries answered by reading the database directly reflect the
+ * changes made to these files, without waiting for the entire database to be
+ * rebuilt.
+ */
+void KScope::buildDelta()
+{
+	// Wait for the current build to finish
+	if (m_pCscopeDelta->state() != QProcess::NotRunning) {
+		m_bDeltaPending = true;
+		return;
+	}
+	
+	m_slDeltaBuilt = m_slDeltaFiles;
+	m_pCscopeDelta->rebuildDelta(m_slDeltaBuilt);
 }
 
 /**
@@ -1041,14 +1139,31 @@ bool KScope::slotCloseProject()
 	
 	// Close the project in the project manager, and terminate the Cscope
 	// process
+	m_pWatcher->stop();
+	m_pTagBuilder->stop();
 	m_pProjMgr->close();
 	delete m_pCscopeBuild;
 	m_pCscopeBuild = NULL;
+	delete m_pCscopeDelta;
+	m_pCscopeDelta = NULL;
+	m_slDeltaFiles.clear();
+	m_hashSaved.clear();
+	m_bDeltaPending = false;
+	m_bRebuildAll = false;
+	m_timerRebuild.stop();
+	CscopeSession::stop();
+	CscopeWorker::reset();
+	SymbolIndex::reset();
+	CtagsCache::setDir(QString::null);
+	CtagsIndex::reset();
 	setCaption(QString::null);
 
 	// Clear the contents of the file list
 	m_pFileView->clear();
 
+	// No view refers to the paths of the project any longer
+	PathTable::clear();
+
 	// Reset queried symbols history
 	SymbolDlg::resetHistory();
 	
@@ -1329,6 +1444,7 @@ EditorPage* KScope::createEditorPage()
 	EditorPage* pPage;
 	QMenu* pMenu;
 	ProjectBase* pProj;
+	ProjectBase::Options opt;
 	
 	// Load a new document part
 	pDoc = m_pEditMgr->add();
@@ -1349,6 +1465,10 @@ EditorPage* KScope::createEditorPage()
 	connect(pPage, SIGNAL(cursorPosChanged(uint, uint)), this,
 		SLOT(slotShowCursorPos(uint, uint)));
 	
+	// Show the function holding the cursor in the status bar
+	connect(pPage, SIGNAL(scopeChanged(const QString&)), this,
+		SLOT(slotShowScope(const QString&)));
+	
 	// Rebuild the database after a file has changed
 	connect(pPage, SIGNAL(fileSaved(const QString&, bool)), this,
 		SLOT(slotFileSaved(const QString&, bool)));
@@ -1362,6 +1482,11 @@ EditorPage* KScope::createEditorPage()
 	if (pProj && pProj->getTabWidth() > 0)
 		pPage->setTabWidth(pProj->getTabWidth());
 	
+	if (pProj) {
+		pProj->getOptions(opt);
+		pPage->setAutoCompletion(opt);
+	}
+	
 	return pPage;
 }
 	
@@ -1416,6 +1541,7 @@ void KScope::slotChangeEditor(EditorPage* pOldPage, EditorPage* pNewPage)
 		pFactory->addClient(pNewPage->getView());
 		m_sCurFilePath = pNewPage->getFilePath();
 		setCaption(m_pProjMgr->getProjName() + " - " + m_sCurFilePath);
+		slotShowScope(pNewPage->getScope());
 	}
 	
 	// Enable/disable file-related actions, if necessary
@@ -1608,6 +1734,17 @@ void KScope::slotBuildInvIndex()
  */
 void KScope::slotBuildFinished(uint)
 {
+	// Results of previous queries no longer apply
+	CscopeCache::invalidate();
+	
+	// Read the symbols of the new database in the background
+	SymbolIndex::refresh();
+	
+	// The rebuilt database replaces the delta (@see CscopeFrontend), so
+	// build it again for files saved while the database was rebuilt
+	if (!m_slDeltaFiles.isEmpty())
+		buildDelta();
+	
 	// Delete the progress dialogue, if it exists (first time builds)
 	if (m_pProgressDlg) {
 		delete m_pProgressDlg;
@@ -1681,6 +1818,19 @@ void KScope::slotShowCursorPos(uint nLine, uint nCol)
 	m_nCurLine = nLine;
 }
 
+/**
+ * Displays the function, structure or class that holds the cursor.
+ * This slot is connected to the scopeChanged() signal emitted by an
+ * EditorPage object.
+ * @param	sScope	Describes the scope, an empty string if the cursor is
+ *					not inside any scope
+ */
+void KScope::slotShowScope(const QString& sScope)
+{
+	statusBar()->changeItem(i18n(" Scope: %1 ").arg(sScope.isEmpty() ?
+		i18n("N/A") : sScope), 1);
+}
+
 /**
  * Stores the path of a newly opened file.
  * This slot is connected to the fileOpened() signal emitted by an
@@ -1704,14 +1854,15 @@ void KScope::slotFileOpened(EditorPage*, const QString& sFilePath)
 void KScope::slotFileSaved(const QString& sPath, bool bIsNew)
 {
 	ProjectBase* pProj;
-	int nTime;
 	
 	pProj = m_pProjMgr->curProject();
 	if (!pProj)
 		return;
 	
-	// Prompt the user to add this file to the current project
-	if (bIsNew && !pProj->isTemporary()) {
+	// Prompt the user to add this file to the current project (unless it was
+	// already added when detected in the source tree)
+	if (bIsNew && !pProj->isTemporary() &&
+		!m_pFileListWidget->findFile(sPath)) {
 		if (KMessageBox::questionYesNo(0, 
 			i18n("Whould you like to add this file to the active project?")) == 
 				  KMessageBox::Yes) {
@@ -1731,11 +1882,8 @@ void KScope::slotFileSaved(const QString& sPath, bool bIsNew)
 		}
 	}
 	
-	// Get the project's auto-rebuild time
-	nTime = pProj->getAutoRebuildTime();
-	
 	// Do nothing if the time is set to -1
-	if (nTime == -1)
+	if (!isAutoRebuildEnabled())
 		return;
 		
 	// Check if the file is included in the project (external files should
@@ -1743,14 +1891,229 @@ void KScope::slotFileSaved(const QString& sPath, bool bIsNew)
 	if (!m_pFileListWidget->findFile(sPath))
 		return;
 	
+	// The project watcher reports this change as well
+	m_hashSaved.insert(sPath, QFileInfo(sPath).lastModified());
+	rebuildModified(QStringList(sPath));
+}
+
+/**
+ * Updates the database for files which were modified or added to the
+ * project.
+ * A database built for these files alone is used until the project's database
+ * is rebuilt, which happens once the project's auto-rebuild time has elapsed
+ * since the last modification.
+ * @param	slFiles	The full paths of the modified files
+ */
+void KScope::rebuildModified(const QStringList& slFiles)
+{
+	QStringList::ConstIterator itr;
+	int nTime;
+	
+	// Get the project's auto-rebuild time
+	nTime = m_pProjMgr->curProject()->getAutoRebuildTime();
+	
+	for (itr = slFiles.begin(); itr != slFiles.end(); ++itr) {
+		if (!m_slDeltaFiles.contains(*itr))
+			m_slDeltaFiles.append(*itr);
+	}
+	
 	// Rebuild immediately for a time set to 0
 	if (nTime == 0) {
+		slotRebuildSaved();
+		return;
+	}
+
+	// Reflect the changes in query results right away, using a database
+	// built for the modified files only
+
+	if (m_slDeltaFiles.count() > DELTA_MAX_FILES) {
+		// Reset the rebuild timer
+		m_timerRebuild.start(nTime * 1000);
+		return;
+	}
+	
+	buildDelta();
+	
+	// The project's database can be rebuilt once the user is idle
+	m_timerRebuild.start(qMax(nTime, DELTA_IDLE_TIME) * 1000);
+}
+
+/**
+ * Loads a database built for modified files, so that it is used by further
+ * queries.
+ * This slot is connected to the finished() signal emitted by the process
+ * building this database.
+ */
+void KScope::slotDeltaFinished(uint)
+{
+	ProjectBase* pProj;
+	
+	pProj = m_pProjMgr->curProject();
+	if (!pProj)
+		return;
+	
+	// Use the new database, unless the process has failed
+	if ((m_pCscopeDelta->exitStatus() == QProcess::NormalExit) &&
+		(m_pCscopeDelta->exitCode() == 0)) {
+		CscopeWorker::setDelta(pProj->getPath(), m_slDeltaBuilt);
+		CscopeCache::invalidate();
+		SymbolIndex::refresh();
+	}
+	
+	// Build again for files saved in the meantime
+	if (m_bDeltaPending) {
+		m_bDeltaPending = false;
+		buildDelta();
+	}
+}
+
+/**
+ * Rebuilds the database once project files were saved.
+ * For projects built in shards, only the shards holding the saved files are
+ * rebuilt.
+ * This slot is connected to the timeout() signal of the rebuild timer.
+ */
+void KScope::slotRebuildSaved()
+{
+	ProjectBase* pProj;
+	QStringList slFiles;
+	
+	pProj = m_pProjMgr->curProject();
+	if (!pProj)
+		return;
+	
+	// A missing database is built entirely, as is a database covering
+	// files which were removed from the project
+	if (!pProj->dbExists() || m_bRebuildAll) {
 		slotRebuildDB();
 		return;
 	}
+	
+	// The new database covers all files modified so far
+	slFiles = m_slDeltaFiles;
+	m_slDeltaFiles.clear();
+	m_timerRebuild.stop();
+	
+	m_pCscopeBuild->rebuild(slFiles);
+}
 
-	// Reset the rebuild timer
-	m_timerRebuild.start(nTime * 1000);
+/**
+ * Applies changes detected in the project's source tree.
+ * New files are added to the project, and files which no longer exist are
+ * removed from it. The database is then updated in the same manner as for
+ * files saved in the editor, except that removing files requires the entire
+ * database to be rebuilt.
+ * Also loads the project's tag index, once it has been built.
+ * @param	pEvent	A ProjectWatchEvent describing a batch of changes, or a
+ *					CtagsIndexEvent
+ */
+void KScope::customEvent(QEvent* pEvent)
+{
+	ProjectWatchEvent* pPWE;
+	ProjectBase* pProj;
+	QStringList slAdded, slRemoved, slModified;
+	QStringList::ConstIterator itr;
+	QStringList::Iterator itrModified;
+	QHash<QString, QDateTime>::Iterator itrSaved;
+	bool bSaved;
+	
+	// Load a tag index once it is built (unless the project was closed in
+	// the meantime)
+	if (pEvent->type() == CtagsIndexEvent::eventTypeId) {
+		pProj = m_pProjMgr->curProject();
+		if (pProj && ((CtagsIndexEvent*)pEvent)->m_bSuccess &&
+			((CtagsIndexEvent*)pEvent)->m_sProjPath == pProj->getPath() &&
+			CtagsIndex::load(pProj->getPath())) {
+			statusBar()->showMessage(i18n("Building the tag index..."
+				"Done!"), 3000);
+		}
+		return;
+	}
+	
+	if (pEvent->type() != ProjectWatchEvent::eventTypeId) {
+		KXmlGuiWindow::customEvent(pEvent);
+		return;
+	}
+	
+	pPWE = (ProjectWatchEvent*)pEvent;
+	
+	// The event may have been posted just before the project was closed
+	pProj = m_pProjMgr->curProject();
+	if (!pProj || pProj->isTemporary())
+		return;
+	
+	// Ignore files saved in the editor, which were already handled (@see
+	// slotFileSaved()), unless modified again since, and files already
+	// waiting for the database to be updated
+	for (itr = pPWE->m_slModified.begin(); itr != pPWE->m_slModified.end();
+		++itr) {
+		itrSaved = m_hashSaved.find(*itr);
+		if (itrSaved != m_hashSaved.end()) {
+			bSaved = (*itrSaved == QFileInfo(*itr).lastModified());
+			m_hashSaved.erase(itrSaved);
+			if (bSaved)
+				continue;
+		}
+		
+		if (!m_slDeltaFiles.contains(*itr))
+			slModified.append(*itr);
+	}
+	
+	slAdded = pPWE->m_slAdded;
+	slRemoved = pPWE->m_slRemoved;
+	if (slAdded.isEmpty() && slRemoved.isEmpty() &&
+		pPWE->m_slRemovedDirs.isEmpty() && !pPWE->m_bRescan) {
+		// The file list does not change, only keep the project's files
+		for (itrModified = slModified.begin();
+			itrModified != slModified.end(); ) {
+			if (m_pFileListWidget->findFile(*itrModified))
+				++itrModified;
+			else
+				itrModified = slModified.erase(itrModified);
+		}
+		
+		if (slModified.isEmpty() || !isAutoRebuildEnabled())
+			return;
+		
+		rebuildModified(slModified);
+		return;
+	}
+	
+	// Update the 'cscope.files' file
+	if (!((Project*)pProj)->updateFiles(slAdded, slRemoved, slModified,
+		pPWE->m_slRemovedDirs, pPWE->m_bRescan)) {
+		statusBar()->showMessage(i18n("Failed to write the file list."),
+			3000);
+		return;
+	}
+	
+	// Update the file list (which cannot remove single files)
+	if (!slRemoved.isEmpty()) {
+		m_pFileListWidget->clear();
+		pProj->loadFileList(m_pFileListWidget, true);
+	} else {
+		for (itr = slAdded.begin(); itr != slAdded.end(); ++itr)
+			m_pFileListWidget->addItem(*itr);
+	}
+	
+	if (!isAutoRebuildEnabled())
+		return;
+	
+	// Files cannot be removed from a database, so all of it needs to be
+	// rebuilt
+	// The same holds if changes were lost, since any file may have been
+	// modified
+	if (!slRemoved.isEmpty() || pPWE->m_bRescan) {
+		m_bRebuildAll = true;
+		if (pProj->getAutoRebuildTime() == 0)
+			slotRebuildSaved();
+		else
+			m_timerRebuild.start(pProj->getAutoRebuildTime() * 1000);
+		return;
+	}
+	
+	if (!slAdded.isEmpty() || !slModified.isEmpty())
+		rebuildModified(slAdded + slModified);
 }
 
 /**
@@ -21,6 +21,8 @@ class CscopeMsgDlg;
 class MakeDlg;
 class CallTreeManager;
 class KScopeActions;
+class ProjectWatcher;
+class CtagsIndexBuilder;
 
 class KScope : public KXmlGuiWindow
 {
@@ -43,6 +45,7 @@ public slots:
 
 protected:
 	virtual bool queryClose();
+	virtual void customEvent(QEvent*);
 
 private:
 	/** A project manager used to load projects and read their properties. */
@@ -68,9 +71,37 @@ private:
 	/** A Cscope process for building the database. */
 	CscopeFrontend* m_pCscopeBuild;
 
+	/** A Cscope process for building a database of modified files. */
+	CscopeFrontend* m_pCscopeDelta;
+	
+	/** Project files saved since the database was last built. */
+	QStringList m_slDeltaFiles;
+	
+	/** The files included in the last database built for modified files. */
+	QStringList m_slDeltaBuilt;
+	
+	/** The modification times of files saved in the editor, until their
+		changes are reported by the project watcher (which should then
+		ignore them.) */
+	QHash<QString, QDateTime> m_hashSaved;
+	
+	/** true if files were saved while building the database of modified
+		files, in which case it should be built again. */
+	bool m_bDeltaPending;
+
 	/** A timer for rebuilding the database after a file has been saved. */
 	QTimer m_timerRebuild;
 	
+	/** true if files were removed from the project since the database was
+		last built, in which case it needs to be rebuilt entirely. */
+	bool m_bRebuildAll;
+	
+	/** Keeps the project's file list in sync with its source tree. */
+	ProjectWatcher* m_pWatcher;
+	
+	/** Builds the project-wide tag index. */
+	CtagsIndexBuilder* m_pTagBuilder;
+	
 	/** Whether the query window should be hidden after the user selects an
 		item. */	
 	bool m_bHideQueryOnSelection;
@@ -121,6 +152,8 @@ private:
 	
 	void initMainWindow();
 	void initCscope();
+	void buildDelta();
+	void rebuildModified(const QStringList&);
 	bool getSymbol(uint&, QString&, bool&, bool bPrompt = true);
 	EditorPage* addEditor(const QString&s);
 	EditorPage* createEditorPage();
@@ -178,8 +211,11 @@ private slots:
 	void slotBuildInvIndex();
 	void slotBuildFinished(uint);
 	void slotBuildAborted();
+	void slotDeltaFinished(uint);
+	void slotRebuildSaved();
 	void slotApplyPref();
 	void slotShowCursorPos(uint, uint);
+	void slotShowScope(const QString&);
 	void slotQueryShowEditor(const QString&, uint);
 	void slotDropEvent(QDropEvent*);
 	void slotCscopeVerified(bool, uint);
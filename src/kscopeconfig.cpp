@@ -56,6 +56,7 @@ const ElementInfo eiFonts[] = {
 KScopeConfig::ConfParams KScopeConfig::s_cpDef = {
 	"/usr/bin/cscope", // Cscope path
 	"/usr/bin/ctags", // Ctags path
+	true, // Use the built-in tag extractor
 	true, // Show the tag list
 	SPLIT_SIZES(), // Tag list width
 	{
@@ -119,6 +120,8 @@ void KScopeConfig::load()
     KConfigGroup groupProgram = pConf->group("Programs");
 	m_cp.sCscopePath = groupProgram.readEntry("CScope", "/usr/bin/cscope");
 	m_cp.sCtagsPath = groupProgram.readEntry("CTags", "/usr/bin/ctags");
+	m_cp.bBuiltinTags = groupProgram.readEntry("BuiltinTags",
+		s_cpDef.bBuiltinTags);
 
 	// Read size and position parameters
     KConfigGroup groupGeometry = pConf->group("Geometry");
@@ -193,6 +196,7 @@ void KScopeConfig::store()
     KConfigGroup groupProgram = pConf->group("Programs");
 	groupProgram.writeEntry("CScope", m_cp.sCscopePath);
 	groupProgram.writeEntry("CTags", m_cp.sCtagsPath);
+	groupProgram.writeEntry("BuiltinTags", m_cp.bBuiltinTags);
 
 	// Write size and position parameters
     KConfigGroup groupGeometry = pConf->group("Geometry");
@@ -308,6 +312,24 @@ void KScopeConfig::setCtagsPath(const QString& sPath)
 	m_cp.sCtagsPath = sPath;
 }
 
+/**
+ * @return	true to extract the tags of C and C++ files in-process, false to
+ *			always run Ctags
+ */
+bool KScopeConfig::getBuiltinTags() const
+{
+	return m_cp.bBuiltinTags;
+}
+
+/**
+ * @param	bBuiltin	true to extract the tags of C and C++ files
+ *						in-process, false to always run Ctags
+ */
+void KScopeConfig::setBuiltinTags(bool bBuiltin)
+{
+	m_cp.bBuiltinTags = bBuiltin;
+}
+
 /**
  * @return	A sorted list of recently used project paths.
  */
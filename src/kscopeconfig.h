@@ -59,6 +59,8 @@ public:
 	void setCscopePath(const QString&);
 	const QString& getCtagsPath() const;
 	void setCtagsPath(const QString&);
+	bool getBuiltinTags() const;
+	void setBuiltinTags(bool);
 	const QStringList& getRecentProjects() const;
 	void addRecentProject(const QString&);
 	void removeRecentProject(const QString&);
@@ -110,6 +112,10 @@ private:
 		/** The full path of the Ctags executable. */
 		QString sCtagsPath;
 		
+		/** Whether the tags of C and C++ files should be extracted
+			in-process, rather than by running Ctags. */
+		bool bBuiltinTags;
+		
 		/** Whether the tag list should be visible. */
 		bool bShowTagList;
 		
@@ -0,0 +1,164 @@
+#include <qapplication.h>
+#include <qregexp.h>
+#include "listfilter.h"
+
+int ListFilterEvent::eventTypeId = QEvent::None;
+
+/**
+ * Class constructor.
+ * @param	nSerial	The serial number of the run that produced the results
+ * @param	vecRows	The rows matching the filter
+ */
+ListFilterEvent::ListFilterEvent(uint nSerial, const QVector<int>& vecRows) :
+	QEvent(QEvent::Type(ListFilterEvent::eventTypeId)),
+	m_nSerial(nSerial),
+	m_vecRows(vecRows)
+{
+}
+
+int ListFilterEvent::registerFilterEventType()
+{
+	ListFilterEvent::eventTypeId =
+		QEvent::registerEventType(ListFilterEvent::EventId);
+	return ListFilterEvent::eventTypeId;
+}
+
+/**
+ * Class constructor.
+ * @param	pEventReceiver	Pointer to an object to receive ListFilterEvent
+ *							results
+ */
+ListFilter::ListFilter(QObject* pEventReceiver) : QThread(),
+	m_pEventReceiver(pEventReceiver),
+	m_nPrevKeys(0),
+	m_bRegExp(false),
+	m_nSerial(0),
+	m_bCancel(false)
+{
+	if (ListFilterEvent::eventTypeId == QEvent::None)
+		ListFilterEvent::registerFilterEventType();
+}
+
+/**
+ * Class destructor.
+ */
+ListFilter::~ListFilter()
+{
+	cancel();
+}
+
+/**
+ * Begins matching the list against a new filter string.
+ * A run that is still in progress is stopped first.
+ * @param	vecKeys	The lower-case key of each row
+ * @param	sFilter	The filter string
+ * @return	The serial number of the new run
+ */
+uint ListFilter::start(const QVector<QString>& vecKeys, const QString& sFilter)
+{
+	cancel();
+
+	// Initialise the run parameters (the key index is shared, not copied)
+	m_vecKeys = vecKeys;
+	m_bRegExp = isRegExp(sFilter);
+	m_sFilter = m_bRegExp ? sFilter : sFilter.toLower();
+	m_bCancel = false;
+	m_nSerial++;
+
+	// Invoke the thread
+	QThread::start();
+	return m_nSerial;
+}
+
+/**
+ * Stops the current run, and waits for the thread to terminate.
+ * Results of the stopped run are not posted.
+ */
+void ListFilter::cancel()
+{
+	m_bCancel = true;
+	wait();
+}
+
+/**
+ * Discards the results of the previous run, so that the next run searches
+ * all rows (e.g., when the rows of the list have changed).
+ */
+void ListFilter::reset()
+{
+	cancel();
+	m_sPrevFilter = QString();
+	m_vecPrevRows.clear();
+	m_nPrevKeys = 0;
+}
+
+/**
+ * Matches the rows against the current filter, and posts the results.
+ */
+void ListFilter::run()
+{
+	QVector<int> vecRows;
+	QRegExp re;
+	int i, nRow;
+	bool bNarrow;
+
+	// A plain filter extending the previous one can only match rows that
+	// matched the previous filter (or rows added since)
+	bNarrow = !m_bRegExp && !m_sPrevFilter.isNull() &&
+		m_sFilter.contains(m_sPrevFilter) && m_nPrevKeys <= m_vecKeys.size();
+
+	if (m_bRegExp)
+		re = QRegExp(m_sFilter, Qt::CaseInsensitive);
+
+	if (bNarrow) {
+		for (i = 0; i < m_vecPrevRows.size(); i++) {
+			nRow = m_vecPrevRows[i];
+			if (m_vecKeys[nRow].contains(m_sFilter))
+				vecRows.append(nRow);
+		}
+	}
+
+	for (nRow = bNarrow ? m_nPrevKeys : 0; nRow < m_vecKeys.size(); nRow++) {
+		// Check the cancellation flag every once in a while
+		if ((nRow & 0x3ff) == 0 && m_bCancel)
+			return;
+
+		if (m_bRegExp) {
+			if (re.indexIn(m_vecKeys[nRow]) != -1)
+				vecRows.append(nRow);
+		} else if (m_vecKeys[nRow].contains(m_sFilter)) {
+			vecRows.append(nRow);
+		}
+	}
+
+	if (m_bCancel)
+		return;
+
+	// Remember the results of plain filters for narrowing the next run
+	if (!m_bRegExp) {
+		m_sPrevFilter = m_sFilter;
+		m_vecPrevRows = vecRows;
+		m_nPrevKeys = m_vecKeys.size();
+	}
+
+	QApplication::postEvent(m_pEventReceiver,
+		new ListFilterEvent(m_nSerial, vecRows));
+}
+
+/**
+ * @param	sFilter	A filter string
+ * @return	true if the string contains regular expression characters, false
+ *			otherwise
+ */
+bool ListFilter::isRegExp(const QString& sFilter)
+{
+	static const QString sSpecial("\\^$.|?*+()[]{}");
+	int i;
+
+	for (i = 0; i < sFilter.length(); i++) {
+		if (sSpecial.contains(sFilter.at(i)))
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,88 @@
+#ifndef LISTFILTER_H
+#define LISTFILTER_H
+
+#include <qthread.h>
+#include <qevent.h>
+#include <qstring.h>
+#include <qvector.h>
+
+/**
+ * Carries the results of a ListFilter run to the main application thread.
+ * @author Elad Lahav
+ */
+class ListFilterEvent : public QEvent
+{
+public:
+	/** The event's unique ID. */
+	enum { EventId = 6925 };
+
+	ListFilterEvent(uint, const QVector<int>&);
+	static int registerFilterEventType();
+	static int eventTypeId;
+
+	/** The serial number of the run that produced the results. */
+	uint m_nSerial;
+
+	/** The rows matching the filter, in ascending order. */
+	QVector<int> m_vecRows;
+};
+
+/**
+ * Matches the items of a list against a filter string, using a separate
+ * thread.
+ * The list is given as an index of lower-case keys, one for each row, which
+ * is built once by the owner and shared with the thread. Plain strings are
+ * matched as case-insensitive substrings, while strings holding regular
+ * expression characters are matched as case-insensitive regular expressions.
+ * When a plain filter extends the previous one, only the rows that matched
+ * the previous filter are searched.
+ * Results are posted as a ListFilterEvent, and are tagged with a serial
+ * number, so that the owner can discard the results of superseded runs.
+ * @author Elad Lahav
+ */
+class ListFilter : public QThread
+{
+public:
+	ListFilter(QObject*);
+	~ListFilter();
+
+	uint start(const QVector<QString>&, const QString&);
+	void cancel();
+	void reset();
+
+protected:
+	virtual void run();
+
+private:
+	/** Pointer to an object that receives the filter results. */
+	QObject* m_pEventReceiver;
+
+	/** The lower-case key of each row. */
+	QVector<QString> m_vecKeys;
+
+	/** The current filter string (lower-case, unless a regular
+		expression). */
+	QString m_sFilter;
+
+	/** The previous plain filter string (lower-case). */
+	QString m_sPrevFilter;
+
+	/** The rows matching the previous plain filter. */
+	QVector<int> m_vecPrevRows;
+
+	/** The number of keys searched by the previous plain filter. */
+	int m_nPrevKeys;
+
+	/** Whether the current filter is a regular expression. */
+	bool m_bRegExp;
+
+	/** The serial number of the current run. */
+	uint m_nSerial;
+
+	/** A cancellation flag. Stops the current run when raised. */
+	volatile bool m_bCancel;
+
+	static bool isRegExp(const QString&);
+};
+
+#endif
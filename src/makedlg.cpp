@@ -32,8 +32,8 @@ MakeDlg::MakeDlg(QWidget* pParent):
 	
 	// Create a new make front-end
 	m_pMake = new MakeFrontend();
-	connect(m_pMake, SIGNAL(dataReady(FrontendToken*)), this,
-		SLOT(slotShowOutput(FrontendToken*)));
+	connect(m_pMake, SIGNAL(dataReady(const FrontendBatch&)), this,
+		SLOT(slotShowOutput(const FrontendBatch&)));
 	connect(m_pMake, SIGNAL(finished(uint)), this, SLOT(slotFinished(uint)));
 	connect(m_pMake,
 		SIGNAL(error(const QString&, const QString&, const QString&)),
@@ -171,16 +171,20 @@ void MakeDlg::slotStop()
 /**
  * Displays the parsed output, as generated by the MakeFrontend object.
  * This slot is connected to the dataReady() signal of the make front-end.
- * @param	pToken	Holds the parsed data
+ * @param	batch	Holds the parsed data
  */
-void MakeDlg::slotShowOutput(FrontendToken* pToken)
+void MakeDlg::slotShowOutput(const FrontendBatch& batch)
 {
 	QString sData;
+	int i;
 	
 	// GCC uses unicode quote characters - this should ensure that they are
 	// treated correctly by the text browser widget
-	sData = QTextCodec::codecForLocale()->toUnicode(pToken->getData().toAscii());
-	m_pOutputBrowser->append(sData);
+	for (i = 0; i < batch.count(); i++) {
+		sData = QTextCodec::codecForLocale()->toUnicode(
+			batch.at(i)->getData().toAscii());
+		m_pOutputBrowser->append(sData);
+	}
 }
 
 /**
@@ -5,7 +5,7 @@
 #include "ui_makelayout.h"
 
 class MakeFrontend;
-class FrontendToken;
+class FrontendBatch;
 
 /**
  * A window that displays the output of make-like commands.
@@ -39,7 +39,7 @@ protected:
 	
 protected slots:
 	virtual void slotStop();
-	void slotShowOutput(FrontendToken*);
+	void slotShowOutput(const FrontendBatch&);
 	void slotFinished(uint);
 	void slotBrowserClicked(const QString&);
 	void slotAddError(const QString&, const QString&, const QString&);
@@ -60,17 +60,19 @@ bool MakeFrontend::run(const QString& sName, const QStringList& slArgs,
 
 /**
  * Parses lines of output produced by the make command.
- * @param	sToken	A single line of output
+ * @param	token	A single line of output
  */
-Frontend::ParseResult MakeFrontend::parseStdout(QString& sToken, ParserDelim)
+Frontend::ParseResult MakeFrontend::parseStdout(FrontendToken& token,
+	ParserDelim)
 {
 	static QRegExp reErrWarn(RE_FILE_LINE);
 	static QRegExp reEntDir(RE_ENTER_DIR);
 	static QRegExp reExtDir(RE_EXIT_DIR);
 	QString sRep;
 	int nPos;
-	QString sFile, sLine, sText;
+	QString sToken, sFile, sLine, sText;
 	
+	sToken = token.getData();
 	if ((nPos = reErrWarn.indexIn(sToken)) >= 0) {
 		// An error/warning message
 		if (sToken.at(nPos) == '/') {
@@ -100,6 +102,11 @@ Frontend::ParseResult MakeFrontend::parseStdout(QString& sToken, ParserDelim)
 			m_slPathStack.last();
 		m_slPathStack.pop_back();
 	}
+	else {
+		return RecordReady;
+	}
 
+	// Pass the modified line on to the consumer
+	token.setData(sToken);
 	return RecordReady;
 }
@@ -20,7 +20,7 @@ public:
 
 	virtual bool run(const QString&, const QStringList&, 
 		const QString&, bool bBlock = false);
-	virtual ParseResult parseStdout(QString&, ParserDelim);
+	virtual ParseResult parseStdout(FrontendToken&, ParserDelim);
 	
 signals:
 	void error(const QString& sFile, const QString& sLine,
@@ -87,6 +87,7 @@ void NewProjectDlg::setProperties(const QString& sName, const QString& sPath,
 	m_pInvCheck->setChecked(opt.bInvIndex);
 	m_pNoCompCheck->setChecked(opt.bNoCompress);
 	m_pSlowPathCheck->setChecked(opt.bSlowPathDef);
+	m_pShardedCheck->setChecked(opt.bSharded);
 	
 	if (opt.nAutoRebuildTime >= 0) {
 		m_pAutoRebuildCheck->setChecked(true);
@@ -151,6 +152,7 @@ void NewProjectDlg::getOptions(ProjectBase::Options& opt)
 	opt.bInvIndex = m_pInvCheck->isChecked();
 	opt.bNoCompress = m_pNoCompCheck->isChecked();
 	opt.bSlowPathDef = m_pSlowPathCheck->isChecked();
+	opt.bSharded = m_pShardedCheck->isChecked();
 		
 	if (m_pAutoRebuildCheck->isChecked())
 		opt.nAutoRebuildTime = m_pAutoRebuildSpin->value();
@@ -0,0 +1,241 @@
+#include <string.h>
+#include "pagefile.h"
+
+/**
+ * Class constructor.
+ */
+PageFile::PageFile() :
+	m_pData(NULL),
+	m_pHeader(NULL),
+	m_pFields(NULL),
+	m_pRecords(NULL),
+	m_pPool(NULL)
+{
+}
+
+/**
+ * Class destructor.
+ * Unmaps the file, if one is mapped.
+ */
+PageFile::~PageFile()
+{
+	close();
+}
+
+/**
+ * Appends a field to the field table of the file to write.
+ * @param	sField	The contents of the field
+ */
+void PageFile::addField(const QString& sField)
+{
+	m_vecFields.append(intern(sField));
+}
+
+/**
+ * Appends a record to the record table of the file to write.
+ * @param	sFunc	The name of the function
+ * @param	sFile	The full path of the file
+ * @param	nLine	The line number, 0 for records without a line
+ * @param	sText	The line's text
+ * @param	nDepth	The level of the record below the root of a tree, 0 for
+ *					records of a flat list
+ */
+void PageFile::addRecord(const QString& sFunc, const QString& sFile,
+	uint nLine, const QString& sText, uint nDepth)
+{
+	Record rec;
+
+	rec.nFunc = intern(sFunc);
+	rec.nFile = intern(sFile);
+	rec.nLine = nLine;
+	rec.nText = intern(sText);
+	rec.nDepth = nDepth;
+	m_vecRecords.append(rec);
+}
+
+/**
+ * Writes the added fields and records to a file.
+ * @param	sPath	The full path of the file
+ * @return	true if successful, false otherwise
+ */
+bool PageFile::write(const QString& sPath)
+{
+	QFile file(sPath);
+	Header header;
+	bool bResult;
+
+	// The pool always ends with a NULL character
+	if (m_baPool.isEmpty())
+		m_baPool.append('\0');
+
+	memset(&header, 0, sizeof(header));
+	header.nMagic = PAGE_FILE_MAGIC;
+	header.nVersion = PAGE_FILE_VERSION;
+	header.nFields = m_vecFields.size();
+	header.nRecords = m_vecRecords.size();
+	header.nPool = m_baPool.size();
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	bResult = (file.write((const char*)&header, sizeof(header)) ==
+			sizeof(header)) &&
+		(file.write((const char*)m_vecFields.constData(),
+			m_vecFields.size() * sizeof(quint32)) ==
+			(qint64)(m_vecFields.size() * sizeof(quint32))) &&
+		(file.write((const char*)m_vecRecords.constData(),
+			m_vecRecords.size() * sizeof(Record)) ==
+			(qint64)(m_vecRecords.size() * sizeof(Record))) &&
+		(file.write(m_baPool) == m_baPool.size());
+	file.close();
+
+	if (!bResult)
+		file.remove();
+
+	return bResult;
+}
+
+/**
+ * Maps a page file into memory.
+ * Any previously-mapped file is released first.
+ * @param	sPath	The full path of the file
+ * @return	true if successful, false if the file does not exist, is not a
+ *			page file of the current version, or is corrupted
+ */
+bool PageFile::open(const QString& sPath)
+{
+	const Header* pHeader;
+	qint64 nSize, nExpected;
+
+	close();
+
+	m_file.setFileName(sPath);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	nSize = m_file.size();
+	if (nSize < (qint64)sizeof(Header)) {
+		m_file.close();
+		return false;
+	}
+
+	m_pData = m_file.map(0, nSize);
+	if (m_pData == NULL) {
+		m_file.close();
+		return false;
+	}
+
+	// Validate the header, and make sure the tables fit in the file
+	pHeader = (const Header*)m_pData;
+	nExpected = sizeof(Header) + (qint64)pHeader->nFields * sizeof(quint32) +
+		(qint64)pHeader->nRecords * sizeof(Record) + pHeader->nPool;
+	if ((pHeader->nMagic != PAGE_FILE_MAGIC) ||
+		(pHeader->nVersion != PAGE_FILE_VERSION) ||
+		(nExpected != nSize) || (pHeader->nPool == 0) ||
+		(m_pData[nSize - 1] != 0)) {
+		close();
+		return false;
+	}
+
+	m_pHeader = pHeader;
+	m_pFields = (const quint32*)(m_pData + sizeof(Header));
+	m_pRecords = (const Record*)(m_pFields + pHeader->nFields);
+	m_pPool = (const char*)(m_pRecords + pHeader->nRecords);
+
+	return true;
+}
+
+/**
+ * Releases the mapped file.
+ */
+void PageFile::close()
+{
+	if (m_pData != NULL)
+		m_file.unmap((uchar*)m_pData);
+
+	m_file.close();
+	m_pData = NULL;
+	m_pHeader = NULL;
+	m_pFields = NULL;
+	m_pRecords = NULL;
+	m_pPool = NULL;
+}
+
+/**
+ * @param	nField	The index of a field in the mapped file
+ * @return	The contents of the field, a null string if no such field exists
+ */
+QString PageFile::getField(uint nField) const
+{
+	if (m_pData == NULL || nField >= m_pHeader->nFields)
+		return QString();
+
+	return getString(m_pFields[nField]);
+}
+
+/**
+ * Converts the records of the mapped file.
+ * @param	lstRecords	Holds the records, upon return, each holding the
+ *						function name, file path, line number and line text
+ *						(in this order)
+ * @param	pDepths		If not NULL, holds the depth of each record, upon
+ *						return
+ */
+void PageFile::getRecords(QList<QStringList>& lstRecords,
+	QList<uint>* pDepths) const
+{
+	const Record* pRec;
+	quint32 i;
+
+	lstRecords.clear();
+	if (pDepths != NULL)
+		pDepths->clear();
+
+	if (m_pData == NULL)
+		return;
+
+	for (i = 0; i < m_pHeader->nRecords; i++) {
+		pRec = &m_pRecords[i];
+		lstRecords.append(QStringList() << getString(pRec->nFunc)
+			<< getString(pRec->nFile)
+			<< (pRec->nLine > 0 ? QString::number(pRec->nLine) : QString(""))
+			<< getString(pRec->nText));
+
+		if (pDepths != NULL)
+			pDepths->append(pRec->nDepth);
+	}
+}
+
+/**
+ * Adds a string to the pool of the file to write, unless it is already
+ * there.
+ * @param	sText	The string to add
+ * @return	The position of the string in the pool
+ */
+quint32 PageFile::intern(const QString& sText)
+{
+	QHash<QString, quint32>::ConstIterator itr;
+	quint32 nPos;
+
+	itr = m_hashStrings.find(sText);
+	if (itr != m_hashStrings.end())
+		return *itr;
+
+	nPos = m_baPool.size();
+	m_baPool.append(sText.toUtf8());
+	m_baPool.append('\0');
+	m_hashStrings.insert(sText, nPos);
+	return nPos;
+}
+
+/**
+ * @param	nPos	The position of a string in the pool of the mapped file
+ * @return	The string, an empty string if the position is outside the pool
+ */
+QString PageFile::getString(quint32 nPos) const
+{
+	if (nPos >= m_pHeader->nPool)
+		return "";
+
+	return QString::fromUtf8(m_pPool + nPos);
+}
@@ -0,0 +1,143 @@
+#ifndef PAGEFILE_H
+#define PAGEFILE_H
+
+#include <qfile.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qbytearray.h>
+#include <qvector.h>
+#include <qhash.h>
+#include <qlist.h>
+
+/** Identifies the format of a saved page file. */
+#define PAGE_FILE_MAGIC		0x4b535150
+
+/** The version of the saved page file format. Text files written by older
+	versions begin with "VERSION=2". */
+#define PAGE_FILE_VERSION	3
+
+/**
+ * Stores the records of a query page in a binary file.
+ * The file holds the following tables, following a header:
+ * - Fields: strings describing the page (e.g., the query's type and text)
+ * - Records: the function, file, line, text and depth of each record
+ * - A pool of NULL-terminated UTF-8 strings
+ * Fields and records refer to strings by their position in the pool. Each
+ * distinct string is stored once, so that a file path or a function name
+ * shared by many records does not add to the size of the file. Line numbers
+ * are stored as integers. All numbers are stored in the native byte order.
+ * A file is read by mapping it into memory, so that the header and the
+ * fields can be read when a page is restored, while the records are only
+ * converted once the page is shown.
+ * @author Elad Lahav
+ */
+class PageFile
+{
+public:
+	PageFile();
+	~PageFile();
+
+	void addField(const QString&);
+	void addRecord(const QString&, const QString&, uint, const QString&,
+		uint nDepth = 0);
+	bool write(const QString&);
+
+	bool open(const QString&);
+	void close();
+	QString getField(uint) const;
+	void getRecords(QList<QStringList>&, QList<uint>* pDepths = NULL) const;
+
+	/**
+	 * @return	true if a file is mapped, false otherwise
+	 */
+	bool isOpen() const { return m_pData != NULL; }
+
+	/**
+	 * @return	The number of fields in the mapped file
+	 */
+	uint getFieldCount() const { return m_pHeader->nFields; }
+
+	/**
+	 * @return	The number of records in the mapped file
+	 */
+	uint getRecordCount() const { return m_pHeader->nRecords; }
+
+	/**
+	 * The header of a page file.
+	 */
+	struct Header
+	{
+		/** Should be PAGE_FILE_MAGIC. */
+		quint32 nMagic;
+
+		/** Should be PAGE_FILE_VERSION. */
+		quint32 nVersion;
+
+		/** The number of entries in the field table. */
+		quint32 nFields;
+
+		/** The number of entries in the record table. */
+		quint32 nRecords;
+
+		/** The size of the string pool. */
+		quint32 nPool;
+	};
+
+	/**
+	 * An entry in the record table.
+	 */
+	struct Record
+	{
+		/** The position of the function name in the string pool. */
+		quint32 nFunc;
+
+		/** The position of the file path in the string pool. */
+		quint32 nFile;
+
+		/** The line number, 0 for records without a line. */
+		quint32 nLine;
+
+		/** The position of the line's text in the string pool. */
+		quint32 nText;
+
+		/** The level of the record below the root of a tree, 0 for records
+			of a flat list. */
+		quint32 nDepth;
+	};
+
+private:
+	/** The fields to write. */
+	QVector<quint32> m_vecFields;
+
+	/** The records to write. */
+	QVector<Record> m_vecRecords;
+
+	/** The strings to write. */
+	QByteArray m_baPool;
+
+	/** Maps each string to its position in the pool. */
+	QHash<QString, quint32> m_hashStrings;
+
+	/** The mapped file. */
+	QFile m_file;
+
+	/** The mapped contents of the file, NULL if no file is mapped. */
+	const uchar* m_pData;
+
+	/** The header of the mapped file. */
+	const Header* m_pHeader;
+
+	/** The field table of the mapped file. */
+	const quint32* m_pFields;
+
+	/** The record table of the mapped file. */
+	const Record* m_pRecords;
+
+	/** The string pool of the mapped file. */
+	const char* m_pPool;
+
+	quint32 intern(const QString&);
+	QString getString(quint32) const;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "pathtable.h"
+
+QStringList PathTable::s_slPaths;
+QHash<QString, int> PathTable::s_hashPaths;
+QString PathTable::s_sRoot;
+
+/**
+ * Looks up a path in the table, adding it if not found.
+ * @param	sPath	The full path of a file or a directory
+ * @return	The index of the path
+ */
+int PathTable::getId(const QString& sPath)
+{
+	QHash<QString, int>::ConstIterator itr;
+
+	itr = s_hashPaths.find(sPath);
+	if (itr != s_hashPaths.constEnd())
+		return *itr;
+
+	s_slPaths.append(sPath);
+	s_hashPaths.insert(sPath, s_slPaths.count() - 1);
+	return s_slPaths.count() - 1;
+}
+
+/**
+ * @param	sPath	The full path of a file or a directory
+ * @return	The index of the path, -1 if the path is not in the table
+ */
+int PathTable::find(const QString& sPath)
+{
+	return s_hashPaths.value(sPath, -1);
+}
+
+/**
+ * Sets the common root for displaying paths.
+ * Views showing paths from the table need to be repainted.
+ * @param	sRoot	The full path of the root directory, an empty string (or
+ *					"/") for displaying full paths
+ */
+void PathTable::setRoot(const QString& sRoot)
+{
+	s_sRoot = sRoot;
+
+	if (s_sRoot == "/")
+		s_sRoot = "";
+	else if (s_sRoot.endsWith('/'))
+		s_sRoot.truncate(s_sRoot.length() - 1);
+}
+
+/**
+ * Replaces the root part of a path with a "$" sign.
+ * @param	sPath	The full path of a file or a directory
+ * @return	The path, as displayed to the user
+ */
+QString PathTable::toDisplay(const QString& sPath)
+{
+	if (s_sRoot.isEmpty() || !sPath.startsWith(s_sRoot))
+		return sPath;
+
+	// Make sure the root matches a whole path component
+	if (sPath.length() > s_sRoot.length() &&
+		sPath.at(s_sRoot.length()) != '/') {
+		return sPath;
+	}
+
+	return "$" + sPath.mid(s_sRoot.length());
+}
+
+/**
+ * Restores the full path of a displayed path.
+ * @param	sDisplay	A path, as displayed to the user
+ * @return	The full path
+ */
+QString PathTable::toPath(const QString& sDisplay)
+{
+	if (!sDisplay.startsWith('$'))
+		return sDisplay;
+
+	return s_sRoot + sDisplay.mid(1);
+}
+
+/**
+ * Removes all paths from the table.
+ * Should only be called when no view holds indices of paths in the table
+ * (i.e., after the current project was closed.)
+ */
+void PathTable::clear()
+{
+	s_slPaths.clear();
+	s_hashPaths.clear();
+}
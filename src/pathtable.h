@@ -0,0 +1,65 @@
+#ifndef PATHTABLE_H
+#define PATHTABLE_H
+
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qhash.h>
+
+/**
+ * A project-wide table of file paths.
+ * Each path is stored once, and is referred to by its index in the table.
+ * Views holding many records for the same files (such as query results and
+ * the file list) keep these indices rather than copies of the path strings.
+ * A path under the project's source root is displayed with a "$" sign
+ * instead of the root. Since the root is only applied when a path is
+ * displayed, changing it does not require updating any stored record.
+ * Paths are never removed from the table while a project is open, so that an
+ * index remains valid as long as the records of the project are shown. The
+ * table is cleared when the project is closed, once all views holding
+ * indices were cleared.
+ * @author Elad Lahav
+ */
+class PathTable
+{
+public:
+	static int getId(const QString&);
+	static int find(const QString&);
+	static void setRoot(const QString&);
+	static QString toDisplay(const QString&);
+	static QString toPath(const QString&);
+	static void clear();
+
+	/**
+	 * @param	nId	The index of a path in the table
+	 * @return	The full path
+	 */
+	static const QString& getPath(int nId) { return s_slPaths.at(nId); }
+
+	/**
+	 * @param	nId	The index of a path in the table
+	 * @return	The path, as displayed to the user
+	 */
+	static QString getDisplay(int nId) { return toDisplay(s_slPaths.at(nId)); }
+
+	/**
+	 * @return	The number of paths in the table
+	 */
+	static int count() { return s_slPaths.count(); }
+
+	/**
+	 * @return	The current source root, an empty string if none is set
+	 */
+	static const QString& getRoot() { return s_sRoot; }
+
+private:
+	/** All paths, by index. */
+	static QStringList s_slPaths;
+
+	/** Maps each path to its index. */
+	static QHash<QString, int> s_hashPaths;
+
+	/** The common root replaced by a "$" sign when displaying paths. */
+	static QString s_sRoot;
+};
+
+#endif
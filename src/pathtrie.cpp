@@ -0,0 +1,323 @@
+#include <qstringlist.h>
+#include "pathtrie.h"
+
+/**
+ * Class constructor.
+ * Creates a trie holding only the root node, which stands for the empty path.
+ */
+PathTrie::PathTrie()
+{
+	clear();
+}
+
+/**
+ * Adds a file to the set.
+ * @param	sPath	The path of the file
+ * @return	true if the file was added, false if it already exists
+ */
+bool PathTrie::insert(const QString& sPath)
+{
+	QStringList slParts;
+	QStringList::ConstIterator itr;
+	QMap<QString, int>::ConstIterator itrChild;
+	int nNode;
+
+	// Find the file's node, creating the missing components
+	slParts = sPath.split('/');
+	nNode = 0;
+	for (itr = slParts.begin(); itr != slParts.end(); ++itr) {
+		itrChild = m_vecNodes[nNode].mapChildren.find(*itr);
+		if (itrChild != m_vecNodes[nNode].mapChildren.end())
+			nNode = *itrChild;
+		else
+			nNode = addNode(nNode, *itr);
+	}
+
+	if (m_vecNodes[nNode].bFile)
+		return false;
+
+	// Count the file in all sub-trees holding it
+	m_vecNodes[nNode].bFile = true;
+	for (; nNode >= 0; nNode = m_vecNodes[nNode].nParent)
+		m_vecNodes[nNode].nFiles++;
+
+	return true;
+}
+
+/**
+ * Removes a file from the set.
+ * @param	sPath	The path of the file
+ * @return	true if the file was removed, false if it is not in the set
+ */
+bool PathTrie::remove(const QString& sPath)
+{
+	int nNode;
+
+	nNode = find(sPath);
+	if (nNode < 0 || !m_vecNodes[nNode].bFile)
+		return false;
+
+	m_vecNodes[nNode].bFile = false;
+	freeTree(detach(nNode, 1));
+	return true;
+}
+
+/**
+ * Removes all files in a directory, and in any of its sub-directories.
+ * @param	sDir	The path of the directory
+ * @return	The number of removed files
+ */
+int PathTrie::removeTree(const QString& sDir)
+{
+	int nNode, nFiles;
+
+	nNode = find(sDir);
+	if (nNode <= 0)
+		return 0;
+
+	nFiles = m_vecNodes[nNode].nFiles;
+	freeTree(detach(nNode, nFiles));
+	return nFiles;
+}
+
+/**
+ * Removes the files in a directory, but not in its sub-directories.
+ * @param	sDir	The path of the directory
+ * @return	The number of removed files
+ */
+int PathTrie::removeDir(const QString& sDir)
+{
+	QMap<QString, int>::ConstIterator itr;
+	QVector<int> vecFiles;
+	int i, nNode;
+
+	nNode = find(sDir);
+	if (nNode < 0)
+		return 0;
+
+	// Collect the files first, as removing them modifies the child map
+	for (itr = m_vecNodes[nNode].mapChildren.begin();
+		itr != m_vecNodes[nNode].mapChildren.end(); ++itr) {
+		if (m_vecNodes[*itr].bFile && m_vecNodes[*itr].mapChildren.isEmpty())
+			vecFiles.append(*itr);
+	}
+
+	for (i = 0; i < vecFiles.size(); i++) {
+		m_vecNodes[vecFiles[i]].bFile = false;
+		freeTree(detach(vecFiles[i], 1));
+	}
+
+	return vecFiles.size();
+}
+
+/**
+ * Finds the node of a path.
+ * A trailing slash is ignored, so that directories can be given either
+ * way.
+ * @param	sPath	A file or directory path
+ * @return	The index of the node, -1 if the path is not in the trie
+ */
+int PathTrie::find(const QString& sPath) const
+{
+	QStringList slParts;
+	QStringList::ConstIterator itr;
+	QMap<QString, int>::ConstIterator itrChild;
+	int nNode;
+
+	slParts = sPath.split('/');
+	if (slParts.count() > 1 && slParts.last().isEmpty())
+		slParts.removeLast();
+
+	nNode = 0;
+	for (itr = slParts.begin(); itr != slParts.end(); ++itr) {
+		itrChild = m_vecNodes[nNode].mapChildren.find(*itr);
+		if (itrChild == m_vecNodes[nNode].mapChildren.end())
+			return -1;
+
+		nNode = *itrChild;
+	}
+
+	return nNode;
+}
+
+/**
+ * Composes the path of a node.
+ * @param	nNode	The index of the node
+ * @return	The full path
+ */
+QString PathTrie::getPath(int nNode) const
+{
+	QString sPath;
+
+	if (nNode <= 0)
+		return sPath;
+
+	sPath = m_vecNodes[nNode].sName;
+	for (nNode = m_vecNodes[nNode].nParent; nNode > 0;
+		nNode = m_vecNodes[nNode].nParent) {
+		sPath.prepend(m_vecNodes[nNode].sName + '/');
+	}
+
+	return sPath;
+}
+
+/**
+ * Computes the position of a sub-tree in the sorted list of all files
+ * (@see getFiles()).
+ * @param	nNode	The index of the root of the sub-tree
+ * @return	The position of the sub-tree's first file
+ */
+int PathTrie::getRank(int nNode) const
+{
+	QMap<QString, int>::ConstIterator itr;
+	int nParent, nRank;
+
+	// Count the files preceding the sub-tree under each of its ancestors
+	nRank = 0;
+	for (nParent = m_vecNodes[nNode].nParent; nParent >= 0;
+		nNode = nParent, nParent = m_vecNodes[nParent].nParent) {
+		if (m_vecNodes[nParent].bFile)
+			nRank++;
+
+		for (itr = m_vecNodes[nParent].mapChildren.begin(); *itr != nNode;
+			++itr) {
+			nRank += m_vecNodes[*itr].nFiles;
+		}
+	}
+
+	return nRank;
+}
+
+/**
+ * Lists the files in a sub-tree, in sorted order.
+ * @param	vecFiles	Holds the indices of the files' nodes, on return
+ * @param	nNode		The root of the sub-tree
+ */
+void PathTrie::getFiles(QVector<int>& vecFiles, int nNode) const
+{
+	QVector<int> vecStack;
+	QMap<QString, int>::ConstIterator itr;
+
+	vecFiles.reserve(vecFiles.size() + m_vecNodes[nNode].nFiles);
+
+	// Traverse the sub-tree in depth-first order, pushing children in reverse
+	// so that they are visited in sorted order
+	vecStack.append(nNode);
+	while (!vecStack.isEmpty()) {
+		nNode = vecStack.last();
+		vecStack.pop_back();
+
+		const Node& node = m_vecNodes[nNode];
+		if (node.bFile)
+			vecFiles.append(nNode);
+
+		itr = node.mapChildren.end();
+		while (itr != node.mapChildren.begin()) {
+			--itr;
+			vecStack.append(*itr);
+		}
+	}
+}
+
+/**
+ * Removes all files.
+ */
+void PathTrie::clear()
+{
+	m_vecNodes.resize(1);
+	m_vecNodes[0].sName = QString();
+	m_vecNodes[0].nParent = -1;
+	m_vecNodes[0].mapChildren.clear();
+	m_vecNodes[0].nFiles = 0;
+	m_vecNodes[0].bFile = false;
+	m_vecFree.clear();
+}
+
+/**
+ * Creates a new node.
+ * @param	nParent	The index of the parent node
+ * @param	sName	The name of the new path component
+ * @return	The index of the new node
+ */
+int PathTrie::addNode(int nParent, const QString& sName)
+{
+	int nNode;
+
+	// Reuse a removed node, if any
+	if (!m_vecFree.isEmpty()) {
+		nNode = m_vecFree.last();
+		m_vecFree.pop_back();
+	} else {
+		nNode = m_vecNodes.size();
+		m_vecNodes.resize(nNode + 1);
+	}
+
+	Node& node = m_vecNodes[nNode];
+	node.sName = sName;
+	node.nParent = nParent;
+	node.mapChildren.clear();
+	node.nFiles = 0;
+	node.bFile = false;
+
+	m_vecNodes[nParent].mapChildren.insert(sName, nNode);
+	return nNode;
+}
+
+/**
+ * Makes the nodes of a detached sub-tree available for reuse.
+ * @param	nNode	The root of the sub-tree, -1 for none
+ */
+void PathTrie::freeTree(int nNode)
+{
+	QVector<int> vecStack;
+	QMap<QString, int>::ConstIterator itr;
+
+	if (nNode <= 0)
+		return;
+
+	vecStack.append(nNode);
+	while (!vecStack.isEmpty()) {
+		nNode = vecStack.last();
+		vecStack.pop_back();
+
+		Node& node = m_vecNodes[nNode];
+		for (itr = node.mapChildren.begin(); itr != node.mapChildren.end();
+			++itr) {
+			vecStack.append(*itr);
+		}
+
+		node.mapChildren.clear();
+		node.sName = QString();
+		node.nParent = -1;
+		node.bFile = false;
+		m_vecFree.append(nNode);
+	}
+}
+
+/**
+ * Subtracts a number of files from a node and all of its ancestors.
+ * Nodes which no longer lead to any file are detached from their parents.
+ * @param	nNode	The index of the node
+ * @param	nFiles	The number of files to subtract
+ * @return	The highest detached node (whose sub-tree includes all other
+ *			detached nodes), -1 if no node was detached
+ */
+int PathTrie::detach(int nNode, int nFiles)
+{
+	int nParent, nTop;
+
+	nTop = -1;
+	for (; nNode > 0; nNode = nParent) {
+		nParent = m_vecNodes[nNode].nParent;
+		m_vecNodes[nNode].nFiles -= nFiles;
+
+		// Remove a node without files from the tree
+		if (m_vecNodes[nNode].nFiles == 0) {
+			m_vecNodes[nParent].mapChildren.remove(m_vecNodes[nNode].sName);
+			nTop = nNode;
+		}
+	}
+
+	m_vecNodes[0].nFiles -= nFiles;
+	return nTop;
+}
@@ -0,0 +1,85 @@
+#ifndef PATHTRIE_H
+#define PATHTRIE_H
+
+#include <qstring.h>
+#include <qvector.h>
+#include <qmap.h>
+
+/**
+ * A set of file paths, stored as a tree of path components.
+ * Each directory is stored once, no matter how many files it holds, and
+ * keeps the number of files in its sub-tree. Adding, removing or finding a
+ * path, as well as detaching an entire sub-tree, takes time proportional to
+ * the depth of the path. Files are enumerated in sorted order (by
+ * component), with the files of each sub-tree following each other, so that
+ * the position of a sub-tree in this order can be computed from the file
+ * counts along its path.
+ * Nodes are kept in a single vector, and are referred to by index. Since the
+ * vector is implicitly shared, copying a trie is cheap, and the copy can be
+ * safely read by another thread while the original is modified.
+ * @author Elad Lahav
+ */
+class PathTrie
+{
+public:
+	PathTrie();
+
+	bool insert(const QString&);
+	bool remove(const QString&);
+	int removeTree(const QString&);
+	int removeDir(const QString&);
+	int find(const QString&) const;
+	QString getPath(int) const;
+	int getRank(int) const;
+	void getFiles(QVector<int>&, int nNode = 0) const;
+	void clear();
+
+	/**
+	 * @param	sPath	A file path
+	 * @return	true if the path is in the set, false otherwise
+	 */
+	bool contains(const QString& sPath) const {
+		int nNode = find(sPath);
+		return nNode >= 0 && m_vecNodes[nNode].bFile;
+	}
+
+	/**
+	 * @param	nNode	The index of a node
+	 * @return	The number of files in the node's sub-tree
+	 */
+	int getCount(int nNode = 0) const { return m_vecNodes[nNode].nFiles; }
+
+private:
+	/**
+	 * A single path component.
+	 */
+	struct Node {
+		/** The name of the component. */
+		QString sName;
+
+		/** The index of the parent node, -1 for the root. */
+		int nParent;
+
+		/** Child nodes, sorted by name. */
+		QMap<QString, int> mapChildren;
+
+		/** The number of files in the sub-tree, including the node itself. */
+		int nFiles;
+
+		/** Whether the node is a file in the set (rather than a directory
+			leading to files.) */
+		bool bFile;
+	};
+
+	/** All nodes, the root first. */
+	QVector<Node> m_vecNodes;
+
+	/** Indices of removed nodes, which may be reused. */
+	QVector<int> m_vecFree;
+
+	int addNode(int, const QString&);
+	void freeTree(int);
+	int detach(int, int);
+};
+
+#endif
@@ -29,6 +29,8 @@ PrefFrontend::PrefFrontend(QWidget* pParent):
 		SIGNAL(modified()));
 	connect(m_pCtagsURL, SIGNAL(textChanged(const QString&)), this,
 		SIGNAL(modified()));
+	connect(m_pBuiltinTagsCheck, SIGNAL(toggled(bool)), this,
+		SIGNAL(modified()));
 }
 
 /**
@@ -46,6 +48,7 @@ void PrefFrontend::load()
 {
 	m_pCscopeURL->lineEdit()->setText(Config().getCscopePath());
 	m_pCtagsURL->lineEdit()->setText(Config().getCtagsPath());
+	m_pBuiltinTagsCheck->setChecked(Config().getBuiltinTags());
 }
 
 /**
@@ -55,6 +58,7 @@ void PrefFrontend::apply()
 {
 	Config().setCscopePath(m_pCscopeURL->text());
 	Config().setCtagsPath(m_pCtagsURL->text());
+	Config().setBuiltinTags(m_pBuiltinTagsCheck->isChecked());
 }
 
 /**
@@ -3,6 +3,7 @@
 #include <errno.h>
 #include <kmessagebox.h>
 #include <QTextStream>
+#include <QSet>
 #include <klocale.h>
 #include <KConfig>
 #include <KConfigGroup>
@@ -102,6 +103,13 @@ bool Project::open(const QString& sPath)
 	// Get stored options
 	initOptions();
 	
+	// Get the cached number of files (validated against the file list when
+	// used)
+	group = m_pConf->group("FileList");
+	m_nFileCount = group.readEntry("Count", -1);
+	m_nFileListSize = group.readEntry("Size", (qint64)0);
+	m_nFileListTime = group.readEntry("Time", 0U);
+	
 	// Set default make values for new projects (overriden in loadSession(), 
 	// which is not called for new projects)
 	m_sMakeRoot = getSourceRoot();
@@ -114,8 +122,10 @@ bool Project::open(const QString& sPath)
  */
 void Project::close()
 {
-	if (m_pConf)
+	if (m_pConf) {
 		delete m_pConf;
+		m_pConf = NULL;
+	}
 
 	m_fiFileList.close();
 }
@@ -146,6 +156,7 @@ void Project::getOptions(Options& opt) const
 	opt.bInvIndex = group.readEntry("InvIndex", DEF_INV_INDEX);
 	opt.bNoCompress = group.readEntry("NoCompress", DEF_NO_COMPRESS);
 	opt.bSlowPathDef = group.readEntry("SlowPathDef", DEF_SLOW_PATH);
+	opt.bSharded = group.readEntry("Sharded", DEF_SHARDED);
 	opt.nAutoRebuildTime = group.readEntry("AutoRebuildTime", 0);
 	opt.nTabWidth = group.readEntry("TabWidth", 0);
 	opt.sCtagsCmd = group.readEntry("CtagsCommand", DEF_CTAGS_COMMAND);
@@ -238,37 +249,6 @@ void Project::storeSession(const Session& sess)
 		group.writeEntry("MakeRoot", sess.sMakeRoot);
 }
 
-/**
- * Fills a list object with all files in the project.
- * List items are created by reading and parsing all file name entries from
- * the project's 'cscope.files' file.
- * Note that the file may contain option lines, beginning with a dash. These
- * should be ignored.
- * @param	pList	Pointer to the object to fill
- */
-bool Project::loadFileList(FileListTarget* pList)
-{
-	QString sFilePath;
-	
-	// Open the 'cscope.files' file
-	if (!m_fiFileList.open(QIODevice::ReadOnly))
-		return false;
-
-	// Read all file names from the file
-	QTextStream str(&m_fiFileList);
-	while ((sFilePath = str.readLine()) != QString::null) {
-		// Skip option lines
-		if (sFilePath.at(0) == '-')
-			continue;
-
-		// Set the new list item
-		pList->addItem(sFilePath);
-	}
-
-	m_fiFileList.close();
-	return true;
-}
-
 /**
  * Writes all file entries in a list view widget to the project's
  * 'cscope.files' file (replacing current file contents.)
@@ -277,21 +257,27 @@ bool Project::loadFileList(FileListTarget* pList)
 bool Project::storeFileList(FileListSource* pList)
 {
 	QString sFilePath;
+	int nFiles;
 	
 	// Open the 'cscope.files' file
+	finishLoading();
 	if (!m_fiFileList.open(QIODevice::WriteOnly | QIODevice::Truncate))
 		return false;
 
 	QTextStream str(&m_fiFileList);
 
 	// Write all file names
+	nFiles = 0;
 	if (pList->firstItem(sFilePath)) {
 		do {
 			str << sFilePath << "\n";
+			nFiles++;
 		} while (pList->nextItem(sFilePath));
 	}
 
+	str.flush();
 	m_fiFileList.close();
+	setFileCount(nFiles);
 	return true;
 }
 
@@ -302,7 +288,13 @@ bool Project::storeFileList(FileListSource* pList)
  */
 bool Project::addFile(const QString& sPath)
 {
+	int nFiles;
+	
+	// Get the number of files before the file list changes
+	nFiles = getFileCount();
+	
 	// Open the 'cscope.files' file
+	finishLoading();
 	if (!m_fiFileList.open(QIODevice::WriteOnly | QIODevice::Append))
 		return false;
 	
@@ -310,38 +302,144 @@ bool Project::addFile(const QString& sPath)
 	QTextStream str(&m_fiFileList);
 	str << sPath << "\n";
 
+	str.flush();
 	m_fiFileList.close();
+	setFileCount(nFiles + 1);
 	return true;	
 }
 
 /**
- * Determines whether the project includes any files.
- * Reads the 'cscope.files' file and looks for any file names in it. If none
- * is present, then the project is considered empty.
- * Note that the file may contain option lines, beginning with a dash. These
- * should be ignored.
- * @return	true if no files are included in the project, false otherwise
+ * Applies a set of changes in the source tree to the file list.
+ * The lists of changed files are filtered, so that on return they only hold
+ * files whose inclusion in the project has actually changed (or, for
+ * modified files, files included in the project.)
+ * @param	slAdded			New files to add to the project
+ * @param	slRemoved		Files to remove from the project
+ * @param	slModified		Files which were modified
+ * @param	slRemovedDirs	Directories whose files should be removed from the
+ *							project
+ * @param	bRescan			true if the source tree was scanned again after
+ *							changes were lost, in which case files under the
+ *							source root which no longer exist are removed as
+ *							well
+ * @return	true if successful, false otherwise
  */
-bool Project::isEmpty()
+bool Project::updateFiles(QStringList& slAdded, QStringList& slRemoved,
+	QStringList& slModified, const QStringList& slRemovedDirs, bool bRescan)
 {
-	QString sPath, sFileName;
-	bool bResult = true;
+	QStringList slLines, slFiles;
+	QStringList::ConstIterator itrDir;
+	QStringList::Iterator itr;
+	QSet<QString> setFiles, setRemoved;
+	QString sLine;
+	bool bRemove;
 	
-	// Open the 'cscope.files' file
+	// Read the 'cscope.files' file
 	if (!m_fiFileList.open(QIODevice::ReadOnly))
-		return true;
+		return false;
 
-	// Find at least one file name entry in the file
-	QTextStream str(&m_fiFileList);
-	while ((sPath = str.readLine()) != QString::null) {
-		if (sPath.at(0) != '-') {
-			bResult = false;
-			break;
+	QTextStream strIn(&m_fiFileList);
+	while ((sLine = strIn.readLine()) != QString::null)
+		slLines.append(sLine);
+	
+	m_fiFileList.close();
+	
+	// Remove deleted files, keeping option lines
+	setRemoved = QSet<QString>::fromList(slRemoved);
+	slRemoved.clear();
+	for (itr = slLines.begin(); itr != slLines.end(); ++itr) {
+		if ((*itr).isEmpty() || (*itr).at(0) == '-') {
+			slFiles.append(*itr);
+			continue;
+		}
+		
+		bRemove = setRemoved.contains(*itr);
+		for (itrDir = slRemovedDirs.begin(); !bRemove &&
+			itrDir != slRemovedDirs.end(); ++itrDir) {
+			bRemove = (*itr).startsWith(*itrDir + "/");
+		}
+		
+		if (!bRemove && bRescan &&
+			(*itr).startsWith(getSourceRoot() + "/")) {
+			bRemove = !QFile::exists(*itr);
+		}
+		
+		if (bRemove) {
+			slRemoved.append(*itr);
+		} else {
+			slFiles.append(*itr);
+			setFiles.insert(*itr);
 		}
 	}
+	
+	// Filter out new files which are already included in the project
+	for (itr = slAdded.begin(); itr != slAdded.end(); ) {
+		if (setFiles.contains(*itr)) {
+			itr = slAdded.erase(itr);
+		} else {
+			setFiles.insert(*itr);
+			slFiles.append(*itr);
+			++itr;
+		}
+	}
+	
+	// Modified files only matter if included in the project
+	for (itr = slModified.begin(); itr != slModified.end(); ) {
+		if (setFiles.contains(*itr))
+			++itr;
+		else
+			itr = slModified.erase(itr);
+	}
+	
+	// Nothing to write if the project's files have not changed
+	if (slAdded.isEmpty() && slRemoved.isEmpty()) {
+		setFileCount(setFiles.count());
+		return true;
+	}
+	
+	// Write the new list
+	finishLoading();
+	if (!m_fiFileList.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	QTextStream strOut(&m_fiFileList);
+	for (itr = slFiles.begin(); itr != slFiles.end(); ++itr)
+		strOut << *itr << "\n";
 
+	strOut.flush();
 	m_fiFileList.close();
-	return bResult;
+	setFileCount(setFiles.count());
+	return true;
+}
+
+/**
+ * Determines whether the project includes any files.
+ * Uses the cached number of entries in the 'cscope.files' file, which is
+ * only counted again if the file was changed by another program.
+ * @return	true if no files are included in the project, false otherwise
+ */
+bool Project::isEmpty()
+{
+	return getFileCount() <= 0;
+}
+
+/**
+ * Caches the number of entries in the 'cscope.files' file, and stores it in
+ * the configuration file, so that it remains valid when the project is
+ * opened again.
+ * @param	nFiles	The number of entries
+ */
+void Project::setFileCount(int nFiles)
+{
+	ProjectBase::setFileCount(nFiles);
+	
+	if (!m_pConf)
+		return;
+	
+	KConfigGroup group = m_pConf->group("FileList");
+	group.writeEntry("Count", m_nFileCount);
+	group.writeEntry("Size", m_nFileListSize);
+	group.writeEntry("Time", m_nFileListTime);
 }
 
 /**
@@ -406,6 +504,7 @@ void Project::writeOptions(KConfig* pConf, const Options& opt)
 	group.writeEntry("InvIndex", opt.bInvIndex);		
 	group.writeEntry("NoCompress", opt.bNoCompress);		
 	group.writeEntry("SlowPathDef", opt.bSlowPathDef);		
+	group.writeEntry("Sharded", opt.bSharded);
 	group.writeEntry("AutoRebuildTime", opt.nAutoRebuildTime);
 	group.writeEntry("TabWidth", opt.nTabWidth);
 	group.writeEntry("CtagsCommand", opt.sCtagsCmd);
@@ -23,9 +23,10 @@ public:
 	};
 	
 	virtual bool open(const QString&);
-	virtual bool loadFileList(FileListTarget*);
 	virtual bool storeFileList(FileListSource*);
 	virtual bool addFile(const QString&);
+	virtual bool updateFiles(QStringList&, QStringList&, QStringList&,
+		const QStringList&, bool bRescan = false);
 	virtual bool isEmpty();
 	virtual void close();
 	
@@ -59,6 +60,8 @@ private:
 	
 	QString m_sMakeRoot;
 	
+	virtual void setFileCount(int);
+	
 	static void writeOptions(KConfig*, const Options&);
 };
 
@@ -1,13 +1,21 @@
+#include <qdatetime.h>
 #include "projectbase.h"
 #include "kscopeconfig.h"
 #include "cscopefrontend.h"
+#include "cscopeshards.h"
+#include "filelistloader.h"
 
-ProjectBase::ProjectBase()
+ProjectBase::ProjectBase() :
+	m_nFileCount(-1),
+	m_nFileListSize(0),
+	m_nFileListTime(0),
+	m_pLoader(NULL)
 {
 }
 
 ProjectBase::~ProjectBase()
 {
+	delete m_pLoader;
 }
 
 bool ProjectBase::open(const QString& sPath)
@@ -35,10 +43,14 @@ bool ProjectBase::open(const QString& sPath)
 
 /**
  * Determines if the cscope.out file for this project exists.
+ * For projects built in shards, checks for the database of the first shard.
  * @return	true if the database exists, false otherwise
  */
 bool ProjectBase::dbExists()
 {
+	if (m_nArgs & CscopeFrontend::Sharded)
+		return m_dir.exists(CscopeShards::getDatabase(0));
+		
 	return m_dir.exists("cscope.out");
 }
 
@@ -73,6 +85,7 @@ void ProjectBase::getDefOptions(Options& opt)
 	opt.bInvIndex = DEF_INV_INDEX;
 	opt.bNoCompress = DEF_NO_COMPRESS;
 	opt.bSlowPathDef = DEF_SLOW_PATH;
+	opt.bSharded = DEF_SHARDED;
 	opt.nACMinChars = DEF_AC_MIN_CHARS;
 	opt.nACDelay = DEF_AC_DELAY;
 	opt.nACMaxEntries = DEF_AC_MAX_ENTRIES;
@@ -104,6 +117,8 @@ void ProjectBase::initOptions()
 		m_nArgs |= CscopeFrontend::NoCompression;
 	if (m_opt.bSlowPathDef)
 		m_nArgs |= CscopeFrontend::SlowPathDef;
+	if (m_opt.bSharded)
+		m_nArgs |= CscopeFrontend::Sharded;
 }
 
 /**
@@ -132,34 +147,70 @@ bool ProjectBase::isCscopeOut(const QString& sPath)
  * List items are created by reading and parsing all file name entries from
  * the project's 'cscope.files' file.
  * Note that the file may contain option lines, beginning with a dash. These
- * should be ignored.
+ * are ignored.
  * @param	pList	Pointer to the object to fill
+ * @param	bAsync	true to read the file in a separate thread, in which case
+ *					items are added to the list in batches, once control
+ *					returns to the event loop (a previous asynchronous load
+ *					is stopped), false to fill the list before returning
+ * @return	true if successful, false otherwise
  */
-bool ProjectBase::loadFileList(FileListTarget* pList)
+bool ProjectBase::loadFileList(FileListTarget* pList, bool bAsync)
 {
-	QString sFilePath;
-	QFile file;
+	FileListLoader loader;
 	
-	// Make sure the file exists
-	if (!m_dir.exists("cscope.files"))
-		return false;
+	if (!bAsync)
+		return loader.load(getFileListPath(), pList);
 	
-	// Open the file
-	file.setFileName(m_dir.absolutePath() + "/cscope.files");
-	if (!file.open(QIODevice::ReadOnly))
-		return false;
+	if (m_pLoader == NULL)
+		m_pLoader = new FileListLoader();
+	
+	return m_pLoader->start(getFileListPath(), pList);
+}
 
-	// Read all file names from the file
-	QTextStream str(&file);
-	while ((sFilePath = str.readLine()) != QString::null) {
-		// Skip option lines
-		if (sFilePath.at(0) == '-')
-			continue;
+/**
+ * Waits until a separate thread started by loadFileList() has finished
+ * reading the 'cscope.files' file (which is mapped to memory while read), so
+ * that the file can be rewritten.
+ * Entries already read are still added to the list.
+ */
+void ProjectBase::finishLoading()
+{
+	if (m_pLoader != NULL)
+		m_pLoader->wait();
+}
 
-		// Set the new list item
-		pList->addItem(sFilePath);
+/**
+ * Returns the number of files in the project.
+ * The count is cached, and the file list is only scanned again if it has
+ * changed since (as determined by its size and modification time.)
+ * @return	The number of entries in the 'cscope.files' file
+ */
+int ProjectBase::getFileCount()
+{
+	QFileInfo fi(getFileListPath());
+	
+	if (!fi.exists())
+		return 0;
+	
+	if (m_nFileCount < 0 || fi.size() != m_nFileListSize ||
+		fi.lastModified().toTime_t() != m_nFileListTime) {
+		setFileCount(FileListLoader::count(getFileListPath()));
 	}
+	
+	return m_nFileCount;
+}
 
-	file.close();
-	return true;
+/**
+ * Caches the number of entries in the 'cscope.files' file, along with the
+ * current size and modification time of the file.
+ * @param	nFiles	The number of entries
+ */
+void ProjectBase::setFileCount(int nFiles)
+{
+	QFileInfo fi(getFileListPath());
+	
+	m_nFileCount = nFiles;
+	m_nFileListSize = fi.size();
+	m_nFileListTime = fi.lastModified().toTime_t();
 }
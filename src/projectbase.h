@@ -16,6 +16,7 @@
 #define DEF_INV_INDEX		true
 #define DEF_NO_COMPRESS		false
 #define DEF_SLOW_PATH		false
+#define DEF_SHARDED			false
 #define DEF_AC_MIN_CHARS	3
 #define DEF_AC_DELAY		500
 #define DEF_AC_MAX_ENTRIES	100
@@ -127,6 +128,7 @@ struct FileLocation
 typedef QList<FileLocation *> FileLocationList;
 
 class FileSemaphore;
+class FileListLoader;
 
 /**
  * @author Elad Lahav
@@ -159,6 +161,10 @@ public:
 		/** true if the -D option for CScope should be used. */
 		bool bSlowPathDef;
 		
+		/** true if the database should be built in several parts, in
+			parallel. */
+		bool bSharded;
+		
 		/** The time, in milliseconds, after which the database should be
 			automatically rebuilt (-1 if this option is disabled). */
 		int nAutoRebuildTime;
@@ -184,10 +190,11 @@ public:
 	};
 	
 	virtual bool open(const QString&);
-	virtual bool loadFileList(FileListTarget*);
+	virtual bool loadFileList(FileListTarget*, bool bAsync = false);
 	virtual bool storeFileList(FileListSource*) { return false; }
 	virtual bool isEmpty() { return false; }
 	bool dbExists();
+	int getFileCount();
 	virtual void close() {}
 	
 	virtual QString getFileTypes() const { return QString::null; }
@@ -252,7 +259,29 @@ protected:
 	/** A list of symbols previously queried. */
 	QStringList m_slSymHistory;
 	
+	/** The number of entries in the 'cscope.files' file, -1 if unknown. */
+	int m_nFileCount;
+	
+	/** The size of the 'cscope.files' file when its entries were counted. */
+	qint64 m_nFileListSize;
+	
+	/** The modification time of the 'cscope.files' file when its entries
+		were counted. */
+	uint m_nFileListTime;
+	
+	/** Reads the 'cscope.files' file in a separate thread. */
+	FileListLoader* m_pLoader;
+	
 	void initOptions();
+	void finishLoading();
+	virtual void setFileCount(int);
+	
+	/**
+	 * @return	The full path of the project's 'cscope.files' file
+	 */
+	QString getFileListPath() const {
+		return m_dir.absolutePath() + "/cscope.files";
+	}
 	
 	static bool isCscopeOut(const QString&);
 };
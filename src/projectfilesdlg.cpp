@@ -8,8 +8,9 @@
 #include <kfiledialog.h>
 #include "projectfilesdlg.h"
 #include "dirscanner.h"
-#include "scanprogressdlg.h"
+#include "projectfilesmodel.h"
 #include "kscopeconfig.h"
+#include "scanprogressdlg.h"
 
 /**
  * Class constructor.
@@ -21,26 +22,23 @@ ProjectFilesDlg::ProjectFilesDlg(Project* pProj, QWidget* pParent) :
     QDialog(pParent),
 	m_pProj(pProj),
 	m_pScanDlg(NULL),
-	m_pItrItem(NULL),
-	m_pLastItem(NULL)
+	m_nItrPos(0)
 {
 
     setupUi(this);
-	// Create the scanner object
-	m_pScanner = new DirScanner(this, &m_dicFiles);
-
-	// Initialise the QTreeWidget
-	// m_pFileList->setSelectionMode(QListView::Extended); // TODO
-    m_pFileList->setColumnCount(1);
-    QStringList strList;
-    strList << "File Path";
-    m_pFileList->setHeaderLabels(strList);
 	
+	// Create the file list model
 	// Sort only when asked to by the user
-	if (Config().getAutoSortFiles())
-		m_pFileList->setSortingEnabled(true);
-	else
-		m_pFileList->setSortingEnabled(false);
+	m_pModel = new ProjectFilesModel(Config().getAutoSortFiles(), this);
+	m_pFileList->setModel(m_pModel);
+	
+	// Create the scanner object
+	m_pScanner = new DirScanner(this, &m_pModel->getFiles());
+
+	// Initialise the list view
+	m_pFileList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+	m_pFileList->setRootIsDecorated(false);
+	m_pFileList->setUniformRowHeights(true);
 
 	// Add file/directory/tree when the appropriate button is clicked
 	connect(m_pAddFilesButton, SIGNAL(clicked()), this,
@@ -63,10 +61,8 @@ ProjectFilesDlg::ProjectFilesDlg(Project* pProj, QWidget* pParent) :
 	connect(m_pCancelButton, SIGNAL(clicked()), this, SLOT(reject()));
 
 	// Fill the list with the project's files
-	m_pFileList->setUpdatesEnabled(false);
 	m_pProj->loadFileList(this);
-	m_pFileList->setUpdatesEnabled(true);
-	//m_pFileList->triggerUpdate();
+	m_pModel->refresh();
 }
 
 /**
@@ -82,34 +78,30 @@ ProjectFilesDlg::~ProjectFilesDlg()
  * Implements the addItem() virtual method of the FileListTarget base
  * class. When a ProjectFilesDlg object is given as a parameter to
  * ProjectManager::fillList(), this method is called for each file included
- * in the project. A new list item is created, containing the file's path,
- * and is added to the list.
+ * in the project. The file is added to the model, which is refreshed once
+ * all files are loaded.
  * @param	sFilePath	The full path of a source file
  */
 void ProjectFilesDlg::addItem(const QString& sFilePath)
 {
-	QTreeWidgetItem* pItem;
-	
-	pItem = new QTreeWidgetItem(m_pFileList, m_pLastItem);
-	pItem->setText(0, sFilePath);
-	m_pLastItem = pItem;
-	m_dicFiles.insert(sFilePath, pItem);
+	m_pModel->insert(sFilePath);
 }
 
 /**
  * Retrieves the first file path in the list.
  * Imlpements the firstItem() virtual method of the FileListSource base
- * class.
+ * class. All files in the project are returned, including those hidden by a
+ * filter.
  * @param	sFilePath	Contains the file path, upon successful return
  * @return	bool		true if successful, false if the list is empty
  */
 bool ProjectFilesDlg::firstItem(QString& sFilePath)
 {
-	m_pItrItem = m_pFileList->topLevelItem(0);
-	if (m_pItrItem == NULL)
-		return false;
-	sFilePath = m_pItrItem->text(0);
-    return true;
+	m_vecItr.clear();
+	m_pModel->getOrder(m_vecItr);
+	m_nItrPos = -1;
+	
+	return nextItem(sFilePath);
 }
 
 /**
@@ -123,10 +115,10 @@ bool ProjectFilesDlg::firstItem(QString& sFilePath)
  */
 bool ProjectFilesDlg::nextItem(QString& sFilePath)
 {
-	m_pItrItem = m_pFileList->itemBelow(m_pItrItem);;
-	if (m_pItrItem == NULL)
+	if (++m_nItrPos >= m_vecItr.size())
 		return false;
-	sFilePath = m_pItrItem->text(0);
+	
+	sFilePath = m_pModel->getFiles().getPath(m_vecItr[m_nItrPos]);
 	return true;
 }
 
@@ -188,20 +180,7 @@ void ProjectFilesDlg::customEvent(QEvent* pEvent)
 		return;
 
 	// Add the files to the list
-	const QStringList& slFiles = m_pScanner->getFiles();
-	QStringList::const_iterator itr;
-
-	for (itr = slFiles.begin(); itr != slFiles.end(); ++itr)
-		addItem(*itr);
-}
-
-/**
- * Removes a single item from the file list.
- */
-void ProjectFilesDlg::removeItem(QTreeWidgetItem* pItem)
-{
-	m_dicFiles.remove(pItem->text(0));
-	delete pItem;
+	m_pModel->addFiles(m_pScanner->getFiles());
 }
 
 /**
@@ -212,17 +191,13 @@ void ProjectFilesDlg::removeItem(QTreeWidgetItem* pItem)
 void ProjectFilesDlg::slotAddFiles()
 {
 	QStringList slFiles;
-	QStringList::const_iterator itr;
 
 	// Prompt the user
 	slFiles = KFileDialog::getOpenFileNames(m_pProj->getSourceRoot(),
 		m_pProj->getFileTypes());
 
 	// Add the selected files, skipping existing entries
-	for (itr = slFiles.begin(); itr != slFiles.end(); ++itr) {
-		if (m_dicFiles.find(*itr) == m_dicFiles.end())
-			addItem(*itr);
-	}
+	m_pModel->addFiles(slFiles);
 }
 
 /**
@@ -274,8 +249,7 @@ void ProjectFilesDlg::slotAddTree()
  */
 void ProjectFilesDlg::slotRemSel()
 {
-	QTreeWidgetItem* pItem, * pPrevItem;
-	
+
 	// Prompt the user before removing the files
 	if (KMessageBox::questionYesNo(0, i18n("Are you sure you want to remove "
 		"the selected files from the project?")) == KMessageBox::No) {
@@ -283,14 +257,7 @@ void ProjectFilesDlg::slotRemSel()
 	}
 
 	// Remove the selected files
-    pItem = m_pFileList->topLevelItem(0);
-	while (pItem != NULL) {
-		pPrevItem = pItem;
-		pItem = m_pFileList->itemBelow(pItem);
-		
-		if (pPrevItem->isSelected())
-			removeItem(pPrevItem);
-	}
+	m_pModel->removeFiles(m_pFileList->selectionModel()->selectedRows());
 }
 
 /**
@@ -298,8 +265,7 @@ void ProjectFilesDlg::slotRemSel()
  */
 void ProjectFilesDlg::slotRemDir()
 {
-	QString sDir, sFilePath;
-	QTreeWidgetItem* pItem, * pPrevItem;
+	QString sDir;
 
 	// Prompt the user for a directory
 	sDir = KFileDialog::getExistingDirectory(m_pProj->getSourceRoot());
@@ -313,16 +279,7 @@ void ProjectFilesDlg::slotRemDir()
 	}
 
 	// Remove the files under the selected directory
-    pItem = m_pFileList->topLevelItem(0);
-	while (pItem != NULL) {
-		pPrevItem = pItem;
-		pItem = m_pFileList->itemBelow(pItem);
-
-		// Check if the file is under the selected directory
-		sFilePath = pPrevItem->text(0);
-		if (sFilePath.left(sFilePath.lastIndexOf('/') + 1) == sDir)
-			removeItem(pPrevItem);
-	}
+	m_pModel->removeDir(sDir);
 }
 
 /**
@@ -331,8 +288,7 @@ void ProjectFilesDlg::slotRemDir()
  */
 void ProjectFilesDlg::slotRemTree()
 {
-	QString sDir, sFilePath;
-	QTreeWidgetItem* pItem, * pPrevItem;
+	QString sDir;
 
 	// Prompt the user for a directory
 	sDir = KFileDialog::getExistingDirectory(m_pProj->getSourceRoot());
@@ -346,17 +302,8 @@ void ProjectFilesDlg::slotRemTree()
 		return;
 	}
 
-	// Remove the files under the selected directory
-	pItem = m_pFileList->topLevelItem(0);
-	while (pItem != NULL) {
-		pPrevItem = pItem;
-		pItem = m_pFileList->itemBelow(pItem);
-
-		// Check if the file is under the selected directory
-		sFilePath = pPrevItem->text(0);
-		if (sFilePath.startsWith(sDir))
-			removeItem(pPrevItem);
-	}
+	// Remove the files under the selected directory and its sub-directories
+	m_pModel->removeTree(sDir);
 }
 
 /**
@@ -367,28 +314,14 @@ void ProjectFilesDlg::slotRemTree()
 void ProjectFilesDlg::slotFilter()
 {
 	QString sFilter;
-	QTreeWidgetItem* pItem;
 	
 	// Get the user's filter string
 	sFilter = m_pFilterEdit->text().trimmed();
 	if (sFilter.isEmpty())
 		return;
 
-	// Create the regular expression
-	QRegExp reFilter(sFilter);
-    reFilter.setPatternSyntax(QRegExp::Wildcard);
-		
-	// Iterate over the list entries, and hide all items not matching the
-	// filter string
-	pItem = m_pFileList->topLevelItem(0);
-	while (pItem != NULL) {
-		if (reFilter.indexIn(pItem->text(0)) == -1) {
-			pItem->setHidden(true);
-			pItem->setFlags(pItem->flags() ^ Qt::ItemIsSelectable);
-		}
-
-		pItem = m_pFileList->itemBelow(pItem);
-	}
+	// List only the files matching the filter string
+	m_pModel->setFilter(sFilter);
 }
 
 /**
@@ -396,15 +329,7 @@ void ProjectFilesDlg::slotFilter()
  */
 void ProjectFilesDlg::slotShowAll()
 {
-	QTreeWidgetItem* pItem;
-
-	// Iterate over the list entries, and make all items visible
-	pItem = m_pFileList->topLevelItem(0);
-	while (pItem != NULL) {
-        pItem->setHidden(false);
-        pItem->setFlags(pItem->flags() | Qt::ItemIsSelectable);
-		pItem = m_pFileList->itemBelow(pItem);
-	}
+	m_pModel->setFilter(QString());
 }
 
 /**
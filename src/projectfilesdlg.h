@@ -2,14 +2,15 @@
 #define PROJECTFILESDLG_H
 
 #include <QWidget>
-#include <QHash>
 #include <QEvent>
+#include <QVector>
 
 #include "project.h"
 #include "ui_projectfileslayout.h"
 
 class DirScanner;
 class ScanProgressDlg;
+class ProjectFilesModel;
 
 /**
  * A dialog to manipulate the project's files.
@@ -18,10 +19,9 @@ class ScanProgressDlg;
  * displays all files currently in the project. When files are added or
  * removed, this list view is updated. The project, however, is only modified
  * if the user closes the dialog using the "OK" button.
- * Since searches through a list view are very slow, the class also maintains
- * a QDict object, that connects file names with their respective list items.
- * This dictionary is used to ensure duplicated items are not added to the
- * list.
+ * The files are kept in a ProjectFilesModel object, which stores them as a
+ * tree of path components, so that adding, removing and filtering files does
+ * not involve a search through the list.
  * @author Elad Lahav
  */
 
@@ -45,9 +45,8 @@ private:
 	/** The project to manipulate. */
 	Project* m_pProj;
 
-	/** Holds all file paths in a quickly searchable format (for duplicate
-		entries lookup). */
-	QHash<QString, QTreeWidgetItem *> m_dicFiles;
+	/** Holds all file paths in a quickly searchable format. */
+	ProjectFilesModel* m_pModel;
 	
 	/** A thread object to a-synchronously scan directories for source files
 		to add to the project. */
@@ -56,13 +55,12 @@ private:
 	/** Displays the progress of a directory scan operation. */
 	ScanProgressDlg* m_pScanDlg;
 
-	/** A file list item that serves as an iterator. */
-	QTreeWidgetItem* m_pItrItem;
-
-	/** The last item added. */
-	QTreeWidgetItem* m_pLastItem;
+	/** The files returned by firstItem() and nextItem(). */
+	QVector<int> m_vecItr;
 	
-	void removeItem(QTreeWidgetItem*);
+	/** The position of the last file returned by firstItem() or
+		nextItem(). */
+	int m_nItrPos;
 	
 private slots:
 	void slotAddFiles();
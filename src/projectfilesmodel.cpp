@@ -0,0 +1,212 @@
+#include "projectfilesmodel.h"
+
+/**
+ * Class constructor.
+ * @param	bSorted	true to list files in sorted order, false to list them in
+ *					the order in which they were added
+ * @param	pParent	The parent object
+ */
+ProjectFilesModel::ProjectFilesModel(bool bSorted, QObject* pParent) :
+	QAbstractListModel(pParent),
+	m_bSorted(bSorted)
+{
+}
+
+/**
+ * Class destructor.
+ */
+ProjectFilesModel::~ProjectFilesModel()
+{
+}
+
+/**
+ * Adds a file without updating the list (@see refresh()).
+ * @param	sPath	The full path of the file
+ * @return	true if the file was added, false if it is already included
+ */
+bool ProjectFilesModel::insert(const QString& sPath)
+{
+	if (!m_trie.insert(sPath))
+		return false;
+
+	if (!m_bSorted)
+		m_vecOrder.append(m_trie.find(sPath));
+
+	return true;
+}
+
+/**
+ * Adds files to the project, skipping files which are already included.
+ * @param	slFiles	The full paths of the files to add
+ */
+void ProjectFilesModel::addFiles(const QStringList& slFiles)
+{
+	QStringList::ConstIterator itr;
+	bool bAdded;
+
+	bAdded = false;
+	for (itr = slFiles.begin(); itr != slFiles.end(); ++itr)
+		bAdded |= insert(*itr);
+
+	if (bAdded)
+		refresh();
+}
+
+/**
+ * Removes listed files from the project.
+ * @param	lstIndices	The indices of the rows to remove
+ */
+void ProjectFilesModel::removeFiles(const QModelIndexList& lstIndices)
+{
+	QModelIndexList::ConstIterator itr;
+	QStringList slFiles;
+	QStringList::ConstIterator itrFile;
+
+	// Get the paths first, since the nodes are reused once removed
+	for (itr = lstIndices.begin(); itr != lstIndices.end(); ++itr) {
+		if ((*itr).isValid() && (*itr).row() < m_vecRows.size())
+			slFiles.append(m_trie.getPath(m_vecRows[(*itr).row()]));
+	}
+
+	if (slFiles.isEmpty())
+		return;
+
+	for (itrFile = slFiles.begin(); itrFile != slFiles.end(); ++itrFile)
+		m_trie.remove(*itrFile);
+
+	refresh();
+}
+
+/**
+ * Removes the files in a directory (but not in its sub-directories) from the
+ * project.
+ * @param	sDir	The path of the directory
+ */
+void ProjectFilesModel::removeDir(const QString& sDir)
+{
+	if (m_trie.removeDir(sDir) > 0)
+		refresh();
+}
+
+/**
+ * Removes the files in a directory, and in all of its sub-directories, from
+ * the project.
+ * @param	sDir	The path of the directory
+ */
+void ProjectFilesModel::removeTree(const QString& sDir)
+{
+	int nNode, nRank, nFiles;
+
+	nNode = m_trie.find(sDir);
+	if (nNode <= 0)
+		return;
+
+	// A filtered list needs to be matched again, and an unsorted list does
+	// not hold the tree's files in a single range
+	if (!m_bSorted || !m_reFilter.isEmpty() || !m_sFilter.isEmpty()) {
+		m_trie.removeTree(sDir);
+		refresh();
+		return;
+	}
+
+	// The tree's files are listed in a single range of rows
+	nRank = m_trie.getRank(nNode);
+	nFiles = m_trie.getCount(nNode);
+
+	beginRemoveRows(QModelIndex(), nRank, nRank + nFiles - 1);
+	m_trie.removeTree(sDir);
+	m_vecRows.remove(nRank, nFiles);
+	endRemoveRows();
+}
+
+/**
+ * Lists only the files whose paths match a wildcard pattern.
+ * @param	sFilter	The pattern, an empty string to list all files
+ */
+void ProjectFilesModel::setFilter(const QString& sFilter)
+{
+	// Match plain strings directly, rather than through a regular expression
+	m_reFilter = QRegExp();
+	m_sFilter = QString();
+	if (sFilter.contains(QRegExp("[*?\\[]")))
+		m_reFilter = QRegExp(sFilter, Qt::CaseSensitive, QRegExp::Wildcard);
+	else
+		m_sFilter = sFilter;
+
+	refresh();
+}
+
+/**
+ * Rebuilds the list of files from the trie, applying the current filter.
+ */
+void ProjectFilesModel::refresh()
+{
+	QVector<int> vecFiles;
+	QVector<bool> vecLive;
+	int i, nMax;
+
+	m_trie.getFiles(vecFiles);
+
+	// Drop the files removed since the last refresh from the order in which
+	// files were added
+	// Removed nodes are reused by files added later, so this needs to be
+	// done before any file is added
+	if (!m_bSorted) {
+		nMax = -1;
+		for (i = 0; i < vecFiles.size(); i++)
+			nMax = qMax(nMax, vecFiles[i]);
+
+		vecLive.fill(false, nMax + 1);
+		for (i = 0; i < vecFiles.size(); i++)
+			vecLive[vecFiles[i]] = true;
+
+		vecFiles.clear();
+		for (i = 0; i < m_vecOrder.size(); i++) {
+			if (m_vecOrder[i] <= nMax && vecLive[m_vecOrder[i]])
+				vecFiles.append(m_vecOrder[i]);
+		}
+
+		m_vecOrder = vecFiles;
+	}
+
+	if (!m_reFilter.isEmpty() || !m_sFilter.isEmpty()) {
+		m_vecRows.clear();
+		for (i = 0; i < vecFiles.size(); i++) {
+			if (m_sFilter.isEmpty() ?
+				m_reFilter.indexIn(m_trie.getPath(vecFiles[i])) != -1 :
+				m_trie.getPath(vecFiles[i]).contains(m_sFilter)) {
+				m_vecRows.append(vecFiles[i]);
+			}
+		}
+	} else {
+		m_vecRows = vecFiles;
+	}
+
+	reset();
+}
+
+/**
+ * Returns all files in the project, including those hidden by a filter, in
+ * the order in which they are listed.
+ * @param	vecFiles	Holds the trie nodes of the files, upon return
+ */
+void ProjectFilesModel::getOrder(QVector<int>& vecFiles) const
+{
+	if (m_bSorted)
+		m_trie.getFiles(vecFiles);
+	else
+		vecFiles = m_vecOrder;
+}
+
+int ProjectFilesModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_vecRows.size();
+}
+
+QVariant ProjectFilesModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || role != Qt::DisplayRole)
+		return QVariant();
+
+	return m_trie.getPath(m_vecRows[index.row()]);
+}
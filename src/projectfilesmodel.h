@@ -0,0 +1,69 @@
+#ifndef PROJECTFILESMODEL_H
+#define PROJECTFILESMODEL_H
+
+#include <QAbstractListModel>
+#include <qstringlist.h>
+#include <qvector.h>
+#include <qregexp.h>
+#include "pathtrie.h"
+
+/**
+ * A list model holding the files of a project, as edited by the
+ * ProjectFilesDlg dialogue.
+ * Files are kept in a PathTrie, and are listed either in sorted order, or in
+ * the order in which they were added to the project (if the user has turned
+ * off sorting.) The model keeps the trie nodes of the listed files, which are
+ * all files in the project, unless a filter is applied. Since sorted files of
+ * a directory tree are listed consecutively, removing a tree from an
+ * unfiltered, sorted list removes a single range of rows.
+ * @author Elad Lahav
+ */
+class ProjectFilesModel : public QAbstractListModel
+{
+	Q_OBJECT
+
+public:
+	ProjectFilesModel(bool bSorted = true, QObject* pParent = 0);
+	~ProjectFilesModel();
+
+	bool insert(const QString&);
+	void addFiles(const QStringList&);
+	void removeFiles(const QModelIndexList&);
+	void removeDir(const QString&);
+	void removeTree(const QString&);
+	void setFilter(const QString&);
+	void refresh();
+	void getOrder(QVector<int>&) const;
+
+	/**
+	 * @return	All files in the project
+	 */
+	const PathTrie& getFiles() const { return m_trie; }
+
+	virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+	virtual QVariant data(const QModelIndex&, int role = Qt::DisplayRole)
+		const;
+
+private:
+	/** All files in the project. */
+	PathTrie m_trie;
+
+	/** true to list files in sorted order, false to list them in the order
+		in which they were added. */
+	bool m_bSorted;
+
+	/** The trie nodes of all files, in the order in which they were added
+		(only kept if files are not sorted.) */
+	QVector<int> m_vecOrder;
+
+	/** The trie nodes of the listed files, in display order. */
+	QVector<int> m_vecRows;
+
+	/** Matches the paths of listed files (empty if no filter is applied.) */
+	QRegExp m_reFilter;
+
+	/** A filter string without wildcards, matched as a plain string. */
+	QString m_sFilter;
+};
+
+#endif
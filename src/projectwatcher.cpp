@@ -0,0 +1,414 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <poll.h>
+#include <errno.h>
+#include <unistd.h>
+#include <qapplication.h>
+#include <qfile.h>
+#include <qdatetime.h>
+#include "projectwatcher.h"
+
+/** The changes reported for each watched directory. */
+#define WATCH_MASK	(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+	IN_CLOSE_WRITE | IN_ONLYDIR | IN_DONT_FOLLOW)
+
+int ProjectWatchEvent::eventTypeId = QEvent::None;
+
+/**
+ * Class constructor.
+ */
+ProjectWatchEvent::ProjectWatchEvent() :
+	QEvent(QEvent::Type(ProjectWatchEvent::eventTypeId)),
+	m_bRescan(false)
+{
+}
+
+int ProjectWatchEvent::registerWatchEventType()
+{
+	ProjectWatchEvent::eventTypeId =
+		QEvent::registerEventType(ProjectWatchEvent::EventId);
+	return ProjectWatchEvent::eventTypeId;
+}
+
+/**
+ * Class constructor.
+ * @param	pEventReceiver	Pointer to an object to receive ProjectWatchEvent
+ *							batches
+ */
+ProjectWatcher::ProjectWatcher(QObject* pEventReceiver) : QThread(),
+	m_pEventReceiver(pEventReceiver),
+	m_nFd(-1),
+	m_bRescan(false)
+{
+	m_arrPipe[0] = m_arrPipe[1] = -1;
+
+	if (ProjectWatchEvent::eventTypeId == QEvent::None)
+		ProjectWatchEvent::registerWatchEventType();
+}
+
+/**
+ * Class destructor.
+ */
+ProjectWatcher::~ProjectWatcher()
+{
+	stop();
+}
+
+/**
+ * Starts watching a source tree.
+ * A tree that is currently watched is released first.
+ * @param	sRoot		The root directory of the tree
+ * @param	sFileTypes	A space-separated list of wildcard patterns, matching
+ *						the names of project files
+ */
+void ProjectWatcher::start(const QString& sRoot, const QString& sFileTypes)
+{
+	stop();
+
+	// Initialise the watch parameters
+	m_sRoot = sRoot;
+	m_glob.compile(sFileTypes);
+	if (pipe(m_arrPipe) != 0)
+		return;
+
+	// Invoke the thread
+	QThread::start();
+}
+
+/**
+ * Stops watching the current tree, and waits for the thread to terminate.
+ * Changes which were not yet posted are discarded.
+ */
+void ProjectWatcher::stop()
+{
+	if (m_arrPipe[1] < 0)
+		return;
+
+	// Wake the thread
+	write(m_arrPipe[1], "", 1);
+	wait();
+
+	close(m_arrPipe[0]);
+	close(m_arrPipe[1]);
+	m_arrPipe[0] = m_arrPipe[1] = -1;
+}
+
+/**
+ * Watches the tree until stopped, posting batches of changes.
+ */
+void ProjectWatcher::run()
+{
+	struct pollfd arrFds[2];
+	QTime timeBatch;
+	bool bPending;
+	int nResult;
+
+	m_nFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_nFd < 0)
+		return;
+
+	// Watch all directories in the tree
+	watchDir(QFile::encodeName(m_sRoot), false);
+
+	arrFds[0].fd = m_nFd;
+	arrFds[0].events = POLLIN;
+	arrFds[1].fd = m_arrPipe[0];
+	arrFds[1].events = POLLIN;
+
+	for (;;) {
+		// Wait for a quiet period before posting pending changes
+		nResult = poll(arrFds, 2, isPending() ? WATCH_BATCH_DELAY : -1);
+		if (nResult < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		// Check whether the watch was stopped
+		if (arrFds[1].revents != 0)
+			break;
+
+		if (nResult == 0) {
+			postBatch();
+			continue;
+		}
+
+		// Collect the changes, starting a new batch if required
+		bPending = isPending();
+		readEvents();
+		if (!bPending)
+			timeBatch.start();
+
+		// Do not let a long burst of changes delay the update indefinitely
+		if (isPending() && timeBatch.elapsed() > WATCH_BATCH_MAX_DELAY)
+			postBatch();
+	}
+
+	close(m_nFd);
+	m_nFd = -1;
+	m_hashDirs.clear();
+	m_setAdded.clear();
+	m_setRemoved.clear();
+	m_setModified.clear();
+	m_slRemovedDirs.clear();
+	m_bRescan = false;
+}
+
+/**
+ * Adds a watch for a directory and all of its sub-directories.
+ * Hidden directories, and symbolic links to directories, are not watched.
+ * @param	baDir	The encoded path of the directory
+ * @param	bScan	true to report all matching files in the tree as new
+ *					(for directories created or moved into the tree), false
+ *					otherwise
+ */
+void ProjectWatcher::watchDir(const QByteArray& baDir, bool bScan)
+{
+	QList<QByteArray> lstDirs;
+	QList<QByteArray>::Iterator itr;
+	struct stat st;
+	struct dirent* pEntry;
+	DIR* pDir;
+	int nWd, nLen;
+	bool bDir;
+
+	// The watch may fail if the directory was already removed, or if the
+	// system's limit on the number of watches was reached
+	nWd = inotify_add_watch(m_nFd, baDir.data(), WATCH_MASK);
+	if (nWd < 0)
+		return;
+
+	m_hashDirs.insert(nWd, baDir);
+
+	pDir = opendir(baDir.data());
+	if (pDir == NULL)
+		return;
+
+	while ((pEntry = readdir(pDir)) != NULL) {
+		// Skip hidden entries, including the "." and ".." directories
+		if (pEntry->d_name[0] == '.')
+			continue;
+
+		nLen = strlen(pEntry->d_name);
+
+		// Determine the type of the entry, without following symbolic links
+		bDir = (pEntry->d_type == DT_DIR);
+		if (pEntry->d_type == DT_UNKNOWN) {
+			if (fstatat(dirfd(pDir), pEntry->d_name, &st,
+				AT_SYMLINK_NOFOLLOW) != 0) {
+				continue;
+			}
+
+			bDir = S_ISDIR(st.st_mode);
+		}
+
+		if (bDir) {
+			lstDirs.append(baDir + '/' + QByteArray(pEntry->d_name, nLen));
+		} else if (bScan && m_glob.matches(pEntry->d_name, nLen)) {
+			addFile(QFile::decodeName(baDir + '/' +
+				QByteArray(pEntry->d_name, nLen)));
+		}
+	}
+
+	closedir(pDir);
+
+	// Descend into sub-directories once the directory is closed, to limit the
+	// number of open descriptors
+	for (itr = lstDirs.begin(); itr != lstDirs.end(); ++itr)
+		watchDir(*itr, bScan);
+}
+
+/**
+ * Handles a directory removed from the tree.
+ * The watches of the directory and its sub-directories are removed, and all
+ * files in it are reported as removed.
+ * @param	baDir	The encoded path of the directory
+ */
+void ProjectWatcher::removeDir(const QByteArray& baDir)
+{
+	QHash<int, QByteArray>::Iterator itrDir;
+	QSet<QString>::Iterator itrFile;
+	QByteArray baPrefix;
+	QString sPrefix;
+
+	baPrefix = baDir + '/';
+	sPrefix = QFile::decodeName(baPrefix);
+
+	// Remove the watches (a directory that was moved, rather than deleted,
+	// is still watched)
+	itrDir = m_hashDirs.begin();
+	while (itrDir != m_hashDirs.end()) {
+		if (*itrDir == baDir || (*itrDir).startsWith(baPrefix)) {
+			inotify_rm_watch(m_nFd, itrDir.key());
+			itrDir = m_hashDirs.erase(itrDir);
+		} else {
+			++itrDir;
+		}
+	}
+
+	// Pending changes to files in this directory are no longer relevant
+	itrFile = m_setAdded.begin();
+	while (itrFile != m_setAdded.end()) {
+		if ((*itrFile).startsWith(sPrefix))
+			itrFile = m_setAdded.erase(itrFile);
+		else
+			++itrFile;
+	}
+
+	itrFile = m_setModified.begin();
+	while (itrFile != m_setModified.end()) {
+		if ((*itrFile).startsWith(sPrefix))
+			itrFile = m_setModified.erase(itrFile);
+		else
+			++itrFile;
+	}
+
+	m_slRemovedDirs.append(QFile::decodeName(baDir));
+}
+
+/**
+ * Reads all available inotify events, and adds the changes they describe to
+ * the current batch.
+ */
+void ProjectWatcher::readEvents()
+{
+	char arrBuf[4096]
+		__attribute__ ((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event* pEvent;
+	QHash<int, QByteArray>::Iterator itr;
+	QByteArray baPath;
+	ssize_t nSize;
+	char* pPos;
+	int nLen;
+
+	while ((nSize = read(m_nFd, arrBuf, sizeof(arrBuf))) > 0) {
+		for (pPos = arrBuf; pPos < arrBuf + nSize;
+			pPos += sizeof(struct inotify_event) + pEvent->len) {
+			pEvent = (const struct inotify_event*)pPos;
+
+			// The event queue overflowed (this event has no watch
+			// descriptor)
+			if (pEvent->mask & IN_Q_OVERFLOW) {
+				rescan();
+				continue;
+			}
+
+			// A watch was removed (along with its directory)
+			if (pEvent->mask & IN_IGNORED) {
+				m_hashDirs.remove(pEvent->wd);
+				continue;
+			}
+
+			// Only changes to named entries in watched directories are of
+			// interest
+			itr = m_hashDirs.find(pEvent->wd);
+			if (itr == m_hashDirs.end() || pEvent->len == 0 ||
+				pEvent->name[0] == '.') {
+				continue;
+			}
+
+			nLen = strlen(pEvent->name);
+			baPath = *itr + '/' + QByteArray(pEvent->name, nLen);
+
+			if (pEvent->mask & IN_ISDIR) {
+				if (pEvent->mask & (IN_CREATE | IN_MOVED_TO))
+					watchDir(baPath, true);
+				else if (pEvent->mask & (IN_DELETE | IN_MOVED_FROM))
+					removeDir(baPath);
+				continue;
+			}
+
+			if (!m_glob.matches(pEvent->name, nLen))
+				continue;
+
+			if (pEvent->mask & (IN_CREATE | IN_MOVED_TO)) {
+				addFile(QFile::decodeName(baPath));
+			} else if (pEvent->mask & (IN_DELETE | IN_MOVED_FROM)) {
+				removeFile(QFile::decodeName(baPath));
+			} else if (pEvent->mask & IN_CLOSE_WRITE) {
+				if (!m_setAdded.contains(QFile::decodeName(baPath)))
+					m_setModified.insert(QFile::decodeName(baPath));
+			}
+		}
+	}
+}
+
+/**
+ * Handles an overflow of the inotify event queue.
+ * Since the changes made to the tree can no longer be determined, the
+ * current batch is discarded, and the tree is watched and scanned again.
+ * The next batch reports all files found, and the receiver should replace
+ * the tree's files with those.
+ */
+void ProjectWatcher::rescan()
+{
+	QHash<int, QByteArray>::Iterator itr;
+
+	m_setAdded.clear();
+	m_setRemoved.clear();
+	m_setModified.clear();
+	m_slRemovedDirs.clear();
+
+	// Directories moved out of the tree may still be watched
+	for (itr = m_hashDirs.begin(); itr != m_hashDirs.end(); ++itr)
+		inotify_rm_watch(m_nFd, itr.key());
+
+	m_hashDirs.clear();
+	watchDir(QFile::encodeName(m_sRoot), true);
+	m_bRescan = true;
+}
+
+/**
+ * Adds a new file to the current batch.
+ * @param	sPath	The full path of the file
+ */
+void ProjectWatcher::addFile(const QString& sPath)
+{
+	// A file that was removed and then created again is only modified
+	if (m_setRemoved.remove(sPath))
+		m_setModified.insert(sPath);
+	else
+		m_setAdded.insert(sPath);
+}
+
+/**
+ * Adds a removed file to the current batch.
+ * @param	sPath	The full path of the file
+ */
+void ProjectWatcher::removeFile(const QString& sPath)
+{
+	m_setModified.remove(sPath);
+
+	// A file that was created and then removed is not reported at all
+	if (!m_setAdded.remove(sPath))
+		m_setRemoved.insert(sPath);
+}
+
+/**
+ * Posts the current batch of changes to the receiver object.
+ */
+void ProjectWatcher::postBatch()
+{
+	ProjectWatchEvent* pEvent;
+
+	if (!isPending())
+		return;
+
+	pEvent = new ProjectWatchEvent();
+	pEvent->m_slAdded = m_setAdded.toList();
+	pEvent->m_slRemoved = m_setRemoved.toList();
+	pEvent->m_slModified = m_setModified.toList();
+	pEvent->m_slRemovedDirs = m_slRemovedDirs;
+	pEvent->m_bRescan = m_bRescan;
+
+	m_setAdded.clear();
+	m_setRemoved.clear();
+	m_setModified.clear();
+	m_slRemovedDirs.clear();
+	m_bRescan = false;
+
+	QApplication::postEvent(m_pEventReceiver, pEvent);
+}
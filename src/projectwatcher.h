@@ -0,0 +1,133 @@
+#ifndef PROJECTWATCHER_H
+#define PROJECTWATCHER_H
+
+#include <qthread.h>
+#include <qevent.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <QHash>
+#include <QSet>
+#include "dirscanner.h"
+
+/** The time, in milliseconds, without changes after which a batch of changes
+	is reported. */
+#define WATCH_BATCH_DELAY	500
+
+/** The maximal time, in milliseconds, during which changes are collected
+	before a batch is reported (for long bursts of changes.) */
+#define WATCH_BATCH_MAX_DELAY	5000
+
+/**
+ * Carries a batch of changes in the watched source tree to the main
+ * application thread.
+ * Only files matching the project's file types are reported.
+ * @author Elad Lahav
+ */
+class ProjectWatchEvent : public QEvent
+{
+public:
+	/** The event's unique ID. */
+	enum { EventId = 6926 };
+
+	ProjectWatchEvent();
+	static int registerWatchEventType();
+	static int eventTypeId;
+
+	/** Files created in (or moved into) the source tree. */
+	QStringList m_slAdded;
+
+	/** Files deleted from (or moved out of) the source tree. */
+	QStringList m_slRemoved;
+
+	/** Existing files which were written to. */
+	QStringList m_slModified;
+
+	/** Directories deleted from (or moved out of) the source tree, along with
+		all the files they contained. */
+	QStringList m_slRemovedDirs;
+
+	/** true if changes were lost, in which case m_slAdded holds all files
+		found in the source tree when it was scanned again. */
+	bool m_bRescan;
+};
+
+/**
+ * Watches a project's source tree for files being created, deleted or
+ * modified, using inotify.
+ * The tree is watched by a separate thread, which adds a watch for each
+ * directory (hidden directories, such as those of version control systems,
+ * are skipped), and collects changes to files matching the project's file
+ * types. Changes are posted as a single ProjectWatchEvent once no change has
+ * occurred for WATCH_BATCH_DELAY milliseconds, so that a burst of changes
+ * (e.g., switching to a different branch, or cleaning the tree) results in a
+ * single update of the project.
+ * If the kernel's event queue overflows, the tree is scanned again, and all
+ * of its files are reported (@see rescan()).
+ * @author Elad Lahav
+ */
+class ProjectWatcher : public QThread
+{
+public:
+	ProjectWatcher(QObject*);
+	~ProjectWatcher();
+
+	void start(const QString&, const QString&);
+	void stop();
+
+protected:
+	virtual void run();
+
+private:
+	/** Pointer to an object that receives the watch events. */
+	QObject* m_pEventReceiver;
+
+	/** The root of the watched tree. */
+	QString m_sRoot;
+
+	/** Matches the names of project files. */
+	GlobMatcher m_glob;
+
+	/** The inotify descriptor. */
+	int m_nFd;
+
+	/** A pipe used to wake the thread when the watch is stopped. */
+	int m_arrPipe[2];
+
+	/** Maps watch descriptors to the paths of the watched directories. */
+	QHash<int, QByteArray> m_hashDirs;
+
+	/** Files added since the last batch was posted. */
+	QSet<QString> m_setAdded;
+
+	/** Files removed since the last batch was posted. */
+	QSet<QString> m_setRemoved;
+
+	/** Files modified since the last batch was posted. */
+	QSet<QString> m_setModified;
+
+	/** Directories removed since the last batch was posted. */
+	QStringList m_slRemovedDirs;
+
+	/** true if events were lost since the last batch was posted. */
+	bool m_bRescan;
+
+	/**
+	 * @return	true if there are changes which were not yet posted, false
+	 *			otherwise
+	 */
+	bool isPending() const {
+		return !m_setAdded.isEmpty() || !m_setRemoved.isEmpty() ||
+			!m_setModified.isEmpty() || !m_slRemovedDirs.isEmpty() ||
+			m_bRescan;
+	}
+
+	void watchDir(const QByteArray&, bool);
+	void removeDir(const QByteArray&);
+	void readEvents();
+	void rescan();
+	void addFile(const QString&);
+	void removeFile(const QString&);
+	void postBatch();
+};
+
+#endif
@@ -1,8 +1,9 @@
 #include <qfile.h>
 #include <klocale.h>
 #include "querypage.h"
-#include "queryview.h"
+#include "queryresultsview.h"
 #include "queryviewdriver.h"
+#include "pagefile.h"
 
 const char* QUERY_TYPES[][2] = {
 	{ "References to ", "REF " },
@@ -26,7 +27,8 @@ QueryPage::QueryPage(QWidget* pParent) :
 	QueryPageBase(pParent),
 	m_nType(CscopeFrontend::None)
 {
-	m_pView = new QueryView(this);
+	m_pResults = new QueryResultsView(this);
+	m_pView = m_pResults;
     m_pLayout = new QHBoxLayout(this);
 	m_pDriver = new QueryViewDriver(m_pView, this);
 
@@ -55,6 +57,9 @@ QueryPage::~QueryPage()
  */
 void QueryPage::query(uint nType, const QString& sText, bool bCase)
 {
+	// The records of a restored page are replaced
+	discardFile();
+	
 	m_nType = nType;
 	m_sText = sText;
 	m_bCase = bCase;
@@ -68,7 +73,8 @@ void QueryPage::query(uint nType, const QString& sText, bool bCase)
  */
 void QueryPage::refresh()
 {
-	m_pView->clear();
+	discardFile();
+	m_pResults->clear();
 	if (!m_sText.isEmpty())
 		m_pDriver->query(m_nType, m_sText, m_bCase);
 }
@@ -78,7 +84,8 @@ void QueryPage::refresh()
  */
 void QueryPage::clear()
 {
-	m_pView->clear();
+	discardFile();
+	m_pResults->clear();
 	m_nType = CscopeFrontend::None;
 	m_sText = QString();
 	m_sName = QString();
@@ -92,6 +99,22 @@ bool QueryPage::isRunning()
 	return m_pDriver->isRunning();
 }
 
+/**
+ * Selects the next record in the view.
+ */
+void QueryPage::selectNext()
+{
+	m_pResults->selectNext();
+}
+
+/**
+ * Selects the previous record in the view.
+ */
+void QueryPage::selectPrev()
+{
+	m_pResults->selectPrev();
+}
+
 /** 
  * Constructs a caption for this page, based on the query's type and text.
  * @param	bBrief	true to use a shortened version of the caption, false
@@ -104,18 +127,16 @@ QString QueryPage::getCaption(bool bBrief) const
 }
 
 /**
- * Creates a new query result item.
- * @param	sFile	The file name
+ * Creates a new query result record.
  * @param	sFunc	The function defining the scope of the result
+ * @param	sFile	The file name
  * @param	sLine	The line number
  * @param	sText	The contents of the line
  */
-void QueryPage::addRecord(const QString& sFile, const QString& sFunc,
+void QueryPage::addRecord(const QString& sFunc, const QString& sFile,
 	const QString& sLine, const QString& sText)
 {
-    QStringList s;
-    s << sFile << sFunc << sLine << sText;
-	new QTreeWidgetItem(m_pView, s);
+	m_pResults->addRecord(sFunc, sFile, sLine, sText);
 }
 
 /**
@@ -143,51 +164,93 @@ QString QueryPage::getFileName(const QString& sProjPath) const
 }
 
 /**
- * Reads query parameters from a file.
- * This mehtod is used as part of the loading process.
+ * Creates query result records for the records of a stored page.
+ * @param	lstRecords	The records to add, each holding the function name,
+ *						file path, line number and line text (in this order)
+ */
+void QueryPage::addRecords(const QList<QStringList>& lstRecords)
+{
+	m_pResults->addRecords(lstRecords);
+}
+
+/**
+ * Reads query parameters from a file written in the text format.
+ * This method is used as part of the loading process.
  * @param	str	A text stream set to the correct place in the file
  * @return	true if successful, false otherwise
  */
 bool QueryPage::readHeader(QTextStream& str)
 {
-	QString sTemp;
+	QString sName, sType;
 	
+	sName = str.readLine();
+	sType = str.readLine();
+	return setHeader(sName, sType, str.readLine());
+}
+
+/**
+ * Reads query parameters from the header fields of a page file.
+ * This method is used as part of the loading process.
+ * @param	file	The open page file
+ * @return	true if successful, false otherwise
+ */
+bool QueryPage::readHeader(const PageFile& file)
+{
+	return setHeader(file.getField(0), file.getField(1), file.getField(2));
+}
+
+/**
+ * Adds query parameters to the header fields of a page file.
+ * This method is used as part of the storing process.
+ * @param	file	The page file to write
+ */
+void QueryPage::writeHeader(PageFile& file)
+{
+	file.addField(m_sName);
+	file.addField(QString::number(m_nType));
+	file.addField(m_sText);
+}
+
+/**
+ * Adds the query's records to a page file.
+ * This method is used as part of the storing process.
+ * @param	file	The page file to write
+ */
+void QueryPage::writeRecords(PageFile& file)
+{
+	m_pResults->write(file);
+}
+
+/**
+ * Sets the query parameters read from a stored page.
+ * @param	sName	The caption of the query
+ * @param	sType	The type of the query, as a number
+ * @param	sText	The text of the query
+ * @return	true if all parameters are valid, false otherwise
+ */
+bool QueryPage::setHeader(const QString& sName, const QString& sType,
+	const QString& sText)
+{
 	// Read the query name
-	m_sName = str.readLine();
+	m_sName = sName;
 	if (m_sName == QString::null || m_sName.isEmpty())
 		return false;
 		
 	// Read the query's type
-	sTemp = str.readLine();
-	if (sTemp == QString::null || sTemp.isEmpty())
+	if (sType == QString::null || sType.isEmpty())
 		return false;
 	
 	// Convert the type string to an integer
-	m_nType = sTemp.toUInt();
+	m_nType = sType.toUInt();
 	if (m_nType >= CscopeFrontend::None) {
 		m_nType = CscopeFrontend::None;
 		return false;
 	}		
 				
 	// Read the query's text
-	m_sText = str.readLine();
+	m_sText = sText;
 	if (m_sText == QString::null || m_sText.isEmpty())
 		return false;
 
 	return true;
 }
-
-/**
- * Writes query parameters to a file.
- * This mehtod is used as part of the storing process.
- * @param	str	A text stream set to the correct place in the file
- */
-void QueryPage::writeHeader(QTextStream& str)
-{
-	str << m_sName << "\n" << m_nType << "\n" << m_sText << "\n";
-}
-
-void QueryPage::setRoot(QString &root)
-{
-    m_pDriver->setRoot(root);
-}
@@ -8,11 +8,12 @@
 #include "cscopefrontend.h"
 
 class QueryViewDriver;
+class QueryResultsView;
 
 /**
  * A QueryWidget page that runs and displays Cscope queries.
  * The page uses a QueryViewDriver object to run queries, and an embedded
- * QueryView widget for displaying query results.
+ * QueryResultsView widget for displaying query results.
  * @author Elad Lahav
  */
 class QueryPage : public QueryPageBase
@@ -27,7 +28,9 @@ public:
 	void refresh();
 	void clear();
 	bool isRunning();
-    void setRoot(QString &root);
+	
+	virtual void selectNext();
+	virtual void selectPrev();
 	
 	virtual QString getCaption(bool bBrief = false) const;
 
@@ -35,8 +38,11 @@ protected:
 	virtual void addRecord(const QString&, const QString&, const QString&,
 		const QString&);
 	virtual QString getFileName(const QString&) const;
+	virtual void addRecords(const QList<QStringList>&);
 	virtual bool readHeader(QTextStream&);
-	virtual void writeHeader(QTextStream&);
+	virtual bool readHeader(const PageFile&);
+	virtual void writeHeader(PageFile&);
+	virtual void writeRecords(PageFile&);
 
 private:
 	/** The type of query whose results are listed on this page. */
@@ -52,7 +58,12 @@ private:
 		its text. */
 	QString m_sName;
 	
+	bool setHeader(const QString&, const QString&, const QString&);
+	
 private:
+	/** The embedded view (also referenced as m_pView). */
+	QueryResultsView* m_pResults;
+	
 	/** Runs Cscope queries whose results are displayed in this page. */
 	QueryViewDriver* m_pDriver;
 };
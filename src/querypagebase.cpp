@@ -1,9 +1,11 @@
-#include <QTreeWidgetItemIterator>
 #include <qfile.h>
+#include <qtimer.h>
 #include "querypagebase.h"
-#include "queryview.h"
 #include "kscopeconfig.h"
+#include "pathtable.h"
+#include "pagefile.h"
 
+/** The first line of page files written in the text format. */
 #define FILE_VERSION	"VERSION=2"
 
 /**
@@ -13,15 +15,24 @@
  */
 QueryPageBase::QueryPageBase(QWidget* pParent) :
 	QWidget(pParent),
-	m_bLocked(false)
+	m_bLocked(false),
+	m_pFile(NULL),
+	m_bKeepFile(false)
 {
 }
 
 /**
  * Class destructor.
+ * The file from which the page was restored is deleted, unless it was
+ * never shown and is kept as the page's stored file.
  */
 QueryPageBase::~QueryPageBase()
 {
+	if (m_pFile != NULL) {
+		delete m_pFile;
+		if (!m_bKeepFile)
+			QFile::remove(m_sFileName);
+	}
 }
 
 /**
@@ -40,19 +51,157 @@ void QueryPageBase::applyPrefs()
 
 /**
  * Restores a locked query from the given query file.
- * NOTE: The query file is deleted when loading is complete.
+ * Only the header is read from files in the binary format. The records are
+ * added once the page is shown (@see loadRecords()).
+ * NOTE: The query file is deleted once all records were read.
  * @param	sProjPath	The full path of the project directory
  * @param	sFileName	The name of the query file to load
  * @return	true if successful, false otherwise
  */
-bool QueryPageBase::load(const QString& sProjPath, const QString& sFileName, 
-        const QString &srcRoot)
+bool QueryPageBase::load(const QString& sProjPath, const QString& sFileName)
+{
+	QString sPath;
+	
+	discardFile();
+	sPath = sProjPath + "/" + sFileName;
+	
+	// Files written by older versions are imported at once
+	m_pFile = new PageFile();
+	if (!m_pFile->open(sPath)) {
+		delete m_pFile;
+		m_pFile = NULL;
+		return loadText(sPath);
+	}
+	
+	m_sFileName = sPath;
+	m_bKeepFile = false;
+	if (!readHeader(*m_pFile)) {
+		discardFile();
+		return false;
+	}
+	
+	// Defer the records until the page is shown (pages are usually made
+	// current while restored, but only the last one remains visible)
+	if (isVisible())
+		QTimer::singleShot(0, this, SLOT(slotLoadVisible()));
+	
+	return true;
+}
+
+/**
+ * Adds the records of a restored page, unless they were already added.
+ * The file from which the page was restored is deleted.
+ */
+void QueryPageBase::loadRecords()
+{
+	QList<QStringList> lstRecords;
+	
+	if (m_pFile == NULL)
+		return;
+	
+	m_pFile->getRecords(lstRecords);
+	discardFile();
+	addRecords(lstRecords);
+}
+
+/**
+ * Writes the contents of the page to a file.
+ * This method is called for pages that shoukld be stored before the owner 
+ * project is closed (@see shouldSave()).
+ * A restored page that was never shown is stored in the file from which it
+ * was restored.
+ * @param	sProjPath	The full path of the project directory
+ * @param	sFileName	Holds the file name to which the page was saved, upon
+ *						return
+ * @return	true if successful, false otherwise
+ */
+bool QueryPageBase::save(const QString& sProjPath, QString& sFileName)
+{
+	PageFile file;
+	
+	// The records are already stored
+	if (m_pFile != NULL) {
+		sFileName = m_sFileName.mid(m_sFileName.lastIndexOf('/') + 1);
+		m_bKeepFile = true;
+		return true;
+	}
+	
+	// Get the file name to use
+	sFileName = getFileName(sProjPath);
+	if (sFileName.isEmpty())
+		return false;
+		
+	writeHeader(file);
+	writeRecords(file);
+	
+	return file.write(sProjPath + "/" + sFileName);
+}
+
+/**
+ * Adds the records of a restored page once the page is first shown.
+ * @param	pEvent	The show event
+ */
+void QueryPageBase::showEvent(QShowEvent* pEvent)
+{
+	QWidget::showEvent(pEvent);
+	loadRecords();
+}
+
+/**
+ * Adds the records of a restored page, if the page is still shown.
+ * This slot is called after the page is restored while shown.
+ */
+void QueryPageBase::slotLoadVisible()
+{
+	if (isVisible())
+		loadRecords();
+}
+
+/**
+ * Creates list items for records read from a stored file.
+ * The default implementation adds the records one by one.
+ * @param	lstRecords	The records to add, each holding the function name,
+ *						file path, line number and line text (in this order)
+ */
+void QueryPageBase::addRecords(const QList<QStringList>& lstRecords)
+{
+	QList<QStringList>::ConstIterator itr;
+	
+	for (itr = lstRecords.begin(); itr != lstRecords.end(); ++itr)
+		addRecord((*itr)[0], (*itr)[1], (*itr)[2], (*itr)[3]);
+}
+
+/**
+ * Deletes the file from which the page was restored, without adding the
+ * records it holds.
+ * Used when the records are added, or when they are no longer required (e.g.,
+ * the query is run again.)
+ */
+void QueryPageBase::discardFile()
+{
+	if (m_pFile == NULL)
+		return;
+	
+	delete m_pFile;
+	m_pFile = NULL;
+	m_bKeepFile = false;
+	QFile::remove(m_sFileName);
+}
+
+/**
+ * Imports a locked query from a file written in the text format of older
+ * versions, 4 lines per record.
+ * NOTE: The query file is deleted when loading is complete.
+ * @param	sPath	The full path of the query file
+ * @return	true if successful, false otherwise
+ */
+bool QueryPageBase::loadText(const QString& sPath)
 {
 	QString sTemp, sFile, sFunc, sLine, sText;
 	int nState;
 	
 	// Try to open the query file for reading
-	QFile file(sProjPath + "/" + sFileName);
+	QFile file(sPath);
 	if (!file.open(QIODevice::ReadOnly))
 		return false;
 	
@@ -77,16 +226,15 @@ bool QueryPageBase::load(const QString& sProjPath, const QString& sFileName,
 		nState = 0;
 		while (sTemp != QString::null) {
 			switch (nState) {
-			// File path
+			// Function name
 			case 0:
-				sFile = sTemp;
-                if (srcRoot != "/")
-                    sFile.replace(srcRoot, "$");
+				sFunc = sTemp;
 				break;
 				
-			// Function name
+			// File path (older files store paths relative to the source
+			// root)
 			case 1:
-				sFunc = sTemp;
+				sFile = PathTable::toPath(sTemp);
 				break;
 				
 			// Line number
@@ -97,7 +245,7 @@ bool QueryPageBase::load(const QString& sProjPath, const QString& sFileName,
 			// Text string
 			case 3:
 				sText = sTemp;
-				addRecord(sFile, sFunc, sLine, sText);
+				addRecord(sFunc, sFile, sLine, sText);
 				break;
 			}
 			
@@ -111,60 +259,3 @@ bool QueryPageBase::load(const QString& sProjPath, const QString& sFileName,
 	
 	return true;
 }
-
-/**
- * Writes the contents of the page to a file.
- * This method is called for pages that shoukld be stored before the owner 
- * project is closed (@see shouldSave()).
- * @param	sProjPath	The full path of the project directory
- * @param	sFileName	Holds the file name to which the page was saved, upon
- *						return
- * @return	true if successful, false otherwise
- */
-bool QueryPageBase::save(const QString& sProjPath, QString& sFileName)
-{
-	QTreeWidgetItemIterator itr(m_pView);
-
-	// Get the file name to use
-	sFileName = getFileName(sProjPath);
-	if (sFileName.isEmpty())
-		return false;
-		
-	// Open the query file for writing
-	QFile file(sProjPath + "/" + sFileName);
-	if (!file.open(QIODevice::WriteOnly))
-		return false;
-	
-	QTextStream str(&file);
-	
-	// Write the version string
-	str << FILE_VERSION << "\n";
-	
-	writeHeader(str);
-		
-	// Write all records
-    for (; *itr; ++itr) {
-		str << (*itr)->text(0) << "\n" 
-			<< (*itr)->text(1) << "\n"
-			<< (*itr)->text(2) << "\n"
-			<< (*itr)->text(3) << "\n";
-	}
-	
-	return true;
-}
-
-/**
- * Selects the next record in the view.
- */
-void QueryPageBase::selectNext()
-{
-	m_pView->selectNext();
-}
-
-/**
- * Selects the previous record in the view.
- */
-void QueryPageBase::selectPrev()
-{
-	m_pView->selectPrev();
-}
@@ -4,8 +4,11 @@
 #include <QWidget>
 #include <QHBoxLayout>
 #include <QTextStream>
+#include <QTreeView>
+#include <qlist.h>
+#include <qstringlist.h>
 
-class QueryView;
+class PageFile;
 
 /**
  * Defines a page in a QueryWidget's tab widget.
@@ -13,8 +16,13 @@ class QueryView;
  * the common behaviour for all pages, which includes appearance, display
  * of tab text, page locking, storage and retrieval of information to
  * and from files and basic navigation.
- * Each page embeds a list widget derived from QueryView. The actual type
- * of widget is defined by the different page classes.
+ * Pages are stored in binary files (@see PageFile). When a page is restored,
+ * only the header of its file is read. The records are added once the page
+ * is first shown, so that restoring many pages does not delay the opening
+ * of a project. Text files written by older versions are still read.
+ * Each page embeds a list widget derived from QTreeView (either a QueryView
+ * or a QueryResultsView). The actual type of widget is defined by the
+ * different page classes.
  * @author Elad Lahav
  */
 class QueryPageBase : public QWidget
@@ -25,10 +33,19 @@ public:
     ~QueryPageBase();
 
 	void applyPrefs();
-	bool load(const QString&, const QString&, const QString &srcRoot);
+	bool load(const QString&, const QString&);
 	bool save(const QString&, QString&);
-	void selectNext();
-	void selectPrev();
+	void loadRecords();
+	
+	/**
+	 * Selects the next record in the view.
+	 */
+	virtual void selectNext() = 0;
+	
+	/**
+	 * Selects the previous record in the view.
+	 */
+	virtual void selectPrev() = 0;
 	
 	/**
 	 * Determines whether this page can be locked.
@@ -37,6 +54,12 @@ public:
 	 */
 	virtual bool canLock() { return true; }
 	
+	/**
+	 * Repaints the records shown in the page (e.g., after the source root
+	 * has changed).
+	 */
+	void updateView() { m_pView->viewport()->update(); }
+	
 	/**
 	 * Locks or unlocks this page.
 	 * @param	bLocked	true to lock the page, false to unlock it.
@@ -76,22 +99,37 @@ signals:
 protected:
     QHBoxLayout *m_pLayout;
 	/** The embedded list. */
-	QueryView* m_pView;
+	QTreeView* m_pView;
 	
 	/** Indicates whether this page is locked. A locked page is never
 		overriden by new data, and is also saved to a disc file when the
 		session is closed. */
 	bool m_bLocked;
 	
+	/** The file from which the records of a restored page are read, NULL
+		if the page holds all of its records. */
+	PageFile* m_pFile;
+	
+	/** The full path of the above file. */
+	QString m_sFileName;
+	
+	/** Set when the file from which the page was restored is kept as the
+		page's stored file, so that it is not deleted. */
+	bool m_bKeepFile;
+	
+	virtual void showEvent(QShowEvent*);
+	virtual void addRecords(const QList<QStringList>&);
+	void discardFile();
+	
 	/**
 	 * Creates a new list item and adds it to the embedded view.
 	 * This method is used to add records read from a stored file.
-	 * @param	sFile	The "File" field of the record
 	 * @param	sFunc	The "Function" field of the record
+	 * @param	sFile	The full path of the record's file
 	 * @param	sLine	The "Line" field of the record
 	 * @param	sText	The "Text" field of the record
 	 */
-	virtual void addRecord(const QString& sFile, const QString& sFunc, 
+	virtual void addRecord(const QString& sFunc, const QString& sFile, 
 		const QString& sLine, const QString& sText) = 0;
 	
 	/**
@@ -104,7 +142,8 @@ protected:
 	virtual QString getFileName(const QString& sProjPath) const = 0;
 	
 	/**
-	 * Tries to read the file header of a stored page.
+	 * Tries to read the file header of a stored page, written in the text
+	 * format of older versions.
 	 * The contents of the header differ among inheriting classes.
 	 * @param	str	A text stream initialised to the open page file
 	 * @return	true if the header was read successfully and contains the
@@ -113,11 +152,32 @@ protected:
 	virtual bool readHeader(QTextStream& str) = 0;
 	
 	/**
-	 * Writes a header to a page's file.
+	 * Tries to read the header fields of a stored page.
 	 * The contents of the header differ among inheriting classes.
-	 * @param	str	A text stream initialised to the open page file
+	 * @param	file	The open page file
+	 * @return	true if the header was read successfully and contains the
+	 *			expected information, false otherwise
+	 */
+	virtual bool readHeader(const PageFile& file) = 0;
+	
+	/**
+	 * Adds the header fields of the page to a page file.
+	 * The contents of the header differ among inheriting classes.
+	 * @param	file	The page file to write
+	 */
+	virtual void writeHeader(PageFile& file) = 0;
+	
+	/**
+	 * Adds the records of the page to a page file.
+	 * @param	file	The page file to write
 	 */
-	virtual void writeHeader(QTextStream& str) = 0;
+	virtual void writeRecords(PageFile& file) = 0;
+	
+private:
+	bool loadText(const QString&);
+	
+private slots:
+	void slotLoadVisible();
 };
 
 #endif
@@ -7,8 +7,7 @@
  * @param	szName	Optional object name
  */
 QueryResultsMenu::QueryResultsMenu(QWidget* pParent) :
-	QMenu(pParent),
-	m_pItem(NULL)
+	QMenu(pParent)
 {
 	// Create the menu
 	m_pViewSourceAction = addAction(i18n("&View Source"), this, SLOT(slotViewSource()));
@@ -18,6 +17,9 @@ QueryResultsMenu::QueryResultsMenu(QWidget* pParent) :
 	addSeparator();
 	m_pFilterAction = addAction(i18n("&Filter..."), this, SLOT(slotFilter()));
 	m_pShowAllAction = addAction(i18n("&Show All"), this, SIGNAL(showAll()));
+	m_pExpandAction = addAction(i18n("&Expand to Depth..."), this,
+		SIGNAL(expand()));
+	m_pExpandAction->setVisible(false);
 	addSeparator();
 	m_pRemoveAction = addAction(i18n("&Remove Item"), this, SLOT(slotRemove()));
 }
@@ -29,21 +31,31 @@ QueryResultsMenu::~QueryResultsMenu()
 {
 }
 
+/**
+ * Shows or hides the "Expand to Depth..." menu item.
+ * @param	bExpandable	true to show the item, false to hide it
+ */
+void QueryResultsMenu::setExpandable(bool bExpandable)
+{
+	m_pExpandAction->setVisible(bExpandable);
+}
+
 /**
  * Displays the popup-menu at the requested coordinates.
- * @param	pItem	The item on which the menu was requested
+ * @param	idx		The index on which the menu was requested (may belong to
+ *					any view whose model has the columns of a QueryView)
  * @param	ptPos	The requested position for the menu
  * @param	nCol	The column over which the menu was requested, -1 if no
  *					column is associated with the request
  */
-void QueryResultsMenu::slotShow(QTreeWidgetItem* pItem, const QPoint& ptPos, 
+void QueryResultsMenu::slotShow(const QModelIndex& idx, const QPoint& ptPos, 
 	int nCol)
 {
-	// Save the requested item and column number to use in signals
-	m_pItem = pItem;
+	// Save the requested index and column number to use in signals
+	m_idx = idx;
 	m_nCol = nCol;
 	
-	if (m_pItem == NULL) {
+	if (!m_idx.isValid()) {
 		// No item selected, disable everything but the "Filter" and "Show All" 
         m_pViewSourceAction->setEnabled(false);
 		m_pFindDefAction->setEnabled(false);
@@ -57,7 +69,8 @@ void QueryResultsMenu::slotShow(QTreeWidgetItem* pItem, const QPoint& ptPos,
 			
 		// The "Find Definition" item should only be enabled if the mouse
 		// was clicked over a valid function name 
-        m_pFindDefAction->setEnabled((m_nCol == 0) && (m_pItem->text(0) != "<global>"));
+        m_pFindDefAction->setEnabled((m_nCol == 0) && (m_idx.sibling(m_idx.row(), 0).data().toString() !=
+			"<global>"));
 
 		// Set menu contents according to the column number
 		switch (m_nCol) {
@@ -88,8 +101,8 @@ void QueryResultsMenu::slotShow(QTreeWidgetItem* pItem, const QPoint& ptPos,
  */
 void QueryResultsMenu::slotViewSource()
 {
-	if (m_pItem != NULL)
-		emit viewSource(m_pItem);
+	if (m_idx.isValid())
+		emit viewSource(m_idx);
 }
 
 /**
@@ -98,8 +111,8 @@ void QueryResultsMenu::slotViewSource()
  */
 void QueryResultsMenu::slotFindDef()
 {
-	if (m_pItem != NULL)
-		emit findDef(m_pItem->text(0));
+	if (m_idx.isValid())
+		emit findDef(m_idx.sibling(m_idx.row(), 0).data().toString());
 }
 
 /**
@@ -108,8 +121,8 @@ void QueryResultsMenu::slotFindDef()
  */
 void QueryResultsMenu::slotCopy()
 {
-	if (m_pItem != NULL)
-		emit copy(m_pItem, m_nCol);
+	if (m_idx.isValid())
+		emit copy(m_idx, m_nCol);
 }
 
 /**
@@ -127,6 +140,6 @@ void QueryResultsMenu::slotFilter()
  */
 void QueryResultsMenu::slotRemove()
 {
-	if (m_pItem != NULL)
-		emit remove(m_pItem);
+	if (m_idx.isValid())
+		emit remove(m_idx);
 } 
@@ -2,8 +2,7 @@
 #define QUERYRESULTSMENU_H
 
 #include <QMenu>
-#include <QTreeWidget>
-#include <QTreeWidgetItem>
+#include <QPersistentModelIndex>
 #include <qregexp.h>
 
 /**
@@ -13,6 +12,8 @@
  * This class assumes a certain ordering of the list columns. If an owner
  * object uses a different configuration, it needs to call setColumns() after
  * constructing the object.
+ * Views showing a tree of calls can also add an "Expand to Depth..." item,
+ * using setExpandable().
  * @author Elad Lahav
  */
 class QueryResultsMenu : public QMenu
@@ -23,15 +24,17 @@ public:
     QueryResultsMenu(QWidget* pParent = 0);
     ~QueryResultsMenu();
 	
+	void setExpandable(bool);
+	
 public slots:		
-	void slotShow(QTreeWidgetItem*, const QPoint&, int nCol);
+	void slotShow(const QModelIndex&, const QPoint&, int nCol);
 	
 signals:
 	/** 
 	 * Indicates that the "View Source" menu item was selected. 
-	 * @param	pItem	The item for which the menu was displayed
+	 * @param	idx		The index for which the menu was displayed
 	 */
-	void viewSource(QTreeWidgetItem* pItem);
+	void viewSource(const QModelIndex& idx);
 	 
 	/**
 	 * Indicates that the "Find Definition" menu item was selected.
@@ -41,10 +44,10 @@ signals:
 	
 	/** 
 	 * Indicates that the "Copy [Column]" menu item was selected. 
-	 * @param	pItem	The item for which the menu was displayed
+	 * @param	idx		The index for which the menu was displayed
 	 * @param	nCol	The requested column
 	 */
-	void copy(QTreeWidgetItem* pItem, int nCol);
+	void copy(const QModelIndex& idx, int nCol);
 	
 	/**
 	 * Indicates that the "Filter..." menu item was selected.
@@ -57,11 +60,16 @@ signals:
 	 */
 	void showAll();
 	
+	/**
+	 * Indicates that the "Expand to Depth..." menu item was selected.
+	 */
+	void expand();
+	
 	/** 
 	 * Indicates that the "Remove Item" menu item was selected. 
-	 * @param	pItem	The item for which the menu was displayed
+	 * @param	idx		The index for which the menu was displayed
 	 */
-	void remove(QTreeWidgetItem* pItem);
+	void remove(const QModelIndex& idx);
 	
 private:
     QAction *m_pViewSourceAction;
@@ -69,10 +77,12 @@ private:
     QAction *m_pCopyAction;
     QAction *m_pFilterAction;
     QAction *m_pShowAllAction;
+    QAction *m_pExpandAction;
     QAction *m_pRemoveAction;
 		
-	/** The item for which the popup menu is provided (cannot be NULL). */
-	QTreeWidgetItem* m_pItem;
+	/** The index for which the popup menu is provided (invalid if the menu
+		was not requested over a record). */
+	QPersistentModelIndex m_idx;
 	
 	/** The list column for which the query was invoked. */
 	int m_nCol;
@@ -0,0 +1,428 @@
+#include <klocale.h>
+#include "queryresultsmodel.h"
+#include "queryview.h"
+#include "pathtable.h"
+
+/**
+ * Orders the records of a QueryResultsModel by one of its columns.
+ * Line numbers are compared numerically, other columns by their text. Records
+ * with equal values keep the order in which they were added.
+ * @author Elad Lahav
+ */
+class QueryResultsLessThan
+{
+public:
+	/**
+	 * Class constructor.
+	 * @param	pModel	The model whose records are sorted
+	 * @param	nCol	The column by which to sort
+	 * @param	bAscend	true to sort in ascending order, false otherwise
+	 */
+	QueryResultsLessThan(const QueryResultsModel* pModel, int nCol,
+		bool bAscend) : m_pModel(pModel), m_nCol(nCol), m_bAscend(bAscend) {}
+
+	/**
+	 * @param	nLeft	The index of a record
+	 * @param	nRight	The index of another record
+	 * @return	true if the first record should be shown before the second,
+	 *			false otherwise
+	 */
+	bool operator()(int nLeft, int nRight) const {
+		int nResult;
+
+		if (!m_bAscend)
+			qSwap(nLeft, nRight);
+
+		switch (m_nCol) {
+		case QueryView::QUERY_FUNC_COL:
+			nResult = m_pModel->m_slFuncs[m_pModel->m_vecFuncs[nLeft]].compare(
+				m_pModel->m_slFuncs[m_pModel->m_vecFuncs[nRight]]);
+			break;
+
+		case QueryView::QUERY_FILE_COL:
+			nResult = PathTable::getPath(m_pModel->m_vecFiles[nLeft]).compare(
+				PathTable::getPath(m_pModel->m_vecFiles[nRight]));
+			break;
+
+		case QueryView::QUERY_LINE_COL:
+			nResult = (m_pModel->m_vecLines[nLeft] >
+				m_pModel->m_vecLines[nRight]) -
+				(m_pModel->m_vecLines[nLeft] < m_pModel->m_vecLines[nRight]);
+			break;
+
+		case QueryView::QUERY_TEXT_COL:
+			nResult = m_pModel->getText(nLeft, m_nCol).compare(
+				m_pModel->getText(nRight, m_nCol));
+			break;
+
+		default:
+			// Restore the order in which records were added
+			nResult = 0;
+		}
+
+		if (nResult != 0)
+			return nResult < 0;
+
+		return m_bAscend ? (nLeft < nRight) : (nRight < nLeft);
+	}
+
+private:
+	/** The model whose records are sorted. */
+	const QueryResultsModel* m_pModel;
+
+	/** The column by which to sort. */
+	int m_nCol;
+
+	/** Whether records are sorted in ascending order. */
+	bool m_bAscend;
+};
+
+/**
+ * Class constructor.
+ * @param	pParent	The parent object
+ */
+QueryResultsModel::QueryResultsModel(QObject* pParent) :
+	QAbstractItemModel(pParent)
+{
+}
+
+/**
+ * Class destructor.
+ */
+QueryResultsModel::~QueryResultsModel()
+{
+}
+
+/**
+ * Appends a block of records to the model.
+ * All records are shown at the end of the view, in a single insertion.
+ * @param	lstRecords	The records to add, each holding the function name,
+ *						file path, line number and line text (in this order)
+ */
+void QueryResultsModel::addRecords(const QList<QStringList>& lstRecords)
+{
+	QList<QStringList>::ConstIterator itr;
+	int nRecord, nRow;
+
+	if (lstRecords.isEmpty())
+		return;
+
+	nRecord = m_vecLines.count();
+	nRow = m_vecRows.count();
+	m_baRemoved.resize(nRecord + lstRecords.count());
+
+	beginInsertRows(QModelIndex(), nRow, nRow + lstRecords.count() - 1);
+
+	for (itr = lstRecords.begin(); itr != lstRecords.end(); ++itr) {
+		m_vecFuncs.append(intern((*itr)[QueryView::QUERY_FUNC_COL], m_slFuncs,
+			m_hashFuncs));
+		m_vecFiles.append(PathTable::getId((*itr)[QueryView::QUERY_FILE_COL]));
+		m_vecLines.append((*itr)[QueryView::QUERY_LINE_COL].toUInt());
+		m_vecText.append(m_baText.size());
+		m_baText.append((*itr)[QueryView::QUERY_TEXT_COL].toUtf8());
+		m_vecRows.append(nRecord++);
+	}
+
+	endInsertRows();
+}
+
+/**
+ * Appends a single record to the model.
+ * @param	sFunc	The name of the function
+ * @param	sFile	The file path
+ * @param	sLine	The line number in the above file
+ * @param	sText	The line's text
+ */
+void QueryResultsModel::addRecord(const QString& sFunc, const QString& sFile,
+	const QString& sLine, const QString& sText)
+{
+	addRecords(QList<QStringList>() << (QStringList() << sFunc << sFile
+		<< sLine << sText));
+}
+
+/**
+ * Removes all records.
+ */
+void QueryResultsModel::clear()
+{
+	m_slFuncs.clear();
+	m_hashFuncs.clear();
+	m_vecFiles.clear();
+	m_vecFuncs.clear();
+	m_vecLines.clear();
+	m_vecText.clear();
+	m_baText.clear();
+	m_baRemoved.clear();
+	m_vecRows.clear();
+
+	reset();
+}
+
+/**
+ * Hides all shown records that do not meet the given search criteria.
+ * The search is incremental: only shown records are checked, so that a new
+ * search goes over the results of the previous one.
+ * File paths and function names are matched once for each distinct string,
+ * rather than once for each record.
+ * @param	nCol	The column to search in
+ * @param	re		The pattern to look for
+ * @param	bNegate	true to hide records matching the pattern, false to hide
+ *					records that do not match it
+ */
+void QueryResultsModel::filter(int nCol, const QRegExp& re, bool bNegate)
+{
+	QVector<int> vecRows;
+	QVector<char> vecMatches;
+	int i;
+
+	if (nCol == QueryView::QUERY_FUNC_COL)
+		vecMatches.fill(-1, m_slFuncs.count());
+	else if (nCol == QueryView::QUERY_FILE_COL)
+		vecMatches.fill(-1, PathTable::count());
+
+	vecRows.reserve(m_vecRows.count());
+	for (i = 0; i < m_vecRows.count(); i++) {
+		if (match(m_vecRows[i], nCol, re, vecMatches) != bNegate)
+			vecRows.append(m_vecRows[i]);
+	}
+
+	m_vecRows = vecRows;
+	reset();
+}
+
+/**
+ * Shows all records, except for those removed by the user, in the order in
+ * which they were added.
+ */
+void QueryResultsModel::showAll()
+{
+	int i;
+
+	m_vecRows.clear();
+	m_vecRows.reserve(m_vecLines.count());
+	for (i = 0; i < m_vecLines.count(); i++) {
+		if (!m_baRemoved.testBit(i))
+			m_vecRows.append(i);
+	}
+
+	reset();
+}
+
+/**
+ * Removes a record from the view.
+ * The record's data remains in the model's tables, but the record is no
+ * longer shown, or written when the results are saved.
+ * @param	nRow	The row showing the record
+ */
+void QueryResultsModel::removeRecord(int nRow)
+{
+	if (nRow < 0 || nRow >= m_vecRows.count())
+		return;
+
+	beginRemoveRows(QModelIndex(), nRow, nRow);
+	m_baRemoved.setBit(m_vecRows[nRow]);
+	m_vecRows.remove(nRow);
+	endRemoveRows();
+}
+
+/**
+ * @param	nRecord	The index of a record
+ * @param	nCol	A column of the model
+ * @return	The text of the record's field (the full path, for the file
+ *			column)
+ */
+QString QueryResultsModel::getText(int nRecord, int nCol) const
+{
+	int nStart, nEnd;
+
+	switch (nCol) {
+	case QueryView::QUERY_FUNC_COL:
+		return m_slFuncs[m_vecFuncs[nRecord]];
+
+	case QueryView::QUERY_FILE_COL:
+		return PathTable::getPath(m_vecFiles[nRecord]);
+
+	case QueryView::QUERY_LINE_COL:
+		// Records without a line number (e.g., "No results") show nothing
+		if (m_vecLines[nRecord] == 0)
+			return "";
+
+		return QString::number(m_vecLines[nRecord]);
+
+	case QueryView::QUERY_TEXT_COL:
+		nStart = m_vecText[nRecord];
+		nEnd = (nRecord + 1 < m_vecText.count()) ? m_vecText[nRecord + 1] :
+			m_baText.size();
+		return QString::fromUtf8(m_baText.constData() + nStart,
+			nEnd - nStart);
+	}
+
+	return "";
+}
+
+/**
+ * @param	nRow	The row of the requested index
+ * @param	nCol	The column of the requested index
+ * @param	parent	The parent index (must be invalid, since the model is
+ *					flat)
+ * @return	An index for the given row and column
+ */
+QModelIndex QueryResultsModel::index(int nRow, int nCol,
+	const QModelIndex& parent) const
+{
+	if (parent.isValid() || nRow < 0 || nRow >= m_vecRows.count() ||
+		nCol < 0 || nCol > QueryView::QUERY_TEXT_COL) {
+		return QModelIndex();
+	}
+
+	return createIndex(nRow, nCol);
+}
+
+/**
+ * @return	An invalid index, since the model is flat
+ */
+QModelIndex QueryResultsModel::parent(const QModelIndex&) const
+{
+	return QModelIndex();
+}
+
+/**
+ * @param	parent	The parent index
+ * @return	The number of shown records for the root index, 0 otherwise
+ */
+int QueryResultsModel::rowCount(const QModelIndex& parent) const
+{
+	if (parent.isValid())
+		return 0;
+
+	return m_vecRows.count();
+}
+
+/**
+ * @return	The number of columns (function, file, line and text)
+ */
+int QueryResultsModel::columnCount(const QModelIndex&) const
+{
+	return QueryView::QUERY_TEXT_COL + 1;
+}
+
+/**
+ * Provides the text of a record's field.
+ * Text is only constructed for rows that are actually painted. File paths
+ * are shown relative to the project's source root.
+ * @param	idx		The index of the requested field
+ * @param	nRole	The requested data role
+ * @return	The field's text for the display role, an invalid value otherwise
+ */
+QVariant QueryResultsModel::data(const QModelIndex& idx, int nRole) const
+{
+	if (!idx.isValid() || nRole != Qt::DisplayRole)
+		return QVariant();
+
+	if (idx.column() == QueryView::QUERY_FILE_COL)
+		return PathTable::getDisplay(m_vecFiles[m_vecRows[idx.row()]]);
+
+	return getText(m_vecRows[idx.row()], idx.column());
+}
+
+/**
+ * @param	nSection	A column of the model
+ * @param	orient		The orientation of the header
+ * @param	nRole		The requested data role
+ * @return	The title of the column
+ */
+QVariant QueryResultsModel::headerData(int nSection, Qt::Orientation orient,
+	int nRole) const
+{
+	if (orient != Qt::Horizontal || nRole != Qt::DisplayRole)
+		return QVariant();
+
+	switch (nSection) {
+	case QueryView::QUERY_FUNC_COL:
+		return i18n("Function");
+
+	case QueryView::QUERY_FILE_COL:
+		return i18n("File");
+
+	case QueryView::QUERY_LINE_COL:
+		return i18n("Line");
+
+	case QueryView::QUERY_TEXT_COL:
+		return i18n("Text");
+	}
+
+	return QVariant();
+}
+
+/**
+ * Reorders the shown records.
+ * Only the list of shown records is sorted, the records themselves are not
+ * moved.
+ * @param	nCol	The column by which to sort, -1 to restore the order in
+ *					which records were added
+ * @param	order	The sort order
+ */
+void QueryResultsModel::sort(int nCol, Qt::SortOrder order)
+{
+	emit layoutAboutToBeChanged();
+	qSort(m_vecRows.begin(), m_vecRows.end(),
+		QueryResultsLessThan(this, nCol, order == Qt::AscendingOrder));
+	emit layoutChanged();
+}
+
+/**
+ * Looks up a string in a string table, adding it if not found.
+ * @param	sText	The string to look up
+ * @param	slTable	The string table
+ * @param	hashIndex	Maps the strings in the table to their indices
+ * @return	The index of the string in the table
+ */
+int QueryResultsModel::intern(const QString& sText, QStringList& slTable,
+	QHash<QString, int>& hashIndex)
+{
+	QHash<QString, int>::ConstIterator itr;
+
+	itr = hashIndex.find(sText);
+	if (itr != hashIndex.constEnd())
+		return *itr;
+
+	slTable.append(sText);
+	hashIndex.insert(sText, slTable.count() - 1);
+	return slTable.count() - 1;
+}
+
+/**
+ * Matches a field of a record against a pattern.
+ * @param	nRecord		The index of the record
+ * @param	nCol		The column of the field
+ * @param	re			The pattern to look for
+ * @param	vecMatches	Caches the result for each entry of the string table
+ *						referenced by the column (-1 for unmatched entries)
+ * @return	true if the field matches, false otherwise
+ */
+bool QueryResultsModel::match(int nRecord, int nCol, const QRegExp& re,
+	QVector<char>& vecMatches) const
+{
+	int nString;
+
+	switch (nCol) {
+	case QueryView::QUERY_FUNC_COL:
+		nString = m_vecFuncs[nRecord];
+		break;
+
+	case QueryView::QUERY_FILE_COL:
+		nString = m_vecFiles[nRecord];
+		break;
+
+	default:
+		return re.indexIn(getText(nRecord, nCol)) != -1;
+	}
+
+	// Match paths as they are displayed
+	if (vecMatches[nString] == -1) {
+		vecMatches[nString] = (re.indexIn(nCol == QueryView::QUERY_FILE_COL ?
+			PathTable::getDisplay(nString) : getText(nRecord, nCol)) != -1);
+	}
+
+	return vecMatches[nString];
+}
@@ -0,0 +1,106 @@
+#ifndef QUERYRESULTSMODEL_H
+#define QUERYRESULTSMODEL_H
+
+#include <QAbstractItemModel>
+#include <qstringlist.h>
+#include <qbytearray.h>
+#include <qvector.h>
+#include <qbitarray.h>
+#include <qhash.h>
+#include <qregexp.h>
+
+/**
+ * A flat item model holding the records of a query.
+ * Records are kept in columnar form: file paths are stored once in the
+ * project's PathTable, and function names in a string table of the model, so
+ * that records refer to them by index. Line
+ * numbers are kept as integers, and the text of all records is appended to
+ * a single buffer, with each record holding the offset of its text.
+ * Records are never moved once added. Instead, the model maintains a list of
+ * the records shown in the view, in display order, which is rebuilt for
+ * sorting and filtering.
+ * The model has 4 columns, arranged in the same order as the columns of a
+ * QueryView widget.
+ * @author Elad Lahav
+ */
+class QueryResultsModel : public QAbstractItemModel
+{
+	Q_OBJECT
+
+public:
+	QueryResultsModel(QObject* pParent = 0);
+	~QueryResultsModel();
+
+	void addRecords(const QList<QStringList>&);
+	void addRecord(const QString&, const QString&, const QString&,
+		const QString&);
+	void clear();
+	void filter(int, const QRegExp&, bool);
+	void showAll();
+	void removeRecord(int);
+	QString getText(int, int) const;
+
+	/**
+	 * @return	The number of records added to the model (including those
+	 *			that are not shown)
+	 */
+	int getRecordCount() const { return m_vecLines.count(); }
+
+	/**
+	 * @param	nRecord	The index of a record
+	 * @return	true if the record was removed by the user, false otherwise
+	 */
+	bool isRemoved(int nRecord) const { return m_baRemoved.testBit(nRecord); }
+
+	/**
+	 * @param	nRow	A row in the model
+	 * @return	The index of the record shown in this row
+	 */
+	int getRecord(int nRow) const { return m_vecRows[nRow]; }
+
+	virtual QModelIndex index(int, int,
+		const QModelIndex& parent = QModelIndex()) const;
+	virtual QModelIndex parent(const QModelIndex&) const;
+	virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+	virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+	virtual QVariant data(const QModelIndex&, int role = Qt::DisplayRole)
+		const;
+	virtual QVariant headerData(int, Qt::Orientation,
+		int role = Qt::DisplayRole) const;
+	virtual void sort(int, Qt::SortOrder order = Qt::AscendingOrder);
+
+private:
+	/** Function names, indexed by the records. */
+	QStringList m_slFuncs;
+
+	/** Maps each function name to its index in the function table. */
+	QHash<QString, int> m_hashFuncs;
+
+	/** The file of each record, as an index into the path table. */
+	QVector<int> m_vecFiles;
+
+	/** The function of each record, as an index into the function table. */
+	QVector<int> m_vecFuncs;
+
+	/** The line number of each record (0 for records without a line). */
+	QVector<uint> m_vecLines;
+
+	/** The offset of each record's text in the text buffer. */
+	QVector<int> m_vecText;
+
+	/** The text of all records, UTF-8 encoded. */
+	QByteArray m_baText;
+
+	/** Marks the records removed by the user. */
+	QBitArray m_baRemoved;
+
+	/** The records shown in the view, in display order. */
+	QVector<int> m_vecRows;
+
+	static int intern(const QString&, QStringList&, QHash<QString, int>&);
+	bool match(int, int, const QRegExp&, QVector<char>&) const;
+
+	friend class QueryResultsLessThan;
+};
+
+#endif
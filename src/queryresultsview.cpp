@@ -0,0 +1,384 @@
+#include <qapplication.h>
+#include <qclipboard.h>
+#include <QHeaderView>
+#include <QKeyEvent>
+#include <QContextMenuEvent>
+#include <klocale.h>
+#include "queryresultsview.h"
+#include "queryresultsmodel.h"
+#include "queryresultsmenu.h"
+#include "queryview.h"
+#include "queryviewdlg.h"
+#include "cscopefrontend.h"
+#include "searchresultsdlg.h"
+#include "pagefile.h"
+
+/**
+ * Class constructor.
+ * @param	pParent	The parent widget
+ */
+QueryResultsView::QueryResultsView(QWidget* pParent) :
+	QTreeView(pParent),
+	m_bSized(false)
+{
+	m_pModel = new QueryResultsModel(this);
+	setModel(m_pModel);
+
+	// Create the popup-menu
+	m_pQueryMenu = new QueryResultsMenu(this);
+
+	// All rows have the same height, which allows the view to lay out any
+	// number of records without measuring them
+	setRootIsDecorated(false);
+	setAllColumnsShowFocus(true);
+	setUniformRowHeights(true);
+	setSortingEnabled(false);
+	header()->setResizeMode(QHeaderView::Interactive);
+
+	// A record is selected if it is either double-clicked, or the ENTER
+	// key is pressed while the record is highlighted
+	connect(this, SIGNAL(doubleClicked(const QModelIndex&)), this,
+		SLOT(slotRecordSelected(const QModelIndex&)));
+
+	// Handle popup-menu commands
+	connect(m_pQueryMenu, SIGNAL(viewSource(const QModelIndex&)), this,
+		SLOT(slotRecordSelected(const QModelIndex&)));
+	connect(m_pQueryMenu, SIGNAL(findDef(const QString&)), this,
+		SLOT(slotFindDef(const QString&)));
+	connect(m_pQueryMenu, SIGNAL(copy(const QModelIndex&, int)), this,
+		SLOT(slotCopy(const QModelIndex&, int)));
+	connect(m_pQueryMenu, SIGNAL(filter(int)), this, SLOT(slotFilter(int)));
+	connect(m_pQueryMenu, SIGNAL(showAll()), this, SLOT(slotShowAll()));
+	connect(m_pQueryMenu, SIGNAL(remove(const QModelIndex&)), this,
+		SLOT(slotRemoveItem(const QModelIndex&)));
+}
+
+/**
+ * Class destructor.
+ */
+QueryResultsView::~QueryResultsView()
+{
+}
+
+/**
+ * Adds a single record at the end of the view.
+ * @param	sFunc	The name of the function
+ * @param	sFile	The file path
+ * @param	sLine	The line number in the above file
+ * @param	sText	The line's text
+ */
+void QueryResultsView::addRecord(const QString& sFunc, const QString& sFile,
+	const QString& sLine, const QString& sText)
+{
+	m_pModel->addRecord(sFunc, sFile, sLine, sText);
+}
+
+/**
+ * Removes all records from the view.
+ */
+void QueryResultsView::clear()
+{
+	// Do not keep a sort order from a previous query
+	setSortingEnabled(false);
+	header()->setSortIndicator(-1, Qt::AscendingOrder);
+
+	m_pModel->clear();
+	m_bSized = false;
+}
+
+/**
+ * Selects a record.
+ * The record is highlighted and made visible, and the lineRequested() signal
+ * is emitted.
+ * @param	idx	The index of the record to select
+ */
+void QueryResultsView::select(const QModelIndex& idx)
+{
+	if (!idx.isValid())
+		return;
+
+	setCurrentIndex(idx);
+	scrollTo(idx);
+	slotRecordSelected(idx);
+}
+
+/**
+ * Selects the next record in the view (if one exists).
+ * The function selects the next record as follows:
+ * - The first record, if there is no current record
+ * - The current record, if it is not selected
+ * - The record immediately below the current one, otherwise
+ */
+void QueryResultsView::selectNext()
+{
+	QModelIndex idx;
+
+	// Do nothing if the view is empty
+	if (m_pModel->rowCount() == 0)
+		return;
+
+	// Find the next record
+	idx = currentIndex();
+	if (!idx.isValid()) {
+		idx = m_pModel->index(0, 0);
+	} else if (selectionModel()->isSelected(idx)) {
+		idx = idx.sibling(idx.row() + 1, idx.column());
+		if (!idx.isValid())
+			return;
+	}
+
+	select(idx);
+}
+
+/**
+ * Selects the previous record in the view (if one exists).
+ * The function selects the previous record as follows:
+ * - The first record, if there is no current record
+ * - The current record, if it is not selected
+ * - The record immediately above the current one, otherwise
+ */
+void QueryResultsView::selectPrev()
+{
+	QModelIndex idx;
+
+	// Do nothing if the view is empty
+	if (m_pModel->rowCount() == 0)
+		return;
+
+	// Find the previous record
+	idx = currentIndex();
+	if (!idx.isValid()) {
+		idx = m_pModel->index(0, 0);
+	} else if (selectionModel()->isSelected(idx)) {
+		idx = idx.sibling(idx.row() - 1, idx.column());
+		if (!idx.isValid())
+			return;
+	}
+
+	select(idx);
+}
+
+/**
+ * Adds all records that were not removed by the user to a page file, in the
+ * order in which they were added.
+ * @param	file	The page file to write
+ */
+void QueryResultsView::write(PageFile& file)
+{
+	int i;
+
+	for (i = 0; i < m_pModel->getRecordCount(); i++) {
+		if (m_pModel->isRemoved(i))
+			continue;
+
+		file.addRecord(m_pModel->getText(i, QueryView::QUERY_FUNC_COL),
+			m_pModel->getText(i, QueryView::QUERY_FILE_COL),
+			m_pModel->getText(i, QueryView::QUERY_LINE_COL).toUInt(),
+			m_pModel->getText(i, QueryView::QUERY_TEXT_COL));
+	}
+}
+
+/**
+ * Adds a block of query result records at the end of the view.
+ * Columns are sized once the first block is shown.
+ * @param	lstRecords	The records to add, each holding the function name,
+ *						file path, line number and line text (in this order)
+ * @param	pParent		The parent item (ignored)
+ */
+void QueryResultsView::addRecords(const QList<QStringList>& lstRecords,
+	QTreeWidgetItem* /* pParent */)
+{
+	m_pModel->addRecords(lstRecords);
+
+	if (!m_bSized && !lstRecords.isEmpty()) {
+		resizeColumns();
+		m_bSized = true;
+	}
+}
+
+/**
+ * Informs the view that query progress information has been received.
+ * The view emits the needToShow() signal telling its parent that the widget
+ * should become visible (if not already so).
+ */
+void QueryResultsView::queryProgress()
+{
+	if (!isVisible())
+		emit needToShow();
+}
+
+/**
+ * Called when a query using this view terminates.
+ * @param	nRecords	Number of records generated by the query
+ * @param	pParent		The parent item (ignored)
+ */
+void QueryResultsView::queryFinished(uint nRecords, QTreeWidgetItem*)
+{
+	// Allow the user to sort the results, starting from the order in which
+	// they were generated
+	header()->setSortIndicator(-1, Qt::AscendingOrder);
+	setSortingEnabled(true);
+
+	// Auto-select a single record (no need to emit the show() signal in
+	// that case)
+	if (nRecords == 1) {
+		select(m_pModel->index(0, 0));
+		return;
+	}
+
+	// Report a query that has returned an empty record set
+	if (nRecords == 0)
+		addRecord(i18n("No results"), "", "", "");
+
+	resizeColumns();
+
+	// Data is available, instruct the owner object to show the view
+	emit needToShow();
+}
+
+/**
+ * Emits the lineRequested() signal for the current record when the ENTER
+ * key is pressed.
+ * @param	pEvent	Event description object
+ */
+void QueryResultsView::keyPressEvent(QKeyEvent* pEvent)
+{
+	if (pEvent->key() != Qt::Key_Return && pEvent->key() != Qt::Key_Enter) {
+		QTreeView::keyPressEvent(pEvent);
+		return;
+	}
+
+	if (currentIndex().isValid())
+		slotRecordSelected(currentIndex());
+}
+
+/**
+ * Shows the popup-menu for the record under the mouse pointer.
+ * @param	pEvent	Event description object
+ */
+void QueryResultsView::contextMenuEvent(QContextMenuEvent* pEvent)
+{
+	QModelIndex idx;
+
+	idx = indexAt(pEvent->pos());
+	m_pQueryMenu->slotShow(idx, pEvent->globalPos(),
+		idx.isValid() ? idx.column() : -1);
+}
+
+/**
+ * Sizes the function, file and line columns to fit the records on screen.
+ * The text column takes the remaining width.
+ */
+void QueryResultsView::resizeColumns()
+{
+	resizeColumnToContents(QueryView::QUERY_FUNC_COL);
+	resizeColumnToContents(QueryView::QUERY_FILE_COL);
+	resizeColumnToContents(QueryView::QUERY_LINE_COL);
+}
+
+/**
+ * Emits the lineRequested() signal when a record is selected.
+ * @param	idx	The index of the selected record
+ */
+void QueryResultsView::slotRecordSelected(const QModelIndex& idx)
+{
+	QString sFileName, sLine;
+
+	if (!idx.isValid())
+		return;
+
+	// Get the full path of the file and the line number
+	sFileName = m_pModel->getText(m_pModel->getRecord(idx.row()),
+		QueryView::QUERY_FILE_COL);
+	sLine = idx.sibling(idx.row(), QueryView::QUERY_LINE_COL).data()
+		.toString();
+
+	// Do not process the "No results" record
+	if (!sLine.isEmpty())
+		emit lineRequested(sFileName, sLine.toUInt());
+}
+
+/**
+ * Looks up the definition of a given function.
+ * Results are displayed in a popup window.
+ * This slot is connected to the findDef() signal emitted by the results menu.
+ * @param	sFunc	The function to look for
+ */
+void QueryResultsView::slotFindDef(const QString& sFunc)
+{
+	QueryViewDlg* pDlg;
+
+	// Create a query view dialogue
+	pDlg = new QueryViewDlg(QueryViewDlg::DestroyOnSelect, this);
+
+	// Display a line when it is selected in the dialogue
+	connect(pDlg, SIGNAL(lineRequested(const QString&, uint)), this,
+		SIGNAL(lineRequested(const QString&, uint)));
+
+	// Start the query
+	pDlg->query(CscopeFrontend::Definition, sFunc);
+}
+
+/**
+ * Copies the text of the requested field to the clipboard.
+ * This slot is connected to the copy() signal of the QueryResultsMenu object.
+ * @param	idx		The index of the record from which to copy
+ * @param	nCol	The column of the field to copy
+ */
+void QueryResultsView::slotCopy(const QModelIndex& idx, int nCol)
+{
+	QApplication::clipboard()->setText(idx.sibling(idx.row(), nCol).data()
+		.toString(), QClipboard::Clipboard);
+}
+
+/**
+ * Hides all records that do not meet the given search criteria.
+ * This slot is connected to the filter() signal of the QueryResultsMenu
+ * object.
+ * The search is incremental: only shown records are checked, so that a new
+ * search goes over the results of the previous one.
+ * @param	nCol	The column to search in
+ */
+void QueryResultsView::slotFilter(int nCol)
+{
+	SearchResultsDlg dlg(this);
+	QRegExp re;
+
+	// Prepare the dialogue
+	dlg.setColumn(nCol);
+
+	// Show the dialogue
+	if (dlg.exec() != QDialog::Accepted)
+		return;
+
+	// Get the selected regular expression
+	dlg.getPattern(re);
+	m_pModel->filter(dlg.getColumn(), re, dlg.isNegated());
+}
+
+/**
+ * Shows all records that were not removed.
+ * This slot is connected to the showAll() signal of the QueryResultsMenu
+ * object.
+ */
+void QueryResultsView::slotShowAll()
+{
+	m_pModel->showAll();
+
+	// Keep the current sort order
+	if (isSortingEnabled())
+		sortByColumn(header()->sortIndicatorSection(),
+			header()->sortIndicatorOrder());
+}
+
+/**
+ * Removes the record on which a popup-menu has been invoked.
+ * This slot is connected to the remove() signal of the QueryResultsMenu
+ * object.
+ * @param	idx	The index of the record to remove
+ */
+void QueryResultsView::slotRemoveItem(const QModelIndex& idx)
+{
+	if (idx.isValid())
+		m_pModel->removeRecord(idx.row());
+}
@@ -0,0 +1,84 @@
+#ifndef QUERYRESULTSVIEW_H
+#define QUERYRESULTSVIEW_H
+
+#include <QTreeView>
+#include <QTreeWidgetItem>
+
+class QueryResultsModel;
+class PageFile;
+class QueryResultsMenu;
+
+/**
+ * A view for displaying the results of Cscope queries.
+ * Unlike QueryView, this widget does not create an item object for each
+ * record. Records are held in a QueryResultsModel object, which constructs
+ * the text of a record only when it is painted. All rows have the same
+ * height, and columns are sized according to the rows on screen, so that
+ * views holding a very large number of records can be scrolled, sorted and
+ * filtered without delay.
+ * The widget provides the same interface as QueryView for use with a
+ * QueryViewDriver object, as well as the same popup-menu.
+ * @author Elad Lahav
+ */
+class QueryResultsView : public QTreeView
+{
+	Q_OBJECT
+
+public:
+	QueryResultsView(QWidget* pParent = 0);
+	~QueryResultsView();
+
+	void addRecord(const QString&, const QString&, const QString&,
+		const QString&);
+	void clear();
+	void select(const QModelIndex&);
+	void selectNext();
+	void selectPrev();
+	void write(PageFile&);
+
+public slots:
+	void addRecords(const QList<QStringList>&, QTreeWidgetItem* pParent = NULL);
+	void queryProgress();
+	void queryFinished(uint, QTreeWidgetItem* pParent = NULL);
+
+signals:
+	/**
+	 * Notifies the owner widget that it needs to be visible since some
+	 * information is available to display.
+	 */
+	void needToShow();
+
+	/**
+	 * Emitted when a record is selected, by either double-clicking it or by
+	 * highlighting it and pressing the ENTER key.
+	 * @param	sFile	The "File" field of the selected record
+	 * @param	nLine	The "Line" field of the selected record
+	 */
+	void lineRequested(const QString& sFile, uint nLine);
+
+protected:
+	virtual void keyPressEvent(QKeyEvent*);
+	virtual void contextMenuEvent(QContextMenuEvent*);
+
+private:
+	/** Holds the records shown in the view. */
+	QueryResultsModel* m_pModel;
+
+	/** A popup-menu for manipulating query result records. */
+	QueryResultsMenu* m_pQueryMenu;
+
+	/** Whether columns were sized to fit the records on screen. */
+	bool m_bSized;
+
+	void resizeColumns();
+
+private slots:
+	void slotRecordSelected(const QModelIndex&);
+	void slotFindDef(const QString&);
+	void slotCopy(const QModelIndex&, int);
+	void slotFilter(int);
+	void slotShowAll();
+	void slotRemoveItem(const QModelIndex&);
+};
+
+#endif
@@ -40,17 +40,17 @@ QueryView::QueryView(QWidget* pParent) :
 		SLOT(slotRecordSelected(QTreeWidgetItem*)));
 
 	// Handle popup-menu commands
-	connect(m_pQueryMenu, SIGNAL(viewSource(QTreeWidgetItem*)), this,
-		SLOT(slotRecordSelected(QTreeWidgetItem*)));
+	connect(m_pQueryMenu, SIGNAL(viewSource(const QModelIndex&)), this,
+		SLOT(slotMenuViewSource(const QModelIndex&)));
 	connect(m_pQueryMenu, SIGNAL(findDef(const QString&)), this,
 		SLOT(slotFindDef(const QString&)));
-	connect(m_pQueryMenu, SIGNAL(copy(QTreeWidgetItem*, int)), this,
-		SLOT(slotCopy(QTreeWidgetItem*, int)));
+	connect(m_pQueryMenu, SIGNAL(copy(const QModelIndex&, int)), this,
+		SLOT(slotMenuCopy(const QModelIndex&, int)));
 	connect(m_pQueryMenu, SIGNAL(filter(int)), this, SLOT(slotFilter(int)));
 	connect(m_pQueryMenu, SIGNAL(showAll()), this, 
 		SLOT(slotShowAll()));
-	connect(m_pQueryMenu, SIGNAL(remove(QTreeWidgetItem*)), this,
-		SLOT(slotRemoveItem(QTreeWidgetItem*)));
+	connect(m_pQueryMenu, SIGNAL(remove(const QModelIndex&)), this,
+		SLOT(slotMenuRemove(const QModelIndex&)));
 }
 
 /**
@@ -82,6 +82,29 @@ void QueryView::addRecord(const QString& sFunc, const QString& sFile,
 	m_pLastItem = pItem;
 }
 
+/**
+ * Creates list items for a block of query result records.
+ * All items are inserted into the view in a single operation.
+ * @param	lstRecords	The records to add, each holding the function name,
+ *						file path, line number and line text (in this order)
+ * @param	pParent		The parent item (ignored)
+ */
+void QueryView::addRecords(const QList<QStringList>& lstRecords,
+	QTreeWidgetItem* /* pParent */)
+{
+	QList<QTreeWidgetItem*> lstItems;
+	QList<QStringList>::ConstIterator itr;
+	
+	if (lstRecords.isEmpty())
+		return;
+	
+	for (itr = lstRecords.begin(); itr != lstRecords.end(); ++itr)
+		lstItems.append(new QueryViewItem(*itr, 2));
+	
+	addTopLevelItems(lstItems);
+	m_pLastItem = lstItems.last();
+}
+
 /**
  * Selects an item.
  * When an item is selected, it is highlighted and made visible. By
@@ -269,7 +292,7 @@ void QueryView::MousePressEvent(QMouseEvent *pEvent)
     if (pItem == NULL)
         return;
     int column = currentColumn();
-    m_pQueryMenu->slotShow(pItem, point, column);
+    m_pQueryMenu->slotShow(indexFromItem(pItem, column), point, column);
 }
 
 /**
@@ -398,6 +421,39 @@ void QueryView::slotRemoveItem(QTreeWidgetItem* pItem)
 	delete pItem;
 }
 
+/**
+ * Displays the item on which a popup-menu has been invoked.
+ * This slot is connected to the viewSource() signal of the QueryResultsMenu
+ * object.
+ * @param	idx	The index of the item
+ */
+void QueryView::slotMenuViewSource(const QModelIndex& idx)
+{
+	slotRecordSelected(itemFromIndex(idx));
+}
+
+/**
+ * Copies a field of the item on which a popup-menu has been invoked.
+ * This slot is connected to the copy() signal of the QueryResultsMenu object.
+ * @param	idx		The index of the item
+ * @param	nCol	The index of the item field to copy
+ */
+void QueryView::slotMenuCopy(const QModelIndex& idx, int nCol)
+{
+	slotCopy(itemFromIndex(idx), nCol);
+}
+
+/**
+ * Removes the item on which a popup-menu has been invoked.
+ * This slot is connected to the remove() signal of the QueryResultsMenu
+ * object.
+ * @param	idx	The index of the item
+ */
+void QueryView::slotMenuRemove(const QModelIndex& idx)
+{
+	slotRemoveItem(itemFromIndex(idx));
+}
+
 /**
  * Moves the iterator to the next _visible_ item in the list.
  TODO
@@ -38,6 +38,16 @@ public:
 		int nLineCol) : QTreeWidgetItem(pParent, pAfter), m_nLineCol(nLineCol)
 		{}
 	
+	/**
+	 * Class constructor.
+	 * Creates an item that is not yet inserted into a view (used for adding
+	 * multiple items at once).
+	 * @param	slText		The text of each column
+	 * @param	nLineCol	The index of the line column
+	 */
+	QueryViewItem(const QStringList& slText, int nLineCol) :
+		QTreeWidgetItem(slText), m_nLineCol(nLineCol) {}
+	
 	/**
 	 * Compares two items.
 	 * If the given column holds line numbers, than the items are compared
@@ -106,8 +116,6 @@ public:
 	virtual void select(QTreeWidgetItem*);
 	virtual void selectNext();
 	virtual void selectPrev();
-	virtual void queryProgress();
-	virtual void queryFinished(uint, QTreeWidgetItem* pParent = NULL);
 	
     // TODO: this class can be removed.
 	/**
@@ -157,6 +165,12 @@ public:
 	
 	Iterator getIterator();
 	
+public slots:
+	virtual void addRecords(const QList<QStringList>&,
+		QTreeWidgetItem* pParent = NULL);
+	virtual void queryProgress();
+	virtual void queryFinished(uint, QTreeWidgetItem* pParent = NULL);
+	
 signals:
 	/**
 	 * Notifies the owner widget that it needs to be visible since some
@@ -193,6 +207,11 @@ protected slots:
 	virtual void slotFilter(int);
 	virtual void slotShowAll();
 	virtual void slotRemoveItem(QTreeWidgetItem*);
+	
+private slots:
+	void slotMenuViewSource(const QModelIndex&);
+	void slotMenuCopy(const QModelIndex&, int);
+	void slotMenuRemove(const QModelIndex&);
 };
 
 #endif
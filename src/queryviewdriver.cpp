@@ -1,7 +1,7 @@
 #include "husky.h"
 #include <klocale.h>
 #include "queryviewdriver.h"
-#include "queryview.h"
+#include "cscopecache.h"
 
 /**
  * Class constructor.
@@ -10,19 +10,18 @@
  * @param	pParent	The parent object of the driver
  * @param	szName	The name of the object
  */
-QueryViewDriver::QueryViewDriver(QueryView* pView, QObject* pParent) :
+QueryViewDriver::QueryViewDriver(QTreeView* pView, QObject* pParent) :
     QObject(pParent),
 	m_pView(pView),
 	m_pItem(NULL),
 	m_progress(pView),
-	m_bRunning(false),
-    m_sRoot("/")
+	m_bRunning(false)
 {
 	m_pCscope = new CscopeFrontend();	
 		
 	// Add records to the page when Cscope outputs them
-	connect(m_pCscope, SIGNAL(dataReady(FrontendToken*)), this,
-		SLOT(slotDataReady(FrontendToken*)));
+	connect(m_pCscope, SIGNAL(dataReady(const FrontendBatch&)), this,
+		SLOT(slotDataReady(const FrontendBatch&)));
 		
 	// Report progress information
 	connect(m_pCscope, SIGNAL(progress(int, int)), this,
@@ -32,6 +31,14 @@ QueryViewDriver::QueryViewDriver(QueryView* pView, QObject* pParent) :
 	connect(m_pCscope, SIGNAL(finished(uint)), this,
 		SLOT(slotFinished(uint)));
 	
+	// Pass records and query status to the view
+	connect(this, SIGNAL(recordsReady(const QList<QStringList>&,
+		QTreeWidgetItem*)), m_pView,
+		SLOT(addRecords(const QList<QStringList>&, QTreeWidgetItem*)));
+	connect(this, SIGNAL(queryProgress()), m_pView, SLOT(queryProgress()));
+	connect(this, SIGNAL(queryFinished(uint, QTreeWidgetItem*)), m_pView,
+		SLOT(queryFinished(uint, QTreeWidgetItem*)));
+	
 	connect(m_pView, SIGNAL(destroyed()), this, SLOT(slotViewClosed()));
 }
 
@@ -49,61 +56,46 @@ QueryViewDriver::~QueryViewDriver()
  * @param	sText	The query's text
  * @param	bCase		true for case-sensitive queries, false otherwise
  * @param	pItem	If non-null, represents an view item passed back to
- *					the view in a call to addRecord()
+ *					the view in a call to addRecords()
  */
 void QueryViewDriver::query(uint nType, const QString& sText, bool bCase,
 	QTreeWidgetItem* pItem)
 {
+	bool bStored;
+	
 	m_pItem = pItem;
 	
 	// Make sure sorting is disabled while entries are added
 	m_pView->setSortingEnabled(false);
 		
-	// Execute the query
+	// Execute the query (a previous query that is still running is
+	// cancelled, and does not report any further records)
+	// The view is only disabled if the results are not already stored, as
+	// otherwise they are delivered immediately
+	bStored = CscopeCache::contains(nType, sText, bCase);
 	m_pCscope->query(nType, sText, bCase);
 	m_bRunning = true;
-	m_pView->setEnabled(false);
-	m_pView->setUpdatesEnabled(false);
+	if (!bStored) {
+		m_pView->setEnabled(false);
+		m_pView->setUpdatesEnabled(false);
+	}
 }
 
 /**
- * Adds a query entry to the view.
- * Called by a CscopeFrontend object, when a new entry was received in its
- * whole from the Cscope back-end process.
- * @param	pToken	The first token in the entry
+ * Adds query entries to the view.
+ * Called by a CscopeFrontend object, when a block of entries was received in
+ * its whole from the Cscope back-end process. All entries in the block are
+ * added to the view in a single operation.
+ * @param	batch	The block of entries
  */
-void QueryViewDriver::slotDataReady(FrontendToken* pToken)
+void QueryViewDriver::slotDataReady(const FrontendBatch& batch)
 {
-	QString sFile, sFunc, sLine, sText;
+	QList<QStringList> lstRecords;
 	
-	// Get the file name
-	sFile = pToken->getData();
-	pToken = pToken->getNext();
-	if (m_sRoot != "/")
-		sFile.replace(m_sRoot, "$");
-
-	// Get the function name
-	sFunc = pToken->getData();
-	pToken = pToken->getNext();
+	CscopeFrontend::getRecords(batch, lstRecords);
 
-	// Get the line number
-	sLine = pToken->getData();
-	if (!sLine.toInt()) {
-		// Line number could not be 0!
-		// means that function name was empty
-		sLine = sFunc;
-		sFunc = "<global>";
-	}
-	else {
-		pToken = pToken->getNext();
-	}
-	
-	// Get the line's text
-	sText = pToken->getData();
-	pToken = pToken->getNext();
-
-	// Add a new item at the end of the list
-	m_pView->addRecord(sFunc, sFile, sLine, sText, m_pItem);
+	// Add the new items at the end of the list
+	emit recordsReady(lstRecords, m_pItem);
 }
 
 /**
@@ -116,6 +108,11 @@ void QueryViewDriver::slotFinished(uint nRecords)
 {
 	// The query is no longer running
 	m_bRunning = false;
+	
+	// Nothing to do if the view was closed while the query was running
+	if (m_pView == NULL)
+		return;
+		
 	m_pView->setEnabled(true);
 	m_pView->setUpdatesEnabled(true);
 	//m_pView->triggerUpdate();
@@ -124,7 +121,7 @@ void QueryViewDriver::slotFinished(uint nRecords)
 	m_progress.finished();
 
 	// Let owner widget decide what to do based on the number of records
-	m_pView->queryFinished(nRecords, m_pItem);
+	emit queryFinished(nRecords, m_pItem);
 }
 
 /**
@@ -139,7 +136,7 @@ void QueryViewDriver::slotProgress(int nFiles, int nTotal)
 	// A progress report is available, instruct the owner object to show the
 	// view
 	if (nTotal > 1)
-		m_pView->queryProgress();
+		emit queryProgress();
 		
 	// Set the progress bar
 	m_progress.setProgress(nFiles, nTotal);
@@ -153,8 +150,3 @@ void QueryViewDriver::slotViewClosed()
 	m_pView = NULL;
 	m_pCscope->kill();
 }
-
-void QueryViewDriver::setRoot(QString &root)
-{
-    m_sRoot = root;
-}
@@ -2,17 +2,18 @@
 #define QUERYVIEWDRIVER_H
 
 #include <QObject>
-#include <QTreeWidget>
+#include <QTreeView>
+#include <QTreeWidgetItem>
 #include "cscopefrontend.h"
 
-class QueryView;
-
 /**
- * Executes a Cscope query and displays the results in a QueryView widget.
- * This class is used in conjunction with QueryView to create a query
- * display object. The driver uses the view widget to display result records
- * of an executed query. It also uses the view as a parent widget for the
- * query progress bar.
+ * Executes a Cscope query and displays the results in a view widget.
+ * This class is used in conjunction with either QueryView or
+ * QueryResultsView to create a query display object. The driver uses the
+ * view widget to display result records of an executed query. It also uses
+ * the view as a parent widget for the query progress bar.
+ * Records are passed to the view through its addRecords(), queryProgress()
+ * and queryFinished() slots, which both view classes provide.
  * @author Elad Lahav
  */
 class QueryViewDriver : public QObject
@@ -20,25 +21,46 @@ class QueryViewDriver : public QObject
 	Q_OBJECT
 
 public:
-    QueryViewDriver(QueryView*, QObject* pParent = 0);
+    QueryViewDriver(QTreeView*, QObject* pParent = 0);
     ~QueryViewDriver();
 
 	void query(uint, const QString&, bool bCase, QTreeWidgetItem* pItem = NULL);
-    void setRoot(QString &root);
 	
 	/**
 	 * @return	true if a query is currently running, false otherwise
 	 */
 	bool isRunning() { return m_bRunning; }
 		
+signals:
+	/**
+	 * Delivers a block of result records to the view.
+	 * @param	lstRecords	The records, each holding the function name, file
+	 *						path, line number and line text (in this order)
+	 * @param	pItem		The item passed to query()
+	 */
+	void recordsReady(const QList<QStringList>& lstRecords,
+		QTreeWidgetItem* pItem);
+	
+	/**
+	 * Informs the view that query progress information was received.
+	 */
+	void queryProgress();
+	
+	/**
+	 * Informs the view that the query has terminated.
+	 * @param	nRecords	The number of records generated by the query
+	 * @param	pItem		The item passed to query()
+	 */
+	void queryFinished(uint nRecords, QTreeWidgetItem* pItem);
+	
 private:
 	/** Cscope object for running queries. */
 	CscopeFrontend* m_pCscope;
 	
 	/** The view to which this object adds result records. */
-	QueryView* m_pView;
+	QTreeView* m_pView;
 	
-	/** QueryView item passed to addRecord(). */
+	/** View item passed to addRecords(). */
 	QTreeWidgetItem* m_pItem;
 	
 	/** Displays query progress information. */
@@ -47,11 +69,9 @@ private:
 	/** This flag is set to true when a query is executed, and back to false
 		when the the CscopeFrontend object emits the finished() signal. */
 	bool m_bRunning;
-
-    QString m_sRoot;
 	
 private slots:
-	void slotDataReady(FrontendToken*);
+	void slotDataReady(const FrontendBatch&);
 	void slotFinished(uint);
 	void slotProgress(int, int);
 	void slotViewClosed();
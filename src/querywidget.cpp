@@ -6,6 +6,7 @@
 #include "querywidget.h"
 #include "kscopepixmaps.h"
 #include "kscopeconfig.h"
+#include "pathtable.h"
 
 /**
  * Class constructor.
@@ -120,7 +121,7 @@ void QueryWidget::loadPages(const QString& sProjPath,
 		}
 
 		// Load a query file to this page, and lock the page
-		if (pPage->load(sProjPath, *itr, m_sRoot)) {
+		if (pPage->load(sProjPath, *itr)) {
 			setPageCaption(pPage);
 			setPageLocked(pPage, true);
 		}
@@ -160,8 +161,6 @@ void QueryWidget::savePages(const QString& sProjPath, QStringList& slFiles)
 void QueryWidget::addHistoryRecord(const QString& sFile, uint nLine, 
 	const QString& sText)
 {
-    QString name(sFile);
-
 	// Validate file name and line number
 	if (sFile.isEmpty() || nLine == 0)
 		return;
@@ -173,10 +172,8 @@ void QueryWidget::addHistoryRecord(const QString& sFile, uint nLine,
 	// Make sure there is an active history page	
 	findHistoryPage();
 
-    if (m_sRoot != "/")
-        name.replace(m_sRoot, "$");
 	// Add the position entry to the active page
-	m_pHistPage->addRecord(name, nLine, sText);
+	m_pHistPage->addRecord(PathTable::toDisplay(sFile), nLine, sText);
 }
 
 /**
@@ -201,7 +198,6 @@ void QueryWidget::addQueryPage()
 
 	// Create the page
 	pPage = new QueryPage(this);
-    pPage->setRoot(m_sRoot);
 
 	// Add the page, and set it as the current one
     // QIcon icon("project_new");
@@ -385,15 +381,12 @@ void QueryWidget::setPageMenu(QMenu* pMenu, KToggleAction* pAction)
  */
 void QueryWidget::slotRequestLine(const QString& sFileName, uint nLine)
 {
-    QString sFile(sFileName);
 	// Disable history if the request came from the active history page
 	if (currentPage() == m_pHistPage)
 		m_bHistEnabled = false;
 		
-	if (sFile.startsWith("$"))
-		sFile.replace("$", m_sRoot);
-	// Emit the signal
-	emit lineRequested(sFile, nLine);
+	// Emit the signal (with the full path of the file)
+	emit lineRequested(PathTable::toPath(sFileName), nLine);
 	
 	// Re-enable history
 	if (currentPage() == m_pHistPage)
@@ -596,17 +589,17 @@ void QueryWidget::findHistoryPage()
 }
 
 /**
- * Sets a new common root path
+ * Sets a new common root path.
+ * Paths are stored in full, and the root is only applied when they are
+ * displayed, so the pages merely need to be repainted.
  * @param	sRoot	The full path of the new root
  */
 void QueryWidget::setRoot(const QString& sRoot)
 {
-	// Nothing to do if the given root is the same as the old one
-	if (sRoot == m_sRoot)
-		return;
+	int i;
 	
-	m_sRoot = sRoot;
+	PathTable::setRoot(sRoot);
 	
-	// TODO: Update the query pages
-	//m_pFileList->setRoot(sRoot);
+	for (i = 0; i < m_pQueryTabs->count(); i++)
+		((QueryPageBase*)m_pQueryTabs->widget(i))->updateView();
 }
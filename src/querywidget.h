@@ -69,7 +69,6 @@ signals:
 	void newQuery();
 	
 private:
-	QString m_sRoot;
 	/** A menu with query page commands (new query, lock/unlock, close
 		query, etc.). */
 	QMenu* m_pPageMenu;
@@ -1,4 +1,5 @@
 #include "searchlistview.h"
+#include "listfilter.h"
 
 ListTreeView::ListTreeView(QWidget *parent) :
     QTreeView(parent)
@@ -71,6 +72,7 @@ void ListLineEdit::keyPressEvent(QKeyEvent *pEvent)
 ListSortFilterProxyModel::ListSortFilterProxyModel(QObject *parent) :
     QSortFilterProxyModel(parent),
     m_bSortByInt(false),
+    m_bFiltered(false),
 	m_bgColor(Qt::white),
 	m_fgColor(Qt::black),
     m_nSortCol(-1)
@@ -98,6 +100,41 @@ bool ListSortFilterProxyModel::lessThan(const QModelIndex &left,
     return QSortFilterProxyModel::lessThan(left, right);
 }
 
+/**
+ * Shows only the given source rows.
+ * @param	rows	The accepted rows
+ */
+void ListSortFilterProxyModel::setAcceptedRows(const QVector<int> &rows)
+{
+    m_baAccepted.fill(false, sourceModel()->rowCount());
+    for (int i = 0; i < rows.size(); i++) {
+        if (rows[i] < m_baAccepted.size())
+            m_baAccepted.setBit(rows[i]);
+    }
+    m_bFiltered = true;
+    invalidateFilter();
+}
+
+/**
+ * Shows all source rows.
+ */
+void ListSortFilterProxyModel::clearAcceptedRows()
+{
+    if (!m_bFiltered)
+        return;
+    m_baAccepted.clear();
+    m_bFiltered = false;
+    invalidateFilter();
+}
+
+bool ListSortFilterProxyModel::filterAcceptsRow(int row,
+        const QModelIndex &) const
+{
+    if (!m_bFiltered)
+        return true;
+    return row < m_baAccepted.size() && m_baAccepted.testBit(row);
+}
+
 void ListSortFilterProxyModel::setBgColor(QColor color)
 {
 	m_bgColor = color;
@@ -124,11 +161,18 @@ QVariant ListSortFilterProxyModel::data(const QModelIndex & index, int role) con
 ////////////////////////////////////////////////////////////////////////////////
 SearchListView::SearchListView(int searchCol, QWidget *parent) :
     QWidget(parent),
-    m_searchCol(searchCol)
+    m_searchCol(searchCol),
+    m_nFilterSerial(0)
 {
     m_proxyModel = new ListSortFilterProxyModel;
     m_proxyModel->setFilterKeyColumn(m_searchCol);
 
+    m_pFilter = new ListFilter(this);
+    m_pFilterTimer = new QTimer(this);
+    m_pFilterTimer->setSingleShot(true);
+    m_pFilterTimer->setInterval(SEARCH_LIST_FILTER_DELAY);
+    connect(m_pFilterTimer, SIGNAL(timeout()), this, SLOT(slotFindItem()));
+
     m_pView = new ListTreeView(this);
     m_pView->setRootIsDecorated(false);
     m_pView->setSortingEnabled(true);
@@ -143,7 +187,7 @@ SearchListView::SearchListView(int searchCol, QWidget *parent) :
     setLayout(layout);
 
     connect(m_pEdit, SIGNAL(textChanged(QString)),
-            this, SLOT(slotFindItem()));
+            this, SLOT(slotFilterChanged()));
 
 	connect(m_pView, SIGNAL(doubleClicked(const QModelIndex &)), 
             this, SLOT(slotItemSelected(const QModelIndex &)));
@@ -161,16 +205,125 @@ SearchListView::SearchListView(int searchCol, QWidget *parent) :
 void SearchListView::setSourceModel(QAbstractItemModel *model)
 {
     m_proxyModel->setSourceModel(model);
+
+    // Keep the filter index up to date with the list
+    connect(model, SIGNAL(rowsInserted(const QModelIndex &, int, int)),
+            this, SLOT(slotRowsInserted(const QModelIndex &, int, int)));
+    connect(model, SIGNAL(rowsRemoved(const QModelIndex &, int, int)),
+            this, SLOT(slotModelReset()));
+    connect(model, SIGNAL(modelReset()), this, SLOT(slotModelReset()));
+    slotModelReset();
 }
 
 SearchListView::~SearchListView()
 {
+    delete m_pFilter;
 }
 
+/**
+ * Restarts the filter delay whenever the search string changes.
+ * An empty string shows all items immediately.
+ */
+void SearchListView::slotFilterChanged()
+{
+    if (m_pEdit->text().isEmpty()) {
+        m_pFilterTimer->stop();
+        slotFindItem();
+        return;
+    }
+    m_pFilterTimer->start();
+}
+
+/**
+ * Filters the list by the current search string.
+ * Items are matched by a separate thread, and the list is updated once the
+ * results are available (@see customEvent()).
+ */
 void SearchListView::slotFindItem()
 {
-    QRegExp regExp(m_pEdit->text(), Qt::CaseInsensitive);
-    m_proxyModel->setFilterRegExp(regExp);
+    if (m_pEdit->text().isEmpty()) {
+        // Discard the results of a run in progress
+        m_pFilter->cancel();
+        m_nFilterSerial = 0;
+        m_proxyModel->clearAcceptedRows();
+        return;
+    }
+    m_nFilterSerial = m_pFilter->start(m_vecKeys, m_pEdit->text());
+}
+
+/**
+ * Adds the text of new items to the filter index.
+ * This slot is connected to the rowsInserted() signal of the source model.
+ * @param	parent	The parent of the new rows
+ * @param	first	The first new row
+ * @param	last	The last new row
+ */
+void SearchListView::slotRowsInserted(const QModelIndex &parent, int first,
+        int last)
+{
+    QAbstractItemModel *model = m_proxyModel->sourceModel();
+
+    if (parent.isValid())
+        return;
+
+    // Rows inserted in the middle shift the index
+    if (first != m_vecKeys.size()) {
+        slotModelReset();
+        return;
+    }
+
+    m_vecKeys.reserve(last + 1);
+    for (int i = first; i <= last; i++) {
+        m_vecKeys.append(model->data(model->index(i, m_searchCol))
+                .toString().toLower());
+    }
+
+    // Match the new rows as well
+    if (!m_pEdit->text().isEmpty())
+        m_pFilterTimer->start();
+}
+
+/**
+ * Rebuilds the filter index from all rows of the source model.
+ */
+void SearchListView::slotModelReset()
+{
+    QAbstractItemModel *model = m_proxyModel->sourceModel();
+
+    m_pFilter->reset();
+    m_vecKeys.clear();
+    if (model != NULL) {
+        m_vecKeys.reserve(model->rowCount());
+        for (int i = 0; i < model->rowCount(); i++) {
+            m_vecKeys.append(model->data(model->index(i, m_searchCol))
+                    .toString().toLower());
+        }
+    }
+
+    if (!m_pEdit->text().isEmpty())
+        m_pFilterTimer->start();
+}
+
+/**
+ * Shows the items matching the search string, once the filter thread has
+ * finished.
+ * Results of runs superseded by a newer search string are ignored.
+ * @param	pEvent	The event object
+ */
+void SearchListView::customEvent(QEvent *pEvent)
+{
+    ListFilterEvent *pFilterEvent;
+
+    if (pEvent->type() != ListFilterEvent::eventTypeId)
+        return;
+
+    pFilterEvent = (ListFilterEvent *)pEvent;
+    if (pFilterEvent->m_nSerial != m_nFilterSerial ||
+        m_pEdit->text().isEmpty()) {
+        return;
+    }
+
+    m_proxyModel->setAcceptedRows(pFilterEvent->m_vecRows);
 }
 
 /**
@@ -3,6 +3,11 @@
 
 #include <QtGui>
 
+class ListFilter;
+
+/** The time, in milliseconds, to wait for further typing before filtering. */
+#define SEARCH_LIST_FILTER_DELAY	150
+
 class ListTreeView : public QTreeView
 {
     Q_OBJECT
@@ -42,15 +47,22 @@ class ListSortFilterProxyModel : public QSortFilterProxyModel
         ListSortFilterProxyModel(QObject *parent = 0);
         ~ListSortFilterProxyModel();
         void setSortByInt(int, bool);
+        void setAcceptedRows(const QVector<int> &rows);
+        void clearAcceptedRows();
 		void setBgColor(QColor color);
 		void setFgColor(QColor color);
 		virtual QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const;
 
     protected:
         virtual bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
+        virtual bool filterAcceptsRow(int row, const QModelIndex &parent) const;
 
     private:
         bool m_bSortByInt;
+        /** Marks the source rows accepted by the filter. */
+        QBitArray m_baAccepted;
+        /** Whether rows are filtered by m_baAccepted. */
+        bool m_bFiltered;
 		QColor m_bgColor;
 		QColor m_fgColor;
         int m_nSortCol;
@@ -72,7 +84,10 @@ class SearchListView: public QWidget
         void slotSetFocus();
 
     private slots:
+        void slotFilterChanged();
         void slotFindItem();
+        void slotRowsInserted(const QModelIndex &, int, int);
+        void slotModelReset();
         void slotItemSelected(const QModelIndex &);
         void slotItemSelected();
         void slotEditUpDownPressed(int);
@@ -84,6 +99,8 @@ class SearchListView: public QWidget
         ListSortFilterProxyModel *m_proxyModel;
         int m_searchCol;
 
+        virtual void customEvent(QEvent *pEvent);
+
         /**
          * Called whenever the user selects an item in the list by either double-
          * clicking it, or by highlighting the item and pressing the ENTER key.
@@ -92,6 +109,16 @@ class SearchListView: public QWidget
         virtual void processItemSelected(const QModelIndex &) = 0;
         //void MousePressEvent(QMouseEvent *pEvent);
         //void keyPressEvent(QKeyEvent *pEvent);
+
+    private:
+        /** Matches the list against the search string. */
+        ListFilter *m_pFilter;
+        /** Delays filtering until the user stops typing. */
+        QTimer *m_pFilterTimer;
+        /** The lower-case text of the search column, by source row. */
+        QVector<QString> m_vecKeys;
+        /** The serial number of the latest filter run. */
+        uint m_nFilterSerial;
 };
 
 #endif
@@ -1,33 +1,192 @@
 #include "stringlistmodel.h"
+#include "pathtable.h"
 
 StringListModel::StringListModel(int columns, QObject *parent):
-    QStandardItemModel(0, columns, parent)
+    QAbstractTableModel(parent),
+    m_vecColumns(columns),
+    m_nRows(0),
+    m_nPathCol(-1),
+    m_nIconCol(-1)
 {
 }
 
-void StringListModel::addItem(const QStringList &item, int row)
+void StringListModel::setHeader(const QStringList &item)
 {
-    if (item.size() != columnCount())
+    if (item.size() != m_vecColumns.size())
         return;
-    insertRow(row);
-    for (int i = 0; i < item.size(); i++)
-        setData(index(0, i), item.at(i));
+    m_slHeader = item;
+    emit headerDataChanged(Qt::Horizontal, 0, item.size() - 1);
 }
-        
-void StringListModel::setIcon(int row, int col, QIcon &icon)
+
+/**
+ * Stores the items of the given column in the PathTable.
+ * Items in this column hold the index of their path, and are displayed
+ * relative to the current source root.
+ * @param	col	The column holding full paths
+ */
+void StringListModel::setPathColumn(int col)
 {
-    setData(index(row, col), icon, Qt::DecorationRole);
+    m_nPathCol = col;
 }
 
-void StringListModel::setHeader(const QStringList &item)
+/**
+ * @param	col	The column in which the icon of each row's kind is shown
+ */
+void StringListModel::setIconColumn(int col)
+{
+    m_nIconCol = col;
+}
+
+/**
+ * Sets the icon shown for all rows of the given kind.
+ * @param	kind	A non-negative kind number
+ * @param	icon	The icon to show
+ */
+void StringListModel::setIcon(int kind, const QIcon &icon)
 {
-    if (item.size() != columnCount())
+    if (kind >= m_vecIcons.size())
+        m_vecIcons.resize(kind + 1);
+    m_vecIcons[kind] = icon;
+}
+
+/**
+ * Allocates storage in advance for the given number of rows.
+ * @param	rows	The expected number of rows
+ */
+void StringListModel::reserve(int rows)
+{
+    for (int i = 0; i < m_vecColumns.size(); i++) {
+        if (i != m_nPathCol)
+            m_vecColumns[i].reserve(rows);
+    }
+    if (m_nPathCol >= 0)
+        m_vecPaths.reserve(rows);
+    m_vecKinds.reserve(rows);
+}
+
+/**
+ * Appends a single row.
+ * @param	item	The text of each column
+ * @param	kind	The kind of the row, -1 if the row has no icon
+ */
+void StringListModel::addItem(const QStringList &item, int kind)
+{
+    if (item.size() != m_vecColumns.size())
+        return;
+    beginInsertRows(QModelIndex(), m_nRows, m_nRows);
+    append(item, kind);
+    endInsertRows();
+}
+
+/**
+ * Appends a block of rows, so that views are updated a single time.
+ * @param	items	The text of each column, by row
+ * @param	kinds	The kind of each row (may be empty if rows have no icon)
+ */
+void StringListModel::addItems(const QList<QStringList> &items,
+        const QList<int> &kinds)
+{
+    int rows;
+
+    // Count the well-formed rows in advance
+    rows = 0;
+    for (int r = 0; r < items.size(); r++) {
+        if (items.at(r).size() == m_vecColumns.size())
+            rows++;
+    }
+    if (rows == 0)
         return;
-    for (int i = 0; i < item.size(); i++)
-        setHeaderData(i, Qt::Horizontal, item.at(i));
+
+    // Storage is not reserved for each block, since an exact reservation
+    // would copy all rows every time, while appending grows the storage
+    // geometrically
+    beginInsertRows(QModelIndex(), m_nRows, m_nRows + rows - 1);
+    for (int r = 0; r < items.size(); r++) {
+        if (items.at(r).size() == m_vecColumns.size())
+            append(items.at(r), r < kinds.size() ? kinds.at(r) : -1);
+    }
+    endInsertRows();
+}
+
+/**
+ * Removes all rows.
+ */
+void StringListModel::clear()
+{
+    for (int i = 0; i < m_vecColumns.size(); i++)
+        m_vecColumns[i].clear();
+    m_vecPaths.clear();
+    m_vecKinds.clear();
+    m_nRows = 0;
+    reset();
+}
+
+QString StringListModel::getString(int row, int col) const
+{
+    if (col == m_nPathCol)
+        return PathTable::getPath(m_vecPaths[row]);
+    return m_vecColumns[col][row];
+}
+
+int StringListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_nRows;
+}
+
+int StringListModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_vecColumns.size();
+}
+
+QVariant StringListModel::data(const QModelIndex &index, int role) const
+{
+    int kind;
+
+    if (!index.isValid())
+        return QVariant();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        // Render paths lazily, so that a new root applies to all rows
+        if (index.column() == m_nPathCol)
+            return PathTable::getDisplay(m_vecPaths[index.row()]);
+        return m_vecColumns[index.column()][index.row()];
+
+    case Qt::DecorationRole:
+        if (index.column() != m_nIconCol)
+            break;
+        kind = m_vecKinds[index.row()];
+        if (kind >= 0 && kind < m_vecIcons.size())
+            return m_vecIcons[kind];
+        break;
+
+    case PathIdRole:
+        if (index.column() == m_nPathCol)
+            return m_vecPaths[index.row()];
+        break;
+    }
+
+    return QVariant();
+}
+
+QVariant StringListModel::headerData(int section, Qt::Orientation orient,
+        int role) const
+{
+    if (orient != Qt::Horizontal || role != Qt::DisplayRole ||
+        section < 0 || section >= m_slHeader.size()) {
+        return QVariant();
+    }
+    return m_slHeader.at(section);
 }
 
-QString StringListModel::getString(int row, int col)
+void StringListModel::append(const QStringList &item, int kind)
 {
-    return data(index(row, col)).toString();
+    for (int i = 0; i < item.size(); i++) {
+        if (i == m_nPathCol)
+            m_vecPaths.append(PathTable::getId(item.at(i)));
+        else
+            m_vecColumns[i].append(item.at(i));
+    }
+    m_vecKinds.append(kind);
+    m_nRows++;
 }
@@ -3,18 +3,74 @@
 
 #include <QtGui>
 
-class StringListModel : public QStandardItemModel
+/**
+ * A flat list model for the file and tag lists.
+ * Rows are only appended, either one at a time or in blocks, and are stored
+ * by column, so that adding a row does not allocate an item object per cell.
+ * A column may be designated to hold paths, which are kept as PathTable
+ * indices. Rows may also be given a kind, which selects an icon shown in the
+ * icon column; each icon is created once for all rows of the same kind.
+ */
+class StringListModel : public QAbstractTableModel
 {
     Q_OBJECT
 
     public:
+        /** Holds the PathTable index of an item in the path column. */
+        enum { PathIdRole = Qt::UserRole + 2 };
+
         StringListModel(int columns, QObject *parent = 0);
         void setHeader(const QStringList &item);
-        void addItem(const QStringList &item, int row = 0);
-        void setIcon(int row, int col, QIcon &icon);
-        QString getString(int row, int col);
+        void setPathColumn(int col);
+        void setIconColumn(int col);
+        void setIcon(int kind, const QIcon &icon);
+        void reserve(int rows);
+        void addItem(const QStringList &item, int kind = -1);
+        void addItems(const QList<QStringList> &items,
+                const QList<int> &kinds = QList<int>());
+        void clear();
+        QString getString(int row, int col) const;
+
+        /**
+         * @param   row The index of a row
+         * @return  The PathTable index of the row's path
+         */
+        int getPathId(int row) const { return m_vecPaths[row]; }
+
+        virtual int rowCount(const QModelIndex &parent = QModelIndex()) const;
+        virtual int columnCount(const QModelIndex &parent = QModelIndex())
+            const;
+        virtual QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const;
+        virtual QVariant headerData(int section, Qt::Orientation orient,
+                int role = Qt::DisplayRole) const;
 
     private:
+        /** The text of each column, by row (unused for the path column). */
+        QVector< QVector<QString> > m_vecColumns;
+
+        /** The PathTable index of each row's path. */
+        QVector<int> m_vecPaths;
+
+        /** The kind of each row, -1 for rows without an icon. */
+        QVector<int> m_vecKinds;
+
+        /** Icons, by kind. */
+        QVector<QIcon> m_vecIcons;
+
+        /** Column titles. */
+        QStringList m_slHeader;
+
+        /** The number of rows. */
+        int m_nRows;
+
+        /** A column holding paths from the PathTable, -1 if none. */
+        int m_nPathCol;
+
+        /** The column showing the icon of each row's kind, -1 if none. */
+        int m_nIconCol;
+
+        void append(const QStringList &item, int kind);
 };
 
 #endif
@@ -0,0 +1,92 @@
+#include <KTextEditor/Document>
+#include <KTextEditor/View>
+#include "symbolcompletionmodel.h"
+#include "symbolindex.h"
+
+/**
+ * Class constructor.
+ * @param	pParent	The parent object
+ */
+SymbolCompletionModel::SymbolCompletionModel(QObject* pParent) :
+	KTextEditor::CodeCompletionModel(pParent),
+	m_nMaxEntries(0)
+{
+}
+
+/**
+ * Class destructor.
+ */
+SymbolCompletionModel::~SymbolCompletionModel()
+{
+}
+
+/**
+ * Looks up the completions of the word being completed.
+ * Called by the editor when completion starts.
+ * @param	pView	The view in which the word is completed
+ * @param	range	The range of the word
+ */
+void SymbolCompletionModel::completionInvoked(KTextEditor::View* pView,
+	const KTextEditor::Range& range, InvocationType)
+{
+	findSymbols(pView->document()->text(range));
+}
+
+/**
+ * Looks up the completions of the word being completed again, once it has
+ * changed.
+ * The completions already found are kept (and filtered by the editor) if
+ * they include all names beginning with the new text, i.e., the word was
+ * extended, and the number of completions was not limited.
+ * Called by the editor whenever text is typed while completion is active.
+ * @param	pView	The view in which the word is completed
+ * @param	range	The current range of the word
+ * @return	The updated range of the word
+ */
+KTextEditor::Range SymbolCompletionModel::updateCompletionRange(
+	KTextEditor::View* pView, const KTextEditor::Range& range)
+{
+	KTextEditor::Range rangeNew;
+	QString sText;
+
+	rangeNew = CodeCompletionModelControllerInterface3::updateCompletionRange(
+		pView, range);
+	sText = pView->document()->text(rangeNew);
+
+	if (!sText.startsWith(m_sPrefix) || (sText != m_sPrefix &&
+		m_nMaxEntries > 0 && (uint)m_slSymbols.count() >= m_nMaxEntries)) {
+		findSymbols(sText);
+	}
+
+	return rangeNew;
+}
+
+/**
+ * Returns the data shown for a completion.
+ * Only the name column is used.
+ * @param	index	The completion's index
+ * @param	role	The requested role
+ * @return	The name of the symbol, for the name column
+ */
+QVariant SymbolCompletionModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_slSymbols.count())
+		return QVariant();
+
+	if (role == Qt::DisplayRole && index.column() == Name)
+		return m_slSymbols[index.row()];
+
+	return QVariant();
+}
+
+/**
+ * Replaces the completions with the names beginning with the given text.
+ * @param	sPrefix	The text of the word being completed
+ */
+void SymbolCompletionModel::findSymbols(const QString& sPrefix)
+{
+	m_sPrefix = sPrefix;
+	SymbolIndex::find(sPrefix, m_nMaxEntries, m_slSymbols);
+	setRowCount(m_slSymbols.count());
+	reset();
+}
@@ -0,0 +1,56 @@
+#ifndef SYMBOLCOMPLETIONMODEL_H
+#define SYMBOLCOMPLETIONMODEL_H
+
+#include <qstringlist.h>
+#include <KTextEditor/CodeCompletionModel>
+#include <KTextEditor/CodeCompletionModelControllerInterface>
+
+/**
+ * Provides the editor with completions for the symbol under the cursor.
+ * The completions are the names of symbols in the project's database that
+ * begin with the text of the word being completed, as found in the symbol
+ * dictionary (@see SymbolIndex).
+ * The number of completions may be limited, in which case the names offered
+ * for a short prefix may not include all of those beginning with a longer
+ * one. The dictionary is therefore searched again whenever the word changes
+ * while completion is active, rather than letting the editor filter the
+ * completions found for the initial prefix.
+ * @author Elad Lahav
+ */
+class SymbolCompletionModel : public KTextEditor::CodeCompletionModel,
+	public KTextEditor::CodeCompletionModelControllerInterface3
+{
+	Q_OBJECT
+	Q_INTERFACES(KTextEditor::CodeCompletionModelControllerInterface3)
+
+public:
+	SymbolCompletionModel(QObject* pParent = 0);
+	~SymbolCompletionModel();
+
+	/**
+	 * @param	nMaxEntries	The maximal number of completions to offer, 0 for
+	 *						no limit
+	 */
+	void setMaxEntries(uint nMaxEntries) { m_nMaxEntries = nMaxEntries; }
+
+	virtual void completionInvoked(KTextEditor::View*,
+		const KTextEditor::Range&, InvocationType);
+	virtual KTextEditor::Range updateCompletionRange(KTextEditor::View*,
+		const KTextEditor::Range&);
+	virtual QVariant data(const QModelIndex&, int role = Qt::DisplayRole)
+		const;
+
+private:
+	/** The completions offered for the current word. */
+	QStringList m_slSymbols;
+
+	/** The text of the word for which the completions were found. */
+	QString m_sPrefix;
+
+	/** The maximal number of completions to offer. */
+	uint m_nMaxEntries;
+
+	void findSymbols(const QString&);
+};
+
+#endif
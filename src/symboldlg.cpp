@@ -8,11 +8,13 @@
 #include <kcombobox.h>
 #include <klocale.h>
 #include "symboldlg.h"
-#include "cscopefrontend.h"
-#include "kscopeconfig.h"
+#include "symbolindex.h"
 
 #define MAX_COUNT 20
 
+/** The maximal number of symbols shown in the hint list. */
+#define MAX_HINTS 500
+
 QStringList SymbolDlg::s_slHistory;
 
 /**
@@ -22,11 +24,10 @@ QStringList SymbolDlg::s_slHistory;
  */
 SymbolDlg::SymbolDlg(QWidget* pParent) : 
     QDialog(pParent),
-	m_progress(m_pHintList)
+	m_pCscope(NULL),
+	m_pProgress(NULL)
 {
     setupUi(this);
-	// Create a persistent Cscope process
-	m_pCscope = new CscopeFrontend();
 
     m_pSymbolHC->setFocus();
 	m_pSymbolHC->setMaxCount(MAX_COUNT);
@@ -45,12 +46,12 @@ SymbolDlg::SymbolDlg(QWidget* pParent) :
 	connect(m_pOKButton, SIGNAL(clicked()), this, SLOT(accept()));
 	connect(m_pCancelButton, SIGNAL(clicked()), this, SLOT(reject()));
 	
-	// Run a symbol completion query when the "Hint" button is clicked
+	// Show the hint list when the "Hint" button is clicked
 	connect(m_pHintButton, SIGNAL(clicked()), this, SLOT(slotHintClicked()));
 	
-	// Add results to the hint list
-	connect(m_pCscope, SIGNAL(dataReady(FrontendToken*)), this,
-		SLOT(slotHintDataReady(FrontendToken*)));
+	// Update the hint list as the text is typed
+	connect(m_pSymbolHC, SIGNAL(editTextChanged(const QString&)), this,
+		SLOT(slotRefreshHints()));
 
 	// Set hint button availability based on the type of query
 	connect(m_pTypeCombo, SIGNAL(activated(int)), this, 
@@ -71,12 +72,12 @@ SymbolDlg::SymbolDlg(QWidget* pParent) :
 		SLOT(slotHintOptionChanged(bool)));
 	connect(m_pContainRadio, SIGNAL(toggled(bool)), this,
 		SLOT(slotHintOptionChanged(bool)));
-		
-	// Show hint query progress information
-	connect(m_pCscope, SIGNAL(progress(int, int)), this,
-		SLOT(slotHintProgress(int, int)));
-	connect(m_pCscope, SIGNAL(finished(uint)), this,
-		SLOT(slotHintFinished(uint)));
+	connect(m_pCaseCheck, SIGNAL(toggled(bool)), this,
+		SLOT(slotRefreshHints()));
+	
+	// Refresh the hint list once the symbol dictionary is read
+	connect(SymbolIndex::getInstance(), SIGNAL(updated()), this,
+		SLOT(slotRefreshHints()));
 }
 
 /**
@@ -85,6 +86,7 @@ SymbolDlg::SymbolDlg(QWidget* pParent) :
 SymbolDlg::~SymbolDlg()
 {
 	delete m_pCscope;
+	delete m_pProgress;
 }
 
 /**
@@ -192,21 +194,19 @@ uint SymbolDlg::getQueryType(uint nType)
 }
 
 /**
- * Runs a symbol definition query, looking for symbols starting with the
- * currently entered text.
- * If the hint list is not visible, it is shown first.
- * This slot is connected to the clicked() signal of the "Hint" button.
+ * Lists the defined symbols matching the currently entered text.
+ * The text is matched as a regular expression, either at the beginning of
+ * the symbols or anywhere within them, according to the hint options.
+ * If the symbol dictionary is not available, the symbols are found by a
+ * Cscope query.
  */
-void SymbolDlg::slotHintClicked()
+void SymbolDlg::updateHints()
 {
-	QString sText, sRegExp;
-	
-	// Show the hint list if necessary
-	if (!m_pHintList->isVisible()) {
-		m_pHintList->show();
-		((QWidget*)m_pHintGroup)->show();
-		adjustSize();
-	}
+	QString sText;
+	QStringList slSymbols;
+	QStringList::ConstIterator itr;
+	QList<QTreeWidgetItem*> lstItems;
+	uint nFlags;
 	
 	// Clear the previous contents
 	m_pHintList->clear();
@@ -216,6 +216,49 @@ void SymbolDlg::slotHintClicked()
 	if (sText.isEmpty())
 		return;
 
+	if (!SymbolIndex::isAvailable()) {
+		queryHints(sText);
+		return;
+	}
+	
+	nFlags = SymbolIndex::DefsOnly;
+	if (m_pBeginWithRadio->isChecked())
+		nFlags |= SymbolIndex::BeginWith;
+	if (m_pCaseCheck->isChecked())
+		nFlags |= SymbolIndex::IgnoreCase;
+	
+	// Each symbol appears once in the dictionary
+	SymbolIndex::match(sText, nFlags, MAX_HINTS, slSymbols);
+	for (itr = slSymbols.begin(); itr != slSymbols.end(); ++itr)
+		lstItems.append(new QTreeWidgetItem(QStringList(*itr)));
+	
+	// Add all items at once
+	m_pHintList->addTopLevelItems(lstItems);
+}
+
+/**
+ * Runs a symbol definition query, looking for symbols matching the given
+ * text, according to the hint options.
+ * The results are added to the hint list as they arrive (@see
+ * slotHintDataReady()).
+ * @param	sText	The currently entered text
+ */
+void SymbolDlg::queryHints(const QString& sText)
+{
+	QString sRegExp;
+	
+	// Create a Cscope process on the first query
+	if (m_pCscope == NULL) {
+		m_pProgress = new CscopeProgress(m_pHintList);
+		m_pCscope = new CscopeFrontend();
+		connect(m_pCscope, SIGNAL(dataReady(const FrontendBatch&)), this,
+			SLOT(slotHintDataReady(const FrontendBatch&)));
+		connect(m_pCscope, SIGNAL(progress(int, int)), this,
+			SLOT(slotHintProgress(int, int)));
+		connect(m_pCscope, SIGNAL(finished(uint)), this,
+			SLOT(slotHintFinished(uint)));
+	}
+	
 	// Create the regular expression
 	if (m_pBeginWithRadio->isChecked())
 		sRegExp = sText + "[a-zA-Z0-9_]*";
@@ -223,85 +266,135 @@ void SymbolDlg::slotHintClicked()
 		sRegExp = "[a-zA-Z0-9_]*" + sText + "[a-zA-Z0-9_]*";
 	
 	m_reHint.setPattern(sRegExp);
+	m_reHint.setCaseSensitivity(m_pCaseCheck->isChecked() ?
+		Qt::CaseInsensitive : Qt::CaseSensitive);
 
 	// Run a Cscope symbol definition query using a regular expression
-	m_pCscope->query(CscopeFrontend::Definition, sRegExp);
+	m_pCscope->query(CscopeFrontend::Definition, sRegExp,
+		!m_pCaseCheck->isChecked());
 }
 
 /**
- * Called when a new record is ready to be added to the hint list.
+ * Called when a block of records is ready to be added to the hint list.
  * NOTE: Cscope 15.5 has a bug where the "function" field of the record
  * displays the regular expression instead of the matched symbol name. For
  * this reason, we need to extract the symbol from the "Text" field.
- * @param	pToken	The head of the record's token list
+ * @param	batch	The block of records
  */
-void SymbolDlg::slotHintDataReady(FrontendToken* pToken)
+void SymbolDlg::slotHintDataReady(const FrontendBatch& batch)
 {
-	QString sText;
+	FrontendToken* pToken;
+	QString sText, sSymbol;
+	QSet<QString> setNew;
+	QList<QTreeWidgetItem*> lstItems;
+	int i;
 
-	// Get the line text
-	pToken = pToken->getNext()->getNext()->getNext();
-	sText = pToken->getData();
+	for (i = 0; i < batch.count(); i++) {
+		// Get the line text
+		pToken = batch.at(i)->getNext()->getNext()->getNext();
+		sText = pToken->getData();
 
-	// Find the symbol within the line
-	if (m_reHint.indexIn(sText) == -1)
-		return;
+		// Find the symbol within the line
+		if (m_reHint.indexIn(sText) == -1)
+			continue;
+		
+		// Find the symbol within the list, if found - do not add
+		sSymbol = m_reHint.capturedTexts().at(0);
+		if (setNew.contains(sSymbol) ||
+			!m_pHintList->findItems(sSymbol, Qt::MatchExactly).isEmpty()) {
+			continue;
+		}
+		
+		setNew.insert(sSymbol);
+		lstItems.append(new QTreeWidgetItem(m_reHint.capturedTexts()));
+	}
 	
-    QList<QTreeWidgetItem *> list;
-	list = m_pHintList->findItems(m_reHint.capturedTexts().at(0), Qt::MatchExactly);
-	// Find the symbol within the list, if found - do not add
-	if (list.size() != 0)
-		return;
+	// Add all new items at once
+	m_pHintList->addTopLevelItems(lstItems);
+}
+
+/**
+ * Display a progress bar while the hint query is working.
+ * This slot is connected to the progress() signal emitted by the Cscope
+ * frontend object.
+ * @param	nProgress	Progress value
+ * @param	nTotal		The final expected value
+ */
+void SymbolDlg::slotHintProgress(int nProgress, int nTotal)
+{
+	m_pProgress->setProgress(nProgress, nTotal);
+}
+
+/**
+ * Destroys all progress information widget when the query process terminates.
+ * This slot is connected to the finished() signal emitted by the Cscope
+ * process.
+ */
+void SymbolDlg::slotHintFinished(uint /* ignored */)
+{
+	m_pProgress->finished();
+}
+
+/**
+ * Lists the symbols matching the currently entered text.
+ * If the hint list is not visible, it is shown first, and is then updated
+ * as the text changes.
+ * This slot is connected to the clicked() signal of the "Hint" button.
+ */
+void SymbolDlg::slotHintClicked()
+{
+	// Show the hint list if necessary
+	if (!m_pHintList->isVisible()) {
+		m_pHintList->show();
+		((QWidget*)m_pHintGroup)->show();
+		adjustSize();
+	}
 	
-	// Add a list item
-	(void)new QTreeWidgetItem(m_pHintList, m_reHint.capturedTexts());
+	updateHints();
+}
 
+/**
+ * Updates the hint list, if it is shown, as the text of the symbol
+ * combo-box or the case option change, or once the symbol dictionary is read.
+ * This slot is connected to the editTextChanged() signal of the symbol
+ * combo-box, to the toggled() signal of the case check-box, and to the
+ * updated() signal of the symbol dictionary.
+ */
+void SymbolDlg::slotRefreshHints()
+{
+	if (m_pHintList->isVisible() && m_pHintButton->isEnabled())
+		updateHints();
 }
 
 /**
  * Sets the text of a selected hint list item as the current text of the
  * symbol combo-box. 
- * This slot is connected to the doubleClicked() signal of the hint list-view.
+ * The hint list is not updated for the new text, so that the selection is
+ * kept.
+ * This slot is connected to the currentItemChanged() signal of the hint
+ * list-view.
  * @param	pItem	The clicked list item
  */
 void SymbolDlg::slotHintItemSelected(QTreeWidgetItem* pItem, QTreeWidgetItem*)
 {
+	if (pItem == NULL)
+		return;
+	
+	m_pSymbolHC->blockSignals(true);
 	m_pSymbolHC->setCurrentItem(pItem->text(0));
+	m_pSymbolHC->blockSignals(false);
 }
 
 /**
  * Refreshes the hint list based on the newly selected option.
  * This slot is connected to the toggled() signal of the hint options radio
  * buttons.
- * NOTE: The list is only refreshed if the system profile is set to Fast.
  * @param	bOn	true if the button was toggled on
  */
 void SymbolDlg::slotHintOptionChanged(bool bOn)
 {
-	if (bOn && Config().getSysProfile() == KScopeConfig::Fast)
-		slotHintClicked();
-}
-
-/**
- * Display a progress bar while the hint query is working.
- * This slot is connected to the progress() signal emitted by the Cscope
- * frontend object.
- * @param	nProgress	Progress value
- * @param	nTotal		The final expected value
- */
-void SymbolDlg::slotHintProgress(int nProgress, int nTotal)
-{
-	m_progress.setProgress(nProgress, nTotal);
-}
-
-/**
- * Destroys all progress information widget when the query process terminates.
- * This slot is connected to the finished() signal emitted by the Cscope
- * process.
- */
-void SymbolDlg::slotHintFinished(uint /* ignored */)
-{
-	m_progress.finished();
+	if (bOn && m_pHintList->isVisible())
+		updateHints();
 }
 
 /**
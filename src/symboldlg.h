@@ -12,6 +12,11 @@
  * information (usually a symbol name). This dialogue allows the user to
  * enter this information, as well as complete a symbol name, and use
  * previously entered text.
+ * Once shown, the list of suggested symbols is updated as the text is typed,
+ * and once the symbol dictionary is read again. Suggestions are taken from
+ * the symbol dictionary (@see SymbolIndex), rather than by running a Cscope
+ * query. If the dictionary cannot be read from the database, a Cscope
+ * definition query is run instead.
  * @author Elad Lahav
  */
  
@@ -38,7 +43,8 @@ public:
 	static void resetHistory() { s_slHistory.clear(); }
 	
 private:
-	/** A cscope process used for symbol completion. */
+	/** A Cscope process used for suggesting symbols, if the symbol
+		dictionary is not available (created on demand.) */
 	CscopeFrontend* m_pCscope;
 	
 	/** A regular expression for extracting the symbol name out of the text
@@ -46,18 +52,23 @@ private:
 		@see note in slotHintDataReady(). */
 	QRegExp m_reHint;
 	
-	/** Displays query progress information. */
-	CscopeProgress m_progress;
+	/** Displays query progress information (created with the Cscope
+		process.) */
+	CscopeProgress* m_pProgress;
 	
 	static QStringList s_slHistory;
 	
+	void updateHints();
+	void queryHints(const QString&);
+	
 private slots:
 	void slotHintClicked();
-	void slotHintDataReady(FrontendToken*);
-	void slotHintItemSelected(QTreeWidgetItem*, QTreeWidgetItem*);
-	void slotHintOptionChanged(bool);
+	void slotRefreshHints();
+	void slotHintDataReady(const FrontendBatch&);
 	void slotHintProgress(int, int);
 	void slotHintFinished(uint);
+	void slotHintItemSelected(QTreeWidgetItem*, QTreeWidgetItem*);
+	void slotHintOptionChanged(bool);
 	void slotTypeChanged(int);
 };
 
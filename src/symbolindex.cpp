@@ -0,0 +1,321 @@
+#include <string.h>
+#include <qregexp.h>
+#include "symbolindex.h"
+#include "cscopefrontend.h"
+#include "cscopecache.h"
+#include "cscopeworker.h"
+
+QByteArray SymbolIndex::s_baPool;
+QVector<quint32> SymbolIndex::s_vecNames;
+QBitArray SymbolIndex::s_baDefined;
+bool SymbolIndex::s_bLoaded = false;
+bool SymbolIndex::s_bFailed = false;
+uint SymbolIndex::s_nGeneration = 0;
+SymbolIndex* SymbolIndex::s_pReceiver = NULL;
+uint SymbolIndex::s_nRequest = 0;
+uint SymbolIndex::s_nRequestGeneration = 0;
+
+/**
+ * Class constructor.
+ * A single object is created, to receive the names read by the worker
+ * thread.
+ */
+SymbolIndex::SymbolIndex() : QObject()
+{
+}
+
+/**
+ * Finds the symbols whose names begin with the given prefix.
+ * @param	sPrefix		The prefix to look for
+ * @param	nMax		The maximal number of symbols to return, 0 for no
+ *						limit
+ * @param	slSymbols	Holds the matching names, in alphabetical order, upon
+ *						return
+ * @return	true if any symbols were found, false otherwise
+ */
+bool SymbolIndex::find(const QString& sPrefix, uint nMax,
+	QStringList& slSymbols)
+{
+	quint32 nFirst, nLast;
+
+	slSymbols.clear();
+
+	// Read the names again if the database has changed
+	if (isStale())
+		refresh();
+
+	findPrefix(sPrefix.toUtf8(), nFirst, nLast);
+	for (; nFirst < nLast; nFirst++) {
+		if (nMax > 0 && (uint)slSymbols.count() >= nMax)
+			break;
+
+		slSymbols.append(QString::fromUtf8(s_baPool.constData() +
+			s_vecNames[nFirst]));
+	}
+
+	return !slSymbols.isEmpty();
+}
+
+/**
+ * Finds the symbols whose names match the given pattern.
+ * The pattern is a regular expression. A pattern that is not a valid
+ * expression is matched as plain text. Plain text is matched without
+ * converting the names, and an expression matched at the beginning of the
+ * names is only tried on those beginning with its literal prefix (unless
+ * case is ignored.)
+ * @param	sPattern	The pattern to look for
+ * @param	nFlags		Matching options (@see MatchFlags)
+ * @param	nMax		The maximal number of symbols to return, 0 for no
+ *						limit
+ * @param	slSymbols	Holds the matching names, in alphabetical order, upon
+ *						return
+ * @return	true if any symbols were found, false otherwise
+ */
+bool SymbolIndex::match(const QString& sPattern, uint nFlags, uint nMax,
+	QStringList& slSymbols)
+{
+	QRegExp re;
+	QByteArray baText;
+	const char* szName;
+	quint32 nFirst, nLast;
+	bool bCase, bText, bMatch;
+	int nPos;
+
+	slSymbols.clear();
+	if (sPattern.isEmpty())
+		return false;
+
+	// Read the names again if the database has changed
+	if (isStale())
+		refresh();
+
+	bCase = (nFlags & IgnoreCase) == 0;
+	re.setPattern(sPattern);
+	re.setCaseSensitivity(bCase ? Qt::CaseSensitive : Qt::CaseInsensitive);
+	if (!re.isValid())
+		re.setPattern(QRegExp::escape(sPattern));
+
+	// Plain text is compared directly with the encoded names
+	bText = bCase && (QRegExp::escape(re.pattern()) == re.pattern());
+	if (bText)
+		baText = sPattern.toUtf8();
+
+	// Names are ordered by their encoding, so that only those beginning with
+	// the prefix of the pattern can match at their beginning
+	nFirst = 0;
+	nLast = s_vecNames.size();
+	if ((nFlags & BeginWith) && bCase)
+		findPrefix(getPrefix(re.pattern()).toUtf8(), nFirst, nLast);
+
+	for (; nFirst < nLast; nFirst++) {
+		if ((nFlags & DefsOnly) && !s_baDefined.testBit(nFirst))
+			continue;
+
+		szName = s_baPool.constData() + s_vecNames[nFirst];
+		if (bText && (nFlags & BeginWith)) {
+			bMatch = true;
+		} else if (bText) {
+			bMatch = (strstr(szName, baText.constData()) != NULL);
+		} else {
+			nPos = re.indexIn(QString::fromUtf8(szName));
+			bMatch = (nFlags & BeginWith) ? (nPos == 0) : (nPos >= 0);
+		}
+
+		if (!bMatch)
+			continue;
+
+		if (nMax > 0 && (uint)slSymbols.count() >= nMax)
+			break;
+
+		slSymbols.append(QString::fromUtf8(szName));
+	}
+
+	return !slSymbols.isEmpty();
+}
+
+/**
+ * Discards the names read from the database.
+ * Should be called when the project is closed.
+ */
+void SymbolIndex::reset()
+{
+	// Ignore names requested for the previous project
+	if (s_pReceiver != NULL)
+		CscopeWorker::cancel(s_pReceiver);
+
+	s_nRequest = 0;
+	s_baPool.clear();
+	s_vecNames.clear();
+	s_baDefined.clear();
+	s_bLoaded = false;
+	s_bFailed = false;
+}
+
+/**
+ * Returns the single object receiving the names read from the database,
+ * creating it if required.
+ * @return	The object emitting the updated() signal
+ */
+SymbolIndex* SymbolIndex::getInstance()
+{
+	if (s_pReceiver == NULL)
+		s_pReceiver = new SymbolIndex();
+
+	return s_pReceiver;
+}
+
+/**
+ * Determines whether the names should be read from the database.
+ * The names are not read again for a generation of the database for which
+ * the request has failed.
+ * @return	true if the names were not read for the current generation of the
+ *			database, false otherwise
+ */
+bool SymbolIndex::isStale()
+{
+	if (s_nGeneration != CscopeCache::getGeneration())
+		return true;
+
+	return !s_bLoaded && !s_bFailed;
+}
+
+/**
+ * Requests the names of all symbols from the database, unless they were
+ * already requested for the current generation of the database.
+ * The names are read by a separate thread, and replace the current ones once
+ * they arrive (@see customEvent()).
+ * Should be called whenever the database changes, so that the new names are
+ * available by the time they are looked up.
+ */
+void SymbolIndex::refresh()
+{
+	if ((s_nRequest != 0) &&
+		(s_nRequestGeneration == CscopeCache::getGeneration())) {
+		return;
+	}
+
+	CscopeWorker::cancel(getInstance());
+	s_nRequestGeneration = CscopeCache::getGeneration();
+	s_nRequest = CscopeFrontend::getSymbols(s_pReceiver);
+}
+
+/**
+ * Replaces the names with those read from the database, or marks the
+ * dictionary as unavailable if they could not be read.
+ * @param	pEvent	A CscopeWorkerEvent holding the names
+ */
+void SymbolIndex::customEvent(QEvent* pEvent)
+{
+	CscopeWorkerEvent* pCWE;
+
+	if (pEvent->type() != CscopeWorkerEvent::eventTypeId)
+		return;
+
+	// Ignore the names of superseded requests
+	pCWE = (CscopeWorkerEvent*)pEvent;
+	if (pCWE->m_nSerial != s_nRequest)
+		return;
+
+	s_nRequest = 0;
+	s_nGeneration = s_nRequestGeneration;
+	s_bFailed = !pCWE->m_bSuccess;
+	if (!s_bFailed) {
+		setNames(pCWE->m_lstSymbols, pCWE->m_baDefined);
+		s_bLoaded = true;
+	}
+
+	emit updated();
+}
+
+/**
+ * Stores the names of all symbols.
+ * The names are already ordered, and only need to be copied into the pool.
+ * @param	lstSymbols	The (UTF-8 encoded) names, in alphabetical order
+ * @param	baDefined	Marks the names of defined symbols, by position
+ */
+void SymbolIndex::setNames(const QList<QByteArray>& lstSymbols,
+	const QBitArray& baDefined)
+{
+	int i;
+
+	s_baPool.resize(0);
+	s_vecNames.resize(0);
+	s_vecNames.reserve(lstSymbols.count());
+	for (i = 0; i < lstSymbols.count(); i++) {
+		s_vecNames.append(s_baPool.size());
+		s_baPool.append(lstSymbols[i]);
+		s_baPool.append('\0');
+	}
+
+	s_baDefined = baDefined;
+}
+
+/**
+ * Finds the range of names that begin with the given prefix.
+ * @param	baPrefix	The (UTF-8 encoded) prefix
+ * @param	nFirst		Holds the position of the first matching name in the
+ *						name table, upon return
+ * @param	nLast		Holds the position following the last matching name,
+ *						upon return
+ */
+void SymbolIndex::findPrefix(const QByteArray& baPrefix, quint32& nFirst,
+	quint32& nLast)
+{
+	quint32 nMid, nHigh;
+
+	// Find the first name that is not smaller than the prefix
+	nFirst = 0;
+	nHigh = s_vecNames.size();
+	while (nFirst < nHigh) {
+		nMid = nFirst + (nHigh - nFirst) / 2;
+		if (strcmp(s_baPool.constData() + s_vecNames[nMid],
+			baPrefix.constData()) < 0) {
+			nFirst = nMid + 1;
+		} else {
+			nHigh = nMid;
+		}
+	}
+
+	// Find the first name that follows all names beginning with the prefix
+	nLast = nFirst;
+	nHigh = s_vecNames.size();
+	while (nLast < nHigh) {
+		nMid = nLast + (nHigh - nLast) / 2;
+		if (strncmp(s_baPool.constData() + s_vecNames[nMid],
+			baPrefix.constData(), baPrefix.size()) == 0) {
+			nLast = nMid + 1;
+		} else {
+			nHigh = nMid;
+		}
+	}
+}
+
+/**
+ * Returns the literal text with which every match of a regular expression
+ * begins.
+ * @param	sPattern	The regular expression
+ * @return	The literal prefix, an empty string if the expression begins with
+ *			a special character or contains alternatives
+ */
+QString SymbolIndex::getPrefix(const QString& sPattern)
+{
+	static const QString sSpecial("\\^$.[]()|*+?{}");
+	int i;
+
+	// Alternatives may begin with different text
+	if (sPattern.contains('|'))
+		return "";
+
+	for (i = 0; i < sPattern.length(); i++) {
+		if (sSpecial.contains(sPattern[i]))
+			break;
+	}
+
+	// A character followed by these quantifiers may not appear at all
+	if (i > 0 && i < sPattern.length() && (sPattern[i] == '*' ||
+		sPattern[i] == '?' || sPattern[i] == '{')) {
+		i--;
+	}
+
+	return sPattern.left(i);
+}
@@ -0,0 +1,121 @@
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include <qobject.h>
+#include <qevent.h>
+#include <qstring.h>
+#include <qstringlist.h>
+#include <qbytearray.h>
+#include <qvector.h>
+#include <qbitarray.h>
+#include <qlist.h>
+
+/**
+ * A sorted dictionary of the symbols in the project's database, used for
+ * completing symbol names in the editor and for suggesting symbols in the
+ * query dialogue (@see SymbolDlg).
+ * The names of all symbols are read from the database (@see CscopeDatabase)
+ * by a separate thread (@see CscopeWorker) the first time they are
+ * requested, and are stored in a single pool of NULL-terminated strings. A
+ * table of the positions of the names, ordered by name, allows the names
+ * beginning with a given prefix to be found with a binary search, so that a
+ * completion does not depend on the size of the project. Names can also be
+ * matched against a regular expression, either at their beginning or
+ * anywhere within them. When matching at the beginning, only the names that
+ * begin with the literal prefix of the expression are checked.
+ * The dictionary is read again in the background as soon as the database is
+ * rebuilt, or a delta is loaded (@see refresh()), as well as on the first
+ * lookup following any other change of its generation (@see CscopeCache.)
+ * Until the new names arrive, the previous ones are used, so that lookups
+ * never wait for the database to be read. Objects showing the results of
+ * lookups can connect to the updated() signal of the single instance (@see
+ * getInstance()) to repeat them once the names change.
+ * If the names cannot be read (e.g., the database is in a format that cannot
+ * be read in-process), the dictionary is marked as unavailable, so that
+ * callers can fall back to running Cscope queries.
+ * @author Elad Lahav
+ */
+class SymbolIndex : public QObject
+{
+	Q_OBJECT
+
+public:
+	/**
+	 * Options for match().
+	 */
+	enum MatchFlags {
+		/** Match the pattern at the beginning of the names (rather than
+			anywhere within them.) */
+		BeginWith = 0x01,
+		/** Ignore case when matching. */
+		IgnoreCase = 0x02,
+		/** Only return symbols that are defined in the database (rather than
+			only referenced.) */
+		DefsOnly = 0x04
+	};
+
+	static bool find(const QString&, uint, QStringList&);
+	static bool match(const QString&, uint, uint, QStringList&);
+	static void refresh();
+	static void reset();
+	static SymbolIndex* getInstance();
+
+	/**
+	 * @return	false if the names could not be read from the database, true
+	 *			otherwise (including while they are being read)
+	 */
+	static bool isAvailable() { return !s_bFailed; }
+
+signals:
+	/**
+	 * Emitted when the names are replaced with those read from the
+	 * database, or when they could not be read.
+	 */
+	void updated();
+
+protected:
+	virtual void customEvent(QEvent*);
+
+private:
+	SymbolIndex();
+
+#ifdef TESTCASE
+	friend class SymbolIndexTest;
+#endif
+
+	/** Receives the names read by the worker thread. */
+	static SymbolIndex* s_pReceiver;
+
+	/** The serial number of the request for the names, 0 if there is no
+		such request. */
+	static uint s_nRequest;
+
+	/** The generation of the database when the names were requested. */
+	static uint s_nRequestGeneration;
+
+	/** The names of the symbols, ordered by name. */
+	static QByteArray s_baPool;
+
+	/** The position of each name in the pool, ordered by name. */
+	static QVector<quint32> s_vecNames;
+
+	/** Marks the names of symbols defined in the database, by their
+		position in the above table. */
+	static QBitArray s_baDefined;
+
+	/** true once the names were read from the database. */
+	static bool s_bLoaded;
+
+	/** true if the last request for the names has failed. */
+	static bool s_bFailed;
+
+	/** The generation of the database from which the names were read. */
+	static uint s_nGeneration;
+
+	static bool isStale();
+	static void setNames(const QList<QByteArray>&, const QBitArray&);
+	static void findPrefix(const QByteArray&, quint32&, quint32&);
+	static QString getPrefix(const QString&);
+};
+
+#endif
@@ -0,0 +1,1031 @@
+#include <string.h>
+#include <ctype.h>
+#include <qfile.h>
+#include <qfileinfo.h>
+#include <qset.h>
+#include "tagextractor.h"
+
+/** File name extensions of C and C++ source files. */
+static const char* const SOURCE_SUFFIXES[] = {
+	"c", "h", "C", "H", "cc", "hh", "cpp", "hpp", "cxx", "hxx", "c++", "h++",
+	"inl", "tcc", "ipp"
+};
+
+#define SOURCE_SUFFIX_COUNT	\
+	((int)(sizeof(SOURCE_SUFFIXES) / sizeof(SOURCE_SUFFIXES[0])))
+
+/** C and C++ keywords, which cannot be tag names. */
+static const char* const KEYWORDS[] = {
+	"alignas", "alignof", "asm", "auto", "bool", "break", "case", "catch",
+	"char", "char16_t", "char32_t", "class", "const", "const_cast",
+	"constexpr", "continue", "decltype", "default", "delete", "do", "double",
+	"dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+	"final", "float", "for", "friend", "goto", "if", "inline", "int", "long",
+	"mutable", "namespace", "new", "noexcept", "nullptr", "operator",
+	"override", "private", "protected", "public", "register",
+	"reinterpret_cast", "restrict", "return", "short", "signed", "sizeof",
+	"static", "static_assert", "static_cast", "struct", "switch", "template",
+	"this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+	"typename", "union", "unsigned", "using", "virtual", "void", "volatile",
+	"wchar_t", "while", "_Bool", "__inline", "__inline__", "__restrict",
+	"__restrict__", "__const", "__volatile__", "__extension__"
+};
+
+#define KEYWORD_COUNT	((int)(sizeof(KEYWORDS) / sizeof(KEYWORDS[0])))
+
+/**
+ * @param	szWord	A NULL-terminated string
+ * @return	true if the token's text matches the given string, false
+ *			otherwise
+ */
+bool TagExtractor::Token::isWord(const char* szWord) const
+{
+	return (type == Ident || type == Keyword) &&
+		(strncmp(pText, szWord, nLength) == 0) && (szWord[nLength] == 0);
+}
+
+/**
+ * Class constructor.
+ * @param	pStart		The beginning of the source buffer
+ * @param	pEnd		The end of the source buffer
+ * @param	baOutput	Receives the tags
+ */
+TagExtractor::TagExtractor(const char* pStart, const char* pEnd,
+	QByteArray& baOutput) :
+	m_pPos(pStart),
+	m_pEnd(pEnd),
+	m_nLine(1),
+	m_bLineStart(true),
+	m_baOutput(baOutput),
+	m_bEnumName(false),
+	m_nEnumDepth(0),
+	m_nLastTag(-1)
+{
+}
+
+/**
+ * Determines whether the tags of a file can be extracted in-process.
+ * @param	sFile	The path of the file
+ * @return	true for C and C++ files, false otherwise
+ */
+bool TagExtractor::supports(const QString& sFile)
+{
+	QString sSuffix;
+	int i;
+
+	sSuffix = QFileInfo(sFile).suffix();
+	for (i = 0; i < SOURCE_SUFFIX_COUNT; i++) {
+		if (sSuffix == SOURCE_SUFFIXES[i])
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * Extracts the tags of a file.
+ * @param	sFile		The full path of the file
+ * @param	baOutput	Holds the tags, in the output format of Ctags, upon
+ *						successful return
+ * @return	true if successful, false if the file could not be read
+ */
+bool TagExtractor::extract(const QString& sFile, QByteArray& baOutput)
+{
+	QFile file(sFile);
+	const char* pData;
+
+	baOutput.resize(0);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	if (file.size() == 0)
+		return true;
+
+	pData = (const char*)file.map(0, file.size());
+	if (pData == NULL)
+		return false;
+
+	TagExtractor extractor(pData, pData + file.size(), baOutput);
+	extractor.parse();
+
+	file.unmap((uchar*)pData);
+	return true;
+}
+
+/**
+ * Scans the source buffer, and writes the tags found in it.
+ */
+void TagExtractor::parse()
+{
+	Token tok;
+
+	openBlock(Global);
+
+	while (nextToken(tok)) {
+		switch (m_vecBlocks.last().type) {
+		case Body:
+			parseBody(tok);
+			break;
+
+		case Init:
+			parseInit(tok);
+			break;
+
+		case Enum:
+			parseEnum(tok);
+			break;
+
+		default:
+			parseDecl(tok);
+		}
+	}
+
+	addEnds();
+}
+
+/**
+ * Reads the next token from the source buffer.
+ * Comments and preprocessor directives are handled here, and are never
+ * returned as tokens.
+ * @param	tok	Holds the token, upon successful return
+ * @return	true if a token was read, false at the end of the buffer
+ */
+bool TagExtractor::nextToken(Token& tok)
+{
+	const char* pStart;
+	char c;
+
+	while (m_pPos < m_pEnd) {
+		c = *m_pPos;
+
+		// Skip white space
+		if (c == '\n') {
+			m_nLine++;
+			m_bLineStart = true;
+			m_pPos++;
+			continue;
+		}
+
+		if (isspace((uchar)c)) {
+			m_pPos++;
+			continue;
+		}
+
+		// Skip comments
+		if (c == '/' && m_pPos + 1 < m_pEnd) {
+			if (m_pPos[1] == '/') {
+				skipLine();
+				continue;
+			}
+
+			if (m_pPos[1] == '*') {
+				skipComment();
+				continue;
+			}
+		}
+
+		// Handle preprocessor directives
+		if (c == '#' && m_bLineStart) {
+			m_pPos++;
+			parseDirective();
+			continue;
+		}
+
+		m_bLineStart = false;
+		pStart = m_pPos;
+		tok.pText = pStart;
+		tok.nLine = m_nLine;
+
+		// String and character literals
+		if (c == '"' || c == '\'') {
+			for (m_pPos++; m_pPos < m_pEnd && *m_pPos != c; m_pPos++) {
+				if (*m_pPos == '\\' && m_pPos + 1 < m_pEnd)
+					m_pPos++;
+
+				if (*m_pPos == '\n')
+					m_nLine++;
+			}
+
+			if (m_pPos < m_pEnd)
+				m_pPos++;
+
+			tok.type = Literal;
+			tok.nLength = m_pPos - pStart;
+			return true;
+		}
+
+		// Identifiers and keywords
+		if (isalpha((uchar)c) || c == '_' || c == '$') {
+			while (m_pPos < m_pEnd && (isalnum((uchar)*m_pPos) ||
+				*m_pPos == '_' || *m_pPos == '$')) {
+				m_pPos++;
+			}
+
+			tok.nLength = m_pPos - pStart;
+
+			// Compiler extensions do not affect the declarations
+			if ((tok.nLength == 13 &&
+					strncmp(pStart, "__attribute__", 13) == 0) ||
+				(tok.nLength == 10 &&
+					strncmp(pStart, "__declspec", 10) == 0) ||
+				(tok.nLength == 7 && strncmp(pStart, "__asm__", 7) == 0)) {
+				skipParens();
+				continue;
+			}
+
+			tok.type = isKeyword(pStart, tok.nLength) ? Keyword : Ident;
+			return true;
+		}
+
+		// Numbers
+		if (isdigit((uchar)c)) {
+			while (m_pPos < m_pEnd && (isalnum((uchar)*m_pPos) ||
+				*m_pPos == '.' || *m_pPos == '_')) {
+				m_pPos++;
+			}
+
+			tok.type = Literal;
+			tok.nLength = m_pPos - pStart;
+			return true;
+		}
+
+		// Punctuation (the scope operator is the only multi-character
+		// operator of interest)
+		m_pPos++;
+		if (c == ':' && m_pPos < m_pEnd && *m_pPos == ':') {
+			m_pPos++;
+			tok.type = Scope;
+			tok.nLength = 2;
+			return true;
+		}
+
+		tok.type = Punct;
+		tok.nLength = 1;
+		return true;
+	}
+
+	tok.type = Eof;
+	return false;
+}
+
+/**
+ * Advances to the end of the current line (not including the newline
+ * character.)
+ */
+void TagExtractor::skipLine()
+{
+	while (m_pPos < m_pEnd && *m_pPos != '\n')
+		m_pPos++;
+}
+
+/**
+ * Skips a C-style comment.
+ * The current position should be at the opening "/ *".
+ */
+void TagExtractor::skipComment()
+{
+	for (m_pPos += 2; m_pPos < m_pEnd; m_pPos++) {
+		if (*m_pPos == '\n') {
+			m_nLine++;
+		} else if (*m_pPos == '*' && m_pPos + 1 < m_pEnd &&
+			m_pPos[1] == '/') {
+			m_pPos += 2;
+			return;
+		}
+	}
+}
+
+/**
+ * Skips a balanced list of parentheses, if one follows the current
+ * position.
+ */
+void TagExtractor::skipParens()
+{
+	int nDepth;
+
+	while (m_pPos < m_pEnd && isspace((uchar)*m_pPos)) {
+		if (*m_pPos == '\n')
+			m_nLine++;
+
+		m_pPos++;
+	}
+
+	if (m_pPos == m_pEnd || *m_pPos != '(')
+		return;
+
+	for (nDepth = 0; m_pPos < m_pEnd; m_pPos++) {
+		if (*m_pPos == '(') {
+			nDepth++;
+		} else if (*m_pPos == ')') {
+			if (--nDepth == 0) {
+				m_pPos++;
+				return;
+			}
+		} else if (*m_pPos == '\n') {
+			m_nLine++;
+		}
+	}
+}
+
+/**
+ * Reads the name of a preprocessor directive, or the first word following
+ * it.
+ * White space (but not a new line) preceding the word is skipped.
+ * @return	The word, which may be empty
+ */
+QByteArray TagExtractor::readWord()
+{
+	const char* pStart;
+
+	while (m_pPos < m_pEnd && (*m_pPos == ' ' || *m_pPos == '\t'))
+		m_pPos++;
+
+	pStart = m_pPos;
+	while (m_pPos < m_pEnd && (isalnum((uchar)*m_pPos) || *m_pPos == '_'))
+		m_pPos++;
+
+	return QByteArray::fromRawData(pStart, m_pPos - pStart);
+}
+
+/**
+ * Handles a preprocessor directive.
+ * Macro definitions and included files are reported as tags. Conditional
+ * directives determine the parts of the file that are skipped. The rest of
+ * the directive (including any continuation lines) is ignored.
+ * The current position should follow the '#' character.
+ */
+void TagExtractor::parseDirective()
+{
+	QByteArray baDirective, baWord;
+	const char* pStart;
+	char cEnd;
+
+	baDirective = readWord();
+
+	if (baDirective == "define") {
+		baWord = readWord();
+		if (!baWord.isEmpty())
+			addTag(baWord.constData(), baWord.size(), m_nLine, 'd');
+	} else if (baDirective == "include" || baDirective == "include_next" ||
+		baDirective == "import") {
+		while (m_pPos < m_pEnd && (*m_pPos == ' ' || *m_pPos == '\t'))
+			m_pPos++;
+
+		if (m_pPos < m_pEnd && (*m_pPos == '<' || *m_pPos == '"')) {
+			cEnd = (*m_pPos == '<') ? '>' : '"';
+			pStart = ++m_pPos;
+			while (m_pPos < m_pEnd && *m_pPos != cEnd && *m_pPos != '\n')
+				m_pPos++;
+
+			if (m_pPos > pStart)
+				addTag(pStart, m_pPos - pStart, m_nLine, 'i');
+		}
+	} else if (baDirective == "if" || baDirective == "ifdef" ||
+		baDirective == "ifndef") {
+		// Remember the nesting of braces at the beginning of the block
+		m_vecCond.append(getBraceLevel());
+
+		// Skip "#if 0" blocks, up to an "#else", "#elif" or "#endif"
+		if (baDirective == "if" && readWord() == "0") {
+			if (!skipBranch(true))
+				m_vecCond.pop_back();
+			return;
+		}
+	} else if (baDirective == "else" || baDirective == "elif") {
+		// As with Ctags, all parts of a conditional block are parsed, unless
+		// a previous part left braces unbalanced (e.g., a different function
+		// header in each part, followed by an opening brace.) Parsing the
+		// rest of the block would then open another scope, so it is skipped
+		// instead
+		if (!m_vecCond.isEmpty() && m_vecCond.last() != getBraceLevel()) {
+			skipBranch(false);
+			m_vecCond.pop_back();
+			return;
+		}
+
+		// Skip "#elif 0" parts
+		if (baDirective == "elif" && readWord() == "0") {
+			if (!skipBranch(true) && !m_vecCond.isEmpty())
+				m_vecCond.pop_back();
+			return;
+		}
+	} else if (baDirective == "endif") {
+		if (!m_vecCond.isEmpty())
+			m_vecCond.pop_back();
+	}
+
+	// Skip the rest of the directive, including continuation lines and
+	// comments
+	while (m_pPos < m_pEnd && *m_pPos != '\n') {
+		if (*m_pPos == '\\' && m_pPos + 1 < m_pEnd && m_pPos[1] == '\n') {
+			m_pPos += 2;
+			m_nLine++;
+		} else if (*m_pPos == '/' && m_pPos + 1 < m_pEnd &&
+			m_pPos[1] == '*') {
+			skipComment();
+		} else if (*m_pPos == '/' && m_pPos + 1 < m_pEnd &&
+			m_pPos[1] == '/') {
+			skipLine();
+		} else {
+			m_pPos++;
+		}
+	}
+}
+
+/**
+ * Skips a part of a conditional block.
+ * Nested conditional blocks are skipped as a whole.
+ * @param	bElse	true to stop at an "#else" or "#elif" directive of the
+ *					current block (resuming the parsing of this part), false
+ *					to skip all the way to the "#endif" directive
+ * @return	true if stopped at an "#else" or "#elif" directive, false if the
+ *			block has ended
+ */
+bool TagExtractor::skipBranch(bool bElse)
+{
+	QByteArray baDirective;
+	int nDepth;
+	bool bResult;
+
+	nDepth = 0;
+	for (;;) {
+		// Advance to the next line
+		skipLine();
+		if (m_pPos == m_pEnd)
+			return false;
+
+		m_pPos++;
+		m_nLine++;
+
+		while (m_pPos < m_pEnd && (*m_pPos == ' ' || *m_pPos == '\t'))
+			m_pPos++;
+
+		if (m_pPos == m_pEnd || *m_pPos != '#')
+			continue;
+
+		m_pPos++;
+		baDirective = readWord();
+		if (baDirective == "if" || baDirective == "ifdef" ||
+			baDirective == "ifndef") {
+			nDepth++;
+		} else if (baDirective == "endif") {
+			if (nDepth-- == 0) {
+				bResult = false;
+				break;
+			}
+		} else if (bElse && nDepth == 0 &&
+			(baDirective == "else" || baDirective == "elif")) {
+			bResult = true;
+			break;
+		}
+	}
+
+	// Ignore the rest of the terminating directive
+	skipLine();
+	m_bLineStart = true;
+	return bResult;
+}
+
+/**
+ * @return	The number of braces currently open
+ */
+int TagExtractor::getBraceLevel() const
+{
+	return m_vecBlocks.count() + m_vecBlocks.last().nDepth;
+}
+
+/**
+ * Handles a token at the global, namespace or structure level.
+ * Tokens are collected until the end of a statement, or until a brace is
+ * opened.
+ * @param	tok	The token to handle
+ */
+void TagExtractor::parseDecl(const Token& tok)
+{
+	if (tok.is(';')) {
+		endStatement();
+		m_vecStmt.clear();
+		return;
+	}
+
+	if (tok.is('{')) {
+		openBrace();
+		return;
+	}
+
+	if (tok.is('}')) {
+		if (m_vecBlocks.last().type == Global)
+			m_vecStmt.clear();
+		else
+			closeBlock();
+		return;
+	}
+
+	// Access specifiers (including Qt's "signals" and "slots" sections)
+	if (tok.is(':') && m_vecBlocks.last().type == Aggregate &&
+		!m_vecStmt.isEmpty() && (m_vecStmt.count() == 1 ||
+		m_vecStmt.last().isWord("public") ||
+		m_vecStmt.last().isWord("protected") ||
+		m_vecStmt.last().isWord("private") ||
+		m_vecStmt.last().isWord("slots") ||
+		m_vecStmt.last().isWord("Q_SLOTS"))) {
+		m_vecStmt.clear();
+		return;
+	}
+
+	m_vecStmt.append(tok);
+}
+
+/**
+ * Handles a token inside a function body.
+ * Only labels are reported.
+ * @param	tok	The token to handle
+ */
+void TagExtractor::parseBody(const Token& tok)
+{
+	Block& block = m_vecBlocks.last();
+
+	if (tok.is('{')) {
+		block.nDepth++;
+	} else if (tok.is('}')) {
+		if (block.nDepth == 0) {
+			closeBlock();
+			return;
+		}
+
+		block.nDepth--;
+	} else if (tok.is(':') && m_arrPrev[0].type == Ident &&
+		(m_arrPrev[1].is(';') || m_arrPrev[1].is('{') ||
+		m_arrPrev[1].is('}'))) {
+		addTag(m_arrPrev[0], 'l');
+	}
+
+	m_arrPrev[1] = m_arrPrev[0];
+	m_arrPrev[0] = tok;
+}
+
+/**
+ * Handles a token inside an initialiser.
+ * @param	tok	The token to handle
+ */
+void TagExtractor::parseInit(const Token& tok)
+{
+	Block& block = m_vecBlocks.last();
+
+	if (tok.is('{')) {
+		block.nDepth++;
+	} else if (tok.is('}')) {
+		if (block.nDepth == 0)
+			closeBlock();
+		else
+			block.nDepth--;
+	}
+}
+
+/**
+ * Handles a token inside the body of an enumeration.
+ * The first identifier in each comma-separated item is an enumerator.
+ * @param	tok	The token to handle
+ */
+void TagExtractor::parseEnum(const Token& tok)
+{
+	if (tok.is('}') && m_nEnumDepth == 0) {
+		closeBlock();
+		return;
+	}
+
+	if (tok.is('(') || tok.is('{')) {
+		m_nEnumDepth++;
+	} else if (tok.is(')') || tok.is('}')) {
+		m_nEnumDepth--;
+	} else if (tok.is(',') && m_nEnumDepth == 0) {
+		m_bEnumName = true;
+	} else if (tok.type == Ident && m_bEnumName) {
+		addTag(tok, 'e');
+		m_bEnumName = false;
+	}
+}
+
+/**
+ * Opens a new block.
+ * The current statement is stored with the block, and is restored once the
+ * block is closed.
+ * @param	type	The type of the block
+ * @param	nTag	The position in the output of the end of the tag defined
+ *					by the block, -1 if none
+ */
+void TagExtractor::openBlock(BlockType type, int nTag)
+{
+	Block block;
+
+	block.type = type;
+	block.vecStmt = m_vecStmt;
+	block.nDepth = 0;
+	block.nTag = nTag;
+	m_vecBlocks.append(block);
+	m_vecStmt.clear();
+
+	if (type == Body) {
+		m_arrPrev[0].type = Punct;
+		m_arrPrev[0].pText = "{";
+		m_arrPrev[1] = m_arrPrev[0];
+	} else if (type == Enum) {
+		m_bEnumName = true;
+		m_nEnumDepth = 0;
+	}
+}
+
+/**
+ * Closes the current block.
+ * Statements that include the definition of a structure or enumeration, or
+ * an initialiser, continue after the closing brace (e.g., the names of
+ * variables or types defined by the statement.) A type marker replaces the
+ * block in the statement.
+ */
+void TagExtractor::closeBlock()
+{
+	Token tok;
+	BlockType type;
+
+	type = m_vecBlocks.last().type;
+	m_vecStmt = m_vecBlocks.last().vecStmt;
+	if (m_vecBlocks.last().nTag >= 0)
+		m_mapEnds.insert(m_vecBlocks.last().nTag, m_nLine);
+	m_vecBlocks.pop_back();
+
+	switch (type) {
+	case Aggregate:
+	case Enum:
+	case Init:
+		tok.type = TypeMark;
+		tok.pText = "}";
+		tok.nLength = 1;
+		tok.nLine = m_nLine;
+		m_vecStmt.append(tok);
+		break;
+
+	default:
+		m_vecStmt.clear();
+	}
+}
+
+/**
+ * Handles an opening brace at the global, namespace or structure level.
+ * Determines whether the brace opens a namespace, the definition of a
+ * structure or an enumeration, a function body, or an initialiser.
+ */
+void TagExtractor::openBrace()
+{
+	int i, nCount, nDepth, nParen, nAggr, nColon, nAngle;
+	const Token* pName;
+	char cKind;
+
+	nCount = m_vecStmt.count();
+
+	// Find the first parenthesis, the last aggregate keyword, and any
+	// colon, at the top level of the statement
+	// Keywords inside angle brackets belong to template parameter lists
+	// (e.g., "template <class T> void foo(T x) {"), and are ignored
+	nParen = nAggr = nColon = -1;
+	nAngle = 0;
+	for (i = 0, nDepth = 0; i < nCount; i++) {
+		const Token& tok = m_vecStmt[i];
+
+		if (tok.is('(') || tok.is('[')) {
+			if (nDepth++ == 0 && nParen < 0 && tok.is('('))
+				nParen = i;
+		} else if (tok.is(')') || tok.is(']')) {
+			nDepth--;
+		} else if (nDepth > 0) {
+			continue;
+		} else if (tok.is('<')) {
+			nAngle++;
+		} else if (tok.is('>')) {
+			// Not a closing bracket in "->"
+			if (nAngle > 0)
+				nAngle--;
+		} else if (nAngle == 0) {
+			// Note that "enum class" defines an enumeration
+			if (tok.isWord("struct") || tok.isWord("union") ||
+				tok.isWord("class") || tok.isWord("enum")) {
+				if (i == 0 || !m_vecStmt[i - 1].isWord("enum"))
+					nAggr = i;
+			} else if (tok.is(':')) {
+				nColon = i;
+			}
+		}
+	}
+
+	// A brace inside parentheses (e.g., a GNU statement expression in a
+	// macro invocation)
+	if (nDepth > 0) {
+		openBlock(Init);
+		return;
+	}
+
+	// Namespaces and linkage specifications
+	if (nCount > 0 && m_vecStmt.first().isWord("namespace")) {
+		if (nCount > 1 && m_vecStmt[1].type == Ident) {
+			addTag(m_vecStmt[1], 'n');
+			openBlock(Namespace, m_nLastTag);
+		} else {
+			openBlock(Namespace);
+		}
+
+		return;
+	}
+
+	if (nCount == 2 && m_vecStmt[0].isWord("extern") &&
+		m_vecStmt[1].type == Literal) {
+		openBlock(Namespace);
+		return;
+	}
+
+	// Structures, unions, classes and enumerations
+	// The keyword may only be followed by the name (possibly preceded by
+	// macros and followed by template arguments or "final"), and by a list of
+	// base classes
+	if (nAggr >= 0) {
+		pName = NULL;
+		nAngle = 0;
+		for (i = nAggr + 1; i < nCount; i++) {
+			const Token& tok = m_vecStmt[i];
+
+			if (tok.is(':') && nAngle == 0)
+				break;
+
+			if (tok.is('<')) {
+				nAngle++;
+			} else if (tok.is('>')) {
+				nAngle--;
+			} else if (nAngle == 0) {
+				if (tok.type == Ident)
+					pName = &tok;
+				else if (tok.type != Scope && !tok.isWord("final") &&
+					!tok.isWord("class") && !tok.isWord("struct"))
+					break;
+			}
+		}
+
+		if (i == nCount || (m_vecStmt[i].is(':') && nAngle == 0)) {
+			switch (m_vecStmt[nAggr].pText[0]) {
+			case 's':
+				cKind = 's';
+				break;
+
+			case 'u':
+				cKind = 'u';
+				break;
+
+			case 'c':
+				cKind = 'c';
+				break;
+
+			default:
+				cKind = 'g';
+			}
+
+			if (pName != NULL)
+				addTag(*pName, cKind);
+
+			openBlock(cKind == 'g' ? Enum : Aggregate,
+				pName != NULL ? m_nLastTag : -1);
+			return;
+		}
+	}
+
+	// Functions
+	// A brace following a colon after the parameter list, and an identifier,
+	// initialises a member in a constructor's initialiser list
+	if (nParen > 0 && m_vecStmt[nParen - 1].type == Ident) {
+		for (i = 0; i < nParen; i++) {
+			if (m_vecStmt[i].is('='))
+				break;
+		}
+
+		if (i == nParen) {
+			if (nColon > nParen && m_vecStmt.last().type == Ident) {
+				openBlock(Init);
+				return;
+			}
+
+			addTag(m_vecStmt[nParen - 1], 'f');
+			m_vecStmt.clear();
+			openBlock(Body, m_nLastTag);
+			return;
+		}
+	}
+
+	// Anything else is an initialiser
+	openBlock(Init);
+}
+
+/**
+ * Handles the end of a statement at the global, namespace or structure
+ * level.
+ * The statement is reported if it declares variables, members or types.
+ * Declarations of functions and extern variables are ignored.
+ */
+void TagExtractor::endStatement()
+{
+	int i, nStart, nCount, nDepth;
+	bool bTypedef;
+	char cKind;
+
+	nCount = m_vecStmt.count();
+	if (nCount == 0)
+		return;
+
+	// Determine the kind of declaration
+	bTypedef = false;
+	for (i = 0; i < nCount; i++) {
+		const Token& tok = m_vecStmt[i];
+
+		if (tok.isWord("extern") || tok.isWord("using") ||
+			tok.isWord("friend") || tok.isWord("template") ||
+			tok.isWord("static_assert") || tok.isWord("namespace")) {
+			return;
+		}
+
+		if (tok.isWord("typedef"))
+			bTypedef = true;
+	}
+
+	if (bTypedef)
+		cKind = 't';
+	else if (m_vecBlocks.last().type == Aggregate)
+		cKind = 'm';
+	else
+		cKind = 'v';
+
+	// Handle each declarator in turn
+	// Template arguments are only expected before the first declarator
+	for (i = 0, nStart = 0, nDepth = 0; i < nCount; i++) {
+		const Token& tok = m_vecStmt[i];
+
+		if (tok.is('(') || tok.is('[') || tok.is('{') ||
+			(tok.is('<') && nStart == 0)) {
+			nDepth++;
+		} else if (tok.is(')') || tok.is(']') || tok.is('}') ||
+			(tok.is('>') && nStart == 0 && nDepth > 0)) {
+			nDepth--;
+		} else if (tok.is(',') && nDepth == 0) {
+			addDeclarator(nStart, i, cKind, nStart == 0);
+			nStart = i + 1;
+		}
+	}
+
+	addDeclarator(nStart, nCount, cKind, nStart == 0);
+}
+
+/**
+ * Reports the name declared by a single declarator.
+ * @param	nStart	The index of the declarator's first token in the
+ *					current statement
+ * @param	nEnd	The index following the declarator's last token
+ * @param	cKind	The kind of tag to report
+ * @param	bFirst	true for the first declarator in the statement (which
+ *					also includes the type)
+ */
+void TagExtractor::addDeclarator(int nStart, int nEnd, char cKind,
+	bool bFirst)
+{
+	const Token* pName;
+	int i, nDepth, nTypes;
+
+	pName = NULL;
+	nTypes = 0;
+	for (i = nStart, nDepth = 0; i < nEnd; i++) {
+		const Token& tok = m_vecStmt[i];
+
+		// A pointer to a function: the name follows the '*'
+		if (tok.is('(') && nDepth == 0 && i + 1 < nEnd &&
+			(m_vecStmt[i + 1].is('*') || m_vecStmt[i + 1].is('&') ||
+			m_vecStmt[i + 1].is('^'))) {
+			for (i++; i < nEnd && m_vecStmt[i].type != Ident; i++)
+				;
+
+			if (i < nEnd)
+				addTag(m_vecStmt[i], cKind);
+			return;
+		}
+
+		// A function declaration (or an object constructed with arguments,
+		// which cannot be told apart), unless defining a type
+		if (tok.is('(') && nDepth == 0) {
+			if (cKind == 't' && pName != NULL)
+				break;
+
+			return;
+		}
+
+		// The name precedes the initialiser, array dimensions or bit-field
+		// width
+		if (nDepth == 0 && (tok.is('=') || tok.is('[') || tok.is(':') ||
+			tok.is('{'))) {
+			break;
+		}
+
+		if (tok.is('<')) {
+			nDepth++;
+		} else if (tok.is('>')) {
+			nDepth--;
+		} else if (nDepth == 0) {
+			if (tok.type == Ident) {
+				// The name of a structure is part of the type
+				if (i > nStart && (m_vecStmt[i - 1].isWord("struct") ||
+					m_vecStmt[i - 1].isWord("union") ||
+					m_vecStmt[i - 1].isWord("class") ||
+					m_vecStmt[i - 1].isWord("enum"))) {
+					nTypes++;
+					continue;
+				}
+
+				if (pName != NULL)
+					nTypes++;
+
+				pName = &tok;
+			} else if (tok.type == Keyword || tok.type == TypeMark) {
+				nTypes++;
+			}
+		}
+	}
+
+	// The first declarator must include a type
+	if (pName != NULL && (!bFirst || nTypes > 0))
+		addTag(*pName, cKind);
+}
+
+/**
+ * Writes a tag, using a token as its name.
+ * @param	tok		The token
+ * @param	cKind	The kind of tag
+ */
+void TagExtractor::addTag(const Token& tok, char cKind)
+{
+	addTag(tok.pText, tok.nLength, tok.nLine, cKind);
+}
+
+/**
+ * Writes a tag in the output format of Ctags.
+ * @param	pName	The name of the tag
+ * @param	nLength	The length of the name
+ * @param	nLine	The line on which the tag is defined
+ * @param	cKind	The kind of tag
+ */
+void TagExtractor::addTag(const char* pName, int nLength, int nLine,
+	char cKind)
+{
+	m_baOutput.append(pName, nLength);
+	m_baOutput += "\t-\t";
+	m_baOutput += QByteArray::number(nLine);
+	m_baOutput += ";\"\t";
+	m_baOutput += cKind;
+	m_nLastTag = m_baOutput.size();
+	m_baOutput += '\n';
+}
+
+/**
+ * Appends an "end:" field to each tag whose block was closed.
+ * The fields are only known once the blocks end, after the tags inside them
+ * were written, and so are added in a single pass over the output.
+ */
+void TagExtractor::addEnds()
+{
+	QMap<int, int>::ConstIterator itr;
+	QByteArray baOutput;
+	int nPos;
+
+	if (m_mapEnds.isEmpty())
+		return;
+
+	nPos = 0;
+	baOutput.reserve(m_baOutput.size() + m_mapEnds.count() * 10);
+	for (itr = m_mapEnds.begin(); itr != m_mapEnds.end(); ++itr) {
+		baOutput.append(m_baOutput.constData() + nPos, itr.key() - nPos);
+		baOutput += "\tend:";
+		baOutput += QByteArray::number(*itr);
+		nPos = itr.key();
+	}
+
+	baOutput.append(m_baOutput.constData() + nPos, m_baOutput.size() - nPos);
+	m_baOutput = baOutput;
+}
+
+/**
+ * @param	pText	A word
+ * @param	nLength	The length of the word
+ * @return	true if the word is a C or C++ keyword, false otherwise
+ */
+bool TagExtractor::isKeyword(const char* pText, int nLength)
+{
+	static QSet<QByteArray> setKeywords;
+	int i;
+
+	if (setKeywords.isEmpty()) {
+		for (i = 0; i < KEYWORD_COUNT; i++)
+			setKeywords.insert(KEYWORDS[i]);
+	}
+
+	return setKeywords.contains(QByteArray::fromRawData(pText, nLength));
+}
@@ -0,0 +1,164 @@
+#ifndef TAGEXTRACTOR_H
+#define TAGEXTRACTOR_H
+
+#include <qstring.h>
+#include <qbytearray.h>
+#include <qvector.h>
+#include <qmap.h>
+
+/**
+ * Extracts the tags of a C or C++ source file, without running Ctags.
+ * The file is mapped into memory, and is scanned once by a simple tokeniser
+ * (which skips comments and literals, and handles preprocessor directives),
+ * followed by a parser that only tracks the structure of declarations: the
+ * nesting of braces, and the statements at the global, namespace and
+ * structure levels. Function bodies and initialisers are skipped, except for
+ * labels inside function bodies. As with Ctags, code in "#if 0" blocks is
+ * ignored, while all other parts of conditional blocks are parsed (unless a
+ * part leaves braces unbalanced, in which case the following parts of the
+ * block are skipped.)
+ * The tags are written in the output format of Ctags (with the file name
+ * replaced by a '-'), using the same single-letter kinds: functions,
+ * variables, structures, unions, classes, enumerations, enumerators,
+ * typedefs, members, macros, namespaces, labels and included files.
+ * Prototypes and extern declarations are not reported (as with the default
+ * settings of Ctags.) The tags of functions, namespaces, structures and
+ * enumerations are followed by an "end:" field, holding the line of the
+ * closing brace.
+ * @author Elad Lahav
+ */
+class TagExtractor
+{
+public:
+	static bool supports(const QString&);
+	static bool extract(const QString&, QByteArray&);
+
+private:
+	/** Types of tokens returned by the tokeniser. */
+	enum TokenType { Eof, Ident, Keyword, Literal, Punct, Scope, TypeMark };
+
+	/**
+	 * A token in the source buffer.
+	 */
+	struct Token
+	{
+		/** The type of the token. */
+		TokenType type;
+
+		/** The text of the token in the source buffer. */
+		const char* pText;
+
+		/** The length of the token's text. */
+		int nLength;
+
+		/** The line on which the token begins. */
+		int nLine;
+
+		/**
+		 * @param	c	A punctuation character
+		 * @return	true if this is the given punctuation token, false
+		 *			otherwise
+		 */
+		bool is(char c) const {
+			return type == Punct && *pText == c;
+		}
+
+		bool isWord(const char*) const;
+	};
+
+	/** Types of brace-delimited blocks. */
+	enum BlockType { Global, Namespace, Aggregate, Enum, Body, Init };
+
+	/**
+	 * An open brace-delimited block.
+	 */
+	struct Block
+	{
+		/** The type of the block. */
+		BlockType type;
+
+		/** The statement in which the block was opened, restored once the
+			block is closed. */
+		QVector<Token> vecStmt;
+
+		/** The depth of nested braces inside the block (for function bodies
+			and initialisers.) */
+		int nDepth;
+
+		/** The position in the output of the end of the tag defined by the
+			block (before the new-line character), -1 if none. */
+		int nTag;
+	};
+
+	/** The current position in the source buffer. */
+	const char* m_pPos;
+
+	/** The end of the source buffer. */
+	const char* m_pEnd;
+
+	/** The current line number. */
+	int m_nLine;
+
+	/** true if only white space was read since the beginning of the current
+		line. */
+	bool m_bLineStart;
+
+	/** Receives the tags. */
+	QByteArray& m_baOutput;
+
+	/** The stack of open blocks. */
+	QVector<Block> m_vecBlocks;
+
+	/** The tokens of the current statement. */
+	QVector<Token> m_vecStmt;
+
+	/** The two tokens preceding the current one (inside function
+		bodies.) */
+	Token m_arrPrev[2];
+
+	/** true while reading the next enumerator's name. */
+	bool m_bEnumName;
+
+	/** The depth of parentheses in an enumerator's value. */
+	int m_nEnumDepth;
+
+	/** The position in the output of the end of the last tag written. */
+	int m_nLastTag;
+
+	/** Maps the positions of tags in the output to the lines on which their
+		blocks end. */
+	QMap<int, int> m_mapEnds;
+
+	/** The number of braces open at the beginning of each of the current
+		conditional blocks. */
+	QVector<int> m_vecCond;
+
+	TagExtractor(const char*, const char*, QByteArray&);
+
+	void parse();
+	bool nextToken(Token&);
+	void skipLine();
+	void skipComment();
+	void skipParens();
+	bool skipBranch(bool);
+	int getBraceLevel() const;
+	void parseDirective();
+	QByteArray readWord();
+
+	void parseDecl(const Token&);
+	void parseBody(const Token&);
+	void parseInit(const Token&);
+	void parseEnum(const Token&);
+	void openBlock(BlockType, int nTag = -1);
+	void closeBlock();
+	void openBrace();
+	void endStatement();
+	void addDeclarator(int, int, char, bool);
+	void addTag(const Token&, char);
+	void addTag(const char*, int, int, char);
+	void addEnds();
+
+	static bool isKeyword(const char*, int);
+};
+
+#endif
@@ -0,0 +1,327 @@
+#include <limits.h>
+#include <qalgorithms.h>
+#include <qpair.h>
+#include "tagscopeindex.h"
+
+/**
+ * The lines spanned by a scope, used while building the ranges.
+ */
+struct TagScope
+{
+	/** The line on which the scope begins. */
+	uint nStart;
+
+	/** The last line of the scope. */
+	uint nEnd;
+
+	/** The tag defining the scope. */
+	int nTag;
+};
+
+/**
+ * Orders scopes by their first lines. Scopes that begin on the same line are
+ * ordered from the outermost to the innermost.
+ * @param	scope1	The first scope
+ * @param	scope2	The second scope
+ * @return	true if the first scope should precede the second, false
+ *			otherwise
+ */
+static bool scopeLessThan(const TagScope& scope1, const TagScope& scope2)
+{
+	if (scope1.nStart != scope2.nStart)
+		return scope1.nStart < scope2.nStart;
+
+	return scope1.nEnd > scope2.nEnd;
+}
+
+/**
+ * Class constructor.
+ */
+TagScopeIndex::TagScopeIndex()
+{
+}
+
+/**
+ * Adds a tag to the index.
+ * The index needs to be rebuilt (by calling build()) before it reflects the
+ * new tag.
+ * @param	nLine	The line on which the tag is defined
+ * @param	nEnd	The last line of the tag's scope, 0 if not known
+ * @param	cKind	The kind of the tag
+ * @param	sName	The name of the tag
+ */
+void TagScopeIndex::add(uint nLine, uint nEnd, char cKind,
+	const QString& sName)
+{
+	Tag tag;
+
+	tag.nLine = nLine;
+	tag.cKind = cKind;
+	tag.nScope = -1;
+
+	// Names are only required for scopes
+	if (isScope(cKind)) {
+		tag.nEnd = nEnd;
+		tag.sName = sName;
+	} else {
+		tag.nEnd = 0;
+	}
+
+	m_vecTags.append(tag);
+}
+
+/**
+ * Creates the line table and the ranges of lines, once all tags were added.
+ */
+void TagScopeIndex::build()
+{
+	QVector< QPair<uint, int> > vecLines;
+	QVector<TagScope> vecScopes, vecStack;
+	TagScope scope;
+	int i, j, nCount;
+
+	nCount = m_vecTags.count();
+	m_vecLines.clear();
+	m_vecRanges.clear();
+	if (nCount == 0)
+		return;
+
+	// Order the tags by line (tags on the same line are kept in the order
+	// they were added)
+	for (i = 0; i < nCount; i++)
+		vecLines.append(qMakePair(m_vecTags[i].nLine, i));
+
+	qSort(vecLines.begin(), vecLines.end());
+	for (i = 0; i < nCount; i++)
+		m_vecLines.append(vecLines[i].second);
+
+	// Collect the scopes, in the order of their lines
+	for (i = 0; i < nCount; i++) {
+		const Tag& tag = m_vecTags[m_vecLines[i]];
+
+		if (!isScope(tag.cKind))
+			continue;
+
+		scope.nStart = tag.nLine;
+		scope.nEnd = tag.nEnd;
+		scope.nTag = m_vecLines[i];
+
+		// Only labels are defined inside a function, so a function whose
+		// end is not known ends before the next tag that is not a label
+		if (tag.cKind == 'f' && scope.nEnd < scope.nStart) {
+			for (j = i + 1; j < nCount; j++) {
+				const Tag& next = m_vecTags[m_vecLines[j]];
+
+				if (next.cKind != 'l' && next.nLine > tag.nLine) {
+					scope.nEnd = next.nLine - 1;
+					break;
+				}
+			}
+		}
+
+		vecScopes.append(scope);
+	}
+
+	// Any other scope whose end is not known continues up to the next scope
+	// that begins after it
+	for (i = vecScopes.count() - 1; i >= 0; i--) {
+		if (vecScopes[i].nEnd >= vecScopes[i].nStart)
+			continue;
+
+		if (i + 1 < vecScopes.count() &&
+			vecScopes[i + 1].nStart > vecScopes[i].nStart) {
+			vecScopes[i].nEnd = vecScopes[i + 1].nStart - 1;
+		} else if (i + 1 < vecScopes.count()) {
+			vecScopes[i].nEnd = vecScopes[i + 1].nEnd;
+		} else {
+			vecScopes[i].nEnd = UINT_MAX;
+		}
+	}
+
+	qStableSort(vecScopes.begin(), vecScopes.end(), scopeLessThan);
+
+	// Divide the lines into ranges, by keeping a stack of the scopes that
+	// hold the current line
+	addRange(0, -1);
+	for (i = 0; i < vecScopes.count(); i++) {
+		scope = vecScopes[i];
+
+		// Close the scopes that end before this one begins
+		while (!vecStack.isEmpty() && vecStack.last().nEnd < scope.nStart) {
+			addRange(vecStack.last().nEnd + 1, vecStack.count() > 1 ?
+				vecStack[vecStack.count() - 2].nTag : -1);
+			vecStack.pop_back();
+		}
+
+		// Scopes are nested, so a scope cannot continue beyond the one
+		// holding it
+		if (!vecStack.isEmpty() && scope.nEnd > vecStack.last().nEnd)
+			scope.nEnd = vecStack.last().nEnd;
+
+		vecStack.append(scope);
+		addRange(scope.nStart, scope.nTag);
+	}
+
+	// Close the remaining scopes
+	while (!vecStack.isEmpty()) {
+		if (vecStack.last().nEnd != UINT_MAX) {
+			addRange(vecStack.last().nEnd + 1, vecStack.count() > 1 ?
+				vecStack[vecStack.count() - 2].nTag : -1);
+		}
+
+		vecStack.pop_back();
+	}
+
+	// Store the innermost scope of each tag
+	for (i = 0; i < nCount; i++)
+		m_vecTags[i].nScope = findScope(m_vecTags[i].nLine);
+}
+
+/**
+ * Removes all tags from the index.
+ */
+void TagScopeIndex::clear()
+{
+	m_vecTags.clear();
+	m_vecLines.clear();
+	m_vecRanges.clear();
+}
+
+/**
+ * Finds the tag that dominates the given line.
+ * This is the last tag defined on or before the line, unless that tag
+ * belongs to a scope that has already ended. In that case, the tag defining
+ * the innermost scope of the line is returned.
+ * @param	nLine	The requested line
+ * @return	The index of the tag, -1 if the index is empty
+ */
+int TagScopeIndex::findTag(uint nLine) const
+{
+	int nPos, nTag, nScope;
+
+	if (m_vecLines.isEmpty())
+		return -1;
+
+	// Use the first tag for lines preceding all tags
+	nPos = findLine(nLine);
+	if (nPos < 0)
+		return m_vecLines[0];
+
+	nTag = m_vecLines[nPos];
+	nScope = findScope(nLine);
+	if (nScope >= 0 && nTag != nScope && m_vecTags[nTag].nScope != nScope)
+		return nScope;
+
+	return nTag;
+}
+
+/**
+ * Finds the innermost scope that holds the given line.
+ * @param	nLine	The requested line
+ * @return	The index of the tag defining the scope, -1 if the line is not
+ *			inside any scope
+ */
+int TagScopeIndex::findScope(uint nLine) const
+{
+	int nFrom, nTo, nMid;
+
+	if (m_vecRanges.isEmpty())
+		return -1;
+
+	// Find the last range that begins on or before the line
+	nFrom = 0;
+	nTo = m_vecRanges.count();
+	while (nFrom < nTo) {
+		nMid = (nFrom + nTo) / 2;
+		if (m_vecRanges[nMid].nStart <= nLine)
+			nFrom = nMid + 1;
+		else
+			nTo = nMid;
+	}
+
+	return (nFrom > 0) ? m_vecRanges[nFrom - 1].nScope : -1;
+}
+
+/**
+ * Determines whether tags of the given kind define a scope.
+ * @param	cKind	The kind of a tag
+ * @return	true for functions, namespaces, structures, unions, classes and
+ *			enumerations, false otherwise
+ */
+bool TagScopeIndex::isScope(char cKind)
+{
+	switch (cKind) {
+	case 'f':
+	case 'n':
+	case 's':
+	case 'u':
+	case 'c':
+	case 'g':
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+/**
+ * Finds the first tag defined on the last line, preceding or equal to the
+ * given one, that holds any tags.
+ * @param	nLine	The requested line
+ * @return	The position of the tag in the line table, -1 if all tags are
+ *			defined after the given line
+ */
+int TagScopeIndex::findLine(uint nLine) const
+{
+	int nFrom, nTo, nMid;
+
+	// Find the position following the last tag on or before the line
+	nFrom = 0;
+	nTo = m_vecLines.count();
+	while (nFrom < nTo) {
+		nMid = (nFrom + nTo) / 2;
+		if (m_vecTags[m_vecLines[nMid]].nLine <= nLine)
+			nFrom = nMid + 1;
+		else
+			nTo = nMid;
+	}
+
+	if (nFrom == 0)
+		return -1;
+
+	// Find the first tag on the same line
+	nLine = m_vecTags[m_vecLines[nFrom - 1]].nLine;
+	nTo = nFrom - 1;
+	nFrom = 0;
+	while (nFrom < nTo) {
+		nMid = (nFrom + nTo) / 2;
+		if (m_vecTags[m_vecLines[nMid]].nLine < nLine)
+			nFrom = nMid + 1;
+		else
+			nTo = nMid;
+	}
+
+	return nFrom;
+}
+
+/**
+ * Appends a range of lines.
+ * The new range replaces the last one if both begin on the same line, and
+ * is merged into the last one if both have the same scope.
+ * @param	nStart	The first line of the range
+ * @param	nScope	The innermost scope of the range, -1 for none
+ */
+void TagScopeIndex::addRange(uint nStart, int nScope)
+{
+	Range range;
+
+	if (!m_vecRanges.isEmpty() && m_vecRanges.last().nStart == nStart)
+		m_vecRanges.pop_back();
+
+	if (!m_vecRanges.isEmpty() && m_vecRanges.last().nScope == nScope)
+		return;
+
+	range.nStart = nStart;
+	range.nScope = nScope;
+	m_vecRanges.append(range);
+}
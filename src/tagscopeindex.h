@@ -0,0 +1,104 @@
+#ifndef TAGSCOPEINDEX_H
+#define TAGSCOPEINDEX_H
+
+#include <qstring.h>
+#include <qvector.h>
+
+/**
+ * Maps lines in a source file to the tags of that file.
+ * Tags are added in the order they are listed (which need not be the order
+ * of their lines), and are referred to by this position. Functions,
+ * namespaces, structures, unions, classes and enumerations define scopes,
+ * which span the lines from the tag to the end of the definition. The end is
+ * taken from the "end:" field reported for the tag. If it is not known, a
+ * function is assumed to end before the next tag that is not a label, and
+ * any other scope before the next scope that begins after it (or at the end
+ * of the file.)
+ * Once all tags are added, build() divides the file into ranges of lines
+ * that have the same innermost scope. Both the innermost scope of a line and
+ * the last tag that precedes it are then found by a binary search over
+ * integer lines, regardless of the way the tags are presented.
+ * @author Elad Lahav
+ */
+class TagScopeIndex
+{
+public:
+	TagScopeIndex();
+
+	void add(uint, uint, char, const QString&);
+	void build();
+	void clear();
+	int findTag(uint) const;
+	int findScope(uint) const;
+
+	static bool isScope(char);
+
+	/**
+	 * @return	The number of tags in the index
+	 */
+	int count() const { return m_vecTags.count(); }
+
+	/**
+	 * @param	nTag	The index of a tag
+	 * @return	The name of the tag, if it defines a scope (an empty string
+	 *			otherwise)
+	 */
+	const QString& getName(int nTag) const { return m_vecTags[nTag].sName; }
+
+	/**
+	 * @param	nTag	The index of a tag
+	 * @return	The kind of the tag
+	 */
+	char getKind(int nTag) const { return m_vecTags[nTag].cKind; }
+
+private:
+	/**
+	 * A single tag.
+	 */
+	struct Tag
+	{
+		/** The line on which the tag is defined. */
+		uint nLine;
+
+		/** The last line of the tag's scope (0 if the tag does not define a
+			scope, or if the end is not known.) */
+		uint nEnd;
+
+		/** The kind of the tag. */
+		char cKind;
+
+		/** The name of the tag (only kept for scopes.) */
+		QString sName;
+
+		/** The innermost scope holding the tag's line, -1 if none. */
+		int nScope;
+	};
+
+	/**
+	 * A range of lines with the same innermost scope.
+	 */
+	struct Range
+	{
+		/** The first line in the range (the range ends where the next one
+			begins.) */
+		uint nStart;
+
+		/** The tag that defines the innermost scope, -1 if the lines are not
+			inside any scope. */
+		int nScope;
+	};
+
+	/** The tags, in the order they were added. */
+	QVector<Tag> m_vecTags;
+
+	/** Tag indices, ordered by line. */
+	QVector<int> m_vecLines;
+
+	/** The ranges of lines, ordered by their first lines. */
+	QVector<Range> m_vecRanges;
+
+	int findLine(uint) const;
+	void addRange(uint, int);
+};
+
+#endif
@@ -1,6 +1,10 @@
-#include <QTextStream>
+#include <klocale.h>
+#include <kinputdialog.h>
 #include "treewidget.h"
 #include "queryviewdriver.h"
+#include "cscopeprefetcher.h"
+#include "cscopecache.h"
+#include "callgraph.h"
 
 /**
  * Class constructor.
@@ -9,16 +13,28 @@
  */
 TreeWidget::TreeWidget(QWidget* pParent) :
 	QueryView(pParent),
-	m_nQueryType(CscopeFrontend::Called)
+	m_nQueryType(CscopeFrontend::Called),
+	m_nQueryGeneration(0),
+	m_nExpandDepth(0)
 {
 	setRootIsDecorated(true);
 	
 	// Create a driver object
 	m_pDriver = new QueryViewDriver(this, this);
 	
+	// Run queries for child items in the background
+	m_pPrefetcher = new CscopePrefetcher(this);
+	
+	// Continue expanding the tree once the queries of a level complete
+	connect(m_pPrefetcher, SIGNAL(idle()), this, SLOT(slotExpandStep()));
+	
 	// Query a tree item when it is expanded for the first time
 	connect(this, SIGNAL(expanded(QTreeWidgetItem*)), this,
 		SLOT(slotQueryItem(QTreeWidgetItem*)));
+	
+	// Expand the tree to a depth chosen through the popup-menu
+	m_pQueryMenu->setExpandable(true);
+	connect(m_pQueryMenu, SIGNAL(expand()), this, SLOT(slotExpand()));
 }
 
 /**
@@ -26,6 +42,8 @@ TreeWidget::TreeWidget(QWidget* pParent) :
  */
 TreeWidget::~TreeWidget()
 {
+	// Stop running queries for the items of the closed tree
+	stopQueries();
 }
 
 /**
@@ -36,6 +54,7 @@ void TreeWidget::setMode(Mode mode)
 {
 	m_nQueryType = (mode == Called) ? CscopeFrontend::Called :
 		CscopeFrontend::Calling;
+	stopQueries();
 }
 
 /**
@@ -47,6 +66,7 @@ void TreeWidget::setRoot(const QString& sFunc)
 	QTreeWidgetItem* pRoot;
 	
 	// Remove the current root, if any
+	stopQueries();
 	if ((pRoot = topLevelItem(0)) != NULL)
 		delete pRoot;
 	
@@ -69,54 +89,30 @@ void TreeWidget::queryRoot()
 }
 
 /**
- * Stores the tree contents in the given file.
- * @param	pFile	An open file to write to
+ * Expands all items in the tree, up to the given depth below the root.
+ * The functions of each level are queried in parallel by the prefetcher (so
+ * that they yield to queries made by the user), and the tree is expanded
+ * once the calls of all functions up to the requested depth are known.
+ * @param	nDepth	The number of levels to show below the root
  */
-void TreeWidget::save(FILE* pFile)
+void TreeWidget::expandToDepth(int nDepth)
 {
-	QTextStream str(pFile, QIODevice::WriteOnly);
-	QTreeWidgetItem* pRoot;
-	Encoder enc;
+	if (topLevelItem(0) == NULL || nDepth <= 0)
+		return;
 	
-	if (m_nQueryType == CscopeFrontend::Called)
-		str << "calltree {\n";
-	else
-		str << "callingtree {\n";
-
-	// Write the tree to the file
-	pRoot = topLevelItem(0);
-	str << pRoot->text(0) << "\n";
-	str << '{' << "\n";
-	saveItems(pRoot->child(0), str, enc);
-	str << '}' << "\n";
-	str << '}' << "\n";
-}
-
-/**
- * Recursively writes tree items to a file.
- * Given an item, the method writes this item and all of its siblings.
- * Child items are written recursively.
- * @param	pItem	The first item to write
- * @param	str		An initialised text stream to use for writing
- * @param	enc		An encoder for free-text strings
- */
-void TreeWidget::saveItems(QTreeWidgetItem* pItem, QTextStream& str, Encoder& enc)
-{
-	// Iterate over all items in this level
-    int index = indexOfTopLevelItem(pItem);
-	for (int i = index; pItem != NULL; pItem = topLevelItem(++i)) {
-		// Write function parameters
-		str << pItem->text(0) << " [ "
-			<< "kscope_file=\"" << pItem->text(1) << "\", "
-			<< "kscope_line=" << pItem->text(2) << ", "
-			<< "kscope_text=\"" << enc.encode(pItem->text(3)) << "\""
-			<< "]" << endl;
-		
-		// Write child items
-		str << "{" << endl;
-		saveItems(pItem->child(0), str, enc);
-		str << "}" << endl;
-	}
+	m_pPrefetcher->cancel();
+	m_nExpandDepth = nDepth;
+	m_setExpandQueried.clear();
+	slotExpandStep();
+}
+
+/**
+ * Stops all background queries, including those of a tree expansion.
+ */
+void TreeWidget::stopQueries()
+{
+	m_nExpandDepth = 0;
+	m_pPrefetcher->cancel();
 }
 
 /**
@@ -142,6 +138,37 @@ void TreeWidget::addRecord(const QString& sFunc, const QString& sFile,
 	m_pLastItem = pItem;
 }
 
+/**
+ * Creates tree items for a block of query result records.
+ * All items are added to the parent in a single operation.
+ * @param	lstRecords	The records to add, each holding the function name,
+ *						file path, line number and line text (in this order)
+ * @param	pParent		The parent for the new items
+ */
+void TreeWidget::addRecords(const QList<QStringList>& lstRecords,
+	QTreeWidgetItem* pParent)
+{
+	QList<QTreeWidgetItem*> lstItems;
+	QList<QStringList>::ConstIterator itr;
+	QTreeWidgetItem* pItem;
+	
+	if (lstRecords.isEmpty())
+		return;
+	
+	for (itr = lstRecords.begin(); itr != lstRecords.end(); ++itr) {
+		pItem = new QueryViewItem(*itr, 2);
+		pItem->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+		lstItems.append(pItem);
+	}
+	
+	if (pParent != NULL)
+		pParent->addChildren(lstItems);
+	else
+		addTopLevelItems(lstItems);
+	
+	m_pLastItem = lstItems.last();
+}
+
 /**
  * Called when a query running on the tree terminates.
  * If there were no results, the item becomes non-expandable.
@@ -152,29 +179,228 @@ void TreeWidget::addRecord(const QString& sFunc, const QString& sFile,
  */
 void TreeWidget::queryFinished(uint nResults, QTreeWidgetItem* pParent)
 {
+	QList<QStringList> lstRecords;
+	int i, j;
+	
+	// Store the calls, unless they were taken from the call graph
+	if (!CallGraph::contains(m_nQueryType, pParent->text(0))) {
+		for (i = 0; i < pParent->childCount(); i++) {
+			lstRecords.append(QStringList());
+			for (j = 0; j < 4; j++)
+				lstRecords.last().append(pParent->child(i)->text(j));
+		}
+		
+		CallGraph::insert(m_nQueryType, pParent->text(0), m_nQueryGeneration,
+			lstRecords);
+	}
+	
 	if (nResults == 0) {
 		pParent->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicator);
     } else {
+		markCycles(pParent);
 		pParent->setExpanded(true);
+		prefetchChildren(pParent);
     }
 }
 
+/**
+ * Prevents the expansion of child items that stand for recursive calls.
+ * A child item is recursive if its function is the same as that of the
+ * parent item, or of any item above it.
+ * @param	pParent	The item whose children should be checked
+ */
+void TreeWidget::markCycles(QTreeWidgetItem* pParent)
+{
+	QSet<QString> setPath;
+	QTreeWidgetItem* pItem;
+	int i;
+	
+	for (pItem = pParent; pItem != NULL; pItem = pItem->parent())
+		setPath.insert(pItem->text(0));
+	
+	for (i = 0; i < pParent->childCount(); i++) {
+		pItem = pParent->child(i);
+		if (setPath.contains(pItem->text(0))) {
+			pItem->setChildIndicatorPolicy(
+				QTreeWidgetItem::DontShowIndicator);
+			pItem->setToolTip(0, i18n("Recursive call"));
+		}
+	}
+}
+
+/**
+ * Runs the queries of the visible child items of the given item in the
+ * background.
+ * Items that were already queried, or are hidden, are skipped. Functions
+ * appearing more than once (e.g., called from several lines) are queried
+ * once.
+ * @param	pParent	The item whose children should be queried
+ */
+void TreeWidget::prefetchChildren(QTreeWidgetItem* pParent)
+{
+	QStringList slFuncs;
+	QSet<QString> setFuncs;
+	QTreeWidgetItem* pItem;
+	int i;
+	
+	// The children of an expanded tree are queried as part of the expansion
+	if (m_nExpandDepth > 0)
+		return;
+	
+	for (i = 0; i < pParent->childCount(); i++) {
+		pItem = pParent->child(i);
+		if (pItem->isHidden() || pItem->child(0) != NULL ||
+			pItem->childIndicatorPolicy() ==
+			QTreeWidgetItem::DontShowIndicator ||
+			setFuncs.contains(pItem->text(0))) {
+			continue;
+		}
+		
+		setFuncs.insert(pItem->text(0));
+		slFuncs.append(pItem->text(0));
+	}
+	
+	m_pPrefetcher->prefetch(m_nQueryType, slFuncs);
+}
+
 /**
  * Runs a query on the given item, unless it was queried before.
+ * The children of an item that was already queried are prefetched again
+ * (their results may have been discarded, or the prefetch cancelled.)
  * This slot is connected to the expanded() signal of the list view.
  * @param	pItem	The item to query
  */
 void TreeWidget::slotQueryItem(QTreeWidgetItem* pItem)
 {
-	// Do nothing if the item was already queried
+	QList<QStringList> lstRecords;
+	
+	// Do nothing if the item was already queried (other than preparing for
+	// the expansion of its children)
 	// An item has been queried if it has children or marked as non-expandable
-	if (pItem->child(0) != NULL || pItem->childIndicatorPolicy() == QTreeWidgetItem::DontShowIndicator)
+	if (pItem->child(0) != NULL) {
+		prefetchChildren(pItem);
 		return;
+	}
+	
+	if (pItem->childIndicatorPolicy() == QTreeWidgetItem::DontShowIndicator)
+		return;
+	
+	// Use the calls stored in the call graph, if available
+	if (CallGraph::find(m_nQueryType, pItem->text(0), lstRecords)) {
+		addRecords(lstRecords, pItem);
+		queryFinished(lstRecords.count(), pItem);
+		return;
+	}
 		
-	// Run the query
+	// Run the query (the results are usually stored already, or are being
+	// prefetched, in which case the query waits for the running one)
+	m_nQueryGeneration = CscopeCache::getGeneration();
 	m_pDriver->query(m_nQueryType, pItem->text(0), true, pItem);
 }
 
+/**
+ * Prompts the user for the number of levels to show below the root, and
+ * expands the tree accordingly.
+ * This slot is connected to the expand() signal of the popup-menu.
+ */
+void TreeWidget::slotExpand()
+{
+	int nDepth;
+	bool bOk;
+	
+	if (topLevelItem(0) == NULL)
+		return;
+	
+	nDepth = KInputDialog::getInteger(i18n("Expand Tree"),
+		i18n("Number of levels to show below the root:"), 2, 1,
+		TREE_MAX_EXPAND_DEPTH, 1, 10, &bOk, this);
+	if (bOk)
+		expandToDepth(nDepth);
+}
+
+/**
+ * Queries the functions required for expanding the tree to the requested
+ * depth, whose calls are not yet known. Once all calls are known, the tree
+ * is expanded.
+ * This slot is connected to the idle() signal of the prefetcher, so that it
+ * is called again once the queries of a level complete (revealing the
+ * functions of the next level.)
+ */
+void TreeWidget::slotExpandStep()
+{
+	QStringList slMissing, slQuery;
+	QStringList::ConstIterator itr;
+	QTreeWidgetItem* pRoot;
+	int nDepth;
+	
+	if (m_nExpandDepth == 0 || (pRoot = topLevelItem(0)) == NULL)
+		return;
+	
+	for (;;) {
+		// Find the functions whose calls are required, skipping those
+		// already queried (their queries may have failed)
+		CallGraph::getMissing(m_nQueryType, pRoot->text(0), m_nExpandDepth,
+			slMissing);
+		slQuery.clear();
+		for (itr = slMissing.begin(); itr != slMissing.end(); ++itr) {
+			if (!m_setExpandQueried.contains(*itr)) {
+				m_setExpandQueried.insert(*itr);
+				slQuery.append(*itr);
+			}
+		}
+		
+		if (slQuery.isEmpty())
+			break;
+		
+		// Wait for the queries to complete
+		m_pPrefetcher->prefetch(m_nQueryType, slQuery);
+		if (!m_pPrefetcher->isIdle())
+			return;
+	}
+	
+	// All calls are known
+	nDepth = m_nExpandDepth;
+	m_setExpandQueried.clear();
+	expandItem(pRoot, nDepth);
+	m_nExpandDepth = 0;
+}
+
+/**
+ * Adds the stored calls of an item and its descendants, and expands them.
+ * Recursive calls are not expanded.
+ * @param	pItem	The item to expand
+ * @param	nDepth	The number of levels to expand below the item
+ */
+void TreeWidget::expandItem(QTreeWidgetItem* pItem, int nDepth)
+{
+	QList<QStringList> lstRecords;
+	int i;
+	
+	if (nDepth == 0 || pItem->childIndicatorPolicy() ==
+		QTreeWidgetItem::DontShowIndicator) {
+		return;
+	}
+	
+	// Create the child items, unless the item was already queried
+	if (pItem->child(0) == NULL) {
+		if (!CallGraph::find(m_nQueryType, pItem->text(0), lstRecords))
+			return;
+		
+		if (lstRecords.isEmpty()) {
+			pItem->setChildIndicatorPolicy(
+				QTreeWidgetItem::DontShowIndicator);
+			return;
+		}
+		
+		addRecords(lstRecords, pItem);
+		markCycles(pItem);
+	}
+	
+	pItem->setExpanded(true);
+	for (i = 0; i < pItem->childCount(); i++)
+		expandItem(pItem->child(i), nDepth - 1);
+}
+
 /**
  * Hides all descendant that do not meet the given search criteria.
  * This slot is connected to the search() signal of the QueryResultsMenu
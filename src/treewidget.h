@@ -1,16 +1,32 @@
 #ifndef TREEWIDGET_H
 #define TREEWIDGET_H
 
+#include <QSet>
 #include "queryview.h"
-#include "encoder.h"
+
+/** The maximal number of levels that can be expanded at once. */
+#define TREE_MAX_EXPAND_DEPTH	10
 
 class QueryViewDriver;
+class CscopePrefetcher;
 
 /**
  * A tree-like widget displaying a hierarchical list of functions.
  * The widget has two modes: called functions and calling functions. Depending
  * on this mode, child items represent functions called by or calling their
  * parent item.
+ * Once the children of an item are shown, the queries for their own children
+ * are run in the background (@see CscopePrefetcher), so that the results are
+ * usually available by the time a child is expanded.
+ * The calls of each queried function are kept in the call graph (@see
+ * CallGraph), so that a function is not queried again when it appears in
+ * other places of the tree, or in other trees. A function that calls itself
+ * (directly or through the functions above it in the tree) cannot be
+ * expanded. The entire tree can be expanded to a given depth (using the
+ * "Expand to Depth..." item of the popup menu), in which case the functions
+ * of each level are queried in parallel, through the same prefetcher.
+ * Trees are not stored with the project, and need to be queried again once
+ * it is reopened (the call graph is not stored either.)
  * @author Elad Lahav
  */
 class TreeWidget : public QueryView
@@ -29,10 +45,11 @@ public:
 	void setMode(Mode);
 	void setRoot(const QString&);
 	void queryRoot();
-	void save(FILE*);
+	void expandToDepth(int);
 	
 	virtual void addRecord(const QString&, const QString&, const QString&,
 		const QString&, QTreeWidgetItem*);
+	virtual void addRecords(const QList<QStringList>&, QTreeWidgetItem*);
 	virtual void queryFinished(uint, QTreeWidgetItem*);
 	
 protected slots:
@@ -47,10 +64,27 @@ private:
 	/** Runs queries and outputs the results as tree items. */
 	QueryViewDriver* m_pDriver;
 	
-	void saveItems(QTreeWidgetItem*, QTextStream&, Encoder&);
+	/** Runs the queries of visible items in the background. */
+	CscopePrefetcher* m_pPrefetcher;
+	
+	/** The generation of the database when the current query was made. */
+	uint m_nQueryGeneration;
+	
+	/** The depth to which the tree is being expanded, 0 if it is not. */
+	int m_nExpandDepth;
+	
+	/** Functions already queried while expanding the tree. */
+	QSet<QString> m_setExpandQueried;
+	
+	void prefetchChildren(QTreeWidgetItem*);
+	void markCycles(QTreeWidgetItem*);
+	void expandItem(QTreeWidgetItem*, int);
+	void stopQueries();
 	
 private slots:
 	void slotQueryItem(QTreeWidgetItem*);
+	void slotExpand();
+	void slotExpandStep();
 };
 
 #endif
@@ -0,0 +1,83 @@
+#include <QList>
+#include <QStringList>
+
+#include "callgraph.h"
+#include "cscopecache.h"
+#include "cscopefrontend.h"
+#include "testcheck.h"
+
+/**
+ * Stores the functions called by the given one.
+ */
+static void addCalls(const QString& sFunc, const QStringList& slCalled)
+{
+	QList<QStringList> lstRecords;
+	QStringList::ConstIterator itr;
+
+	for (itr = slCalled.begin(); itr != slCalled.end(); ++itr) {
+		lstRecords.append(QStringList() << *itr << "/src/" + sFunc + ".c"
+			<< "1" << *itr + "();");
+	}
+
+	CallGraph::insert(CscopeFrontend::Called, sFunc,
+		CscopeCache::getGeneration(), lstRecords);
+}
+
+static QStringList getMissing(uint nType, const QString& sFunc, int nDepth)
+{
+	QStringList slMissing;
+
+	CallGraph::getMissing(nType, sFunc, nDepth, slMissing);
+	return slMissing;
+}
+
+int main()
+{
+	QList<QStringList> lstRecords;
+
+	check(CallGraph::supports(CscopeFrontend::Called), "called functions");
+	check(!CallGraph::supports(CscopeFrontend::Text), "text queries");
+
+	// main -> foo, bar; foo -> bar, baz; bar -> main (a cycle); baz is not
+	// stored
+	addCalls("main", QStringList() << "foo" << "bar");
+	addCalls("foo", QStringList() << "bar" << "baz");
+	addCalls("bar", QStringList() << "main");
+
+	check(CallGraph::contains(CscopeFrontend::Called, "foo"),
+		"stored function");
+	check(!CallGraph::contains(CscopeFrontend::Calling, "foo"),
+		"other query type");
+	check(CallGraph::find(CscopeFrontend::Called, "main", lstRecords) &&
+		(lstRecords.count() == 2) && (lstRecords[1][0] == "bar"),
+		"find stored calls");
+
+	check(getMissing(CscopeFrontend::Called, "qux", 1) ==
+		QStringList("qux"), "missing root");
+	check(getMissing(CscopeFrontend::Called, "main", 1).isEmpty(),
+		"stored root");
+	check(getMissing(CscopeFrontend::Called, "main", 2).isEmpty(),
+		"stored second level");
+	check(getMissing(CscopeFrontend::Called, "main", 3) ==
+		QStringList("baz"), "missing third level");
+	check(getMissing(CscopeFrontend::Called, "main", 10) ==
+		QStringList("baz"), "visit each function once");
+	check(getMissing(CscopeFrontend::Calling, "main", 3) ==
+		QStringList("main"), "separate query types");
+	check(getMissing(CscopeFrontend::Text, "main", 3).isEmpty(),
+		"unsupported query type");
+
+	// Calls made on a previous database are discarded
+	CallGraph::insert(CscopeFrontend::Called, "baz",
+		CscopeCache::getGeneration() - 1, QList<QStringList>());
+	check(!CallGraph::contains(CscopeFrontend::Called, "baz"),
+		"ignore calls of a previous database");
+
+	CscopeCache::invalidate();
+	check(!CallGraph::contains(CscopeFrontend::Called, "main"),
+		"discard calls once the database changes");
+	check(getMissing(CscopeFrontend::Called, "main", 3) ==
+		QStringList("main"), "all functions are missing");
+
+	return nFailed;
+}
@@ -0,0 +1,258 @@
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QByteArray>
+#include <QStringList>
+
+#include "cscopedatabase.h"
+#include "cscopefrontend.h"
+#include "testcheck.h"
+
+/**
+ * A compressed cross-reference file (the default), using keywords and
+ * digraphs:
+ * a.c:
+ *   1 int main() {
+ *   2 	foo(1);
+ *   3 	return x = read;
+ *   4 }
+ * b.c:
+ *   1 #define MAX 10
+ *   2 int y = MAX;
+ */
+static const char* DB_COMPRESSED =
+	"\t@a.c\n"
+	"\n"
+	"1 \x12" "\n"
+	"\t$main\n"
+	"() {\n"
+	"\n"
+	"2 \t\n"
+	"\t`foo\n"
+	"(1);\n"
+	"\n"
+	"3 \t\x15" " \n"
+	"x\n"
+	" \xf0" "\n"
+	"\t`\xbb" "ad\n"
+	";\n"
+	"\n"
+	"4 \n"
+	"\t}\n"
+	"}\n"
+	"\n"
+	"\t@b.c\n"
+	"\n"
+	"1 \x01" "\n"
+	"\t#MAX\n"
+	" 10\n"
+	"\t)\n"
+	"\n"
+	"\n"
+	"2 \x12" "\n"
+	"\tgy\n"
+	" \xf0" "\n"
+	"MAX\n"
+	";\n"
+	"\n"
+	"\t@\n";
+
+/**
+ * The trailer of the compressed file, which lists the source directories
+ * and files (and should not be read as cross-reference entries.)
+ */
+static const char* DB_TRAILER =
+	"1\n"
+	".\n"
+	"0\n"
+	"2\n"
+	"a.c\n"
+	"b.c\n";
+
+/**
+ * A cross-reference file built with the "-c" option (no compression), used
+ * as a second shard:
+ * c.c:
+ *   5 static int g() { return read(); }
+ */
+static const char* DB_SHARD =
+	"cscope 15 /p -c 0000000000\n"
+	"\t@c.c\n"
+	"\n"
+	"5 static int \n"
+	"\t$g\n"
+	"() { return \n"
+	"\t`read\n"
+	"(); }\n"
+	"\t}\n"
+	"\n"
+	"\n"
+	"\t@\n";
+
+/**
+ * A delta database, replacing the entries of a.c:
+ *   7 void h() { read(); }
+ */
+static const char* DB_DELTA =
+	"cscope 15 /p -c 0000000000\n"
+	"\t@a.c\n"
+	"\n"
+	"7 void \n"
+	"\t$h\n"
+	"() { \n"
+	"\t`read\n"
+	"(); }\n"
+	"\t}\n"
+	"\n"
+	"\n"
+	"\t@\n";
+
+static bool writeFile(const QString& sPath, const QByteArray& baData)
+{
+	QFile file(sPath);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	return file.write(baData) == baData.size();
+}
+
+/**
+ * Runs a query on the loaded databases.
+ * @return	The query's records, or "failed" if the query was not run
+ */
+static QByteArray query(uint nType, const char* szText, bool bCase = true)
+{
+	QByteArray baOutput;
+	uint nRecords;
+
+	if (!CscopeDatabase::query(nType, szText, bCase, baOutput, nRecords))
+		return "failed";
+
+	// Each record is written on a line of its own
+	if ((int)nRecords != baOutput.count('\n'))
+		return "miscounted";
+
+	return baOutput;
+}
+
+/**
+ * Runs the same queries on databases that are either scanned or indexed.
+ * @param	baMode	Describes the way the databases are read
+ */
+static void checkQueries(const QByteArray& baMode)
+{
+	check(query(CscopeFrontend::Definition, "main") ==
+		"a.c main 1 int main() {\n",
+		(baMode + ": keywords in a definition").constData());
+	check(query(CscopeFrontend::Called, "main") ==
+		"a.c foo 2 foo(1);\n"
+		"a.c read 3 return x = read;\n",
+		(baMode + ": calls up to the end of a function").constData());
+	check(query(CscopeFrontend::Calling, "read") ==
+		"a.c main 3 return x = read;\n",
+		(baMode + ": digraphs in text and in a symbol").constData());
+	check(query(CscopeFrontend::Calling, "READ") == "",
+		(baMode + ": case-sensitive query").constData());
+	check(query(CscopeFrontend::Calling, "READ", false) ==
+		"a.c main 3 return x = read;\n",
+		(baMode + ": case-insensitive query").constData());
+	check(query(CscopeFrontend::Reference, "MAX") ==
+		"b.c MAX 1 #define MAX 10\n"
+		"b.c <global> 2 int y = MAX;\n",
+		(baMode + ": macro and global scopes").constData());
+	check(query(CscopeFrontend::Definition, "y") ==
+		"b.c y 2 int y = MAX;\n",
+		(baMode + ": global definition").constData());
+	check(query(CscopeFrontend::Reference, "z") == "",
+		(baMode + ": missing symbol").constData());
+}
+
+int main()
+{
+	QString sDir = QDir::tempPath() + "/husky_test_cscopedatabase";
+	QDir dir(sDir);
+	QHash<QByteArray, bool> hashSymbols;
+	QByteArray baHeader, baRecords;
+	QStringList slFiles;
+	int i;
+
+	check(CscopeDatabase::supports(CscopeFrontend::Definition, "main_2"),
+		"support an identifier");
+	check(!CscopeDatabase::supports(CscopeFrontend::Definition, "ma.*"),
+		"do not support a regular expression");
+	check(!CscopeDatabase::supports(CscopeFrontend::Text, "main"),
+		"do not support a text search");
+
+	baRecords = "b.c f 10 x\nb.c f 9 y\na.c g 2 z\nb.c f 10 w\n";
+	CscopeDatabase::sortRecords(baRecords);
+	check(baRecords == "a.c g 2 z\nb.c f 9 y\nb.c f 10 x\nb.c f 10 w\n",
+		"order records by file and line number");
+
+	// The header ends with the position of the trailer
+	slFiles << "cscope.out" << "cscope.out.idx" << "cscope.1.out" <<
+		"cscope.1.out.idx" << CSCOPE_DELTA_FILE;
+	dir.mkpath(sDir);
+	baHeader = "cscope 15 /p ";
+	baHeader += QByteArray::number((int)(qstrlen(DB_COMPRESSED) + 24))
+		.rightJustified(10, '0');
+	baHeader += "\n";
+	check((baHeader.size() == 24) && writeFile(dir.filePath(slFiles[0]),
+		baHeader + DB_COMPRESSED + DB_TRAILER) &&
+		writeFile(dir.filePath(slFiles[2]), DB_SHARD) &&
+		writeFile(dir.filePath(slFiles[4]), DB_DELTA),
+		"write the cross-reference files");
+
+	check(!CscopeDatabase::load(sDir, QStringList("cscope.2.out"), false),
+		"fail to load a missing file");
+	check(query(CscopeFrontend::Definition, "main") == "failed",
+		"no query without a database");
+
+	check(CscopeDatabase::load(sDir, QStringList(slFiles[0]), false),
+		"load a database");
+	checkQueries("scan");
+
+	check(CscopeDatabase::getSymbols(hashSymbols) &&
+		(hashSymbols.count() == 6) && hashSymbols.value("main") &&
+		!hashSymbols.value("foo") && hashSymbols.value("MAX") &&
+		hashSymbols.value("y") && !hashSymbols.value("x"),
+		"collect the names of symbols");
+
+	check(CscopeDatabase::load(sDir, QStringList(slFiles[0]), true),
+		"load an indexed database");
+	checkQueries("build an index");
+	check(QFile::exists(dir.filePath(slFiles[1])), "write the index file");
+
+	CscopeDatabase::reset();
+	check(CscopeDatabase::load(sDir, QStringList(slFiles[0]), true),
+		"load a database with an existing index");
+	checkQueries("read an index");
+
+	for (i = 0; i < 2; i++) {
+		check(CscopeDatabase::load(sDir, QStringList(slFiles[0]) <<
+			slFiles[2], i == 1), "load shards");
+		check(query(CscopeFrontend::Calling, "read") ==
+			"a.c main 3 return x = read;\n"
+			"c.c g 5 static int g() { return read(); }\n",
+			"merge the records of shards");
+
+		check(CscopeDatabase::setDelta(sDir, QStringList("a.c")),
+			"load a delta");
+		check(query(CscopeFrontend::Calling, "read") ==
+			"a.c h 7 void h() { read(); }\n"
+			"c.c g 5 static int g() { return read(); }\n",
+			"replace the entries of files in the delta");
+		check(query(CscopeFrontend::Reference, "MAX") ==
+			"b.c MAX 1 #define MAX 10\n"
+			"b.c <global> 2 int y = MAX;\n",
+			"keep the entries of files not in the delta");
+
+		CscopeDatabase::reset();
+	}
+
+	for (i = 0; i < slFiles.count(); i++)
+		QFile::remove(dir.filePath(slFiles[i]));
+	dir.rmdir(sDir);
+
+	return nFailed;
+}
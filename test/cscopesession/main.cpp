@@ -0,0 +1,148 @@
+#include <QCoreApplication>
+#include <QObject>
+#include <QStringList>
+
+#include "cscopesession.h"
+#include "cscopefrontend.h"
+#include "testcheck.h"
+
+/**
+ * Collects the records delivered by a session.
+ */
+class Receiver : public QObject
+{
+	Q_OBJECT
+
+public:
+	/** The delivered records, with their fields separated by '|'. */
+	QStringList m_slRecords;
+
+public slots:
+	void slotDataReady(const FrontendBatch& batch) {
+		FrontendToken* pToken;
+		QStringList slFields;
+		int i;
+
+		for (i = 0; i < batch.count(); i++) {
+			slFields.clear();
+			for (pToken = batch.at(i); pToken != NULL;
+				pToken = pToken->getNext()) {
+				slFields.append(pToken->getData());
+			}
+
+			m_slRecords.append(slFields.join("|"));
+		}
+	}
+};
+
+/**
+ * Drives the parser of a session that is not connected to a Cscope
+ * process, by handing it the output that Cscope writes in line-oriented
+ * mode.
+ * Queries are queued with no owner, so that the state of the session can
+ * be checked without running them.
+ */
+class CscopeSessionTest
+{
+public:
+	CscopeSessionTest(Receiver* pReceiver) {
+		// Parse output as start() does, without running a process
+		m_pSession = new CscopeSession();
+		m_pSession->m_delim = CscopeSession::WSpace;
+		QObject::connect(m_pSession,
+			SIGNAL(dataReady(const FrontendBatch&)), pReceiver,
+			SLOT(slotDataReady(const FrontendBatch&)));
+	}
+
+	void queue(const QString& sText, bool bCase = true) {
+		CscopeSession::Request req;
+
+		req.pOwner = NULL;
+		req.nType = CscopeFrontend::Reference;
+		req.sText = sText;
+		req.bCase = bCase;
+		m_pSession->m_lstPending.append(req);
+		m_pSession->dispatch();
+	}
+
+	void output(const char* szText) {
+		m_pSession->parseOutput(QByteArray(szText));
+	}
+
+	bool isReady() const {
+		return m_pSession->m_state == CscopeSession::Ready;
+	}
+
+	bool isWaiting() const {
+		return m_pSession->m_state == CscopeSession::Header;
+	}
+
+	int pending() const { return m_pSession->m_lstPending.count(); }
+
+	bool isCaseless() const { return m_pSession->m_bCaseless; }
+
+	bool isCurrent() const {
+		return CscopeSession::s_pSession == m_pSession;
+	}
+
+	void setCurrent() { CscopeSession::s_pSession = m_pSession; }
+
+private:
+	CscopeSession* m_pSession;
+};
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+	Receiver receiver;
+	CscopeSessionTest session(&receiver);
+
+	session.queue("foo");
+	check(!session.isReady() && (session.pending() == 1),
+		"hold queries until Cscope starts");
+
+	session.output(">> ");
+	check(session.isWaiting() && (session.pending() == 0),
+		"send a query on the first prompt");
+
+	session.queue("bar");
+	session.queue("a.*(");
+	session.output("cscope: 2 lines\n"
+		"a.c main 12 foo();\n"
+		"b.c <global> 3 int foo;\n"
+		">> ");
+	check(receiver.m_slRecords == (QStringList()
+		<< "a.c|main|12|foo();" << "b.c|<global>|3|int foo;"),
+		"deliver the records of a query");
+	check(session.isWaiting() && (session.pending() == 1),
+		"send the next query on the prompt");
+
+	receiver.m_slRecords.clear();
+	session.output("cscope: 0 lines\n>> ");
+	check(receiver.m_slRecords.isEmpty() && session.isWaiting() &&
+		(session.pending() == 0), "end a query with no records");
+
+	session.output("Unable to search database\n>> ");
+	check(session.isReady(), "end a failed query on the prompt");
+
+	session.queue("foo", false);
+	check(session.isWaiting() && session.isCaseless(),
+		"switch to case-insensitive mode");
+	session.output(">> cscope: 1 lines\nc.c f 5 x = foo;\n>> ");
+	check(session.isReady() && (receiver.m_slRecords ==
+		(QStringList() << "c.c|f|5|x = foo;")),
+		"skip the prompt of a mode change");
+
+	// A session whose database was rebuilt is stopped once the current
+	// query ends
+	session.setCurrent();
+	session.queue("foo", false);
+	CscopeSession::restart();
+	check(session.isCurrent(), "do not interrupt a query");
+	session.output("cscope: 0 lines\n>> ");
+	check(!session.isCurrent(), "restart once a query ends");
+
+	return nFailed;
+}
+
+#include "main.moc"
@@ -0,0 +1,146 @@
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QStringList>
+
+#include "frontend.h"
+#include "testcheck.h"
+
+/**
+ * Parses records of three fields: two words, followed by the rest of the
+ * line (similar to the output of Cscope.)
+ * Output is handed to the parser in chunks of a given size, the way it is
+ * read from a process, so that tokens and records are split between reads.
+ */
+class FrontendTest : public Frontend
+{
+	Q_OBJECT
+
+public:
+	FrontendTest(bool bBatch) : Frontend(3), m_nBatches(0),
+		m_bBatch(bBatch), m_nField(0) {
+		m_delim = WSpace;
+		connect(this, SIGNAL(dataReady(const FrontendBatch&)), this,
+			SLOT(slotDataReady(const FrontendBatch&)));
+	}
+
+	void parse(const QByteArray& baOutput, int nChunk) {
+		int nPos;
+
+		for (nPos = 0; nPos < baOutput.size(); nPos += nChunk) {
+			m_baBuf.append(baOutput.mid(nPos, nChunk));
+			parseBuffer();
+		}
+	}
+
+	/** The delivered records, with their fields separated by '|'. */
+	QStringList m_slRecords;
+
+	/** The number of blocks delivered. */
+	int m_nBatches;
+
+protected:
+	virtual ParseResult parseStdout(FrontendToken&, ParserDelim) {
+		switch (m_nField++) {
+		case 0:
+			return AcceptToken;
+
+		case 1:
+			m_delim = Newline;
+			return AcceptToken;
+		}
+
+		m_nField = 0;
+		m_delim = WSpace;
+		return m_bBatch ? BatchReady : RecordReady;
+	}
+
+private:
+	/** true to deliver each record in a block of its own. */
+	bool m_bBatch;
+
+	/** The index of the next field in the current record. */
+	int m_nField;
+
+private slots:
+	void slotDataReady(const FrontendBatch& batch) {
+		FrontendToken* pToken;
+		QStringList slFields;
+		int i;
+
+		for (i = 0; i < batch.count(); i++) {
+			slFields.clear();
+			for (pToken = batch.at(i); pToken != NULL;
+				pToken = pToken->getNext()) {
+				slFields.append(pToken->getData());
+			}
+
+			m_slRecords.append(slFields.join("|"));
+		}
+
+		m_nBatches++;
+	}
+};
+
+static const char* OUTPUT =
+	"a.c 12 int main()\n"
+	"  b.c\t7   return  0;\n"
+	"\n"
+	"long/path/c.c 300 x\n";
+
+static const QStringList RECORDS = QStringList()
+	<< "a.c|12|int main()"
+	<< "b.c|7|return  0;"
+	<< "long/path/c.c|300|x";
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+	QByteArray baOutput(OUTPUT);
+	bool bResult;
+	int nChunk;
+
+	{
+		FrontendTest fe(false);
+
+		fe.parse(baOutput, baOutput.size());
+		check(fe.m_slRecords == RECORDS, "parse a single read");
+		check(fe.m_nBatches == 1, "deliver a single block");
+	}
+
+	// Every split of the output should give the same records
+	bResult = true;
+	for (nChunk = 1; nChunk < baOutput.size(); nChunk++) {
+		FrontendTest fe(false);
+
+		fe.parse(baOutput, nChunk);
+		if (fe.m_slRecords != RECORDS) {
+			std::cout << "Chunks of " << nChunk << " bytes" << std::endl;
+			bResult = false;
+		}
+	}
+
+	check(bResult, "tokens and records split between reads");
+
+	{
+		FrontendTest fe(false);
+
+		fe.parse("a.c 12 partial", 14);
+		check(fe.m_slRecords.isEmpty(), "keep an incomplete record");
+		fe.parse(" record\nb.c 7 x\n", 16);
+		check(fe.m_slRecords == (QStringList() << "a.c|12|partial record"
+			<< "b.c|7|x"), "complete a record on the next read");
+		check(fe.m_nBatches == 1, "no block for an incomplete record");
+	}
+
+	{
+		FrontendTest fe(true);
+
+		fe.parse(baOutput, baOutput.size());
+		check(fe.m_slRecords == RECORDS, "parse records delivered at once");
+		check(fe.m_nBatches == 3, "deliver a block for each record");
+	}
+
+	return nFailed;
+}
+
+#include "main.moc"
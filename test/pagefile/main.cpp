@@ -0,0 +1,74 @@
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include <QStringList>
+
+#include "pagefile.h"
+#include "testcheck.h"
+
+int main()
+{
+	QString sPath = QDir::tempPath() + "/husky_test_pagefile";
+	QList<QStringList> lstRecords;
+	QList<uint> lstDepths;
+	QFile file;
+
+	// Write a page holding a tree
+	{
+		PageFile page;
+
+		page.addField("Calling");
+		page.addField("main");
+		page.addRecord("main", "/src/main.c", 10, "foo(1);");
+		page.addRecord("foo", "/src/foo.c", 20, "bar();", 1);
+		page.addRecord("main", "/src/main.c", 0, "", 2);
+		check(page.write(sPath), "write a page");
+	}
+
+	// Read it back
+	{
+		PageFile page;
+
+		check(page.open(sPath), "open a page");
+		check(page.isOpen(), "page is mapped");
+		check(page.getFieldCount() == 2, "field count");
+		check(page.getField(0) == "Calling", "first field");
+		check(page.getField(1) == "main", "second field");
+		check(page.getField(2).isEmpty(), "missing field");
+		check(page.getRecordCount() == 3, "record count");
+
+		page.getRecords(lstRecords, &lstDepths);
+		check(lstRecords.count() == 3, "read all records");
+		check(lstRecords[0] == (QStringList() << "main" << "/src/main.c"
+			<< "10" << "foo(1);"), "first record");
+		check(lstRecords[1] == (QStringList() << "foo" << "/src/foo.c"
+			<< "20" << "bar();"), "second record");
+		check(lstRecords[2] == (QStringList() << "main" << "/src/main.c"
+			<< "" << ""), "record without a line");
+		check(lstDepths == (QList<uint>() << 0 << 1 << 2), "record depths");
+
+		page.close();
+		check(!page.isOpen(), "page is released");
+	}
+
+	// A truncated file is rejected
+	file.setFileName(sPath);
+	file.resize(file.size() - 1);
+	{
+		PageFile page;
+
+		check(!page.open(sPath), "reject a truncated page");
+	}
+
+	// An empty page
+	{
+		PageFile page;
+
+		check(page.write(sPath), "write an empty page");
+		check(page.open(sPath), "open an empty page");
+		check(page.getRecordCount() == 0, "no records");
+	}
+
+	QFile::remove(sPath);
+	return nFailed;
+}
@@ -0,0 +1,67 @@
+#include <QVector>
+#include <QStringList>
+
+#include "pathtrie.h"
+#include "testcheck.h"
+
+static QStringList getFiles(const PathTrie& trie, int nNode = 0)
+{
+	QVector<int> vecFiles;
+	QStringList slFiles;
+	int i;
+
+	trie.getFiles(vecFiles, nNode);
+	for (i = 0; i < vecFiles.size(); i++)
+		slFiles.append(trie.getPath(vecFiles[i]));
+
+	return slFiles;
+}
+
+int main()
+{
+	PathTrie trie;
+
+	check(trie.insert("/p/b/x.c"), "insert a new file");
+	check(trie.insert("/p/a.c"), "insert a file in the parent directory");
+	check(trie.insert("/p/b/y.c"), "insert a sibling file");
+	check(trie.insert("/p/c/z.c"), "insert a file in another directory");
+	check(!trie.insert("/p/a.c"), "insert an existing file");
+	check(trie.getCount() == 4, "count all files");
+
+	check(getFiles(trie) == (QStringList() << "/p/a.c" << "/p/b/x.c"
+		<< "/p/b/y.c" << "/p/c/z.c"), "list files in sorted order");
+	check(getFiles(trie, trie.find("/p/b")) == (QStringList() << "/p/b/x.c"
+		<< "/p/b/y.c"), "list the files of a sub-tree");
+
+	check(trie.contains("/p/b/x.c"), "contains a file");
+	check(!trie.contains("/p/b"), "a directory is not a file");
+	check(trie.find("/p/b/") == trie.find("/p/b"), "ignore a trailing slash");
+	check(trie.find("/q") < 0, "find a missing path");
+
+	check(trie.getCount(trie.find("/p/b")) == 2, "count a sub-tree");
+	check(trie.getRank(trie.find("/p/b")) == 1, "rank of a sub-tree");
+	check(trie.getRank(trie.find("/p/c/z.c")) == 3, "rank of a file");
+
+	check(trie.remove("/p/b/x.c"), "remove a file");
+	check(!trie.remove("/p/b/x.c"), "remove a missing file");
+	check(trie.getRank(trie.find("/p/c")) == 2,
+		"rank after removing a file");
+
+	check(trie.insert("/p/b/x.c"), "insert a removed file again");
+	check(trie.removeDir("/p") == 1, "remove the files of a directory");
+	check(trie.getCount() == 3, "keep the files of sub-directories");
+
+	check(trie.removeDir("/p/b") == 2, "remove the last files of a "
+		"directory");
+	check(trie.find("/p/b") < 0, "detach an empty directory");
+
+	check(trie.insert("/p/d/w.c"), "insert into a new directory");
+	check(trie.getPath(trie.find("/p/d/w.c")) == "/p/d/w.c",
+		"compose the path of a reused node");
+
+	check(trie.removeTree("/p") == 2, "remove a tree");
+	check(trie.getCount() == 0, "no files remain");
+	check(getFiles(trie).isEmpty(), "list no files");
+
+	return nFailed;
+}
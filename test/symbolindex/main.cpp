@@ -0,0 +1,59 @@
+#include <QList>
+#include <QByteArray>
+#include <QBitArray>
+
+#include "symbolindex.h"
+#include "testcheck.h"
+
+/**
+ * Provides access to the lookup functions of the symbol index, without
+ * reading the names from a database.
+ */
+class SymbolIndexTest
+{
+public:
+	static void setNames(const QList<QByteArray>& lstNames) {
+		SymbolIndex::setNames(lstNames, QBitArray(lstNames.count()));
+	}
+
+	static bool findPrefix(const char* szPrefix, quint32 nFirst,
+		quint32 nLast) {
+		quint32 nResFirst, nResLast;
+
+		SymbolIndex::findPrefix(QByteArray(szPrefix), nResFirst, nResLast);
+		return (nResFirst == nFirst) && (nResLast == nLast);
+	}
+
+	static QString getPrefix(const QString& sPattern) {
+		return SymbolIndex::getPrefix(sPattern);
+	}
+};
+
+int main()
+{
+	SymbolIndexTest::setNames(QList<QByteArray>() << "main" << "stat"
+		<< "strcpy" << "strlen" << "strlen_s" << "x");
+
+	check(SymbolIndexTest::findPrefix("", 0, 6), "empty prefix");
+	check(SymbolIndexTest::findPrefix("st", 1, 5), "common prefix");
+	check(SymbolIndexTest::findPrefix("str", 2, 5), "longer prefix");
+	check(SymbolIndexTest::findPrefix("strlen", 3, 5), "complete name");
+	check(SymbolIndexTest::findPrefix("strlen_s", 4, 5), "last match");
+	check(SymbolIndexTest::findPrefix("a", 0, 0), "before all names");
+	check(SymbolIndexTest::findPrefix("sz", 5, 5), "between names");
+	check(SymbolIndexTest::findPrefix("zz", 6, 6), "after all names");
+
+	SymbolIndexTest::setNames(QList<QByteArray>());
+	check(SymbolIndexTest::findPrefix("s", 0, 0), "no names");
+
+	check(SymbolIndexTest::getPrefix("foo") == "foo", "plain text");
+	check(SymbolIndexTest::getPrefix("str.*") == "str", "wildcard");
+	check(SymbolIndexTest::getPrefix("strl?") == "str",
+		"optional character");
+	check(SymbolIndexTest::getPrefix("ab{2}") == "a", "repeated character");
+	check(SymbolIndexTest::getPrefix("st+") == "st", "one or more");
+	check(SymbolIndexTest::getPrefix("^main").isEmpty(), "anchor");
+	check(SymbolIndexTest::getPrefix("a|b").isEmpty(), "alternatives");
+
+	return nFailed;
+}
@@ -0,0 +1,135 @@
+#include <QDir>
+#include <QFile>
+#include <QByteArray>
+
+#include "tagextractor.h"
+#include "testcheck.h"
+
+/**
+ * Extracts the tags of the given source text, and compares them with the
+ * expected output.
+ */
+static void checkTags(const char* szSource, const char* szTags,
+	const char* szTest)
+{
+	QString sPath = QDir::tempPath() + "/husky_test_tagextractor.c";
+	QFile file(sPath);
+	QByteArray baTags;
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		check(false, szTest);
+		return;
+	}
+
+	file.write(szSource);
+	file.close();
+
+	check(TagExtractor::extract(sPath, baTags) && (baTags == szTags), szTest);
+	if (baTags != szTags)
+		std::cout << baTags.constData();
+
+	QFile::remove(sPath);
+}
+
+int main()
+{
+	checkTags(
+		"#define MAX 10\n"
+		"#include <stdio.h>\n",
+		"MAX\t-\t1;\"\td\n"
+		"stdio.h\t-\t2;\"\ti\n",
+		"macros and included files");
+
+	checkTags(
+		"struct point {\n"
+		"\tint x;\n"
+		"\tint y;\n"
+		"};\n"
+		"enum color { RED, GREEN = 2 };\n"
+		"typedef unsigned long size_type;\n"
+		"static int counter;\n",
+		"point\t-\t1;\"\ts\tend:4\n"
+		"x\t-\t2;\"\tm\n"
+		"y\t-\t3;\"\tm\n"
+		"color\t-\t5;\"\tg\tend:5\n"
+		"RED\t-\t5;\"\te\n"
+		"GREEN\t-\t5;\"\te\n"
+		"size_type\t-\t6;\"\tt\n"
+		"counter\t-\t7;\"\tv\n",
+		"structures, enumerations and variables");
+
+	checkTags(
+		"int add(int a, int b)\n"
+		"{\n"
+		"\tif (a)\n"
+		"\t\tgoto out;\n"
+		"out:\n"
+		"\treturn a + b;\n"
+		"}\n",
+		"add\t-\t1;\"\tf\tend:7\n"
+		"out\t-\t5;\"\tl\n",
+		"functions and labels");
+
+	checkTags(
+		"namespace ns {\n"
+		"class Widget {\n"
+		"public:\n"
+		"\tvoid draw();\n"
+		"};\n"
+		"}\n",
+		"ns\t-\t1;\"\tn\tend:6\n"
+		"Widget\t-\t2;\"\tc\tend:5\n",
+		"namespaces and classes");
+
+	checkTags(
+		"#if 0\n"
+		"int hidden(void) { return 0; }\n"
+		"#endif\n"
+		"int shown;\n",
+		"shown\t-\t4;\"\tv\n",
+		"disabled code");
+
+	checkTags(
+		"template <class T> void foo(T x) {\n"
+		"}\n"
+		"template <typename T, class U = Box<T> > class Pair {\n"
+		"\tT first;\n"
+		"};\n",
+		"foo\t-\t1;\"\tf\tend:2\n"
+		"Pair\t-\t3;\"\tc\tend:5\n"
+		"first\t-\t4;\"\tm\n",
+		"templates");
+
+	checkTags(
+		"#if 0\n"
+		"int hidden;\n"
+		"#else\n"
+		"int shown;\n"
+		"#endif\n"
+		"#ifdef X\n"
+		"int first;\n"
+		"#elif defined(Y)\n"
+		"int second;\n"
+		"#endif\n",
+		"shown\t-\t4;\"\tv\n"
+		"first\t-\t7;\"\tv\n"
+		"second\t-\t9;\"\tv\n",
+		"alternative parts of conditional blocks");
+
+	checkTags(
+		"#ifdef X\n"
+		"int get(int a) {\n"
+		"#else\n"
+		"int get(void) {\n"
+		"#endif\n"
+		"\treturn 0;\n"
+		"}\n"
+		"int after;\n",
+		"get\t-\t2;\"\tf\tend:7\n"
+		"after\t-\t8;\"\tv\n",
+		"unbalanced conditional blocks");
+
+	checkTags("", "", "empty file");
+
+	return nFailed;
+}
@@ -0,0 +1,28 @@
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include <iostream>
+
+/**
+ * Checks shared by the test programs that do not show a window.
+ * Each program reports every check on the standard output, and returns the
+ * number of failed checks from main(), so that it can be registered with
+ * add_test().
+ */
+
+/** The number of failed checks. */
+static int nFailed = 0;
+
+/**
+ * Reports the result of a single check.
+ * @param	bResult	true if the check passed, false otherwise
+ * @param	szTest	A short description of the check
+ */
+static void check(bool bResult, const char* szTest)
+{
+	std::cout << (bResult ? "PASS: " : "FAIL: ") << szTest << std::endl;
+	if (!bResult)
+		nFailed++;
+}
+
+#endif